@@ -76,6 +76,10 @@ void (*provider_io_step)();
 		provider_io_step mIoStep;
 		bool mWasInterrupted;
 
+		//Memories mapped in the ISS (base address, size): the other accesses are device I/O
+		vector<pair<uint64_t,uint64_t>> mMappedMemories;
+		bool isMappedMemory ( uint64_t addr );
+
 		void internal_cpu_timeout(uint64_t ticks, void(*timeout_cb)(void*), void* internal_cpu, uint32_t epoch, uint64_t nosync) {
 			while (ticks*DEFAULT_TIMER_SCALE > iss_get_time(0)) {
 				sc_core::wait(sc_time(ticks*DEFAULT_TIMER_SCALE-iss_get_time(0),SC_NS)  );
@@ -249,6 +253,8 @@ void (*provider_io_step)();
 
 		//Set functions
 		void setQuantumEnable ( bool QuantumEnable );
+		void setQuantumSyncMode ( QuantumSyncMode SyncMode );
+		void setAdaptiveQuantum ( const sc_time& MinQuantum, const sc_time& MaxQuantum, uint64_t ShrinkThreshold );
 
 		//Get functions
 		bool getQuantumEnable ( );
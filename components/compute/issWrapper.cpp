@@ -17,6 +17,7 @@
 #include "issWrapper.hpp"
 #include "EndianHelper.hpp"
 #include "log.hpp"
+#include <sstream>
 
 
 extern uint64_t HOST_TIME_START;
@@ -200,6 +201,9 @@ void IssWrapper::iss_rw_sync ( uint64_t addr, ACCESS_TYPE rw_type, uint64_t cnt,
 	//Debug
 	LOG_GLOBAL_DEBUG(dbg2) << getName() <<": Returned delay is "<<delay<<endl;
 
+	//Memories are mapped in the ISS: anything else is a device
+	if (!isMappedMemory(addr)) ParallelQuantumKeeper::notifyInteraction();
+
 	if (  getQuantumEnable() ) {
 
 		//update local time
@@ -297,7 +301,17 @@ void IssWrapper::print_statistics ( ) {
 	//Debug
 	LOG_GLOBAL_STATS << "("<<getName()<<") total number of executed instructions = "<<mICount<<endl;
 	LOG_GLOBAL_STATS << "("<<getName()<<") total number of data accesses = "<<mDCount<<endl;
-	LOG_GLOBAL_STATS << "("<<getName()<<") total number of TLM transactions = "<<mDCount+mICount<<endl << endl;
+	LOG_GLOBAL_STATS << "("<<getName()<<") total number of TLM transactions = "<<mDCount+mICount<<endl;
+	if (mQuantumKeeper.getAdaptiveQuantum()) {
+		ostringstream levels;
+		const vector<sc_time>& times = mQuantumKeeper.getQuantumLevelTime();
+		for (unsigned level = 0; level < times.size(); level++)
+			levels << " " << mQuantumKeeper.getMinQuantum() * (double) (1ull << level) << ": " << times[level];
+		LOG_GLOBAL_STATS << "("<<getName()<<") adaptive quantum: average = "<<mQuantumKeeper.getAverageQuantum()
+				<<", changes = "<<mQuantumKeeper.getQuantumChangeCount()<<", time per quantum:"<<levels.str()<<endl;
+	}
+	LOG_GLOBAL_STATS << "("<<getName()<<") quantum syncs = "<<mQuantumKeeper.getSyncCount()<<", forced syncs = "<<mQuantumKeeper.getForceSyncCount()
+			<<", time waited at syncs = "<<mQuantumKeeper.getSyncWaitTime()<<" (host: "<<mQuantumKeeper.getSyncWaitHostTime()<<" s)"<<endl << endl;
 }
 
 void IssWrapper::setWaitForInterrupt(bool wfi) {
@@ -353,6 +367,21 @@ void IssWrapper::setQuantumEnable( bool QuantumEnable ) {
 	mQuantumEnable = QuantumEnable;
 }
 
+void IssWrapper::setQuantumSyncMode( QuantumSyncMode SyncMode ) {
+	mQuantumKeeper.setSyncMode(SyncMode);
+}
+
+void IssWrapper::setAdaptiveQuantum( const sc_time& MinQuantum, const sc_time& MaxQuantum, uint64_t ShrinkThreshold ) {
+	mQuantumKeeper.setAdaptiveQuantum(MinQuantum, MaxQuantum, ShrinkThreshold);
+}
+
+bool IssWrapper::isMappedMemory ( uint64_t addr ) {
+	for (auto& range: mMappedMemories) {
+		if (addr >= range.first && addr - range.first < range.second) return true;
+	}
+	return false;
+}
+
 uint32_t IssWrapper::get_cpu_id ( ) {
 	return cpu_id;
 }
@@ -372,6 +401,7 @@ void IssWrapper::iss_create_rom ( string name, uint64_t base_address, uint32_t s
 
 void IssWrapper::add_map_dmi(string name, uint64_t base_address, uint32_t size, void *data) {
 	mLib.map_dmi ( name, base_address, size, data );
+	mMappedMemories.push_back(make_pair(base_address, (uint64_t) size));
 }
 
 void IssWrapper::iss_linux_mem_init ( uint32_t ncores, uint32_t size ) {
@@ -385,6 +415,7 @@ void IssWrapper::iss_load_elf(uint64_t ram_size, char *kernel_filename, char *ke
 void  IssWrapper::iss_update_irq(uint64_t val, uint32_t irq_idx) {
 	mLib.update_irq(val, irq_idx&0xffff);
 	if (val) {
+		ParallelQuantumKeeper::notifyInteraction();
 		mWaitForInterrupt.notify(SC_ZERO_TIME);
 		mWasInterrupted=true;
 	}
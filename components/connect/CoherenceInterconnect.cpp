@@ -39,6 +39,8 @@ namespace vpsim {
     , DIAGNOSTIC_LEVEL(DBG_L0)
     , ACCESS_LATENCY  (sc_time(0,SC_NS))
     , ENABLE_LATENCY  (false)
+    , mDmiGranted     (num_cache_in+num_home_in+num_device)
+    , mDmiUntracked   (false)
     , NUM_CACHE_IN    (num_cache_in)
     , NUM_CACHE_OUT   (num_cache_out)
     , NUM_HOME_IN     (num_home_in)
@@ -50,27 +52,39 @@ namespace vpsim {
     , IsCoherent      (isCoherent)
     , MemoryInterleaveLength(memoryInterleaveLength)
     , SLCInterleaveLength(slcInterleaveLength)
+    , mMapsValid      (false)
+    , mMMappedMap     (string(name) + ".mmapped")
+    , mHomeOutputMap  (string(name) + ".home_out")
+    , mMemCtrlMap     (string(name) + ".mem_ctrl")
+    , mHomeCtrlMap    (string(name) + ".home_ctrl")
   {
     for (unsigned i = 0; i<NUM_CACHE_IN; i++) {
-      mCacheSocketsIn.push_back(new tlm_utils::simple_target_socket<CoherenceInterconnect>((string("cache_in_")+to_string(i)).c_str()));
-      mCacheSocketsIn[i]->register_b_transport(this, &CoherenceInterconnect::b_transport);
+      mCacheSocketsIn.push_back(new SimpleInSocket((string("cache_in_")+to_string(i)).c_str()));
+      mCacheSocketsIn[i]->register_b_transport(this, &CoherenceInterconnect::b_transport_in, i);
+      mCacheSocketsIn[i]->register_get_direct_mem_ptr(this, &CoherenceInterconnect::get_direct_mem_ptr_in, i);
+      mCacheSocketsIn[i]->register_transport_dbg(this, &CoherenceInterconnect::transport_dbg_in, i);
     }
     for (unsigned i = 0; i<NUM_CACHE_OUT; i++) {
       mCacheSocketsOut.push_back(new tlm_utils::simple_initiator_socket<CoherenceInterconnect>((string("cache_out_")+to_string(i)).c_str()));
     }
     for (unsigned i = 0; i<NUM_HOME_IN; i++) {
-      mHomeSocketsIn.push_back(new tlm_utils::simple_target_socket<CoherenceInterconnect>((string("home_in_")+to_string(i)).c_str()));
-      mHomeSocketsIn[i]->register_b_transport(this, &CoherenceInterconnect::b_transport);
+      mHomeSocketsIn.push_back(new SimpleInSocket((string("home_in_")+to_string(i)).c_str()));
+      mHomeSocketsIn[i]->register_b_transport(this, &CoherenceInterconnect::b_transport_in, NUM_CACHE_IN+i);
+      mHomeSocketsIn[i]->register_get_direct_mem_ptr(this, &CoherenceInterconnect::get_direct_mem_ptr_in, NUM_CACHE_IN+i);
+      mHomeSocketsIn[i]->register_transport_dbg(this, &CoherenceInterconnect::transport_dbg_in, NUM_CACHE_IN+i);
     }
     for (unsigned i = 0; i<NUM_HOME_OUT; i++) {
       mHomeSocketsOut.push_back(new tlm_utils::simple_initiator_socket<CoherenceInterconnect>((string("home_out_")+to_string(i)).c_str()));
     }
     for (unsigned i = 0; i<NUM_MMAPPED; i++) {
       mMMappedSocketsOut.push_back(new tlm_utils::simple_initiator_socket<CoherenceInterconnect>((string("mmapped_out_")+to_string(i)).c_str()));
+      mMMappedSocketsOut[i]->register_invalidate_direct_mem_ptr(this, &CoherenceInterconnect::invalidate_direct_mem_ptr);
     }
     for (unsigned i = 0; i<NUM_DEVICE; i++) {
-      mDeviceSocketsIn.push_back(new tlm_utils::simple_target_socket<CoherenceInterconnect>((string("device_")+to_string(i)).c_str()));
-      mDeviceSocketsIn[i]->register_b_transport(this, &CoherenceInterconnect::b_transport_device);
+      mDeviceSocketsIn.push_back(new SimpleInSocket((string("device_")+to_string(i)).c_str()));
+      mDeviceSocketsIn[i]->register_b_transport(this, &CoherenceInterconnect::b_transport_device_in, NUM_CACHE_IN+NUM_HOME_IN+i);
+      mDeviceSocketsIn[i]->register_get_direct_mem_ptr(this, &CoherenceInterconnect::get_direct_mem_ptr_in, NUM_CACHE_IN+NUM_HOME_IN+i);
+      mDeviceSocketsIn[i]->register_transport_dbg(this, &CoherenceInterconnect::transport_dbg_in, NUM_CACHE_IN+NUM_HOME_IN+i);
     }
     CacheOutputs.resize   (NUM_CACHE_OUT);
     HomeOutputs.resize    (NUM_HOME_OUT);
@@ -79,16 +93,13 @@ namespace vpsim {
     MMappedReadCountOut.resize (NUM_MMAPPED, 0);
     MMappedWriteCountOut.resize (NUM_MMAPPED, 0);
 
+    DmiGrantCount.resize (NUM_CACHE_IN+NUM_HOME_IN+NUM_DEVICE, 0);
+    DmiDenyCount.resize (NUM_CACHE_IN+NUM_HOME_IN+NUM_DEVICE, 0);
+    DmiInvalidateCount.resize (NUM_CACHE_IN+NUM_HOME_IN+NUM_DEVICE, 0);
+
     RamBaseAddr = UINT64_MAX;
     RamLastAddr = 0x0;
     IndexFirstMemoryController= UINT32_MAX;
-
-
-    if(!MemoryInterleaveLength) get_noc_pos_by_address=&CoherenceInterconnect::get_noc_pos_by_address_without_interleave;
-    else                        get_noc_pos_by_address=&CoherenceInterconnect::get_noc_pos_by_address_with_interleave;
-    if(!SLCInterleaveLength)  get_home_pos_by_address=&CoherenceInterconnect::get_home_pos_by_address_without_interleave;
-    else                      get_home_pos_by_address=&CoherenceInterconnect::get_home_pos_by_address_with_interleave;
-
   }
 
   CoherenceInterconnect::~CoherenceInterconnect() {
@@ -118,18 +129,75 @@ namespace vpsim {
     CacheCount++;
   }
 
-  void CoherenceInterconnect::set_mmapped_output (uint32_t num_port, uint64_t base_addr, uint64_t offset) {
+  void CoherenceInterconnect::end_of_elaboration () {
+    //Report overlapping ranges before the simulation starts rather than at the first access
+    build_address_maps ();
+  }
+
+  /**
+  * Within the RAM range, interleaving spreads the granules over all the registered controllers in turn,
+  * the ranges outside of it are decoded one by one
+  */
+  void CoherenceInterconnect::build_address_maps () {
+    const bool ram = RamBaseAddr < RamLastAddr;
+    auto outside_ram = [&](uint64_t base, uint64_t size) { return !ram || base + size <= RamBaseAddr || base >= RamLastAddr; };
+
+    mMMappedMap.clear();
+    for (uint32_t i = 0; i < MMappedCount; i++)
+      mMMappedMap.addRange (MMappedOutputs[i].base_addr, MMappedOutputs[i].offset, i, MMappedOutputs[i].name);
+
+    vector<int32_t> targets;
+    mHomeOutputMap.clear();
+    if (SLCInterleaveLength && ram && !mHomeIDs.empty()) {
+      targets.clear();
+      for (size_t i = 0; i < mHomeIDs.size(); i++) targets.push_back (i);
+      mHomeOutputMap.addInterleavedRange (RamBaseAddr, RamLastAddr - RamBaseAddr, SLCInterleaveLength, targets, "RAM");
+    } else {
+      for (uint32_t i = 0; i < HomeCount; i++)
+        mHomeOutputMap.addRange (HomeOutputs[i].base_addr, HomeOutputs[i].offset, HomeOutputs[i].port, HomeOutputs[i].name);
+    }
+
+    mMemCtrlMap.clear();
+    if (MemoryInterleaveLength && ram && !mAddressIDs.empty()) {
+      targets.clear();
+      for (size_t i = 0; i < mAddressIDs.size(); i++) targets.push_back (i);
+      mMemCtrlMap.addInterleavedRange (RamBaseAddr, RamLastAddr - RamBaseAddr, MemoryInterleaveLength, targets, "RAM");
+    }
+    for (size_t i = 0; i < mAddressIDs.size(); i++)
+      if (!MemoryInterleaveLength || outside_ram (get<0>(mAddressIDs[i]), get<1>(mAddressIDs[i])))
+        mMemCtrlMap.addRange (get<0>(mAddressIDs[i]), get<1>(mAddressIDs[i]), i);
+
+    mHomeCtrlMap.clear();
+    if (SLCInterleaveLength && ram && !mHomeIDs.empty()) {
+      targets.clear();
+      for (size_t i = 0; i < mHomeIDs.size(); i++) targets.push_back (i);
+      mHomeCtrlMap.addInterleavedRange (RamBaseAddr, RamLastAddr - RamBaseAddr, SLCInterleaveLength, targets, "RAM");
+    } else {
+      for (size_t i = 0; i < mHomeIDs.size(); i++)
+        mHomeCtrlMap.addRange (get<0>(mHomeIDs[i]), get<1>(mHomeIDs[i]), i);
+    }
+
+    mMMappedMap.compile();
+    mHomeOutputMap.compile();
+    mMemCtrlMap.compile();
+    mHomeCtrlMap.compile();
+    mMapsValid = true;
+  }
+
+  void CoherenceInterconnect::set_mmapped_output (uint32_t num_port, uint64_t base_addr, uint64_t offset, string target_name) {
     assert (MMappedCount<NUM_MMAPPED);
     addr_struct mmappedOutput;
     mmappedOutput.base_addr = base_addr;
     mmappedOutput.end_addr  = base_addr+offset-1;
     mmappedOutput.offset    = offset;
     mmappedOutput.port      = num_port;
+    mmappedOutput.name      = target_name;
     MMappedOutputs [MMappedCount] = mmappedOutput;
     MMappedCount++;
+    mMapsValid = false;
   }
 
-  void CoherenceInterconnect::set_home_output (uint32_t num_port, idx_t id, uint64_t base_addr, uint64_t offset) {
+  void CoherenceInterconnect::set_home_output (uint32_t num_port, idx_t id, uint64_t base_addr, uint64_t offset, string target_name) {
     assert (HomeCount<NUM_HOME_OUT);
     assert (id != NULL_IDX);
     id_addr_struct homeOutput;
@@ -138,8 +206,10 @@ namespace vpsim {
     homeOutput.end_addr  = base_addr+offset-1;
     homeOutput.offset    = offset;
     homeOutput.port      = num_port;
+    homeOutput.name      = target_name;
     HomeOutputs [HomeCount] = homeOutput;
     HomeCount++;
+    mMapsValid = false;
   }
 
   void CoherenceInterconnect::set_cache_id (idx_t num_port, idx_t id, string name) {
@@ -172,27 +242,14 @@ namespace vpsim {
       (*mHomeSocketsOut[0])->b_transport(trans, delay);
       return;
     } else {
-      uint64_t addr=trans.get_address();
-      if(SLCInterleaveLength){
-        size_t index=0;
-        if(addr >= RamBaseAddr && addr < RamLastAddr){
-          index = ((addr-RamBaseAddr) /SLCInterleaveLength) % mHomeIDs.size();
-          (*mHomeSocketsOut[index])->b_transport(trans, delay);
-          return;
-        }
-      }
-      else{
-        for (auto it = HomeOutputs.begin(); it != HomeOutputs.end(); ++it)
-          if ((addr >= it->base_addr) && (addr+trans.get_data_length()-1 <= it->end_addr)) {
-            (*mHomeSocketsOut[it->port])->b_transport(trans, delay);
-            return;
-          }
-      }
-      assert (false); //throw runtime_error ("No home found\n");
+      if (!mMapsValid) build_address_maps ();
+      int32_t port = mHomeOutputMap.decode (trans.get_address(), trans.get_data_length());
+      assert (port != AddressMap::NO_TARGET); //throw runtime_error ("No home found\n");
+      (*mHomeSocketsOut[port])->b_transport(trans, delay);
     }
   }
 
-  inline void CoherenceInterconnect::sendTransactionToCache (tlm::tlm_generic_payload& trans, set<idx_t> targetIds, sc_time& delay) {
+  inline void CoherenceInterconnect::sendTransactionToCache (tlm::tlm_generic_payload& trans, const SharerSet& targetIds, sc_time& delay) {
     //if (targetIds.size() == 0 || NUM_CACHE == 0) throw runtime_error("No cache found\n");
     if (targetIds.size()==0)
       // TODO: assert (!IsCoherent);
@@ -201,19 +258,29 @@ namespace vpsim {
     else
       // TODO: assert (IsCoherent);
       for (auto it = CacheOutputs.begin(); it != CacheOutputs.end(); ++it) // broadcast to specific upper caches
-        for (auto id : targetIds)
-          if (it->id==id) (*mCacheSocketsOut[it->position])->b_transport(trans, delay);
+        if (targetIds.contains(it->id)) (*mCacheSocketsOut[it->position])->b_transport(trans, delay);
+  }
+
+  const addr_struct* CoherenceInterconnect::getMMappedOutput (uint64_t addr) {
+    if (!mMapsValid) build_address_maps ();
+    int32_t index = mMMappedMap.decode (addr);
+    return index != AddressMap::NO_TARGET ? &MMappedOutputs[index] : NULL;
+  }
+
+  CoherenceInterconnect::SimpleInSocket& CoherenceInterconnect::getInputSocket (uint32_t in_port) {
+    if (in_port < NUM_CACHE_IN) return *mCacheSocketsIn[in_port];
+    if (in_port < NUM_CACHE_IN+NUM_HOME_IN) return *mHomeSocketsIn[in_port-NUM_CACHE_IN];
+    return *mDeviceSocketsIn[in_port-NUM_CACHE_IN-NUM_HOME_IN];
   }
 
   inline void CoherenceInterconnect::sendTransactionToMMapped (tlm::tlm_generic_payload& trans, sc_time& delay){
     assert(trans.get_command()!=tlm::TLM_IGNORE_COMMAND);
-    for (auto it = MMappedOutputs.begin(); it != MMappedOutputs.end(); ++it)
-      if (trans.get_address() >= it->base_addr && trans.get_address()+trans.get_data_length()-1 <= it->end_addr){
-        (*mMMappedSocketsOut[it->port])-> b_transport (trans, delay);
-        //if (trans.get_command()==tlm::TLM_READ_COMMAND) MMappedReadCountOut[it->port] += trans.get_data_length();
-        //else MMappedWriteCountOut[it->port] += trans.get_data_length();
-        return;
-      } assert (false); //throw runtime_error ("No memory mapped component found\n");
+    if (!mMapsValid) build_address_maps ();
+    int32_t index = mMMappedMap.decode (trans.get_address(), trans.get_data_length());
+    assert (index != AddressMap::NO_TARGET); //throw runtime_error ("No memory mapped component found\n");
+    (*mMMappedSocketsOut[MMappedOutputs[index].port])-> b_transport (trans, delay);
+    //if (trans.get_command()==tlm::TLM_READ_COMMAND) MMappedReadCountOut[it->port] += trans.get_data_length();
+    //else MMappedWriteCountOut[it->port] += trans.get_data_length();
   }
 
   /**
@@ -290,11 +357,11 @@ namespace vpsim {
 
   uint64_t CoherenceInterconnect::get_ram_base_addr () { return RamBaseAddr;}
 
-  void CoherenceInterconnect::set_ram_base_addr (uint64_t firstAddr) { RamBaseAddr = firstAddr;}
+  void CoherenceInterconnect::set_ram_base_addr (uint64_t firstAddr) { RamBaseAddr = firstAddr; mMapsValid = false; }
 
   uint64_t CoherenceInterconnect::get_ram_last_addr () { return RamLastAddr;}
 
-  void CoherenceInterconnect::set_ram_last_addr (uint64_t lastAddr)  { RamLastAddr = lastAddr; }
+  void CoherenceInterconnect::set_ram_last_addr (uint64_t lastAddr)  { RamLastAddr = lastAddr; mMapsValid = false; }
 
   void CoherenceInterconnect::set_memory_word_length (uint32_t wordLengthInByte) { MWordLengthInByte = wordLengthInByte;}
 
@@ -306,6 +373,7 @@ namespace vpsim {
     else{
       mAddressIDs.push_back (make_tuple(base, size, mesh_pos{x_id, y_id}));
       mReadCount.push_back(UINT64_C(0));mWriteCount.push_back(UINT64_C(0));
+      mMapsValid = false;
     }
   }
 
@@ -324,35 +392,24 @@ namespace vpsim {
   void CoherenceInterconnect::register_home_ctrl (uint64_t base, uint64_t size, idx_t x_id, idx_t y_id) {
     assert (x_id!= NULL_IDX && y_id!= NULL_IDX);
     if (x_id > mX || y_id > mY) throw runtime_error("Incorrect memory/LLC mesh coordinates.\n");
-    else mHomeIDs.push_back (make_tuple(base, size, mesh_pos{x_id, y_id}));
-  }
-
-  /**
-  * @param  index   points the registered memory mapped component
-  */
-  CoherenceInterconnect::mesh_pos CoherenceInterconnect::get_noc_pos_by_address_without_interleave (uint64_t addr, size_t& index) {
-    index = 0;
-    for (auto& mapping: mAddressIDs){
-      if (addr >= get<0>(mapping) && addr < get<1>(mapping)+get<0>(mapping)) {
-        return get<2>(mapping);
-      }
-      ++index;
+    else {
+      mHomeIDs.push_back (make_tuple(base, size, mesh_pos{x_id, y_id}));
+      mMapsValid = false;
     }
-    throw runtime_error("Unknown Address: " + to_string(addr));
   }
 
   /**
-  * @param index index of the memory controller. It supposes that Memory controllers are
-  * registered in a sorted way according to their address spaces.
-  * Besides, index must have been initialized with that of the first memory controller
+  * @param index index of the registered memory controller. Within the interleaved RAM range, the
+  * interleaving index is added to it, so that it must have been initialized with that of the first
+  * memory controller
   */
-  CoherenceInterconnect::mesh_pos CoherenceInterconnect::get_noc_pos_by_address_with_interleave (uint64_t addr, size_t& index) {
-    if(addr >= RamBaseAddr && addr < RamLastAddr){
-      index += ((addr-RamBaseAddr) / MemoryInterleaveLength) % mAddressIDs.size();
-      return get<2>(mAddressIDs[index]);
-    }
-    else
-      return get_noc_pos_by_address_without_interleave (addr,index);
+  CoherenceInterconnect::mesh_pos CoherenceInterconnect::get_noc_pos_by_address (uint64_t addr, size_t& index) {
+    if (!mMapsValid) build_address_maps ();
+    int32_t region = mMemCtrlMap.find (addr);
+    if (region < 0) throw runtime_error("Unknown Address: " + to_string(addr));
+    if (mMemCtrlMap.getRegion(region).granule) index += mMemCtrlMap.getTarget (region, addr);
+    else index = mMemCtrlMap.getTarget (region, addr);
+    return get<2>(mAddressIDs[index]);
   }
 
   CoherenceInterconnect::mesh_pos CoherenceInterconnect::get_noc_pos_by_id (idx_t id) {
@@ -373,21 +430,10 @@ namespace vpsim {
     throw runtime_error("Unknown Device ID: " + to_string(id));
   }
 
-  CoherenceInterconnect::mesh_pos CoherenceInterconnect::get_home_pos_by_address_without_interleave (uint64_t addr) {
-    for (auto& mapping: mHomeIDs)
-      if (addr >= get<0>(mapping) && addr < get<1>(mapping)+get<0>(mapping)) {
-        return get<2>(mapping);
-      }
-    throw runtime_error("Unknown Address: " + to_string(addr));
-  }
-
-  CoherenceInterconnect::mesh_pos CoherenceInterconnect::get_home_pos_by_address_with_interleave (uint64_t addr) {
-    size_t index=0;
-    if(addr >= RamBaseAddr && addr < RamLastAddr){
-      index = ((addr-RamBaseAddr) / SLCInterleaveLength) % mHomeIDs.size();
-    }
-    else
-      throw runtime_error("Unknown Address: " + to_string(addr));
+  CoherenceInterconnect::mesh_pos CoherenceInterconnect::get_home_pos_by_address (uint64_t addr) {
+    if (!mMapsValid) build_address_maps ();
+    int32_t index = mHomeCtrlMap.decode (addr);
+    if (index == AddressMap::NO_TARGET) throw runtime_error("Unknown Address: " + to_string(addr));
     return get<2>(mHomeIDs[index]);
   }
 
@@ -397,7 +443,7 @@ namespace vpsim {
     PacketsCount++;
   }
 
-  uint64_t CoherenceInterconnect::computeNoCLatency (bool isHome, bool isIdMapped, uint64_t addr, idx_t src_id, set<idx_t> dst_ids) {
+  uint64_t CoherenceInterconnect::computeNoCLatency (bool isHome, bool isIdMapped, uint64_t addr, idx_t src_id, const SharerSet& dst_ids) {
     mesh_pos src_pos = get_noc_pos_by_id(src_id);
     mesh_pos dst_pos;
     idx_t src_x = src_pos.x_id;
@@ -409,12 +455,12 @@ namespace vpsim {
       // If target is memory-mapped, i.e. main memory or LLC, its mesh position is computed using its address map
       if(!isHome){
         size_t index = 0;
-        dst_pos = (this->*get_noc_pos_by_address)(addr, index);
+        dst_pos = get_noc_pos_by_address(addr, index);
         dst_x = dst_pos.x_id;
         dst_y = dst_pos.y_id;
         dist  = abs((int64_t)src_x-dst_x) + abs((int64_t)src_y-dst_y)+1;
       } else {
-        dst_pos = (this->*get_home_pos_by_address)(addr); 
+        dst_pos = get_home_pos_by_address(addr); 
         dst_x = dst_pos.x_id;
         dst_y = dst_pos.y_id;
         dist  = abs((int64_t)src_x-dst_x) + abs((int64_t)src_y-dst_y)+1;
@@ -423,7 +469,7 @@ namespace vpsim {
       // If target is not memory-mapped, i.e. higher-level cache, its mesh position is computed using its id
       // If broadcast to higher-level caches, only the largest distance is used for delay computation
       if (IsCoherent) {
-        for (set<idx_t>::iterator it = dst_ids.begin(); it!=dst_ids.end(); it++) {
+        for (SharerSet::const_iterator it = dst_ids.begin(); it!=dst_ids.end(); it++) {
           dst_pos = get_noc_pos_by_id(*it);
           dst_x = dst_pos.x_id;
           dst_y = dst_pos.y_id;
@@ -719,13 +765,13 @@ namespace vpsim {
     cout << "*****" << endl;
   }
 
-  vector <CoherenceInterconnect::mesh_pos> CoherenceInterconnect::GetDestinations(tlm::tlm_generic_payload& trans, bool isHome, bool isIdMapped, set<idx_t> dst_ids) {
+  vector <CoherenceInterconnect::mesh_pos> CoherenceInterconnect::GetDestinations(tlm::tlm_generic_payload& trans, bool isHome, bool isIdMapped, const SharerSet& dst_ids) {
     vector <mesh_pos> dest;
     mesh_pos dst_pos;
     if (!isIdMapped) {
       if(!isHome){
         size_t index = IndexFirstMemoryController;
-        dst_pos = (this->*get_noc_pos_by_address)(trans.get_address(), index);
+        dst_pos = get_noc_pos_by_address(trans.get_address(), index);
         dest.push_back(dst_pos);
         //Update Memory Controllers Counters
         if(trans.get_command()==tlm::TLM_READ_COMMAND)
@@ -734,13 +780,13 @@ namespace vpsim {
           mWriteCount[index]+=trans.get_data_length();
         return dest;
       } else {
-        dst_pos = (this->*get_home_pos_by_address)(trans.get_address());
+        dst_pos = get_home_pos_by_address(trans.get_address());
         dest.push_back(dst_pos);
         return dest;
       }
     } else {
       if (IsCoherent) {
-        for (set<idx_t>::iterator it = dst_ids.begin(); it!=dst_ids.end(); it++) {
+        for (SharerSet::const_iterator it = dst_ids.begin(); it!=dst_ids.end(); it++) {
           dst_pos = get_noc_pos_by_id(*it);
           dest.push_back(dst_pos);
         }
@@ -755,13 +801,13 @@ namespace vpsim {
     }
   }
 
-  void CoherenceInterconnect::NetworkTimingModel(tlm::tlm_generic_payload& trans, sc_time trans_time_stamp, sc_time time_interval, bool isHome, bool isIdMapped, uint32_t nbFlits, mesh_pos src_pos, set<idx_t> dst_ids, bool device){
+  void CoherenceInterconnect::NetworkTimingModel(tlm::tlm_generic_payload& trans, sc_time trans_time_stamp, sc_time time_interval, bool isHome, bool isIdMapped, uint32_t nbFlits, mesh_pos src_pos, const SharerSet& dst_ids, bool device){
     route path;
     vector <mesh_pos> dest;
     if(device && trans.get_command()==tlm::TLM_READ_COMMAND){ //Reverse direction: memory -> device
       dest.push_back(src_pos);
       size_t index = IndexFirstMemoryController; //index of the first memory controller
-      src_pos = (this->*get_noc_pos_by_address)(trans.get_address(), index);
+      src_pos = get_noc_pos_by_address(trans.get_address(), index);
     }
     else{
       dest=GetDestinations(trans, isHome, isIdMapped, dst_ids);
@@ -947,7 +993,7 @@ namespace vpsim {
             //Compute latency delay
             sc_time ts = src->time_stamp + arrivalDelay;
 
-            NetworkTimingModel(trans,ts,mContentionInterval,false,false,1,src_pos,set<idx_t>(),true);//Reverse direction
+            NetworkTimingModel(trans,ts,mContentionInterval,false,false,1,src_pos,SharerSet(),true);//Reverse direction
             tmpDelay = memDelay + packet_latency; //Packet or flit latency
             if(tmpDelay>maxDelay) maxDelay=tmpDelay;  //Find a better way than to compare every time
           }
@@ -978,7 +1024,7 @@ namespace vpsim {
 
           //Compute latency delay
           sc_time ts = src->time_stamp + arrivalDelay;
-          NetworkTimingModel(trans,ts,mContentionInterval,false,false,1,src_pos,set<idx_t>());//ext->getToHome() -> false
+          NetworkTimingModel(trans,ts,mContentionInterval,false,false,1,src_pos,SharerSet());//ext->getToHome() -> false
           memDelay = arrivalDelay + packet_latency;//packet or flit latency
 
           //Send transaction
@@ -997,13 +1043,61 @@ namespace vpsim {
     trans.set_address(storeAddr);
   }
 
+  void CoherenceInterconnect::b_transport_in (int in_port, tlm::tlm_generic_payload& trans, sc_time& delay) {
+    b_transport (trans, delay);
+  }
+
+  void CoherenceInterconnect::b_transport_device_in (int in_port, tlm::tlm_generic_payload& trans, sc_time& delay) {
+    b_transport_device (trans, delay);
+  }
+
+  unsigned int CoherenceInterconnect::transport_dbg_in (int in_port, tlm::tlm_generic_payload& trans) {
+    return transport_dbg (trans);
+  }
+
   bool CoherenceInterconnect::get_direct_mem_ptr (tlm::tlm_generic_payload& trans, tlm::tlm_dmi& dmi_data) {
-    // TODO
+    return get_direct_mem_ptr_in (-1, trans, dmi_data);
+  }
+
+  //! DMI requests go to the memory mapped output of the address, then the region granted is clipped
+  //! to the range of the output, a target may grant more than what is routed to it
+  bool CoherenceInterconnect::get_direct_mem_ptr_in (int in_port, tlm::tlm_generic_payload& trans, tlm::tlm_dmi& dmi_data) {
+    const addr_struct* output = getMMappedOutput (trans.get_address());
+    if (!output) {
+      dmi_data.set_start_address (trans.get_address());
+      dmi_data.set_end_address (trans.get_address());
+      if (in_port >= 0) DmiDenyCount[in_port]++;
+      return false;
+    }
+
+    bool ret = (*mMMappedSocketsOut[output->port])->get_direct_mem_ptr (trans, dmi_data);
+    if (dmi_data.get_start_address() < output->base_addr) {
+      if (ret) dmi_data.set_dmi_ptr (dmi_data.get_dmi_ptr() + (output->base_addr - dmi_data.get_start_address()));
+      dmi_data.set_start_address (output->base_addr);
+    }
+    if (dmi_data.get_end_address() > output->end_addr) dmi_data.set_end_address (output->end_addr);
+
+    if (!ret) {
+      if (in_port >= 0) DmiDenyCount[in_port]++;
+      return false;
+    }
+    //Remember who holds the region, so that its invalidation only goes back there
+    if (in_port < 0) mDmiUntracked = true;
+    else {
+      mDmiGranted.setDmiRange (in_port, dmi_data.get_start_address(), dmi_data.get_end_address() - dmi_data.get_start_address() + 1, dmi_data.get_dmi_ptr());
+      DmiGrantCount[in_port]++;
+    }
     return true;
   }
 
   void CoherenceInterconnect::invalidate_direct_mem_ptr (sc_dt::uint64 start_range, sc_dt::uint64 end_range) {
-    /* for (auto& s: SocketsIn) s->invalidate_direct_mem_ptr(start_range, end_range); */
+    for (uint32_t i = 0; i < NUM_CACHE_IN+NUM_HOME_IN+NUM_DEVICE; i++) {
+      //Only the input sockets which may hold a part of the range are told
+      if (!mDmiUntracked && !mDmiGranted.overlapsDmiRange (i, start_range, end_range)) continue;
+      mDmiGranted.invalidateDmiRange (i, start_range, end_range);
+      DmiInvalidateCount[i]++;
+      getInputSocket (i)->invalidate_direct_mem_ptr (start_range, end_range);
+    }
   }
 
   tlm::tlm_sync_enum
@@ -1016,8 +1110,53 @@ namespace vpsim {
     throw;
   }
 
+  //! Debug accesses are split between the memory mapped outputs, then every home and upper cache is snooped
+  //! with a debug ReadBack, homes first, so that the most recent copy of the data ends up in the payload
   unsigned int CoherenceInterconnect::transport_dbg (tlm::tlm_generic_payload& trans) {
-    trans.set_response_status(tlm::tlm_response_status::TLM_OK_RESPONSE);
-    return 0;
+    const uint64_t addr = trans.get_address();
+    unsigned char* const ptr = trans.get_data_ptr();
+    const unsigned int len = trans.get_data_length();
+
+    unsigned int done = 0;
+    while (done < len) {
+      const uint64_t chunkAddr = addr + done;
+      const addr_struct* output = getMMappedOutput (chunkAddr);
+      if (!output) break;
+
+      const unsigned int chunk = min ((uint64_t) (len - done - 1), output->end_addr - chunkAddr) + 1;
+      trans.set_address (chunkAddr);
+      trans.set_data_ptr (ptr + done);
+      trans.set_data_length (chunk);
+      const unsigned int nb = (*mMMappedSocketsOut[output->port])->transport_dbg (trans);
+      done += nb;
+      if (nb < chunk) break;
+    }
+    trans.set_address (addr);
+    trans.set_data_ptr (ptr);
+    trans.set_data_length (len);
+    //A transfer stopping partway is an address error, as in interconnect::transport_dbg
+    const tlm::tlm_response_status status = done == len ? tlm::TLM_OK_RESPONSE : tlm::TLM_ADDRESS_ERROR_RESPONSE;
+    if (done == 0) {
+      trans.set_response_status (status);
+      return 0;
+    }
+
+    tlm::tlm_generic_payload snoop;
+    CoherencePayloadExtension ext;
+    ext.setCoherenceCommand (ReadBack);
+    snoop.set_command (trans.get_command());
+    snoop.set_address (addr);
+    snoop.set_data_ptr (ptr);
+    snoop.set_data_length (done);
+    snoop.set_streaming_width (done);
+    snoop.set_extension (&ext);
+    for (uint32_t i = 0; i < HomeCount; i++)
+      (*mHomeSocketsOut[HomeOutputs[i].port])->transport_dbg (snoop);
+    for (auto it = CacheOutputs.begin(); it != CacheOutputs.end(); ++it)
+      (*mCacheSocketsOut[it->position])->transport_dbg (snoop);
+    snoop.clear_extension (&ext);
+
+    trans.set_response_status (status);
+    return done;
   }
 }
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#include "ParallelBridge.hpp"
+
+namespace vpsim {
+
+ParallelBridge::SharedAccess::SharedAccess(ParallelBridge& bridge, const sc_time& t): Bridge(bridge), Held(false) {
+	Bridge.mDomain.lockShared(Bridge.mCluster, t);
+	Held = true;
+}
+
+ParallelBridge::SharedAccess::~SharedAccess() {
+	if (Held) Bridge.mDomain.unlockSharedNoThrow(Bridge.mCluster);
+}
+
+void ParallelBridge::SharedAccess::unlock() {
+	Held = false;
+	Bridge.mDomain.unlockShared(Bridge.mCluster);
+}
+
+//-----------------------------------------------------------------------------
+//Constructor
+ParallelBridge::ParallelBridge ( sc_module_name name, ParallelDomain& domain, unsigned cluster, ParallelQuantumKeeper& keeper ) :
+	sc_module(name),
+	mDomain(domain),
+	mCluster(cluster),
+	mKeeper(keeper),
+	mTransportCount(0),
+	socket_in("socket_in"),
+	socket_out("socket_out")
+{
+	socket_in.register_b_transport ( this, &ParallelBridge::b_transport );
+	socket_in.register_get_direct_mem_ptr ( this, &ParallelBridge::get_direct_mem_ptr );
+	socket_in.register_transport_dbg ( this, &ParallelBridge::transport_dbg );
+}
+
+//-----------------------------------------------------------------------------
+//Forward interface
+void
+ParallelBridge::b_transport ( tlm::tlm_generic_payload& trans, sc_time& delay )
+{
+	CoherencePayloadExtension* coherence = trans.get_extension<CoherencePayloadExtension> ();
+	if ( coherence && trans.get_command() == tlm::TLM_IGNORE_COMMAND ) {
+		switch ( coherence->getCoherenceCommand() ) {
+		case GetS: case GetM: case PutS: case PutM:
+		case FwdGetS: case FwdGetM: case PutI: case InvS: case InvM:
+			throw runtime_error(string(name()) + ": coherent caches cannot be part of a cluster of a parallel domain");
+		default:
+			break;
+		}
+	}
+
+	SharedAccess access(*this, mKeeper.get_current_time() + delay);
+	mTransportCount++;
+	socket_out->b_transport ( trans, delay );
+	access.unlock();
+	trans.set_dmi_allowed ( false );
+}
+
+bool
+ParallelBridge::get_direct_mem_ptr ( tlm::tlm_generic_payload& trans, tlm::tlm_dmi& dmi_data )
+{
+	return false;
+}
+
+unsigned int
+ParallelBridge::transport_dbg ( tlm::tlm_generic_payload& trans )
+{
+	SharedAccess access(*this, mKeeper.get_current_time());
+	unsigned int count = socket_out->transport_dbg ( trans );
+	access.unlock();
+	return count;
+}
+
+tlm::tlm_sync_enum
+ParallelBridge::nb_transport_fw ( tlm::tlm_generic_payload& trans, tlm::tlm_phase& phase, sc_time& t )
+{
+	throw runtime_error(string(name()) + ": nb_transport_fw is not supported across a parallel domain");
+}
+
+}//end namespace vpsim
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/*
+ * Nanoseconds per address decode with N targets, N from 4 to MAX_TARGETS,
+ * reported in the same layout as Google Benchmark. Random accesses are
+ * decoded by a linear scan of the ranges (the former decoders of the
+ * coherent interconnect and of the NoC), by an AddressMap, and by the
+ * memory mapped outputs of a coherent interconnect which now use one.
+ * Interleaved decodes compare the former scan of the home nodes, each
+ * checking its slot of the interleave, with an interleaved AddressMap.
+ * The interconnect is never bound nor started.
+ */
+
+#include "Bench.hpp"
+#include "AddressMap.hpp"
+#include "CoherenceInterconnect.hpp"
+
+using namespace vpsim;
+using namespace sc_core;
+using namespace std;
+
+static const unsigned MAX_TARGETS = 1024;
+static const uint64_t ITERATIONS = 1 << 22;
+static const uint64_t SIZE = 0x1000;
+static const uint64_t GRANULE = 0x40;
+
+int sc_main(int argc, char* argv[])
+{
+	benchHeader();
+
+	for (unsigned n = 4; n <= MAX_TARGETS; n *= 4) {
+		const string suffix = "/" + to_string(n);
+
+		//Modules are not destroyed before the end of the elaboration
+		CoherenceInterconnect& ic = *new CoherenceInterconnect(("ic" + to_string(n)).c_str(),
+				1, 1, 1, 1, n, 0, 64, 8, false, 0, 0);
+		AddressMap& plain = *new AddressMap("plain" + to_string(n));
+		vector<addr_struct> ranges;
+		//Mapped in a shuffled order, with holes between the targets
+		for (unsigned i = 0; i < n; i++) {
+			unsigned target = (i * 7919) % n;
+			uint64_t base = 0x10000000 + target * 2 * SIZE;
+			ic.set_mmapped_output(target, base, SIZE);
+			plain.addRange(base, SIZE, target);
+			ranges.push_back({ base, base + SIZE - 1, SIZE, target, "" });
+		}
+		plain.compile();
+
+		//Memory interleaved over every target
+		AddressMap& interleaved = *new AddressMap("interleaved" + to_string(n));
+		vector<int32_t> targets(n);
+		for (unsigned i = 0; i < n; i++) targets[i] = i;
+		interleaved.addInterleavedRange(0x80000000, n * SIZE, GRANULE, targets);
+		interleaved.compile();
+
+		vector<uint64_t> addrs(ITERATIONS), mem(ITERATIONS);
+		uint64_t rng = 1;
+		for (uint64_t i = 0; i < ITERATIONS; i++) {
+			rng = rng * 6364136223846793005ull + 1442695040888963407ull;
+			addrs[i] = 0x10000000 + ((rng >> 40) % n) * 2 * SIZE + ((rng >> 20) % SIZE & ~7ull);
+			mem[i] = 0x80000000 + (rng >> 24) % (n * SIZE);
+		}
+
+		bench("BM_Map_Linear" + suffix, ITERATIONS, [&](uint64_t i) {
+			for (auto& as: ranges) {
+				if (addrs[i] >= as.base_addr && addrs[i] <= as.end_addr) return (int64_t)as.port;
+			}
+			return (int64_t)-1;
+		});
+		bench("BM_Map_AddressMap" + suffix, ITERATIONS, [&](uint64_t i) { return (int64_t)plain.decode(addrs[i], 8); });
+		bench("BM_Map_Coherent" + suffix, ITERATIONS, [&](uint64_t i) {
+			const addr_struct* output = ic.getMMappedOutput(addrs[i]);
+			return output ? (int64_t)output->port : -1;
+		});
+
+		bench("BM_Interleaved_Linear" + suffix, ITERATIONS, [&](uint64_t i) {
+			for (unsigned t = 0; t < n; t++) {
+				if (mem[i] >= 0x80000000 && mem[i] < 0x80000000 + n * SIZE
+						&& ((mem[i] - 0x80000000) / GRANULE) % n == t) return (int64_t)t;
+			}
+			return (int64_t)-1;
+		});
+		bench("BM_Interleaved_AddressMap" + suffix, ITERATIONS, [&](uint64_t i) { return (int64_t)interleaved.decode(mem[i]); });
+	}
+	return 0;
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/*
+ * Nanoseconds per b_transport of a 64 byte access through an interconnect
+ * with PORTS targets, reported in the same layout as Google Benchmark.
+ * Accesses go to random targets, through a bus without contention model,
+ * one with a bandwidth on every port, and one which also limits the
+ * outstanding transactions to 4 and 16. The targets only add a latency,
+ * so that the cost measured is that of the interconnect.
+ */
+
+#include "Bench.hpp"
+#include "interconnect.hpp"
+#include <algorithm>
+
+using namespace vpsim;
+using namespace sc_core;
+using namespace std;
+
+static const int PORTS = 8;
+static const uint64_t ITERATIONS = 1 << 22;
+static const uint64_t SIZE = 0x1000;
+
+class NullTarget : public sc_module
+{
+public:
+	tlm_utils::simple_target_socket<NullTarget> socket;
+
+	NullTarget(sc_module_name name): sc_module(name), socket("socket") {
+		socket.register_b_transport(this, &NullTarget::b_transport);
+	}
+
+	void b_transport(tlm::tlm_generic_payload& trans, sc_time& delay) {
+		delay += sc_time(50, SC_NS);
+		trans.set_response_status(tlm::TLM_OK_RESPONSE);
+	}
+};
+
+//Modules are not destroyed before the end of the elaboration
+static BenchInitiator& build(const string& name, uint32_t bytesPerCycle, uint32_t maxOutstanding) {
+	BenchInitiator& cpu = *new BenchInitiator((name + "_cpu").c_str());
+	interconnect& bus = *new interconnect(name.c_str(), 1, PORTS);
+	cpu.getInitiatorSocket()[0]->bind(bus.socket_in[0]);
+	for (int i = 0; i < PORTS; i++) {
+		NullTarget& mem = *new NullTarget((name + "_mem" + to_string(i)).c_str());
+		bus.set_socket_out_addr(i, i * SIZE, SIZE);
+		bus.set_port_bandwidth(i, bytesPerCycle, sc_time(1, SC_NS));
+		bus.set_port_max_outstanding(i, maxOutstanding);
+		bus.socket_out[i].bind(mem.socket);
+	}
+	return cpu;
+}
+
+int sc_main(int argc, char* argv[])
+{
+	const pair<string, pair<uint32_t, uint32_t>> configs[] = {
+		{ "NoContention", { 0, 0 } },
+		{ "Bandwidth", { 16, 0 } },
+		{ "Outstanding/4", { 16, 4 } },
+		{ "Outstanding/16", { 16, 16 } } };
+
+	vector<BenchInitiator*> cpus;
+	for (auto& config : configs) {
+		string name = config.first;
+		replace(name.begin(), name.end(), '/', '_');
+		cpus.push_back(&build(name, config.second.first, config.second.second));
+	}
+
+	vector<uint64_t> addrs(ITERATIONS);
+	uint64_t rng = 1;
+	for (uint64_t i = 0; i < ITERATIONS; i++) {
+		rng = rng * 6364136223846793005ull + 1442695040888963407ull;
+		addrs[i] = ((rng >> 40) % PORTS) * SIZE + ((rng >> 20) % (SIZE / 64)) * 64;
+	}
+
+	benchHeader();
+
+	unsigned char data[64];
+	tlm::tlm_generic_payload trans;
+	trans.set_read();
+	trans.set_data_ptr(data);
+	trans.set_data_length(sizeof(data));
+
+	double baseline = 0;
+	for (size_t c = 0; c < cpus.size(); c++) {
+		BenchInitiator& cpu = *cpus[c];
+		//Issued back to back by an initiator running ahead of the simulated time
+		sc_time local = SC_ZERO_TIME;
+		double ns = bench("BM_Transport_" + configs[c].first, ITERATIONS, [&](uint64_t i) {
+			trans.set_address(addrs[i]);
+			sc_time delay = local;
+			(*cpu.getInitiatorSocket()[0])->b_transport(trans, delay);
+			local += sc_time(1, SC_NS);
+		});
+		if (!c) baseline = ns;
+		else cout << "  overhead " << setprecision(1) << 100 * (ns - baseline) / baseline << "%" << endl;
+	}
+	return 0;
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/*
+ * Nanoseconds per address decode of an interconnect with N mapped targets,
+ * N from 4 to MAX_TARGETS, reported in the same layout as Google Benchmark.
+ * Accesses either jump to a random target every time, or stay on a target
+ * for RUN_LENGTH accesses like an initiator working on a device. Each
+ * pattern is decoded with a linear scan of the ranges (the former decoder),
+ * with the sorted decode table alone, and with the per input socket last hit.
+ * Only get_port is measured, so the interconnect is never bound nor started.
+ */
+
+#include "Bench.hpp"
+#include "interconnect.hpp"
+
+using namespace vpsim;
+using namespace sc_core;
+using namespace std;
+
+static const unsigned MAX_TARGETS = 1024;
+static const unsigned RUN_LENGTH = 16;
+static const uint64_t ITERATIONS = 1 << 22;
+static const uint64_t SIZE = 0x1000;
+
+int sc_main(int argc, char* argv[])
+{
+	benchHeader();
+
+	for (unsigned n = 4; n <= MAX_TARGETS; n *= 4) {
+		//Modules are not destroyed before the end of the elaboration
+		interconnect& bus = *new interconnect(("bus" + to_string(n)).c_str(), 1, n);
+		vector<addr_space_type> ranges;
+		//Mapped in a shuffled order, with holes between the targets
+		for (unsigned i = 0; i < n; i++) {
+			unsigned target = (i * 7919) % n;
+			uint64_t base = 0x10000000 + target * 2 * SIZE;
+			bus.set_socket_out_addr(target, base, SIZE);
+			ranges.push_back({ base, base + SIZE - 1, SIZE, target });
+		}
+
+		vector<uint64_t> random(ITERATIONS), runs(ITERATIONS);
+		uint64_t rng = 1;
+		for (uint64_t i = 0; i < ITERATIONS; i++) {
+			rng = rng * 6364136223846793005ull + 1442695040888963407ull;
+			uint64_t offset = (rng >> 20) % SIZE & ~7ull;
+			random[i] = 0x10000000 + ((rng >> 40) % n) * 2 * SIZE + offset;
+			runs[i] = i % RUN_LENGTH ? (runs[i - 1] & ~(SIZE - 1)) + offset : random[i];
+		}
+
+		const pair<vector<uint64_t>*, string> patterns[] = {
+			{ &random, "Random" },
+			{ &runs, "Runs" } };
+
+		for (auto& pattern : patterns) {
+			const vector<uint64_t>& addrs = *pattern.first;
+			const string suffix = pattern.second + "/" + to_string(n);
+
+			bench("BM_Decode_Linear_" + suffix, ITERATIONS, [&](uint64_t i) {
+				for (auto& as: ranges) {
+					if (addrs[i] >= as.base_addr && addrs[i] + 7 <= as.end_addr) return (int32_t)as.port;
+				}
+				return bus.mDefaultRoute;
+			});
+			bench("BM_Decode_Table_" + suffix, ITERATIONS, [&](uint64_t i) { return bus.get_port(addrs[i], 8); });
+			bench("BM_Decode_LastHit_" + suffix, ITERATIONS, [&](uint64_t i) { return bus.get_port(addrs[i], 8, 0); });
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/*
+ * Nanoseconds per mesh latency lookup of an interconnect modelling an NxN
+ * mesh, N from 4 to MAX_SIDE, reported in the same layout as Google Benchmark.
+ * Every node holds a memory controller, a source CPU and a home node.
+ * Accesses come from a random CPU, or from no CPU (a home node), to a random
+ * address. Each is resolved with linear scans of the registered nodes and a
+ * Manhattan distance (the former model), and with the node tables and the
+ * hop matrix. Only the lookup is measured, so the interconnect is never bound
+ * nor started.
+ */
+
+#include "Bench.hpp"
+#include "interconnect.hpp"
+#include "CosimExtensions.hpp"
+
+using namespace vpsim;
+using namespace sc_core;
+using namespace std;
+
+static const int MAX_SIDE = 16;
+static const uint64_t ITERATIONS = 1 << 22;
+static const uint64_t SIZE = 0x100000;
+
+int sc_main(int argc, char* argv[])
+{
+	benchHeader();
+
+	for (int side = 4; side <= MAX_SIDE; side *= 2) {
+		const int nodes = side * side;
+		//Modules are not destroyed before the end of the elaboration
+		interconnect& mesh = *new interconnect(("mesh" + to_string(side)).c_str(), 1, 1);
+		mesh.set_is_mesh(true);
+		mesh.set_mesh_coord(side, side);
+		mesh.set_router_latency(2);
+		mesh.set_socket_out_addr(0, 0, nodes * SIZE);
+		//Registered in a shuffled order
+		for (int i = 0; i < nodes; i++) {
+			int node = (i * 7919) % nodes;
+			mesh.register_mem_ctrl(node * SIZE, SIZE, node);
+			mesh.register_source(node, node);
+			mesh.register_hn_input(node * SIZE, SIZE, node);
+		}
+
+		vector<uint64_t> addrs(ITERATIONS);
+		vector<SourceCpuExtension> sources(ITERATIONS);
+		uint64_t rng = 1;
+		for (uint64_t i = 0; i < ITERATIONS; i++) {
+			rng = rng * 6364136223846793005ull + 1442695040888963407ull;
+			addrs[i] = (rng >> 16) % (nodes * SIZE);
+			sources[i].type = 0;
+			sources[i].cpu_id = (rng >> 48) % nodes;
+			sources[i].time_stamp = SC_ZERO_TIME;
+		}
+
+		tlm::tlm_generic_payload trans;
+		const pair<bool, string> patterns[] = {
+			{ true, "Cpu" },
+			{ false, "HomeNode" } };
+
+		for (auto& pattern : patterns) {
+			const bool fromCpu = pattern.first;
+			const string suffix = pattern.second + "/" + to_string(side) + "x" + to_string(side);
+
+			bench("BM_Mesh_Scan_" + suffix, ITERATIONS, [&](uint64_t i) {
+				uint64_t from = fromCpu ? mesh.get_id_by_id(sources[i].cpu_id) : mesh.get_hn_id_by_address(addrs[i]);
+				uint64_t to = mesh.get_id_by_address(addrs[i]);
+				int dist = abs((int)(from % side) - (int)(to % side)) + abs((int)(from / side) - (int)(to / side));
+				return mesh.mRouterLatency * dist;
+			});
+			bench("BM_Mesh_Matrix_" + suffix, ITERATIONS, [&](uint64_t i) {
+				if (fromCpu) trans.set_extension<SourceCpuExtension>(&sources[i]);
+				sc_time delay = mesh.get_mesh_latency(trans, addrs[i]);
+				if (fromCpu) trans.clear_extension(&sources[i]);
+				return delay;
+			});
+		}
+	}
+	return 0;
+}
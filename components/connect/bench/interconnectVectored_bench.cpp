@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/*
+ * Nanoseconds per guest memcpy of COPY_SIZE bytes, line by line, through an
+ * interconnect and two memories, reported in the same layout as Google
+ * Benchmark. Each copy is done either with one target_mem_access per line
+ * and direction, or with one vectored transaction per direction.
+ * DMI is disabled so that every access goes through b_transport.
+ */
+
+#include "Bench.hpp"
+#include "interconnect.hpp"
+#include "memory.hpp"
+
+using namespace vpsim;
+using namespace sc_core;
+using namespace std;
+
+static const uint64_t SRC_BASE = 0x00000000;
+static const uint64_t DST_BASE = 0x10000000;
+static const uint64_t MEM_SIZE = 0x100000;
+static const uint32_t LINE = 64;
+
+int sc_main(int argc, char* argv[])
+{
+	BenchInitiator cpu("cpu");
+	interconnect bus("bus", 1, 2);
+	memory src("src", MEM_SIZE);
+	memory dst("dst", MEM_SIZE);
+
+	src.setBaseAddress(SRC_BASE);
+	dst.setBaseAddress(DST_BASE);
+	bus.set_socket_out_addr(0, SRC_BASE, MEM_SIZE);
+	bus.set_socket_out_addr(1, DST_BASE, MEM_SIZE);
+	cpu.getInitiatorSocket()[0]->bind(bus.socket_in[0]);
+	bus.socket_out[0].bind(src.mTargetSocket);
+	bus.socket_out[1].bind(dst.mTargetSocket);
+	cpu.setForceLt(true);
+	sc_start(SC_ZERO_TIME);
+
+	sc_time delay = SC_ZERO_TIME;
+
+	benchHeader();
+
+	const uint32_t sizes[] = { 256, 4096, 65536 };
+	for (uint32_t size : sizes) {
+		const uint32_t lines = size / LINE;
+		const uint64_t iterations = (1 << 26) / size;
+		vector<unsigned char> buffer(size);
+		vector<VectoredSegment> rd(lines), wr(lines);
+
+		bench("BM_Memcpy_PerLine/" + to_string(size), iterations, [&](uint64_t i) {
+			uint64_t off = (i * size) % MEM_SIZE;
+			for (uint32_t l = 0; l < lines; l++)
+				cpu.target_mem_access(0, SRC_BASE + off + l * LINE, LINE, &buffer[l * LINE], READ, delay);
+			for (uint32_t l = 0; l < lines; l++)
+				cpu.target_mem_access(0, DST_BASE + off + l * LINE, LINE, &buffer[l * LINE], WRITE, delay);
+		});
+
+		bench("BM_Memcpy_Vectored/" + to_string(size), iterations, [&](uint64_t i) {
+			uint64_t off = (i * size) % MEM_SIZE;
+			for (uint32_t l = 0; l < lines; l++) {
+				rd[l] = { SRC_BASE + off + l * LINE, LINE, &buffer[l * LINE] };
+				wr[l] = { DST_BASE + off + l * LINE, LINE, &buffer[l * LINE] };
+			}
+			cpu.target_mem_access_vectored(0, rd, READ, delay);
+			cpu.target_mem_access_vectored(0, wr, WRITE, delay);
+		});
+
+		//Interleaved copy: every transaction alternates between both memories
+		bench("BM_MemcpyInterleaved_Vectored/" + to_string(size), iterations, [&](uint64_t i) {
+			uint64_t off = (i * size) % MEM_SIZE;
+			for (uint32_t l = 0; l < lines; l++) {
+				uint64_t base = (l & 1) ? DST_BASE : SRC_BASE;
+				rd[l] = { base + off + l * LINE, LINE, &buffer[l * LINE] };
+			}
+			cpu.target_mem_access_vectored(0, rd, READ, delay);
+		});
+	}
+
+	return 0;
+}
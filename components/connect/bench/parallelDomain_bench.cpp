@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/*
+ * Overhead and scaling of the ParallelDomain and ParallelBridge machinery:
+ * wall-clock time to run N synthetic clusters, N from 1 to MAX_CLUSTERS, on
+ * one host thread then on one host thread per cluster. No CPU model can be a
+ * cluster yet, so the clusters are written for the benchmark: each executes
+ * blocks of BLOCK_NS of private work (some host computation), and now and
+ * then loads or stores a shared memory through its ParallelBridge and an
+ * interconnect. The figures bound what the domain costs and allows, they are
+ * not the speedup of a simulated platform. The checksum of the final cluster
+ * states must not depend on the number of host threads.
+ * A platform can only be elaborated once per process, so each run is done in
+ * a child process.
+ */
+
+#include "InitiatorIf.hpp"
+#include "ParallelBridge.hpp"
+#include "ParallelDomain.hpp"
+#include "interconnect.hpp"
+#include "memory.hpp"
+#include "quantum.hpp"
+#include <chrono>
+#include <iomanip>
+#include <sys/wait.h>
+
+using namespace vpsim;
+using namespace sc_core;
+using namespace std;
+
+static const unsigned MAX_CLUSTERS = 64;
+static const unsigned BLOCKS = 4000;
+static const unsigned BLOCK_NS = 10;
+static const unsigned WORK_PER_BLOCK = 500;
+static const unsigned ACCESS_PERIOD = 16;
+static const sc_time QUANTUM(1, SC_US);
+static const uint64_t MEM_SIZE = 0x100000;
+static const uint64_t SEED = 1;
+
+class BenchCluster : public sc_module, public InitiatorIf
+{
+public:
+	ParallelQuantumKeeper mQuantumKeeper;
+	ParallelBridge mBridge;
+	uint64_t mState;
+
+	BenchCluster(sc_module_name name, ParallelDomain& domain, unsigned id):
+		sc_module(name),
+		InitiatorIf(string(name), 0, true, 1),
+		mBridge("bridge", domain, domain.addCluster([this]{ run(); }), mQuantumKeeper),
+		mState(SEED * 0x9E3779B97F4A7C15ull + id)
+	{
+		mQuantumKeeper.setParallelDomain(&domain, mBridge.getCluster());
+		setForceLt(true);
+		getInitiatorSocket()[0]->bind(mBridge.socket_in);
+	}
+
+	void run() {
+		for (unsigned block = 0; block < BLOCKS; block++) {
+			for (unsigned i = 0; i < WORK_PER_BLOCK; i++) {
+				mState = mState * 6364136223846793005ull + 1442695040888963407ull;
+				mState ^= mState >> 29;
+			}
+			mQuantumKeeper += sc_time(BLOCK_NS, SC_NS);
+			mQuantumKeeper.sync();
+
+			if (mState % ACCESS_PERIOD == 0) {
+				sc_time delay = SC_ZERO_TIME;
+				uint64_t value = mState;
+				uint64_t addr = (mState >> 16) % MEM_SIZE & ~7ull;
+				ACCESS_TYPE rw = (mState >> 8) & 1 ? WRITE : READ;
+				tlm_error_checking(target_mem_access(0, addr, 8, (unsigned char*)&value, rw, delay));
+				mState ^= value;
+				mQuantumKeeper += delay;
+			}
+		}
+	}
+};
+
+static void runConfiguration(unsigned clusters, unsigned hostThreads, const string& name) {
+	ParallelDomain domain("domain", QUANTUM, hostThreads);
+	interconnect bus("bus", clusters, 1);
+	memory mem("mem", MEM_SIZE);
+
+	vector<BenchCluster*> clusterList;
+	for (unsigned i = 0; i < clusters; i++) {
+		BenchCluster* cluster = new BenchCluster(("cluster" + to_string(i)).c_str(), domain, i);
+		cluster->mBridge.socket_out.bind(bus.socket_in[i]);
+		clusterList.push_back(cluster);
+	}
+	mem.setBaseAddress(0);
+	bus.set_socket_out_addr(0, 0, MEM_SIZE);
+	bus.socket_out[0].bind(mem.mTargetSocket);
+
+	auto start = chrono::steady_clock::now();
+	sc_start();
+	auto stop = chrono::steady_clock::now();
+
+	uint64_t checksum = 0;
+	for (BenchCluster* cluster : clusterList) checksum ^= cluster->mState;
+	double ms = chrono::duration<double, milli>(stop - start).count();
+
+	cout << left << setw(36) << name << right
+	     << setw(12) << fixed << setprecision(1) << ms << " ms"
+	     << setw(20) << hex << checksum << dec << endl;
+}
+
+int sc_main(int argc, char* argv[])
+{
+	cout << left << setw(36) << "Benchmark" << right << setw(15) << "Wall time" << setw(20) << "Checksum" << endl;
+	cout << string(71, '-') << endl;
+
+	for (unsigned clusters = 1; clusters <= MAX_CLUSTERS; clusters *= 2) {
+		const pair<unsigned, string> modes[] = {
+			{ 1, "BM_ParallelDomain_OneThread/" },
+			{ 0, "BM_ParallelDomain_ThreadPerCluster/" } };
+
+		for (auto& mode : modes) {
+			cout << flush;
+			pid_t pid = fork();
+			if (pid < 0) throw runtime_error("fork failed");
+			if (pid == 0) {
+				runConfiguration(clusters, mode.first, mode.second + to_string(clusters));
+				cout << flush;
+				_exit(0);
+			}
+			waitpid(pid, nullptr, 0);
+		}
+	}
+	return 0;
+}
@@ -23,6 +23,7 @@
 #include "TargetIf.hpp"
 #include "InitiatorIf.hpp"
 #include "DmiKeeper.hpp"
+#include "AddressMap.hpp"
 #include "CoherenceExtension.hpp"
 
 using namespace std;
@@ -30,8 +31,8 @@ using namespace std;
 namespace vpsim {
 
   struct id_struct      { string name; idx_t id; uint32_t port; idx_t position; };
-  struct addr_struct    {         uint64_t base_addr; uint64_t end_addr; uint64_t offset; uint32_t port; };
-  struct id_addr_struct { idx_t id; uint64_t base_addr; uint64_t end_addr; uint64_t offset; uint32_t port; };
+  struct addr_struct    {         uint64_t base_addr; uint64_t end_addr; uint64_t offset; uint32_t port; string name; };
+  struct id_addr_struct { idx_t id; uint64_t base_addr; uint64_t end_addr; uint64_t offset; uint32_t port; string name; };
 
   class CoherenceInterconnect: public sc_module,
                                public Logger,
@@ -74,6 +75,15 @@ namespace vpsim {
     vector<uint64_t> HomeCoherentCountOut;
     vector<uint64_t> TotalCoherentCountOut;
 
+    /**
+     * DMI, per input socket (cache inputs, then home inputs, then device inputs)
+    */
+    DmiKeeper mDmiGranted;  // regions granted through the interconnect
+    bool mDmiUntracked;     // a region was granted that mDmiGranted does not hold
+    vector<uint64_t> DmiGrantCount;
+    vector<uint64_t> DmiDenyCount;
+    vector<uint64_t> DmiInvalidateCount;
+
     /**
      * NoC performance counters
     */
@@ -104,7 +114,7 @@ namespace vpsim {
     uint64_t         RamLastAddr;    //RAM Last address (not included) used for interleaving
     uint32_t         IndexFirstMemoryController;
 
-    using SimpleInSocket  = tlm_utils::simple_target_socket<CoherenceInterconnect>;
+    using SimpleInSocket  = tlm_utils::simple_target_socket_tagged<CoherenceInterconnect>;
     using SimpleOutSocket = tlm_utils::simple_initiator_socket<CoherenceInterconnect>;
 
 
@@ -114,6 +124,16 @@ namespace vpsim {
     vector<tuple<uint64_t, mesh_pos>> mDeviceIDs;
     vector<tuple<uint64_t, uint64_t, mesh_pos>> mHomeIDs;
 
+    /**
+     * Address decoding, compiled from the outputs and the registered controllers
+    */
+    bool mMapsValid;            // false until the maps below are built
+    AddressMap mMMappedMap;     // index in MMappedOutputs
+    AddressMap mHomeOutputMap;  // home output socket, interleaved over the RAM range with SLC interleaving
+    AddressMap mMemCtrlMap;     // index in mAddressIDs, interleaved over the RAM range with memory interleaving
+    AddressMap mHomeCtrlMap;    // index in mHomeIDs, interleaved over the RAM range with SLC interleaving
+    void build_address_maps ();
+
     /**
      * a Mesh NoC model for NoC latency computation
     */
@@ -173,6 +193,10 @@ namespace vpsim {
     inline bool isCoherent () { return IsCoherent; }
     inline uint32_t getMMappedCount () { return MMappedCount;  }
 
+    inline uint64_t getDmiGrantCount      (idx_t in_port) { return DmiGrantCount[in_port];      }
+    inline uint64_t getDmiDenyCount       (idx_t in_port) { return DmiDenyCount[in_port];       }
+    inline uint64_t getDmiInvalidateCount (idx_t in_port) { return DmiInvalidateCount[in_port]; }
+
     inline uint64_t getReadMemoryCount  (idx_t port) { return MMappedReadCountOut[port];  }
     inline uint64_t getWriteMemoryCount (idx_t port) { return MMappedWriteCountOut[port]; }
 
@@ -201,12 +225,14 @@ namespace vpsim {
     ~CoherenceInterconnect ();
     SC_HAS_PROCESS (CoherenceInterconnect);
 
+    void end_of_elaboration () override;
+
     /**
     * Set functions
     */
     void set_cache_output   (uint32_t num_port, idx_t id);
-    void set_mmapped_output (uint32_t num_port,         uint64_t base_addr, uint64_t offset);
-    void set_home_output    (uint32_t num_port, idx_t id, uint64_t base_addr, uint64_t offset);
+    void set_mmapped_output (uint32_t num_port,         uint64_t base_addr, uint64_t offset, string target_name = "");
+    void set_home_output    (uint32_t num_port, idx_t id, uint64_t base_addr, uint64_t offset, string target_name = "");
     void set_latency (sc_time val);
     void set_enable_latency (bool val);
 
@@ -243,15 +269,11 @@ namespace vpsim {
     void set_ram_last_addr (uint64_t lastAddr);
     void set_memory_word_length (uint32_t wordLengthInByte);
     void set_first_memory_controller ();
-    mesh_pos (CoherenceInterconnect::*get_noc_pos_by_address) (uint64_t addr, size_t& index);
-    mesh_pos get_noc_pos_by_address_without_interleave (uint64_t addr, size_t& index);
-    mesh_pos get_noc_pos_by_address_with_interleave (uint64_t addr, size_t& index);
+    mesh_pos get_noc_pos_by_address (uint64_t addr, size_t& index);
     mesh_pos get_noc_pos_by_id (idx_t id);
     mesh_pos get_device_noc_pos_by_id (idx_t id);
-    mesh_pos (CoherenceInterconnect::*get_home_pos_by_address) (uint64_t addr);
-    mesh_pos get_home_pos_by_address_without_interleave (uint64_t addr);
-    mesh_pos get_home_pos_by_address_with_interleave (uint64_t addr);
-    uint64_t computeNoCLatency (bool isHome, bool isIdMapped, uint64_t addr, idx_t src_id, set<idx_t> dst_ids);
+    mesh_pos get_home_pos_by_address (uint64_t addr);
+    uint64_t computeNoCLatency (bool isHome, bool isIdMapped, uint64_t addr, idx_t src_id, const SharerSet& dst_ids);
     void computeNoCPerformance (uint64_t distance, sc_time latency);
 
     void FillInitTotalStats(idx_t id, mesh_pos src_pos, uint64_t dist, sc_time lat);
@@ -269,8 +291,8 @@ namespace vpsim {
     sc_time QueueWaitingTime(sc_time wait, sc_time router_latency, sc_time link_latency, sc_time time_interval, uint64_t queue_nbr_packets);
     sc_time PacketLatency(sc_time total_wait, sc_time router_latency, sc_time link_latency, uint64_t nbr_hops);
     sc_time ComputePacketLatency();
-    vector <mesh_pos> GetDestinations(tlm::tlm_generic_payload& trans, bool isHome, bool isIdMapped, set<idx_t> dst_ids);
-    void NetworkTimingModel(tlm::tlm_generic_payload& trans, sc_time trans_time_stamp, sc_time time_interval,bool isHome, bool isIdMapped, uint32_t nbFlits, mesh_pos src_pos, set<idx_t> dst_ids, bool device = false);
+    vector <mesh_pos> GetDestinations(tlm::tlm_generic_payload& trans, bool isHome, bool isIdMapped, const SharerSet& dst_ids);
+    void NetworkTimingModel(tlm::tlm_generic_payload& trans, sc_time trans_time_stamp, sc_time time_interval,bool isHome, bool isIdMapped, uint32_t nbFlits, mesh_pos src_pos, const SharerSet& dst_ids, bool device = false);
 
     void PrintPath(route path);
     void PrintPacketBuffer();
@@ -280,8 +302,16 @@ namespace vpsim {
      * TLM 2.0 communication interface
     */
     void sendTransactionToHome    (tlm::tlm_generic_payload& trans, sc_time& delay);
-    void sendTransactionToCache   (tlm::tlm_generic_payload& trans, set<idx_t> targetIds, sc_time& delay);
+    void sendTransactionToCache   (tlm::tlm_generic_payload& trans, const SharerSet& targetIds, sc_time& delay);
     void sendTransactionToMMapped (tlm::tlm_generic_payload& trans, sc_time& delay);
+    const addr_struct* getMMappedOutput (uint64_t addr);
+    SimpleInSocket& getInputSocket (uint32_t in_port);
+
+    // Callbacks of the input sockets, in_port numbering cache inputs, then home inputs, then device inputs
+    void b_transport_in (int in_port, tlm::tlm_generic_payload& trans, sc_time& delay);
+    void b_transport_device_in (int in_port, tlm::tlm_generic_payload& trans, sc_time& delay);
+    bool get_direct_mem_ptr_in (int in_port, tlm::tlm_generic_payload& trans, tlm::tlm_dmi& dmi_data);
+    unsigned int transport_dbg_in (int in_port, tlm::tlm_generic_payload& trans);
 
     void b_transport (tlm::tlm_generic_payload& trans, sc_time& delay);
     void b_transport_device (tlm::tlm_generic_payload& trans, sc_time& delay);
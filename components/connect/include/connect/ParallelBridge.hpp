@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef PARALLELBRIDGE_HPP_
+#define PARALLELBRIDGE_HPP_
+
+#include "global.hpp"
+#include "quantum.hpp"
+#include "ParallelDomain.hpp"
+#include "CoherenceExtension.hpp"
+
+namespace vpsim
+{
+	//! ParallelBridge is the way out of a cluster of a ParallelDomain: bound between the cluster (CPU, private
+	//! caches) and the shared components (interconnect, memories), it forwards each transaction while holding
+	//! the shared access lock of the domain, at the current time of the cluster keeper plus the annotated delay.
+	//! DMI is refused across the bridge, as direct pointers would bypass the ordering of the shared accesses.
+	//! Messages of the coherence protocol are rejected: the caches of a cluster must not be coherent, as the
+	//! interconnect would snoop them from the thread of another cluster.
+	class ParallelBridge : public sc_module,
+						   public tlm::tlm_fw_transport_if<tlm::tlm_base_protocol_types>
+	{
+	private:
+		ParallelDomain& mDomain;
+		unsigned mCluster;
+		ParallelQuantumKeeper& mKeeper;
+
+		//Statistics
+		uint64_t mTransportCount;
+
+		//! holds the shared access lock of the domain until unlock, or until it is destroyed when
+		//! the access throws: the lock is then released without throwing, not to terminate the unwinding
+		struct SharedAccess {
+			ParallelBridge& Bridge;
+			bool Held;
+			SharedAccess(ParallelBridge& bridge, const sc_time& t);
+			~SharedAccess();
+			void unlock(); //!< throws ParallelDomain::Stopped when the domain is destroyed meanwhile
+		};
+
+	public:
+		tlm_utils::simple_target_socket<ParallelBridge> socket_in;
+		tlm_utils::simple_initiator_socket<ParallelBridge> socket_out;
+
+		//! @param keeper : the keeper of the cluster, which gives the time of the transactions
+		ParallelBridge ( sc_module_name name, ParallelDomain& domain, unsigned cluster, ParallelQuantumKeeper& keeper );
+
+		unsigned getCluster() { return mCluster; }
+		uint64_t getTransportCount() { return mTransportCount; }
+
+		//---------------------------------------------------
+		//Forward interface
+		void b_transport ( tlm::tlm_generic_payload& trans, sc_time& delay );
+
+		bool get_direct_mem_ptr ( tlm::tlm_generic_payload& trans, tlm::tlm_dmi& dmi_data );
+
+		unsigned int transport_dbg ( tlm::tlm_generic_payload& trans );
+
+		tlm::tlm_sync_enum nb_transport_fw ( tlm::tlm_generic_payload& trans, tlm::tlm_phase& phase, sc_time& t );
+	};
+}
+
+#endif /* PARALLELBRIDGE_HPP_ */
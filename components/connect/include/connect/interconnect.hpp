@@ -20,9 +20,13 @@
 #include "global.hpp"
 #include <list>
 #include "log.hpp"
+#include "DmiKeeper.hpp"
+#include "AddressMap.hpp"
 
 namespace vpsim
 {
+	struct VectoredExtension;
+
 	struct addr_space_type {
 		uint64_t base_addr;
 		uint64_t end_addr;
@@ -38,7 +42,11 @@ namespace vpsim
 	private:
 		string NAME;
 		DIAG_LEVEL DIAGNOSTIC_LEVEL;
-		std::vector < addr_space_type > output_ports_t;
+
+		//Address decoding
+		AddressMap mDecodeMap;                        //!< output port of each mapped range
+		std::vector < int32_t > mLastHit;             //!< per input socket, region of mDecodeMap of the last hit, -1 if none
+		uint64_t mLastHitCount;
 		sc_time ACCESS_LATENCY;
 		bool ENABLE_LATENCY;
 
@@ -46,6 +54,95 @@ namespace vpsim
 		std::vector<uint64_t> write_count_out;
 		std::vector<uint64_t> read_count_out;
 
+		//Contention model of an output port: transfers are serialized at its bandwidth and at most
+		//maxOutstanding transactions are in flight, an access waiting until the port is free.
+		//Either limit can be set without the other
+		struct PortContention {
+			uint32_t bytesPerCycle;                   //!< 0 if transfers are not serialized
+			sc_time cycle;
+			uint32_t maxOutstanding;                  //!< 0 if unlimited
+			sc_time nextFree;                         //!< end of the last transfer scheduled on the port
+			std::vector < sc_time > completions;      //!< completion times of the last maxOutstanding transactions
+			uint32_t head;                            //!< oldest of completions, the slot of the next transaction
+			uint32_t last;                            //!< slot of the last transaction
+			uint64_t accesses;
+			uint64_t queuedCount;                     //!< accesses which had to wait
+			sc_time queueing;                         //!< total time spent waiting
+			sc_time busy;                             //!< total time spent transferring
+			uint32_t peakOccupancy;                   //!< most transactions in flight, counted if maxOutstanding is set
+		};
+		std::vector < PortContention > mContention;
+		bool mContended;                              //!< a port has a contention model
+		void update_contended ( );
+
+		//!
+		//! schedules the transfer of len bytes on num_port for an access arriving at arrival
+		//! @return the time the access waits for the port plus that of its transfer
+		//!
+		sc_time contend ( uint32_t num_port, uint32_t len, const sc_time& arrival );
+
+		//!
+		//! records the completion time of the last transaction of num_port once the target returned
+		//!
+		void release ( uint32_t num_port, const sc_time& delay );
+
+		//DMI
+		DmiKeeper mDmiGranted;                        //!< per input socket, the DMI regions granted through the interconnect
+		bool mDmiUntracked;                           //!< a region was granted that mDmiGranted does not hold
+		std::vector<uint64_t> mDmiGrantCount;
+		std::vector<uint64_t> mDmiDenyCount;
+		std::vector<uint64_t> mDmiInvalidateCount;
+
+		//Mesh model, built from the registered nodes
+		bool mMeshValid;                                //!< false until the tables below are built
+		uint32_t mMeshNodes;                            //!< mX*mY
+		AddressMap mMemNodes;                           //!< node of each memory controller range of mAddressIDs
+		AddressMap mHnNodes;                            //!< node of each home node range of mHnIDs
+		std::vector < int32_t > mSourceNodes;           //!< node of each source ID, -1 if not registered
+		std::vector < uint32_t > mHopCount;             //!< mMeshNodes x mMeshNodes hops, one row per source node
+		std::vector < sc_time > mHopLatency;            //!< mHopCount times the router latency
+
+		//!
+		//! updates the statistics and adds the latency of an access of len bytes at addr routed to num_port
+		//!
+		void account ( tlm::tlm_generic_payload& trans, uint64_t addr, uint32_t len, int32_t num_port, sc_time& delay );
+
+		//!
+		//! routes all the segments of a vectored transaction in one pass, then forwards them in order,
+		//! a vectored transaction per run of consecutive segments of the same target
+		//!
+		void b_transport_vectored ( tlm::tlm_generic_payload& trans, VectoredExtension& vec, sc_time& delay, int in_port );
+
+		//!
+		//! compiles the output address ranges, throws if two of them overlap
+		//!
+		void build_decode_table ( );
+
+		//!
+		//! builds the node tables and the hop matrix of the mesh from the registered nodes,
+		//! throws if a node is outside the mesh, if two ranges overlap or if a mapped range has no node
+		//!
+		void build_mesh_tables ( );
+		void build_mesh_nodes ( AddressMap& nodes, const std::vector<std::tuple<uint64_t, uint64_t, uint64_t>>& ranges, const char* kind );
+		uint32_t get_mesh_node ( const AddressMap& nodes, uint64_t addr, const char* kind );
+
+		//!
+		//! @return the output port in charge of addr, with [base, end] the window of addresses
+		//! routed to it around addr: its range, or for the default route, the hole between two ranges
+		//!
+		int32_t get_window ( uint64_t addr, uint64_t& base, uint64_t& end );
+
+		//!
+		//! @return the output port of the debug transfers at addr, length being reduced to the
+		//! part of the transfer this port is in charge of
+		//!
+		int32_t get_dbg_port ( uint64_t addr, uint64_t& length );
+
+		//TLM 2.0 callbacks of the input sockets, in_port being the index of the socket
+		void b_transport_in ( int in_port, tlm::tlm_generic_payload& trans, sc_time& delay );
+		bool get_direct_mem_ptr_in ( int in_port, tlm::tlm_generic_payload& trans, tlm::tlm_dmi& dmi_data );
+		unsigned int transport_dbg_in ( int in_port, tlm::tlm_generic_payload& trans );
+
 	public:
 
 		uint64_t getWriteCount(int port) { return write_count_out[port]; }
@@ -63,24 +160,39 @@ namespace vpsim
 		sc_time mRouterLatency;
 		void set_router_latency(uint64_t nanoseconds){
 			mRouterLatency=sc_time(nanoseconds, SC_NS);
+			mMeshValid=false;
 		}
 		void set_is_mesh(bool is_mesh) { mIsMesh=is_mesh; }
 		void set_mesh_coord(int x, int y) {
 			mX=x;
 			mY=y;
+			mMeshValid=false;
 		}
 		std::vector<std::tuple<uint64_t, uint64_t, uint64_t>> mAddressIDs;
 		std::vector<std::pair<uint64_t,uint64_t>> mIdIDs;
 		std::vector<std::tuple<uint64_t, uint64_t, uint64_t>> mHnIDs;
 		void register_mem_ctrl(uint64_t base, uint64_t size, uint64_t id) {
 			mAddressIDs.push_back(make_tuple(base,size,id));
+			mMeshValid=false;
 		}
 		void register_source(uint64_t src_id, uint64_t id) {
 			mIdIDs.push_back(make_pair(src_id,id));
+			mMeshValid=false;
 		}
 		void register_hn_input(uint64_t base, uint64_t size, uint64_t id) {
 			mHnIDs.push_back(make_tuple(base,size,id));
+			mMeshValid=false;
 		}
+
+		//!
+		//! @return the latency of crossing the mesh for an access at addr, from the node of the source
+		//! CPU of trans, or the home node of addr when trans has no source, to the node of addr
+		//!
+		sc_time get_mesh_latency ( tlm::tlm_generic_payload& trans, uint64_t addr );
+
+		//! @return the number of routers between two nodes of the mesh
+		uint32_t get_hop_count ( uint32_t from, uint32_t to );
+
 		uint64_t get_hn_id_by_address(uint64_t addr) {
 			for (auto& mapping: mHnIDs) {
 				if (addr >= get<0>(mapping) && addr < get<1>(mapping)+get<0>(mapping))
@@ -104,7 +216,7 @@ namespace vpsim
 		}
 		//---------------------------------------------------
 		//Ports
-		std::deque<tlm_utils::simple_target_socket<interconnect>> socket_in;
+		std::deque<tlm_utils::simple_target_socket_tagged<interconnect>> socket_in;
 		std::deque<tlm_utils::simple_initiator_socket<interconnect>> socket_out;
 
 
@@ -114,6 +226,8 @@ namespace vpsim
 		~interconnect ( ){};
 		SC_HAS_PROCESS ( interconnect );
 
+		void end_of_elaboration ( ) override;
+
 
 		//---------------------------------------------------
 		//Set functions
@@ -121,7 +235,7 @@ namespace vpsim
 		set_diagnostic_level ( DIAG_LEVEL val );
 
 		void
-		set_socket_out_addr ( uint32_t num_port, uint64_t base_addr, uint64_t offset );
+		set_socket_out_addr ( uint32_t num_port, uint64_t base_addr, uint64_t offset, string target_name = "" );
 
 		void
 		set_latency ( sc_time val );
@@ -129,14 +243,43 @@ namespace vpsim
 		void
 		set_enable_latency ( bool val );
 
+		//!
+		//! enables the contention model of an output port, bytes_per_cycle being transferred
+		//! every cycle, 0 to disable it
+		//!
+		void
+		set_port_bandwidth ( uint32_t num_port, uint32_t bytes_per_cycle, sc_time cycle );
+
+		//! limits the transactions in flight on an output port, 0 for no limit
+		void
+		set_port_max_outstanding ( uint32_t num_port, uint32_t max_outstanding );
+
 
 		//---------------------------------------------------
 		//Get functions
 		DIAG_LEVEL
 		get_diagnostic_level (  );
 
+		//!
+		//! @return the output port of the range containing [addr, addr+length), or the default route
+		//! @param in_port : input socket the access comes from, to start with its last hit, -1 if unknown
+		//!
 		int32_t
-		get_port ( uint64_t addr, uint64_t length );
+		get_port ( uint64_t addr, uint64_t length, int in_port = -1 );
+
+		uint64_t getLastHitCount() { return mLastHitCount; }
+
+		//Contention statistics of an output port
+		uint64_t getPortQueuedCount(int port) { return mContention[port].queuedCount; }
+		sc_time getPortQueueingDelay(int port) { return mContention[port].queueing; }
+		uint32_t getPortPeakOccupancy(int port) { return mContention[port].peakOccupancy; }
+		//! @return the share of the simulated time spent transferring on the port
+		double getPortUtilization(int port);
+
+		//DMI requests of an input socket granted and denied, and invalidations sent back to it
+		uint64_t getDmiGrantCount(int in_port) { return mDmiGrantCount[in_port]; }
+		uint64_t getDmiDenyCount(int in_port) { return mDmiDenyCount[in_port]; }
+		uint64_t getDmiInvalidateCount(int in_port) { return mDmiInvalidateCount[in_port]; }
 
 		sc_time
 		get_latency ( );
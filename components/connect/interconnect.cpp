@@ -17,7 +17,9 @@
 #include "interconnect.hpp"
 #include "log.hpp"
 #include <sstream>
+#include <algorithm>
 #include "MainMemCosim.hpp"
+#include "VectoredTransport.hpp"
 
 namespace vpsim {
 
@@ -30,6 +32,19 @@ interconnect::interconnect ( sc_module_name name, uint32_t nin, uint32_t nout )
 	DIAGNOSTIC_LEVEL ( DBG_L0 ),
 	ACCESS_LATENCY ( sc_time(0,SC_NS) ),
 	ENABLE_LATENCY ( false ),
+	mDecodeMap ( string(name) ),
+	mLastHitCount ( 0 ),
+	mContention ( nout ),
+	mContended ( false ),
+	mDmiGranted ( nin ),
+	mDmiUntracked ( false ),
+	mDmiGrantCount ( nin, 0 ),
+	mDmiDenyCount ( nin, 0 ),
+	mDmiInvalidateCount ( nin, 0 ),
+	mMeshValid ( false ),
+	mMeshNodes ( 0 ),
+	mMemNodes ( string(name) + ".mem_ctrl" ),
+	mHnNodes ( string(name) + ".home_node" ),
 	NUM_PORT_IN ( nin ),
 	NUM_PORT_OUT ( nout )
 {
@@ -57,12 +72,17 @@ interconnect::interconnect ( sc_module_name name, uint32_t nin, uint32_t nout )
 		socket_in.emplace_back(name_socket);
 
 		//Register functions for TLM 2.0 communications
-		socket_in[i].register_get_direct_mem_ptr ( this, &interconnect::get_direct_mem_ptr );
-		socket_in[i].register_b_transport ( this, &interconnect::b_transport );
-		socket_in[i].register_transport_dbg ( this, &interconnect::transport_dbg );
+		socket_in[i].register_get_direct_mem_ptr ( this, &interconnect::get_direct_mem_ptr_in, i );
+		socket_in[i].register_b_transport ( this, &interconnect::b_transport_in, i );
+		socket_in[i].register_transport_dbg ( this, &interconnect::transport_dbg_in, i );
+
+		mLastHit.emplace_back(-1);
 	}
 
 	mDefaultRoute=-1;
+	mIsMesh=false;
+	mX=0;
+	mY=0;
 }
 
 
@@ -81,15 +101,176 @@ interconnect::set_enable_latency ( bool val ) { ENABLE_LATENCY = val; }
 
 
 void
-interconnect::set_socket_out_addr ( uint32_t num_port, uint64_t base_addr, uint64_t offset )
+interconnect::set_port_bandwidth ( uint32_t num_port, uint32_t bytes_per_cycle, sc_time cycle )
+{
+	if (num_port >= NUM_PORT_OUT) throw runtime_error(NAME + ": no output port " + to_string(num_port));
+	if (bytes_per_cycle && cycle == SC_ZERO_TIME) throw runtime_error(NAME + ": the cycle of a port bandwidth cannot be null");
+	mContention[num_port].bytesPerCycle = bytes_per_cycle;
+	mContention[num_port].cycle = cycle;
+	update_contended ( );
+}
+
+void
+interconnect::update_contended ( )
+{
+	mContended = false;
+	for (auto& pc: mContention) mContended = mContended || pc.bytesPerCycle || pc.maxOutstanding;
+}
+
+
+void
+interconnect::set_port_max_outstanding ( uint32_t num_port, uint32_t max_outstanding )
+{
+	if (num_port >= NUM_PORT_OUT) throw runtime_error(NAME + ": no output port " + to_string(num_port));
+	PortContention& pc = mContention[num_port];
+	pc.maxOutstanding = max_outstanding;
+	pc.completions.assign ( max_outstanding, SC_ZERO_TIME );
+	pc.head = 0;
+	pc.last = 0;
+	update_contended ( );
+}
+
+
+void
+interconnect::set_socket_out_addr ( uint32_t num_port, uint64_t base_addr, uint64_t offset, string target_name )
+{
+	//An empty range cannot contain any access
+	mDecodeMap.addRange ( base_addr, offset, num_port, target_name );
+}
+
+
+void
+interconnect::end_of_elaboration ( )
+{
+	//Report overlapping ranges before the simulation starts rather than at the first access
+	build_decode_table ( );
+	if (mIsMesh) build_mesh_tables ( );
+}
+
+
+void
+interconnect::build_decode_table ( )
+{
+	mDecodeMap.compile ( );
+	for (auto& hit: mLastHit) hit = -1;
+}
+
+
+void
+interconnect::build_mesh_nodes ( AddressMap& nodes, const std::vector<std::tuple<uint64_t, uint64_t, uint64_t>>& ranges, const char* kind )
+{
+	nodes.clear();
+	for (auto& range: ranges) {
+		const uint64_t base = get<0>(range), size = get<1>(range), node = get<2>(range);
+		if (node >= mMeshNodes) {
+			stringstream ss;
+			ss << NAME << ": the " << kind << " at 0x" << hex << base << " is on node " << dec << node
+			   << ", outside the " << mX << "x" << mY << " mesh";
+			throw runtime_error(ss.str());
+		}
+		nodes.addRange ( base, size, node, kind );
+	}
+	nodes.compile();
+}
+
+
+void
+interconnect::build_mesh_tables ( )
+{
+	if (mX <= 0 || mY <= 0) {
+		throw runtime_error(NAME + ": the mesh has no node, its coordinates must be set");
+	}
+	mMeshNodes = mX * mY;
+
+	build_mesh_nodes ( mMemNodes, mAddressIDs, "memory controller" );
+	build_mesh_nodes ( mHnNodes, mHnIDs, "home node" );
+
+	mSourceNodes.clear();
+	for (auto& source: mIdIDs) {
+		if (source.second >= mMeshNodes) {
+			stringstream ss;
+			ss << NAME << ": source " << source.first << " is on node " << source.second << ", outside the " << mX << "x" << mY << " mesh";
+			throw runtime_error(ss.str());
+		}
+		if (source.first >= mSourceNodes.size()) mSourceNodes.resize ( source.first + 1, -1 );
+		if (mSourceNodes[source.first] >= 0 && mSourceNodes[source.first] != (int32_t) source.second) {
+			throw runtime_error(NAME + ": source " + to_string(source.first) + " is registered on two nodes");
+		}
+		mSourceNodes[source.first] = source.second;
+	}
+
+	//Every mapped range must be covered by memory controllers
+	if (!mDecodeMap.isCompiled()) build_decode_table ( );
+	for (size_t i=0; i<mDecodeMap.getRegionCount(); i++) {
+		const AddressMap::Region& as = mDecodeMap.getRegion(i);
+		uint64_t addr = as.base_addr, base, end;
+		for (;;) {
+			if (mMemNodes.getWindow ( addr, base, end ) < 0) {
+				stringstream ss;
+				ss << NAME << ": no memory controller registered for 0x" << hex << addr << ", in the range of port " << dec << as.target;
+				throw runtime_error(ss.str());
+			}
+			if (end >= as.end_addr) break;
+			addr = end + 1;
+		}
+	}
+
+	//Dimension-order routing: the distance between two nodes is the Manhattan distance
+	mHopCount.resize ( mMeshNodes * mMeshNodes );
+	mHopLatency.resize ( mMeshNodes * mMeshNodes );
+	for (uint32_t from=0; from<mMeshNodes; from++) {
+		for (uint32_t to=0; to<mMeshNodes; to++) {
+			const uint32_t hops = abs((int)(from % mX) - (int)(to % mX)) + abs((int)(from / mX) - (int)(to / mX));
+			mHopCount[from * mMeshNodes + to] = hops;
+			mHopLatency[from * mMeshNodes + to] = mRouterLatency * hops;
+		}
+	}
+	mMeshValid = true;
+}
+
+
+uint32_t
+interconnect::get_mesh_node ( const AddressMap& nodes, uint64_t addr, const char* kind )
 {
-	addr_space_type asp;
-	asp.base_addr = base_addr;
-	asp.end_addr = base_addr + offset - 1;
-	asp.offset = offset;
-	asp.port = num_port;
+	const int32_t node = nodes.decode ( addr );
+	if (node == AddressMap::NO_TARGET) {
+		stringstream ss;
+		ss << NAME << ": no " << kind << " registered for the address 0x" << hex << addr;
+		throw runtime_error(ss.str());
+	}
+	return node;
+}
+
 
-	output_ports_t.push_back ( asp );
+sc_time
+interconnect::get_mesh_latency ( tlm::tlm_generic_payload& trans, uint64_t addr )
+{
+	if (!mMeshValid) build_mesh_tables ( );
+
+	uint32_t from;
+	SourceCpuExtension* src=nullptr;
+	trans.get_extension<SourceCpuExtension>(src);
+	if (!src) {
+		from = get_mesh_node ( mHnNodes, addr, "home node" );
+	} else if (src->cpu_id < mSourceNodes.size() && mSourceNodes[src->cpu_id] >= 0) {
+		from = mSourceNodes[src->cpu_id];
+	} else {
+		throw runtime_error(NAME + ": no node registered for source " + to_string(src->cpu_id));
+	}
+
+	const uint32_t to = get_mesh_node ( mMemNodes, addr, "memory controller" );
+	return mHopLatency[from * mMeshNodes + to];
+}
+
+
+uint32_t
+interconnect::get_hop_count ( uint32_t from, uint32_t to )
+{
+	if (!mMeshValid) build_mesh_tables ( );
+	if (from >= mMeshNodes || to >= mMeshNodes) {
+		throw runtime_error(NAME + ": node outside the mesh");
+	}
+	return mHopCount[from * mMeshNodes + to];
 }
 
 
@@ -99,29 +280,54 @@ interconnect::get_diagnostic_level (  ) { return ( DIAGNOSTIC_LEVEL ); }
 
 
 int32_t
-interconnect::get_port ( uint64_t addr, uint64_t length )
+interconnect::get_window ( uint64_t addr, uint64_t& base, uint64_t& end )
 {
-	//Test if there is more than 1 output port
-	if (NUM_PORT_OUT>1)
-	{
-		std::list < addr_space_type >::iterator it;
-		int32_t num_port = -1;
-		for (auto& as: output_ports_t){
-			if ( ( addr >= as.base_addr ) && ( (addr+length-1) <= as.end_addr ) ) {
-				num_port = as.port;
-				return num_port;
-			}
-		}
+	if (!mDecodeMap.isCompiled()) build_decode_table ( );
 
-		if (num_port < 0){
-			//cout<<"taking default route."<<endl;
-			num_port=mDefaultRoute;
+	//In a range, otherwise the default route, between the ranges around addr
+	const int32_t index = mDecodeMap.getWindow ( addr, base, end );
+	return index >= 0 ? mDecodeMap.getTarget ( index, addr ) : mDefaultRoute;
+}
+
+
+int32_t
+interconnect::get_dbg_port ( uint64_t addr, uint64_t& length )
+{
+	uint64_t base, end;
+	int32_t num_port = get_window ( addr, base, end );
+	length = std::min ( length - 1, end - addr ) + 1;
+	return num_port;
+}
+
+
+int32_t
+interconnect::get_port ( uint64_t addr, uint64_t length, int in_port )
+{
+	//Always redirect requests to the only existing port if only one exists
+	if (NUM_PORT_OUT<=1) return 0;
+
+	if (!mDecodeMap.isCompiled()) build_decode_table ( );
+
+	const uint64_t last = addr + length - 1;
+
+	//Accesses from an initiator tend to hit the target of its previous access
+	int32_t* hint = in_port >= 0 ? &mLastHit[in_port] : nullptr;
+	if (hint && *hint >= 0 && (size_t)*hint < mDecodeMap.getRegionCount()) {
+		const AddressMap::Region& as = mDecodeMap.getRegion ( *hint );
+		if ( ( addr >= as.base_addr ) && ( last <= as.end_addr ) ) {
+			mLastHitCount++;
+			return as.target;
 		}
-		return num_port;
 	}
 
-	//Always redirect requests to the only existing port if only one exists
-	else return 0;
+	const int32_t index = mDecodeMap.find ( addr );
+	if (index >= 0 && last <= mDecodeMap.getRegion(index).end_addr) {
+		if (hint) *hint = index;
+		return mDecodeMap.getTarget ( index, addr );
+	}
+
+	//cout<<"taking default route."<<endl;
+	return mDefaultRoute;
 }
 
 
@@ -134,20 +340,108 @@ interconnect::get_enable_latency ( ) { return ENABLE_LATENCY; }
 
 
 //Statistics
+double
+interconnect::getPortUtilization ( int port )
+{
+	const PortContention& pc = mContention[port];
+	const sc_time span = std::max ( sc_time_stamp(), pc.nextFree );
+	return span == SC_ZERO_TIME ? 0.0 : pc.busy / span;
+}
+
 void
 interconnect::print_statistics ( ) {
 	for (size_t i=0; i<NUM_PORT_OUT; i++) {
 		LOG_STATS << "(" << NAME << "): port["<<i<<"]: total read = " <<read_count_out[i]<<", total write = "<<write_count_out[i]<<" (total accesses = "<<read_count_out[i]+write_count_out[i]<<")"<<endl;
+		const PortContention& pc = mContention[i];
+		if (!pc.bytesPerCycle && !pc.maxOutstanding) continue;
+		LOG_STATS << "(" << NAME << "): port["<<i<<"]: utilization = "<<100*getPortUtilization(i)<<"%, queued accesses = "<<pc.queuedCount<<"/"<<pc.accesses
+				<<", total queueing delay = "<<pc.queueing<<", peak occupancy = "<<pc.peakOccupancy<<endl;
 	}
 }
 
 //---------------------------------------------------
 //TLM 2.0 communication interface
+void
+interconnect::account ( tlm::tlm_generic_payload& trans, uint64_t addr, uint32_t len, int32_t num_port, sc_time& delay )
+{
+	//Statistics
+	if (trans.get_command () == tlm::TLM_WRITE_COMMAND)
+		write_count_out [num_port] += len ; //TODO
+	else read_count_out [num_port] += len ; //TODO
+
+	//Add timing for communication
+	if (ENABLE_LATENCY) delay += ACCESS_LATENCY;
+
+	// NoC Model
+	if (mIsMesh) delay += get_mesh_latency ( trans, addr );
+
+	//The access reaches the output port at the local time of the initiator
+	if (mContended && (mContention[num_port].bytesPerCycle || mContention[num_port].maxOutstanding))
+		delay += contend ( num_port, len, sc_time_stamp() + delay );
+}
+
+//In loosely timed simulations, accesses do not reach a port in the order of their local times.
+//A port only remembers when it is next free, so an access arriving earlier than the previous
+//one still waits for it: contention is overestimated rather than lost.
+sc_time
+interconnect::contend ( uint32_t num_port, uint32_t len, const sc_time& arrival )
+{
+	PortContention& pc = mContention[num_port];
+	//Without bandwidth, transfers take no time and only the outstanding transactions are limited
+	sc_time start = pc.bytesPerCycle ? std::max ( arrival, pc.nextFree ) : arrival;
+
+	if (pc.maxOutstanding) {
+		uint32_t occupancy = 1;
+		for (const sc_time& completion: pc.completions) occupancy += completion > arrival;
+		pc.peakOccupancy = std::max ( pc.peakOccupancy, std::min ( occupancy, pc.maxOutstanding ) );
+		//Wait for the oldest transaction to leave a slot
+		start = std::max ( start, pc.completions[pc.head] );
+	}
+
+	const sc_time transfer = pc.bytesPerCycle ? pc.cycle * (double) ((len + pc.bytesPerCycle - 1) / pc.bytesPerCycle) : SC_ZERO_TIME;
+	pc.nextFree = start + transfer;
+	if (pc.maxOutstanding) {
+		pc.completions[pc.head] = pc.nextFree;
+		pc.last = pc.head;
+		pc.head = (pc.head + 1) % pc.maxOutstanding;
+	}
+
+	pc.accesses++;
+	pc.busy += transfer;
+	if (start > arrival) {
+		pc.queuedCount++;
+		pc.queueing += start - arrival;
+	}
+	return pc.nextFree - arrival;
+}
+
+void
+interconnect::release ( uint32_t num_port, const sc_time& delay )
+{
+	PortContention& pc = mContention[num_port];
+	if (!pc.maxOutstanding) return;
+	//A transaction holds its slot until the target answered
+	sc_time& completion = pc.completions[pc.last];
+	completion = std::max ( completion, sc_time_stamp() + delay );
+}
+
 void
 interconnect::b_transport ( tlm::tlm_generic_payload& trans, sc_time& delay )
 {
+	b_transport_in ( -1, trans, delay );
+}
+
+void
+interconnect::b_transport_in ( int in_port, tlm::tlm_generic_payload& trans, sc_time& delay )
+{
+	VectoredExtension* vec = trans.get_extension<VectoredExtension>();
+	if (vec && vec->Segments.size() > 1) {
+		b_transport_vectored ( trans, *vec, delay, in_port );
+		return;
+	}
+
 	//Test the target address and dispatch to the correct output port
-    int32_t num_port = get_port ( trans.get_address(), trans.get_data_length() );
+    int32_t num_port = get_port ( trans.get_address(), trans.get_data_length(), in_port );
 
 	if (num_port==-1) {
 		stringstream ss;
@@ -190,39 +484,65 @@ interconnect::b_transport ( tlm::tlm_generic_payload& trans, sc_time& delay )
 	LOG_DEBUG(dbg2) <<NAME<<": num output port = "<<num_port<<endl;
 	LOG_DEBUG(dbg2) <<NAME<<": delay = "<<delay<<endl;
 
-	//Statistics
-	if (trans.get_command () == tlm::TLM_WRITE_COMMAND)
-		write_count_out [num_port] += trans.get_data_length () ; //TODO
-	else read_count_out [num_port] += trans.get_data_length () ; //TODO
+	account ( trans, trans.get_address(), trans.get_data_length(), num_port, delay );
 
-	//Add timing for communication
-	if (ENABLE_LATENCY) delay += ACCESS_LATENCY;
+    socket_out[num_port]->b_transport ( trans, delay );
+	if (mContended) release ( num_port, delay );
+}
 
-	// NoC Model
-	if (mIsMesh) {
-		// get transaction source ID
-		SourceCpuExtension* src=nullptr;
-		uint64_t noc_id;
-		trans.get_extension<SourceCpuExtension>(src);
-		if (!src) {
-			noc_id = get_hn_id_by_address(trans.get_address());
-		} else {
-			noc_id = get_id_by_id(src->cpu_id);
+void
+interconnect::b_transport_vectored ( tlm::tlm_generic_payload& trans, VectoredExtension& vec, sc_time& delay, int in_port )
+{
+	//Route every segment in one pass over the address map
+	const size_t count = vec.Segments.size();
+	std::vector<int32_t> ports (count);
+	bool single = true;
+	for (size_t i=0; i<count; i++) {
+		const VectoredSegment& seg = vec.Segments[i];
+		ports[i] = get_port ( seg.addr, seg.len, in_port );
+		if (ports[i]==-1) {
+			stringstream ss;
+			ss << "Not found - try to access the address 0x"<<hex<<seg.addr<<" (burst="<<dec<<seg.len<<")\n";
+			throw runtime_error(ss.str());
 		}
+		single = single && ports[i]==ports[0];
+	}
 
-		int src_x = noc_id % mX;
-		int src_y = noc_id / mX;
-
-		// dest ID
-		int id = get_id_by_address(trans.get_address());
-		int dst_x = id % mX;
-		int dst_y = id / mX;
+	//All segments go to the same target: forward the transaction as is
+	if (single) {
+		for (const VectoredSegment& seg: vec.Segments) account ( trans, seg.addr, seg.len, ports[0], delay );
+		vectored_b_transport ( [&](tlm::tlm_generic_payload& t, sc_time& d) { socket_out[ports[0]]->b_transport ( t, d ); },
+				trans, vec, delay );
+		if (mContended) release ( ports[0], delay );
+		return;
+	}
 
-		int dist = abs(src_x-dst_x) + abs(src_y-dst_y);
-		delay += mRouterLatency * dist;
+	//Otherwise forward the segments in their original order, one vectored transaction per run of
+	//consecutive segments of the same target, each run being accounted just before it is sent.
+	//When a target fails a segment, no later segment has been forwarded: the serviced segments
+	//remain the leading ones, and the initiator resumes from the first one left
+	std::vector<VectoredSegment> segments;
+	segments.swap ( vec.Segments );
+	size_t serviced = 0;
+	tlm::tlm_response_status rsp = tlm::TLM_OK_RESPONSE;
+	for (size_t first=0; first<count && rsp==tlm::TLM_OK_RESPONSE; ) {
+		const int32_t num_port = ports[first];
+		size_t end = first;
+		while (end<count && ports[end]==num_port) end++;
+
+		vec.Segments.assign ( segments.begin() + first, segments.begin() + end );
+		for (size_t i=first; i<end; i++) account ( trans, segments[i].addr, segments[i].len, num_port, delay );
+		rsp = vectored_b_transport ( [&](tlm::tlm_generic_payload& t, sc_time& d) { socket_out[num_port]->b_transport ( t, d ); },
+				trans, vec, delay );
+		if (mContended) release ( num_port, delay );
+		serviced = first + vec.Serviced;
+		first = end;
 	}
 
-    socket_out[num_port]->b_transport ( trans, delay );
+	vec.Segments.swap ( segments );
+	vec.Serviced = serviced;
+	set_segment ( trans, vec.Segments[0] );
+	trans.set_response_status ( rsp );
 }
 
  tlm::tlm_sync_enum
@@ -248,64 +568,86 @@ interconnect::b_transport ( tlm::tlm_generic_payload& trans, sc_time& delay )
  bool
  interconnect::get_direct_mem_ptr ( tlm::tlm_generic_payload& trans, tlm::tlm_dmi& dmi_data )
  {
- /*	//Debug
- 	if ( DIAGNOSTIC_LEVEL >= DBG_L1 ) {
- 		cout<<NAME<<":---------------------------------------------------------"<<endl;
- 		cout<<NAME<<": get_direct_mem_ptr call"<<endl;
- 		cout<<NAME<<": command = "; if (trans.get_command () == tlm::TLM_WRITE_COMMAND) cout << "WRITE"; else cout << "READ"; cout<<endl;
- 		cout<<NAME<<": address = 0x"<<hex<<(uint64_t)trans.get_address()<<dec<<endl;
- 		cout<<NAME<<": burst = "<<dec<<(uint32_t)trans.get_data_length ()<<dec<<endl;
- 		cout<<NAME<<": data ptr = 0x"<<hex<<(uint64_t*)trans.get_data_ptr ()<<dec<<endl;
- 		cout<<NAME<<": byte_enable_ptr = 0x"<<hex<<(uint64_t*)trans.get_byte_enable_ptr ()<<dec<<endl;
- 		cout<<NAME<<": byte_enable_len = "<<(uint32_t) trans.get_byte_enable_length ()<<endl;
- 	}
-
- 	return socket_out->get_direct_mem_ptr ( trans, dmi_data );*/
+	return get_direct_mem_ptr_in ( -1, trans, dmi_data );
+ }
 
+ //DMI requests go to the target of the address, then the region granted is clipped to the window
+ //of the port: a target may grant more than what is routed to it, e.g. a memory mapped in two parts
+ bool
+ interconnect::get_direct_mem_ptr_in ( int in_port, tlm::tlm_generic_payload& trans, tlm::tlm_dmi& dmi_data )
+ {
 	if (trans.get_data_length() == 0)
 		trans.set_data_length(1);
 
-	int32_t num_port = get_port ( trans.get_address(), trans.get_data_length() );
-
+	//Always redirect requests to the only existing port if only one exists
+	uint64_t base = 0, end = UINT64_MAX;
+	int32_t num_port = NUM_PORT_OUT<=1 ? 0 : get_window ( trans.get_address(), base, end );
 
 	if (num_port<0) {
 		throw runtime_error(string("Nothing found between ")+std::to_string(trans.get_address())+" and "+std::to_string(trans.get_data_length()));
 	}
 	bool ret = socket_out[num_port]->get_direct_mem_ptr ( trans, dmi_data);
 
+	if (dmi_data.get_start_address() < base) {
+		if (ret) dmi_data.set_dmi_ptr ( dmi_data.get_dmi_ptr() + (base - dmi_data.get_start_address()) );
+		dmi_data.set_start_address ( base );
+	}
+	if (dmi_data.get_end_address() > end) dmi_data.set_end_address ( end );
+
 	LOG_GLOBAL_INFO <<"At port : "<<num_port<<" -> ";
 
 	if (ret) {
 		LOG_GLOBAL_INFO<<"Delivering address space : "<<dmi_data.get_start_address()<<" -> "<<dmi_data.get_end_address()<<endl;
+		//Remember who holds the region, so that its invalidation only goes back there
+		uint64_t size = dmi_data.get_end_address() - dmi_data.get_start_address() + 1;
+		if (in_port<0 || size==0) mDmiUntracked = true;
+		else mDmiGranted.setDmiRange ( in_port, dmi_data.get_start_address(), size, dmi_data.get_dmi_ptr() );
+		if (in_port>=0) mDmiGrantCount[in_port]++;
 	}
 	else {
 		LOG_GLOBAL_INFO<<"Address "<<trans.get_address()<<" does not provide DMI"<<endl;
+		if (in_port>=0) mDmiDenyCount[in_port]++;
 	}
 	return ret;
  }
 
  unsigned int
- interconnect::transport_dbg(tlm::tlm_generic_payload& trans)
+ interconnect::transport_dbg_in ( int in_port, tlm::tlm_generic_payload& trans )
  {
- /*	//Debug
- 	if ( DIAGNOSTIC_LEVEL >= DBG_L1 ) {
- 		cout<<NAME<<":---------------------------------------------------------"<<endl;
- 		cout<<NAME<<": transport_dbg call"<<endl;
- 		cout<<NAME<<": command = "; if (trans.get_command () == tlm::TLM_WRITE_COMMAND) cout << "WRITE"; else cout << "READ"; cout<<endl;
- 		cout<<NAME<<": address = 0x"<<hex<<(uint64_t)trans.get_address()<<dec<<endl;
- 		cout<<NAME<<": burst = "<<dec<<(uint32_t)trans.get_data_length ()<<dec<<endl;
- 		cout<<NAME<<": data ptr = 0x"<<hex<<(uint64_t*)trans.get_data_ptr ()<<dec<<endl;
- 		cout<<NAME<<": byte_enable_ptr = 0x"<<hex<<(uint64_t*)trans.get_byte_enable_ptr ()<<dec<<endl;
- 		cout<<NAME<<": byte_enable_len = "<<(uint32_t) trans.get_byte_enable_length ()<<endl;
- 	}
+	return transport_dbg ( trans );
+ }
 
- 	return socket_out->transport_dbg ( trans );*/
-	//TODO: Provide proper implementation or do not use this method
-	trans.set_response_status(tlm::tlm_response_status::TLM_OK_RESPONSE);
+ //Debug transfers (loaders, debuggers) may be large and span several targets: each target
+ //receives a single debug transaction covering its part of the transfer
+ unsigned int
+ interconnect::transport_dbg(tlm::tlm_generic_payload& trans)
+ {
+	const uint64_t addr = trans.get_address();
+	const unsigned int len = trans.get_data_length();
+	unsigned char* ptr = trans.get_data_ptr();
+
+	if (NUM_PORT_OUT<=1) return socket_out[0]->transport_dbg ( trans );
+
+	unsigned int done = 0;
+	while (done<len) {
+		uint64_t chunk = len - done;
+		int32_t num_port = get_dbg_port ( addr + done, chunk );
+		if (num_port<0) break;
+
+		trans.set_address ( addr + done );
+		trans.set_data_ptr ( ptr + done );
+		trans.set_data_length ( chunk );
+		unsigned int nb_bytes = socket_out[num_port]->transport_dbg ( trans );
+		done += nb_bytes;
+		if (nb_bytes<chunk) break;
+	}
 
-	// according to TLM source "The return value of defines the number of bytes successfully transferred"
-	// since the debug interface does not perform any transfer, it is safer to return 0
-	return 0;
+	//A transfer stopping partway, on an unmapped address or a target doing less, is an address error
+	trans.set_address ( addr );
+	trans.set_data_ptr ( ptr );
+	trans.set_data_length ( len );
+	trans.set_response_status ( done==len ? tlm::TLM_OK_RESPONSE : tlm::TLM_ADDRESS_ERROR_RESPONSE );
+	return done;
  }
 
  void
@@ -319,9 +661,13 @@ interconnect::b_transport ( tlm::tlm_generic_payload& trans, sc_time& delay )
  		cout<<NAME<<": end_range = 0x"<<hex<<(uint64_t)start_range<<dec<<endl;
  	}*/
 
-     for(auto& s: socket_in){
-         s->invalidate_direct_mem_ptr(start_range, end_range);
-     }
+	for (size_t i=0; i<socket_in.size(); i++) {
+		//Only the input sockets which may hold a part of the range are told
+		if (!mDmiUntracked && !mDmiGranted.overlapsDmiRange ( i, start_range, end_range )) continue;
+		mDmiGranted.invalidateDmiRange ( i, start_range, end_range );
+		mDmiInvalidateCount[i]++;
+		socket_in[i]->invalidate_direct_mem_ptr ( start_range, end_range );
+	}
  }
 
  tlm::tlm_sync_enum
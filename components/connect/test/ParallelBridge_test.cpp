@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+
+#include <gtest/gtest.h>
+#include "InitiatorIf.hpp"
+#include "ParallelBridge.hpp"
+#include "ParallelDomain.hpp"
+#include "interconnect.hpp"
+#include "memory.hpp"
+#include "quantum.hpp"
+#include <algorithm>
+
+using namespace vpsim;
+using namespace sc_core;
+using namespace std;
+
+/*
+ * General comments
+ * Modules cannot be instantiated once the elaboration is over, so both
+ * platforms are built once in sc_main and simulated together:
+ * { core0 -> bridge0, core1 -> bridge1 } -> bus -> mem
+ * Each core is a cluster of the domain of its platform, run on a single host
+ * thread for the serial platform and on a thread per core for the parallel
+ * one. After pseudo-random steps of local time, a core now and then reads a
+ * word of mem shared by both cores and writes it back updated, at the same
+ * local time. The accesses being granted in (time, cluster) order, every
+ * read returns the value of the preceding write in that order, and both
+ * platforms see the same values.
+ */
+
+static const unsigned CORES = 2;
+static const unsigned ITERATIONS = 2000;
+static const sc_time QUANTUM(500, SC_NS);
+static const uint64_t MEM_SIZE = 0x1000;
+static const uint64_t SHARED_ADDR = 0x100;
+static const uint64_t SEED = 7;
+
+struct Update {
+	sc_time time;
+	unsigned cluster;
+	uint64_t read;
+	uint64_t written;
+
+	bool operator==(const Update& other) const {
+		return time == other.time && cluster == other.cluster && read == other.read && written == other.written;
+	}
+	bool operator<(const Update& other) const {
+		return time < other.time || (time == other.time && cluster < other.cluster);
+	}
+};
+
+class TestCore : public sc_module, public InitiatorIf
+{
+public:
+	ParallelQuantumKeeper mQuantumKeeper;
+	ParallelBridge mBridge;
+	unsigned mId;
+	vector<Update> mUpdates; //!< only touched by the thread of the cluster
+
+	TestCore(sc_module_name name, ParallelDomain& domain, unsigned id):
+		sc_module(name),
+		InitiatorIf(string(name), 0, true, 1),
+		mBridge("bridge", domain, domain.addCluster([this]{ run(); }), mQuantumKeeper),
+		mId(id)
+	{
+		mQuantumKeeper.setParallelDomain(&domain, mBridge.getCluster());
+		setForceLt(true);
+		getInitiatorSocket()[0]->bind(mBridge.socket_in);
+	}
+
+	void run() {
+		uint64_t rng = SEED * 0x9E3779B97F4A7C15ull + mId + 1;
+		for (unsigned i = 0; i < ITERATIONS; i++) {
+			rng = rng * 6364136223846793005ull + 1442695040888963407ull;
+			mQuantumKeeper += sc_time(1 + (rng >> 33) % 20, SC_NS);
+			mQuantumKeeper.sync();
+
+			if ((rng >> 20) % 4 == 0) {
+				Update update = { mQuantumKeeper.get_current_time(), mBridge.getCluster(), 0, 0 };
+				sc_time readDelay = SC_ZERO_TIME, writeDelay = SC_ZERO_TIME;
+				tlm_error_checking(target_mem_access(0, SHARED_ADDR, 8, (unsigned char*)&update.read, READ, readDelay));
+				update.written = update.read * 31 + mId + i + 1;
+				tlm_error_checking(target_mem_access(0, SHARED_ADDR, 8, (unsigned char*)&update.written, WRITE, writeDelay));
+				mUpdates.push_back(update);
+				mQuantumKeeper += readDelay + writeDelay;
+			}
+		}
+	}
+};
+
+class Platform
+{
+public:
+	ParallelDomain domain;
+	interconnect bus;
+	memory mem;
+	vector<TestCore*> cores;
+
+	Platform(const string& name, unsigned hostThreads):
+		domain((name + "_domain").c_str(), QUANTUM, hostThreads),
+		bus((name + "_bus").c_str(), CORES, 1),
+		mem((name + "_mem").c_str(), MEM_SIZE)
+	{
+		for (unsigned i = 0; i < CORES; i++) {
+			cores.push_back(new TestCore((name + "_core" + to_string(i)).c_str(), domain, i));
+			cores.back()->mBridge.socket_out.bind(bus.socket_in[i]);
+		}
+		mem.setBaseAddress(0);
+		bus.set_socket_out_addr(0, 0, MEM_SIZE);
+		bus.socket_out[0].bind(mem.mTargetSocket);
+	}
+
+	//! @return the updates of all the cores, in (time, cluster) order
+	vector<Update> updates() {
+		vector<Update> all;
+		for (TestCore* core : cores) all.insert(all.end(), core->mUpdates.begin(), core->mUpdates.end());
+		stable_sort(all.begin(), all.end());
+		return all;
+	}
+
+	uint64_t shared() {
+		uint64_t value;
+		memcpy(&value, mem.getLocalMem() + SHARED_ADDR, sizeof(value));
+		return value;
+	}
+};
+
+static Platform* serial;
+static Platform* parallel;
+
+int sc_main(int argc, char* argv[])
+{
+	testing::InitGoogleTest(&argc, argv);
+
+	serial = new Platform("serial", 1);
+	parallel = new Platform("parallel", 0);
+	sc_start();
+
+	return RUN_ALL_TESTS();
+}
+
+TEST(ParallelBridge, orderedAccesses){
+	vector<Update> updates = parallel->updates();
+	ASSERT_FALSE(updates.empty());
+	uint64_t previous = 0;
+	for (size_t i = 0; i < updates.size(); i++) {
+		EXPECT_EQ(previous, updates[i].read) << i;
+		previous = updates[i].written;
+	}
+	EXPECT_EQ(previous, parallel->shared());
+}
+
+TEST(ParallelBridge, sameAsSerial){
+	for (unsigned i = 0; i < CORES; i++) {
+		EXPECT_TRUE(serial->cores[i]->mUpdates == parallel->cores[i]->mUpdates) << i;
+	}
+	EXPECT_EQ(serial->shared(), parallel->shared());
+}
+
+TEST(ParallelBridge, everyAccessThroughTheBridge){
+	uint64_t transports = 0;
+	for (TestCore* core : parallel->cores) {
+		EXPECT_EQ(2 * core->mUpdates.size(), core->mBridge.getTransportCount());
+		transports += core->mBridge.getTransportCount();
+	}
+	EXPECT_EQ(transports, parallel->domain.getSharedAccessCount());
+}
+
+TEST(ParallelBridge, rejectsCoherentCaches){
+	//Checked before the shared access lock is taken, hence outside of a cluster
+	tlm::tlm_generic_payload trans;
+	CoherencePayloadExtension coherence;
+	coherence.setCoherenceCommand(GetS);
+	trans.set_command(tlm::TLM_IGNORE_COMMAND);
+	trans.set_address(SHARED_ADDR);
+	trans.set_extension<CoherencePayloadExtension>(&coherence);
+	sc_time delay = SC_ZERO_TIME;
+	uint64_t transports = parallel->cores[0]->mBridge.getTransportCount();
+	EXPECT_THROW(parallel->cores[0]->mBridge.b_transport(trans, delay), runtime_error);
+	EXPECT_EQ(transports, parallel->cores[0]->mBridge.getTransportCount());
+	trans.clear_extension(&coherence);
+}
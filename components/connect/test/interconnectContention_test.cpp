@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+
+#include <gtest/gtest.h>
+#include "interconnect.hpp"
+
+using namespace vpsim;
+using namespace sc_core;
+using namespace std;
+
+/*
+ * General comments
+ * Modules cannot be instantiated once the elaboration is over, so the
+ * platform is built once in sc_main and shared by every test:
+ * cpu -> bus -> { mem0 .. mem3 }, mem<n> mapped at n*MEM_SIZE.
+ * The simulation is never started: accesses are issued at time 0 and
+ * arrive at the ports at the local time given as their delay. Each test
+ * uses its own port, since the contention state of a port is never reset.
+ * Every target answers after TARGET_NS.
+ */
+
+static const uint64_t MEM_SIZE = 0x10000;
+static const int PORTS = 5;
+static const double TARGET_NS = 100;
+
+class LatencyTarget : public sc_module
+{
+public:
+	tlm_utils::simple_target_socket<LatencyTarget> socket;
+
+	LatencyTarget(sc_module_name name): sc_module(name), socket("socket") {
+		socket.register_b_transport(this, &LatencyTarget::b_transport);
+	}
+
+	void b_transport(tlm::tlm_generic_payload& trans, sc_time& delay) {
+		delay += sc_time(TARGET_NS, SC_NS);
+		trans.set_response_status(tlm::TLM_OK_RESPONSE);
+	}
+};
+
+class Initiator : public sc_module
+{
+public:
+	tlm_utils::simple_initiator_socket<Initiator> socket;
+
+	Initiator(sc_module_name name): sc_module(name), socket("socket") { }
+
+	//! @return the delay of an access of len bytes to port issued at the local time start
+	sc_time access(int port, uint32_t len, sc_time start = SC_ZERO_TIME) {
+		unsigned char data[256];
+		tlm::tlm_generic_payload trans;
+		trans.set_read();
+		trans.set_address(port * MEM_SIZE);
+		trans.set_data_ptr(data);
+		trans.set_data_length(len);
+		sc_time delay = start;
+		socket->b_transport(trans, delay);
+		return delay - start;
+	}
+};
+
+static Initiator* cpu;
+static interconnect* bus;
+
+int sc_main(int argc, char* argv[])
+{
+	testing::InitGoogleTest(&argc, argv);
+
+	cpu = new Initiator("cpu");
+	bus = new interconnect("bus", 1, PORTS);
+	cpu->socket.bind(bus->socket_in[0]);
+	for (int i = 0; i < PORTS; i++) {
+		LatencyTarget* mem = new LatencyTarget(("mem" + to_string(i)).c_str());
+		bus->set_socket_out_addr(i, i * MEM_SIZE, MEM_SIZE);
+		bus->socket_out[i].bind(mem->socket);
+	}
+
+	return RUN_ALL_TESTS();
+}
+
+static sc_time ns(double n) { return sc_time(n, SC_NS); }
+
+TEST(interconnectContention, disabled){
+	EXPECT_EQ(ns(TARGET_NS), cpu->access(0, 64));
+	EXPECT_EQ(ns(TARGET_NS), cpu->access(0, 64));
+	EXPECT_EQ(0u, bus->getPortQueuedCount(0));
+}
+
+TEST(interconnectContention, bandwidth){
+	//64 bytes take 16 cycles of 1 ns
+	bus->set_port_bandwidth(1, 4, ns(1));
+	EXPECT_EQ(ns(16 + TARGET_NS), cpu->access(1, 64));
+	//Waits for the first transfer
+	EXPECT_EQ(ns(32 + TARGET_NS), cpu->access(1, 64));
+	//Partial cycles are rounded up
+	EXPECT_EQ(ns(1 + TARGET_NS), cpu->access(1, 2, ns(40)));
+	EXPECT_EQ(1u, bus->getPortQueuedCount(1));
+	EXPECT_EQ(ns(16), bus->getPortQueueingDelay(1));
+	//Busy 33 ns out of 41
+	EXPECT_DOUBLE_EQ(33.0 / 41.0, bus->getPortUtilization(1));
+	EXPECT_EQ(0u, bus->getPortPeakOccupancy(1));
+}
+
+TEST(interconnectContention, outstanding){
+	//Transfers take 1 ns, at most 2 transactions in flight
+	bus->set_port_bandwidth(2, 64, ns(1));
+	bus->set_port_max_outstanding(2, 2);
+	EXPECT_EQ(ns(1 + TARGET_NS), cpu->access(2, 64));
+	EXPECT_EQ(ns(2 + TARGET_NS), cpu->access(2, 64));
+	//Waits for the first one to complete, at 101 ns
+	EXPECT_EQ(ns(102 + TARGET_NS), cpu->access(2, 64));
+	EXPECT_EQ(2u, bus->getPortPeakOccupancy(2));
+	EXPECT_EQ(2u, bus->getPortQueuedCount(2));
+	EXPECT_EQ(ns(102), bus->getPortQueueingDelay(2));
+	//Long after, the port is free again
+	EXPECT_EQ(ns(1 + TARGET_NS), cpu->access(2, 64, ns(1000)));
+}
+
+TEST(interconnectContention, outstandingOnly){
+	//No bandwidth limit, at most 2 transactions in flight
+	bus->set_port_max_outstanding(4, 2);
+	EXPECT_EQ(ns(TARGET_NS), cpu->access(4, 64));
+	EXPECT_EQ(ns(TARGET_NS), cpu->access(4, 64));
+	//Waits for the first one to complete, at 100 ns
+	EXPECT_EQ(ns(100 + TARGET_NS), cpu->access(4, 64));
+	EXPECT_EQ(2u, bus->getPortPeakOccupancy(4));
+	EXPECT_EQ(1u, bus->getPortQueuedCount(4));
+	EXPECT_EQ(ns(100), bus->getPortQueueingDelay(4));
+	//Removing the limit removes the wait
+	bus->set_port_max_outstanding(4, 0);
+	EXPECT_EQ(ns(TARGET_NS), cpu->access(4, 64));
+}
+
+TEST(interconnectContention, errors){
+	EXPECT_THROW(bus->set_port_bandwidth(PORTS, 4, ns(1)), runtime_error);
+	EXPECT_THROW(bus->set_port_bandwidth(3, 4, SC_ZERO_TIME), runtime_error);
+	EXPECT_THROW(bus->set_port_max_outstanding(PORTS, 1), runtime_error);
+	//Disabling the model is always allowed
+	bus->set_port_bandwidth(3, 0, SC_ZERO_TIME);
+	EXPECT_EQ(ns(TARGET_NS), cpu->access(3, 64));
+}
@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+
+#include <gtest/gtest.h>
+#include "interconnect.hpp"
+#include "CoherenceInterconnect.hpp"
+
+using namespace vpsim;
+using namespace sc_core;
+using namespace std;
+
+/*
+ * General comments
+ * Modules cannot be instantiated once the elaboration is over, so the
+ * platform is built once in sc_main and shared by every test:
+ * cpu0 -> bus -> { full0, short0 }
+ * cpu1 -> coh -> { full1, short1 }
+ * Both routers have the same map. A full target transfers all the bytes
+ * asked, a short target at most SHORT_LIMIT bytes per debug transaction,
+ * while still answering TLM_OK_RESPONSE. Every test checks that both
+ * routers answer a debug transfer the same way.
+ */
+
+static const uint64_t SIZE = 0x1000;
+static const uint64_t FULL_BASE = 0x0;
+static const uint64_t SHORT_BASE = FULL_BASE + SIZE;
+static const unsigned int SHORT_LIMIT = 16;
+
+class DebugTarget : public sc_module
+{
+public:
+	tlm_utils::simple_target_socket<DebugTarget> socket;
+	uint64_t mBase;
+	unsigned int mLimit;
+	vector<unsigned char> mStorage;
+
+	DebugTarget(sc_module_name name, uint64_t base, unsigned int limit):
+		sc_module(name), socket("socket"), mBase(base), mLimit(limit), mStorage(SIZE) {
+		socket.register_transport_dbg(this, &DebugTarget::transport_dbg);
+		for (uint64_t i = 0; i < SIZE; i++) mStorage[i] = (unsigned char)(base + i);
+	}
+
+	unsigned int transport_dbg(tlm::tlm_generic_payload& trans) {
+		const uint64_t offset = trans.get_address() - mBase;
+		const unsigned int nb = min((uint64_t)min(trans.get_data_length(), mLimit), SIZE - offset);
+		if (trans.is_read()) memcpy(trans.get_data_ptr(), &mStorage[offset], nb);
+		else memcpy(&mStorage[offset], trans.get_data_ptr(), nb);
+		trans.set_response_status(tlm::TLM_OK_RESPONSE);
+		return nb;
+	}
+};
+
+class DebugInitiator : public sc_module
+{
+public:
+	tlm_utils::simple_initiator_socket<DebugInitiator> socket;
+
+	DebugInitiator(sc_module_name name): sc_module(name), socket("socket") {}
+
+	unsigned int read(uint64_t addr, unsigned char* data, unsigned int len, tlm::tlm_response_status& status) {
+		tlm::tlm_generic_payload trans;
+		trans.set_read();
+		trans.set_address(addr);
+		trans.set_data_ptr(data);
+		trans.set_data_length(len);
+		trans.set_streaming_width(len);
+		trans.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
+		unsigned int nb = socket->transport_dbg(trans);
+		status = trans.get_response_status();
+		return nb;
+	}
+};
+
+static DebugInitiator* cpu0;
+static DebugInitiator* cpu1;
+
+int sc_main(int argc, char* argv[])
+{
+	testing::InitGoogleTest(&argc, argv);
+
+	cpu0 = new DebugInitiator("cpu0");
+	interconnect* bus = new interconnect("bus", 1, 2);
+	DebugTarget* full0 = new DebugTarget("full0", FULL_BASE, SIZE);
+	DebugTarget* short0 = new DebugTarget("short0", SHORT_BASE, SHORT_LIMIT);
+	bus->set_socket_out_addr(0, FULL_BASE, SIZE);
+	bus->set_socket_out_addr(1, SHORT_BASE, SIZE);
+	cpu0->socket.bind(bus->socket_in[0]);
+	bus->socket_out[0].bind(full0->socket);
+	bus->socket_out[1].bind(short0->socket);
+
+	cpu1 = new DebugInitiator("cpu1");
+	CoherenceInterconnect* coh = new CoherenceInterconnect("coh", 1, 0, 0, 0, 2, 0, 8, 8, false, 0, 0);
+	DebugTarget* full1 = new DebugTarget("full1", FULL_BASE, SIZE);
+	DebugTarget* short1 = new DebugTarget("short1", SHORT_BASE, SHORT_LIMIT);
+	coh->set_mmapped_output(0, FULL_BASE, SIZE);
+	coh->set_mmapped_output(1, SHORT_BASE, SIZE);
+	cpu1->socket.bind(*coh->mCacheSocketsIn[0]);
+	coh->mMMappedSocketsOut[0]->bind(full1->socket);
+	coh->mMMappedSocketsOut[1]->bind(short1->socket);
+
+	sc_start(SC_ZERO_TIME);
+
+	return RUN_ALL_TESTS();
+}
+
+//Reads through both routers, checks they agree, and returns the number of bytes and the status
+static unsigned int readBoth(uint64_t addr, unsigned int len, tlm::tlm_response_status& status) {
+	vector<unsigned char> data0(len, 0), data1(len, 0);
+	tlm::tlm_response_status status1;
+	unsigned int nb0 = cpu0->read(addr, data0.data(), len, status);
+	unsigned int nb1 = cpu1->read(addr, data1.data(), len, status1);
+	EXPECT_EQ(nb0, nb1);
+	EXPECT_EQ(status, status1);
+	EXPECT_EQ(data0, data1);
+	for (unsigned int i = 0; i < nb0; i++) EXPECT_EQ((unsigned char)(addr + i), data0[i]) << hex << addr + i;
+	return nb0;
+}
+
+TEST(interconnectDebug, completeTransfer){
+	tlm::tlm_response_status status;
+	//Ends on the short target, which transfers all of its part
+	EXPECT_EQ(2 * SHORT_LIMIT, readBoth(SHORT_BASE - SHORT_LIMIT, 2 * SHORT_LIMIT, status));
+	EXPECT_EQ(tlm::TLM_OK_RESPONSE, status);
+}
+
+TEST(interconnectDebug, shortTarget){
+	tlm::tlm_response_status status;
+	EXPECT_EQ(2 * SHORT_LIMIT, readBoth(SHORT_BASE - SHORT_LIMIT, 4 * SHORT_LIMIT, status));
+	EXPECT_EQ(tlm::TLM_ADDRESS_ERROR_RESPONSE, status);
+}
+
+TEST(interconnectDebug, unmappedTail){
+	tlm::tlm_response_status status;
+	EXPECT_EQ(SHORT_LIMIT, readBoth(SHORT_BASE + SIZE - SHORT_LIMIT, 2 * SHORT_LIMIT, status));
+	EXPECT_EQ(tlm::TLM_ADDRESS_ERROR_RESPONSE, status);
+}
+
+TEST(interconnectDebug, unmapped){
+	tlm::tlm_response_status status;
+	EXPECT_EQ(0u, readBoth(SHORT_BASE + SIZE, 8, status));
+	EXPECT_EQ(tlm::TLM_ADDRESS_ERROR_RESPONSE, status);
+}
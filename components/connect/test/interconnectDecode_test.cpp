@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+
+#include <gtest/gtest.h>
+#include "InitiatorIf.hpp"
+#include "interconnect.hpp"
+
+using namespace vpsim;
+using namespace sc_core;
+using namespace std;
+
+/*
+ * General comments
+ * Modules cannot be instantiated once the elaboration is over, so the
+ * platform is built once in sc_main and shared by every test:
+ * { cpu0, cpu1 } -> bus -> { target[0..TARGETS-1], default }
+ * Targets are mapped in reverse order of their addresses, every other one
+ * leaving a hole behind it, so that the decode table has to sort them.
+ * Each target only counts the transactions it receives.
+ */
+
+static const unsigned TARGETS = 64;
+static const uint64_t SIZE = 0x1000;
+static uint64_t targetBase(unsigned i) { return 0x100000 + i * 2 * SIZE; }
+
+class CountingTarget : public sc_module, public tlm::tlm_fw_transport_if<>
+{
+public:
+	tlm_utils::simple_target_socket<CountingTarget> socket;
+	uint64_t mTransportCount;
+
+	CountingTarget(sc_module_name name): sc_module(name), socket("socket"), mTransportCount(0) {
+		socket.register_b_transport(this, &CountingTarget::b_transport);
+	}
+
+	void b_transport(tlm::tlm_generic_payload& trans, sc_time& delay) override {
+		mTransportCount++;
+		trans.set_response_status(tlm::TLM_OK_RESPONSE);
+	}
+
+	bool get_direct_mem_ptr(tlm::tlm_generic_payload&, tlm::tlm_dmi&) override { return false; }
+	unsigned int transport_dbg(tlm::tlm_generic_payload&) override { return 0; }
+	tlm::tlm_sync_enum nb_transport_fw(tlm::tlm_generic_payload&, tlm::tlm_phase&, sc_time&) override {
+		return tlm::TLM_COMPLETED;
+	}
+};
+
+class TestInitiator : public sc_module, public InitiatorIf
+{
+public:
+	TestInitiator(sc_module_name name):
+		sc_module(name),
+		InitiatorIf(string(name), 0, true, 1)
+	{}
+};
+
+static TestInitiator* cpu0;
+static TestInitiator* cpu1;
+static interconnect* bus;
+static vector<CountingTarget*> targets;
+static CountingTarget* defaultTarget;
+
+//Only used to exercise the overlap detection, its ranges are set by the tests
+static interconnect* overlapBus;
+
+int sc_main(int argc, char* argv[])
+{
+	testing::InitGoogleTest(&argc, argv);
+
+	cpu0 = new TestInitiator("cpu0");
+	cpu1 = new TestInitiator("cpu1");
+	bus = new interconnect("bus", 2, TARGETS + 1);
+	for (unsigned i = 0; i < TARGETS; i++) {
+		targets.push_back(new CountingTarget(("target" + to_string(i)).c_str()));
+	}
+	defaultTarget = new CountingTarget("default");
+
+	for (unsigned i = TARGETS; i-- > 0;) {
+		bus->set_socket_out_addr(i, targetBase(i), SIZE);
+	}
+	//Mapping the same target twice is allowed
+	bus->set_socket_out_addr(3, targetBase(3), SIZE);
+	bus->setDefaultRoute(TARGETS);
+
+	cpu0->getInitiatorSocket()[0]->bind(bus->socket_in[0]);
+	cpu1->getInitiatorSocket()[0]->bind(bus->socket_in[1]);
+	for (unsigned i = 0; i < TARGETS; i++) {
+		bus->socket_out[i].bind(targets[i]->socket);
+	}
+	bus->socket_out[TARGETS].bind(defaultTarget->socket);
+	cpu0->setForceLt(true);
+	cpu1->setForceLt(true);
+
+	overlapBus = new interconnect("overlapBus", 1, 2);
+	overlapBus->socket_out[0].bind((new CountingTarget("overlap0"))->socket);
+	overlapBus->socket_out[1].bind((new CountingTarget("overlap1"))->socket);
+
+	sc_start(SC_ZERO_TIME);
+
+	return RUN_ALL_TESTS();
+}
+
+static void access(TestInitiator* cpu, uint64_t addr, uint64_t len = 4) {
+	uint32_t value = 0;
+	sc_time delay = SC_ZERO_TIME;
+	EXPECT_EQ(tlm::TLM_OK_RESPONSE, cpu->target_mem_access(0, addr, len, (unsigned char*)&value, READ, delay));
+}
+
+TEST(interconnectDecode, everyTarget){
+	for (unsigned i = 0; i < TARGETS; i++) {
+		EXPECT_EQ((int32_t)i, bus->get_port(targetBase(i), 4)) << i;
+		EXPECT_EQ((int32_t)i, bus->get_port(targetBase(i) + SIZE - 4, 4)) << i;
+
+		uint64_t count = targets[i]->mTransportCount;
+		access(cpu0, targetBase(i) + 0x10);
+		EXPECT_EQ(count + 1, targets[i]->mTransportCount) << i;
+	}
+}
+
+TEST(interconnectDecode, defaultRoute){
+	//Below the first target, in a hole, straddling two ranges, above the last target
+	const uint64_t addrs[] = { 0, targetBase(5) + SIZE, targetBase(7) + SIZE - 2, targetBase(TARGETS) };
+	for (uint64_t addr : addrs) {
+		EXPECT_EQ((int32_t)TARGETS, bus->get_port(addr, 4)) << hex << addr;
+	}
+
+	uint64_t count = defaultTarget->mTransportCount;
+	access(cpu0, targetBase(2) + SIZE);
+	EXPECT_EQ(count + 1, defaultTarget->mTransportCount);
+}
+
+TEST(interconnectDecode, lastHitPerInputSocket){
+	access(cpu0, targetBase(10));
+	access(cpu1, targetBase(20));
+
+	//Each input socket keeps its own last hit
+	uint64_t hits = bus->getLastHitCount();
+	access(cpu0, targetBase(10) + 0x100);
+	access(cpu1, targetBase(20) + 0x100);
+	access(cpu0, targetBase(10) + 0x200);
+	EXPECT_EQ(hits + 3, bus->getLastHitCount());
+
+	//A miss decodes through the table and replaces the last hit
+	uint64_t count = targets[11]->mTransportCount;
+	access(cpu0, targetBase(11));
+	EXPECT_EQ(hits + 3, bus->getLastHitCount());
+	access(cpu0, targetBase(11) + 0x100);
+	EXPECT_EQ(hits + 4, bus->getLastHitCount());
+	EXPECT_EQ(count + 2, targets[11]->mTransportCount);
+
+	//Without an input socket, the last hits are neither used nor updated
+	EXPECT_EQ(11, bus->get_port(targetBase(11), 4));
+	EXPECT_EQ(hits + 4, bus->getLastHitCount());
+}
+
+TEST(interconnectDecode, overlap){
+	overlapBus->set_socket_out_addr(0, 0x1000, 0x1000);
+	overlapBus->set_socket_out_addr(1, 0x3000, 0x1000);
+	EXPECT_EQ(1, overlapBus->get_port(0x3000, 4));
+
+	//The table is rebuilt when a range is added
+	overlapBus->set_socket_out_addr(1, 0x1800, 0x1000);
+	EXPECT_THROW(overlapBus->get_port(0x3000, 4), runtime_error);
+}
@@ -0,0 +1,221 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+
+#include <gtest/gtest.h>
+#include "interconnect.hpp"
+#include "CoherenceInterconnect.hpp"
+
+using namespace vpsim;
+using namespace sc_core;
+using namespace std;
+
+/*
+ * General comments
+ * Modules cannot be instantiated once the elaboration is over, so the
+ * platform is built once in sc_main and shared by every test:
+ * { cpu0, cpu1 } -> bus -> { mem0, mem1, window (default route) }
+ * cpu2 -> coh -> { mem2, mem3 }
+ * Each target grants DMI on all of its storage, which for mem1, window and
+ * mem2 is more than what the router maps on its port. Initiators only
+ * record the invalidations they receive.
+ */
+
+static const uint64_t MEM_SIZE = 0x10000;
+
+class DmiTarget : public sc_module
+{
+public:
+	tlm_utils::simple_target_socket<DmiTarget> socket;
+	uint64_t mBase;
+	vector<unsigned char> mStorage;
+	bool mDmiEnable;
+
+	DmiTarget(sc_module_name name, uint64_t base, uint64_t size):
+		sc_module(name), socket("socket"), mBase(base), mStorage(size), mDmiEnable(true) {
+		socket.register_get_direct_mem_ptr(this, &DmiTarget::get_direct_mem_ptr);
+	}
+
+	bool get_direct_mem_ptr(tlm::tlm_generic_payload& trans, tlm::tlm_dmi& dmi) {
+		dmi.set_start_address(mBase);
+		dmi.set_end_address(mBase + mStorage.size() - 1);
+		if (!mDmiEnable) {
+			dmi.allow_none();
+			return false;
+		}
+		dmi.allow_read_write();
+		dmi.set_dmi_ptr(mStorage.data());
+		return true;
+	}
+
+	void invalidate(uint64_t start, uint64_t end) { socket->invalidate_direct_mem_ptr(start, end); }
+};
+
+class DmiInitiator : public sc_module
+{
+public:
+	tlm_utils::simple_initiator_socket<DmiInitiator> socket;
+	vector<pair<uint64_t, uint64_t>> mInvalidations;
+
+	DmiInitiator(sc_module_name name): sc_module(name), socket("socket") {
+		socket.register_invalidate_direct_mem_ptr(this, &DmiInitiator::invalidate_direct_mem_ptr);
+	}
+
+	bool request(uint64_t addr, tlm::tlm_dmi& dmi) {
+		tlm::tlm_generic_payload trans;
+		trans.set_read();
+		trans.set_address(addr);
+		trans.set_data_length(4);
+		return socket->get_direct_mem_ptr(trans, dmi);
+	}
+
+	void invalidate_direct_mem_ptr(sc_dt::uint64 start, sc_dt::uint64 end) {
+		mInvalidations.push_back(make_pair(start, end));
+	}
+};
+
+static DmiInitiator* cpu0;
+static DmiInitiator* cpu1;
+static DmiInitiator* cpu2;
+static interconnect* bus;
+static CoherenceInterconnect* coh;
+static DmiTarget* mem0;
+static DmiTarget* mem1;
+static DmiTarget* window;
+static DmiTarget* mem2;
+static DmiTarget* mem3;
+
+int sc_main(int argc, char* argv[])
+{
+	testing::InitGoogleTest(&argc, argv);
+
+	cpu0 = new DmiInitiator("cpu0");
+	cpu1 = new DmiInitiator("cpu1");
+	cpu2 = new DmiInitiator("cpu2");
+
+	bus = new interconnect("bus", 2, 3);
+	mem0 = new DmiTarget("mem0", 0, MEM_SIZE);
+	mem1 = new DmiTarget("mem1", MEM_SIZE, 2 * MEM_SIZE);
+	window = new DmiTarget("window", 0, 16 * MEM_SIZE);
+	bus->set_socket_out_addr(0, 0, MEM_SIZE);
+	bus->set_socket_out_addr(1, MEM_SIZE, MEM_SIZE);
+	bus->setDefaultRoute(2);
+	cpu0->socket.bind(bus->socket_in[0]);
+	cpu1->socket.bind(bus->socket_in[1]);
+	bus->socket_out[0].bind(mem0->socket);
+	bus->socket_out[1].bind(mem1->socket);
+	bus->socket_out[2].bind(window->socket);
+
+	coh = new CoherenceInterconnect("coh", 1, 0, 0, 0, 2, 0, 8, 8, false, 0, 0);
+	mem2 = new DmiTarget("mem2", 0x100000, MEM_SIZE);
+	mem3 = new DmiTarget("mem3", 0x200000, MEM_SIZE);
+	coh->set_mmapped_output(0, 0x100000, MEM_SIZE / 2);
+	coh->set_mmapped_output(1, 0x200000, MEM_SIZE);
+	cpu2->socket.bind(*coh->mCacheSocketsIn[0]);
+	coh->mMMappedSocketsOut[0]->bind(mem2->socket);
+	coh->mMMappedSocketsOut[1]->bind(mem3->socket);
+
+	sc_start(SC_ZERO_TIME);
+
+	return RUN_ALL_TESTS();
+}
+
+TEST(interconnectDmi, forwardedToDecodedTarget){
+	tlm::tlm_dmi dmi;
+	uint64_t grants = bus->getDmiGrantCount(0);
+	ASSERT_TRUE(cpu0->request(0x100, dmi));
+	EXPECT_EQ(0u, dmi.get_start_address());
+	EXPECT_EQ(MEM_SIZE - 1, dmi.get_end_address());
+	EXPECT_EQ(mem0->mStorage.data(), dmi.get_dmi_ptr());
+	EXPECT_EQ(grants + 1, bus->getDmiGrantCount(0));
+}
+
+TEST(interconnectDmi, clippedToPortWindow){
+	//mem1 grants twice what the bus maps on its port
+	tlm::tlm_dmi dmi;
+	ASSERT_TRUE(cpu0->request(MEM_SIZE + 0x100, dmi));
+	EXPECT_EQ(MEM_SIZE, dmi.get_start_address());
+	EXPECT_EQ(2 * MEM_SIZE - 1, dmi.get_end_address());
+	EXPECT_EQ(mem1->mStorage.data(), dmi.get_dmi_ptr());
+
+	//The default route only receives the addresses above the mapped ranges
+	ASSERT_TRUE(cpu1->request(4 * MEM_SIZE, dmi));
+	EXPECT_EQ(2 * MEM_SIZE, dmi.get_start_address());
+	EXPECT_EQ(16 * MEM_SIZE - 1, dmi.get_end_address());
+	EXPECT_EQ(window->mStorage.data() + 2 * MEM_SIZE, dmi.get_dmi_ptr());
+}
+
+TEST(interconnectDmi, deniedRequestsAreCounted){
+	tlm::tlm_dmi dmi;
+	uint64_t denials = bus->getDmiDenyCount(1);
+	mem0->mDmiEnable = false;
+	EXPECT_FALSE(cpu1->request(0x200, dmi));
+	mem0->mDmiEnable = true;
+	EXPECT_EQ(denials + 1, bus->getDmiDenyCount(1));
+}
+
+TEST(interconnectDmi, invalidationOnlyReachesHolders){
+	tlm::tlm_dmi dmi;
+	//Start with no region held
+	mem0->invalidate(0, UINT64_MAX);
+	mem1->invalidate(0, UINT64_MAX);
+	window->invalidate(0, UINT64_MAX);
+	ASSERT_TRUE(cpu0->request(0x100, dmi));
+	ASSERT_TRUE(cpu1->request(MEM_SIZE + 0x100, dmi));
+	cpu0->mInvalidations.clear();
+	cpu1->mInvalidations.clear();
+
+	//Only cpu1 holds a region of mem1
+	mem1->invalidate(MEM_SIZE, 2 * MEM_SIZE - 1);
+	EXPECT_TRUE(cpu0->mInvalidations.empty());
+	ASSERT_EQ(1u, cpu1->mInvalidations.size());
+	EXPECT_EQ(MEM_SIZE, cpu1->mInvalidations[0].first);
+
+	//Once told, it does not hold the region anymore
+	mem1->invalidate(MEM_SIZE, 2 * MEM_SIZE - 1);
+	EXPECT_EQ(1u, cpu1->mInvalidations.size());
+
+	//The part of mem0 held by cpu0
+	uint64_t invalidations = bus->getDmiInvalidateCount(0);
+	mem0->invalidate(0x1000, 0x1fff);
+	EXPECT_EQ(1u, cpu0->mInvalidations.size());
+	EXPECT_EQ(1u, cpu1->mInvalidations.size());
+	EXPECT_EQ(invalidations + 1, bus->getDmiInvalidateCount(0));
+
+	//cpu0 still holds the rest of mem0
+	mem0->invalidate(0, MEM_SIZE - 1);
+	EXPECT_EQ(2u, cpu0->mInvalidations.size());
+}
+
+TEST(interconnectDmi, coherenceInterconnect){
+	tlm::tlm_dmi dmi;
+	ASSERT_TRUE(cpu2->request(0x100010, dmi));
+	EXPECT_EQ(0x100000u, dmi.get_start_address());
+	EXPECT_EQ(0x100000 + MEM_SIZE / 2 - 1, dmi.get_end_address());
+	EXPECT_EQ(mem2->mStorage.data(), dmi.get_dmi_ptr());
+	EXPECT_EQ(1u, coh->getDmiGrantCount(0));
+
+	//Unmapped address
+	EXPECT_FALSE(cpu2->request(0x300000, dmi));
+	EXPECT_EQ(1u, coh->getDmiDenyCount(0));
+
+	cpu2->mInvalidations.clear();
+	mem3->invalidate(0x200000, 0x20ffff);
+	EXPECT_TRUE(cpu2->mInvalidations.empty());
+	mem2->invalidate(0x100000, 0x10ffff);
+	EXPECT_EQ(1u, cpu2->mInvalidations.size());
+	EXPECT_EQ(1u, coh->getDmiInvalidateCount(0));
+}
@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+
+#include <gtest/gtest.h>
+#include "interconnect.hpp"
+#include "CosimExtensions.hpp"
+
+using namespace vpsim;
+using namespace sc_core;
+using namespace std;
+
+/*
+ * General comments
+ * Only the mesh tables are exercised, so the interconnects are never bound
+ * and the simulation is never started: tests may instantiate their own.
+ * The mesh of sc_main is X nodes wide and Y nodes high, node n at
+ * (n % X, n / X). Node n holds memory controller n, mapping the range
+ * [n*SIZE, (n+1)*SIZE[, source CPU n and home node n, homing the same range.
+ */
+
+static const int X = 4;
+static const int Y = 3;
+static const uint64_t SIZE = 0x1000;
+static const uint64_t ROUTER_NS = 2;
+
+static interconnect* mesh;
+
+int sc_main(int argc, char* argv[])
+{
+	testing::InitGoogleTest(&argc, argv);
+
+	mesh = new interconnect("mesh", 1, 1);
+	mesh->set_is_mesh(true);
+	mesh->set_mesh_coord(X, Y);
+	mesh->set_router_latency(ROUTER_NS);
+	mesh->set_socket_out_addr(0, 0, X * Y * SIZE);
+	//Registered in reverse order, the tables sort them
+	for (int n = X * Y; n-- > 0;) {
+		mesh->register_mem_ctrl(n * SIZE, SIZE, n);
+		mesh->register_source(n, n);
+		mesh->register_hn_input(n * SIZE, SIZE, n);
+	}
+
+	return RUN_ALL_TESTS();
+}
+
+static sc_time latency(interconnect* ic, uint64_t addr, SourceCpuExtension* src) {
+	tlm::tlm_generic_payload trans;
+	if (src) trans.set_extension<SourceCpuExtension>(src);
+	sc_time delay = ic->get_mesh_latency(trans, addr);
+	if (src) trans.clear_extension(src);
+	return delay;
+}
+
+static uint32_t manhattan(int from, int to) {
+	return abs(from % X - to % X) + abs(from / X - to / X);
+}
+
+TEST(interconnectMesh, hopCount){
+	for (int from = 0; from < X * Y; from++) {
+		for (int to = 0; to < X * Y; to++) {
+			EXPECT_EQ(manhattan(from, to), mesh->get_hop_count(from, to)) << from << " " << to;
+		}
+	}
+	EXPECT_THROW(mesh->get_hop_count(X * Y, 0), runtime_error);
+}
+
+TEST(interconnectMesh, latencyFromSource){
+	SourceCpuExtension src;
+	src.type = 0;
+	src.time_stamp = SC_ZERO_TIME;
+	for (int cpu = 0; cpu < X * Y; cpu++) {
+		src.cpu_id = cpu;
+		for (int node = 0; node < X * Y; node++) {
+			EXPECT_EQ(sc_time(ROUTER_NS * manhattan(cpu, node), SC_NS), latency(mesh, node * SIZE + 0x10, &src));
+		}
+	}
+
+	//Unknown source
+	src.cpu_id = X * Y;
+	EXPECT_THROW(latency(mesh, 0, &src), runtime_error);
+}
+
+TEST(interconnectMesh, latencyFromHomeNode){
+	//Without a source, the request comes from the home node of the address, which is its memory node
+	for (int node = 0; node < X * Y; node++) {
+		EXPECT_EQ(SC_ZERO_TIME, latency(mesh, node * SIZE + SIZE - 1, nullptr));
+	}
+	EXPECT_THROW(latency(mesh, X * Y * SIZE, nullptr), runtime_error);
+}
+
+TEST(interconnectMesh, configurationErrors){
+	//No coordinates
+	interconnect* noCoord = new interconnect("noCoord", 1, 1);
+	noCoord->set_is_mesh(true);
+	EXPECT_THROW(noCoord->get_hop_count(0, 0), runtime_error);
+
+	//Memory controller outside of the mesh
+	interconnect* outside = new interconnect("outside", 1, 1);
+	outside->set_mesh_coord(2, 2);
+	outside->register_mem_ctrl(0, SIZE, 4);
+	EXPECT_THROW(outside->get_hop_count(0, 0), runtime_error);
+
+	//Overlapping memory controllers
+	interconnect* overlap = new interconnect("overlap", 1, 1);
+	overlap->set_mesh_coord(2, 2);
+	overlap->register_mem_ctrl(0, SIZE, 0);
+	overlap->register_mem_ctrl(SIZE / 2, SIZE, 1);
+	EXPECT_THROW(overlap->get_hop_count(0, 0), runtime_error);
+
+	//Source on two nodes
+	interconnect* twice = new interconnect("twice", 1, 1);
+	twice->set_mesh_coord(2, 2);
+	twice->register_source(0, 0);
+	twice->register_source(0, 1);
+	EXPECT_THROW(twice->get_hop_count(0, 0), runtime_error);
+
+	//Part of an output range has no memory controller
+	interconnect* uncovered = new interconnect("uncovered", 1, 1);
+	uncovered->set_mesh_coord(2, 2);
+	uncovered->set_socket_out_addr(0, 0, 3 * SIZE);
+	uncovered->register_mem_ctrl(0, SIZE, 0);
+	uncovered->register_mem_ctrl(2 * SIZE, SIZE, 1);
+	EXPECT_THROW(uncovered->get_hop_count(0, 0), runtime_error);
+
+	//The tables are rebuilt once the missing node is registered
+	uncovered->register_mem_ctrl(SIZE, SIZE, 3);
+	EXPECT_EQ(2u, uncovered->get_hop_count(0, 3));
+}
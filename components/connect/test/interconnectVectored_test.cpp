@@ -0,0 +1,329 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+
+#include <gtest/gtest.h>
+#include "InitiatorIf.hpp"
+#include "interconnect.hpp"
+#include "CoherenceInterconnect.hpp"
+#include "CosimExtensions.hpp"
+#include "memory.hpp"
+
+using namespace vpsim;
+using namespace sc_core;
+using namespace std;
+
+/*
+ * General comments
+ * Modules cannot be instantiated once the elaboration is over, so the
+ * platform is built once in sc_main and shared by every test:
+ * cpu -> bus -> { mem0, legacy, mem1 }
+ * dev -> coh -> { mem2, mem3 }
+ * The memories service vectored transactions natively, the legacy target
+ * ignores the extension and only counts the b_transport calls it receives.
+ * It answers an address error from LEGACY_FAIL on.
+ * Unlike bus, coh does not split vectored transactions: it sends them whole
+ * to the memory of the first segment.
+ */
+
+static const uint64_t MEM0_BASE = 0x10000;
+static const uint64_t LEGACY_BASE = 0x20000;
+static const uint64_t MEM1_BASE = 0x30000;
+static const uint64_t MEM2_BASE = 0x40000;
+static const uint64_t MEM3_BASE = 0x50000;
+static const uint64_t SIZE = 0x1000;
+static const uint64_t LEGACY_FAIL = 0xf00;
+static const uint32_t DEVICE_ID = 7;
+
+class LegacyTarget : public sc_module, public tlm::tlm_fw_transport_if<>
+{
+public:
+	tlm_utils::simple_target_socket<LegacyTarget> socket;
+	unsigned char mem[SIZE];
+	uint64_t mTransportCount;
+
+	LegacyTarget(sc_module_name name): sc_module(name), socket("socket"), mTransportCount(0) {
+		socket.register_b_transport(this, &LegacyTarget::b_transport);
+		memset(mem, 0, SIZE);
+	}
+
+	void b_transport(tlm::tlm_generic_payload& trans, sc_time& delay) override {
+		mTransportCount++;
+		uint64_t offset = trans.get_address() - LEGACY_BASE;
+		if (offset >= LEGACY_FAIL) {
+			trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+			return;
+		}
+		if (trans.is_read()) memcpy(trans.get_data_ptr(), mem + offset, trans.get_data_length());
+		else memcpy(mem + offset, trans.get_data_ptr(), trans.get_data_length());
+		delay += sc_time(1, SC_NS);
+		trans.set_response_status(tlm::TLM_OK_RESPONSE);
+	}
+
+	bool get_direct_mem_ptr(tlm::tlm_generic_payload&, tlm::tlm_dmi&) override { return false; }
+	unsigned int transport_dbg(tlm::tlm_generic_payload&) override { return 0; }
+	tlm::tlm_sync_enum nb_transport_fw(tlm::tlm_generic_payload&, tlm::tlm_phase&, sc_time&) override {
+		return tlm::TLM_COMPLETED;
+	}
+};
+
+class TestInitiator : public sc_module, public InitiatorIf
+{
+public:
+	TestInitiator(sc_module_name name):
+		sc_module(name),
+		InitiatorIf(string(name), 0, true, 1)
+	{}
+};
+
+//Device input of a coherence interconnect, which expects the source of the accesses
+class TestDevice : public sc_module
+{
+public:
+	tlm_utils::simple_initiator_socket<TestDevice> socket;
+
+	TestDevice(sc_module_name name): sc_module(name), socket("socket") {}
+
+	tlm::tlm_response_status access(const vector<VectoredSegment>& segments, tlm::tlm_command cmd, sc_time& delay) {
+		tlm::tlm_generic_payload trans;
+		VectoredExtension vec;
+		SourceDeviceExtension src;
+		src.type = 1;
+		src.device_id = DEVICE_ID;
+		src.time_stamp = sc_time_stamp();
+		vec.Segments = segments;
+		trans.set_command(cmd);
+		trans.set_extension<SourceDeviceExtension>(&src);
+		trans.set_extension<VectoredExtension>(&vec);
+		tlm::tlm_response_status rsp = vectored_b_transport(
+				[&](tlm::tlm_generic_payload& t, sc_time& d) { socket->b_transport(t, d); }, trans, vec, delay);
+		if (rsp == tlm::TLM_OK_RESPONSE) EXPECT_EQ(segments.size(), vec.Serviced);
+		trans.clear_extension(&vec);
+		trans.clear_extension(&src);
+		return rsp;
+	}
+};
+
+static TestInitiator* cpu;
+static interconnect* bus;
+static memory* mem0;
+static memory* mem1;
+static LegacyTarget* legacy;
+static TestDevice* dev;
+static CoherenceInterconnect* coh;
+static memory* mem2;
+static memory* mem3;
+
+int sc_main(int argc, char* argv[])
+{
+	testing::InitGoogleTest(&argc, argv);
+
+	cpu = new TestInitiator("cpu");
+	bus = new interconnect("bus", 1, 3);
+	mem0 = new memory("mem0", SIZE);
+	mem1 = new memory("mem1", SIZE);
+	legacy = new LegacyTarget("legacy");
+
+	mem0->setBaseAddress(MEM0_BASE);
+	mem1->setBaseAddress(MEM1_BASE);
+	mem0->setEnableLatency(true);
+	mem0->setChannelWidth(8);
+	mem0->ReadLatency = mem0->WriteLatency = sc_time(10, SC_NS);
+	bus->set_socket_out_addr(0, MEM0_BASE, SIZE);
+	bus->set_socket_out_addr(1, LEGACY_BASE, SIZE);
+	bus->set_socket_out_addr(2, MEM1_BASE, SIZE);
+	bus->set_latency(sc_time(2, SC_NS));
+	bus->set_enable_latency(true);
+
+	cpu->getInitiatorSocket()[0]->bind(bus->socket_in[0]);
+	bus->socket_out[0].bind(mem0->mTargetSocket);
+	bus->socket_out[1].bind(legacy->socket);
+	bus->socket_out[2].bind(mem1->mTargetSocket);
+	cpu->setForceLt(true);
+
+	dev = new TestDevice("dev");
+	coh = new CoherenceInterconnect("coh", 0, 0, 0, 0, 2, 1, 8, 8, false, 0, 0);
+	mem2 = new memory("mem2", SIZE);
+	mem3 = new memory("mem3", SIZE);
+	mem2->setBaseAddress(MEM2_BASE);
+	mem3->setBaseAddress(MEM3_BASE);
+	coh->set_mmapped_output(0, MEM2_BASE, SIZE);
+	coh->set_mmapped_output(1, MEM3_BASE, SIZE);
+	coh->register_device_ctrl(DEVICE_ID, 0, 0);
+	dev->socket.bind(*coh->mDeviceSocketsIn[0]);
+	coh->mMMappedSocketsOut[0]->bind(mem2->mTargetSocket);
+	coh->mMMappedSocketsOut[1]->bind(mem3->mTargetSocket);
+
+	sc_start(SC_ZERO_TIME);
+
+	return RUN_ALL_TESTS();
+}
+
+TEST(interconnectVectored, singleTarget){
+	uint32_t src[3] = { 0x11111111, 0x22222222, 0x33333333 }, dst[3] = { 0, 0, 0 };
+	vector<VectoredSegment> wr = {
+		{ MEM0_BASE + 0x100, 4, (unsigned char*)&src[0] },
+		{ MEM0_BASE + 0x800, 4, (unsigned char*)&src[1] },
+		{ MEM0_BASE + 0x010, 4, (unsigned char*)&src[2] } };
+	vector<VectoredSegment> rd = wr;
+	for (size_t i = 0; i < rd.size(); i++) rd[i].ptr = (unsigned char*)&dst[i];
+
+	uint64_t writes = mem0->getWriteCount(), reads = mem0->getReadCount();
+	uint64_t legacyTransports = legacy->mTransportCount;
+	sc_time delay = SC_ZERO_TIME;
+
+	EXPECT_EQ(tlm::TLM_OK_RESPONSE, cpu->target_mem_access_vectored(0, wr, WRITE, delay));
+	EXPECT_EQ(tlm::TLM_OK_RESPONSE, cpu->target_mem_access_vectored(0, rd, READ, delay));
+
+	EXPECT_EQ(0, memcmp(src, dst, sizeof(src)));
+	EXPECT_EQ(writes + 12, mem0->getWriteCount());
+	EXPECT_EQ(reads + 12, mem0->getReadCount());
+	EXPECT_EQ(legacyTransports, legacy->mTransportCount);
+	//Per segment: bus latency and one memory word
+	EXPECT_EQ(sc_time(6 * (2 + 10), SC_NS), delay);
+}
+
+TEST(interconnectVectored, mixedTargets){
+	uint64_t src[5] = { 1, 2, 3, 4, 5 }, dst[5] = { 0, 0, 0, 0, 0 };
+	vector<VectoredSegment> wr = {
+		{ MEM0_BASE + 0x200, 8, (unsigned char*)&src[0] },
+		{ LEGACY_BASE + 0x040, 8, (unsigned char*)&src[1] },
+		{ MEM1_BASE + 0x300, 8, (unsigned char*)&src[2] },
+		{ MEM0_BASE + 0x208, 8, (unsigned char*)&src[3] },
+		{ LEGACY_BASE + 0x080, 8, (unsigned char*)&src[4] } };
+	vector<VectoredSegment> rd = wr;
+	for (size_t i = 0; i < rd.size(); i++) rd[i].ptr = (unsigned char*)&dst[i];
+
+	uint64_t legacyTransports = legacy->mTransportCount;
+	uint64_t mem1Writes = bus->getWriteCount(2), legacyWrites = bus->getWriteCount(1);
+	sc_time delay = SC_ZERO_TIME;
+
+	EXPECT_EQ(tlm::TLM_OK_RESPONSE, cpu->target_mem_access_vectored(0, wr, WRITE, delay));
+
+	//The legacy target serviced the first of its segments, then the second one alone
+	EXPECT_EQ(legacyTransports + 2, legacy->mTransportCount);
+	EXPECT_EQ(0, memcmp(legacy->mem + 0x40, &src[1], 8));
+	EXPECT_EQ(0, memcmp(legacy->mem + 0x80, &src[4], 8));
+	EXPECT_EQ(0, memcmp(mem0->getLocalMem() + 0x200, &src[0], 8));
+	EXPECT_EQ(0, memcmp(mem0->getLocalMem() + 0x208, &src[3], 8));
+	EXPECT_EQ(0, memcmp(mem1->getLocalMem() + 0x300, &src[2], 8));
+	EXPECT_EQ(mem1Writes + 8, bus->getWriteCount(2));
+	EXPECT_EQ(legacyWrites + 16, bus->getWriteCount(1));
+
+	EXPECT_EQ(tlm::TLM_OK_RESPONSE, cpu->target_mem_access_vectored(0, rd, READ, delay));
+	EXPECT_EQ(0, memcmp(src, dst, sizeof(src)));
+}
+
+TEST(interconnectVectored, sameDelayAsSequential){
+	uint64_t value = 0x0123456789abcdef;
+	vector<VectoredSegment> segs = {
+		{ MEM0_BASE + 0x400, 8, (unsigned char*)&value },
+		{ LEGACY_BASE + 0x400, 8, (unsigned char*)&value },
+		{ MEM1_BASE + 0x400, 8, (unsigned char*)&value },
+		{ MEM0_BASE + 0x408, 8, (unsigned char*)&value } };
+
+	sc_time sequential = SC_ZERO_TIME, vectored = SC_ZERO_TIME;
+	for (const VectoredSegment& seg : segs) {
+		EXPECT_EQ(tlm::TLM_OK_RESPONSE, cpu->target_mem_access(0, seg.addr, seg.len, seg.ptr, WRITE, sequential));
+	}
+	EXPECT_EQ(tlm::TLM_OK_RESPONSE, cpu->target_mem_access_vectored(0, segs, WRITE, vectored));
+	EXPECT_EQ(sequential, vectored);
+}
+
+TEST(interconnectVectored, unmappedSegment){
+	uint64_t value = 0;
+	vector<VectoredSegment> segs = {
+		{ MEM0_BASE, 8, (unsigned char*)&value },
+		{ 0x50000, 8, (unsigned char*)&value } };
+	sc_time delay = SC_ZERO_TIME;
+
+	EXPECT_THROW(cpu->target_mem_access_vectored(0, segs, READ, delay), runtime_error);
+}
+
+TEST(interconnectVectored, failingTarget){
+	//Sent to the bus itself, so that the initiator DMI does not serve the memory segments
+	uint64_t src[4] = { 21, 22, 23, 24 };
+	vector<VectoredSegment> segs = {
+		{ MEM0_BASE + 0x600, 8, (unsigned char*)&src[0] },
+		{ LEGACY_BASE + LEGACY_FAIL, 8, (unsigned char*)&src[1] },
+		{ MEM0_BASE + 0x608, 8, (unsigned char*)&src[2] },
+		{ MEM1_BASE + 0x600, 8, (unsigned char*)&src[3] } };
+	memset(mem0->getLocalMem() + 0x600, 0, 16);
+	memset(mem1->getLocalMem() + 0x600, 0, 8);
+	uint64_t mem0Writes = bus->getWriteCount(0), mem1Writes = bus->getWriteCount(2);
+	uint64_t legacyWrites = bus->getWriteCount(1);
+
+	tlm::tlm_generic_payload trans;
+	VectoredExtension vec;
+	vec.Segments = segs;
+	trans.set_command(tlm::TLM_WRITE_COMMAND);
+	trans.set_extension<VectoredExtension>(&vec);
+	sc_time delay = SC_ZERO_TIME;
+	tlm::tlm_response_status rsp = vectored_b_transport(
+			[&](tlm::tlm_generic_payload& t, sc_time& d) { bus->b_transport(t, d); }, trans, vec, delay);
+	trans.clear_extension(&vec);
+
+	//Only the segment before the failing one is serviced, the later ones are neither sent nor accounted
+	EXPECT_EQ(tlm::TLM_ADDRESS_ERROR_RESPONSE, rsp);
+	EXPECT_EQ(1u, vec.Serviced);
+	EXPECT_EQ(0, memcmp(mem0->getLocalMem() + 0x600, &src[0], 8));
+	uint64_t zero = 0;
+	EXPECT_EQ(0, memcmp(mem0->getLocalMem() + 0x608, &zero, 8));
+	EXPECT_EQ(0, memcmp(mem1->getLocalMem() + 0x600, &zero, 8));
+	EXPECT_EQ(mem0Writes + 8, bus->getWriteCount(0));
+	EXPECT_EQ(legacyWrites + 8, bus->getWriteCount(1));
+	EXPECT_EQ(mem1Writes, bus->getWriteCount(2));
+}
+
+TEST(interconnectVectored, unsplitAcrossTargets){
+	uint64_t src[4] = { 11, 12, 13, 14 }, dst[4] = { 0, 0, 0, 0 };
+	vector<VectoredSegment> wr = {
+		{ MEM2_BASE + 0x100, 8, (unsigned char*)&src[0] },
+		{ MEM2_BASE + 0x108, 8, (unsigned char*)&src[1] },
+		{ MEM3_BASE + 0x200, 8, (unsigned char*)&src[2] },
+		{ MEM2_BASE + 0x110, 8, (unsigned char*)&src[3] } };
+	vector<VectoredSegment> rd = wr;
+	for (size_t i = 0; i < rd.size(); i++) rd[i].ptr = (unsigned char*)&dst[i];
+	sc_time delay = SC_ZERO_TIME;
+
+	//mem2 services the leading segments it holds, the others are sent one by one
+	EXPECT_EQ(tlm::TLM_OK_RESPONSE, dev->access(wr, tlm::TLM_WRITE_COMMAND, delay));
+	EXPECT_EQ(0, memcmp(mem2->getLocalMem() + 0x100, &src[0], 16));
+	EXPECT_EQ(0, memcmp(mem3->getLocalMem() + 0x200, &src[2], 8));
+	EXPECT_EQ(0, memcmp(mem2->getLocalMem() + 0x110, &src[3], 8));
+
+	EXPECT_EQ(tlm::TLM_OK_RESPONSE, dev->access(rd, tlm::TLM_READ_COMMAND, delay));
+	EXPECT_EQ(0, memcmp(src, dst, sizeof(src)));
+}
+
+TEST(interconnectVectored, unsplitFirstSegmentOutOfRange){
+	//The first segment is the one the router decoded: a target failing it still reports the error
+	uint64_t value = 0;
+	vector<VectoredSegment> segs = {
+		{ MEM2_BASE + SIZE - 4, 8, (unsigned char*)&value },
+		{ MEM3_BASE, 8, (unsigned char*)&value } };
+	sc_time delay = SC_ZERO_TIME;
+	tlm::tlm_generic_payload trans;
+	VectoredExtension vec;
+	vec.Segments = segs;
+	set_segment(trans, segs[0]);
+	trans.set_command(tlm::TLM_READ_COMMAND);
+	trans.set_extension<VectoredExtension>(&vec);
+	mem2->b_transport(trans, delay);
+	trans.clear_extension(&vec);
+	EXPECT_EQ(tlm::TLM_ADDRESS_ERROR_RESPONSE, trans.get_response_status());
+	EXPECT_EQ(0u, vec.Serviced);
+}
@@ -574,6 +574,9 @@ public:
 
 		registerOptionalAttribute("force_lt", "0");
 		registerOptionalAttribute("quantum_enable", "1");
+		registerOptionalAttribute("quantum_sync", ""); // unaligned or aligned, defaults to the platform mode
+		registerOptionalAttribute("quantum_max", "0"); // adaptive quantum between quantum and quantum_max, 0 for a fixed quantum
+		registerOptionalAttribute("quantum_shrink_threshold", "0"); // interactions per quantum tolerated before shrinking it
 
 		registerOptionalAttribute("wait_for_interrupt", "0");
 
@@ -619,6 +622,16 @@ public:
 			mModulePtr->setQuantumEnable(false);
 		}
 
+		if (!getAttr("quantum_sync").empty()) {
+			mModulePtr->setQuantumSyncMode(ParallelQuantumKeeper::parseSyncMode(getAttr("quantum_sync")));
+		}
+
+		if (getAttrAsUInt64("quantum_max")) {
+			mModulePtr->setAdaptiveQuantum(sc_time(getAttrAsUInt64("quantum")/1000, SC_NS),
+					sc_time(getAttrAsUInt64("quantum_max")/1000, SC_NS),
+					getAttrAsUInt64("quantum_shrink_threshold"));
+		}
+
 		if (getAttrAsUInt64("force_lt")) {
 			mModulePtr->setForceLt(true);
 		} else {
@@ -733,6 +746,9 @@ public:
 
 		registerOptionalAttribute("force_lt", "0");
 		registerOptionalAttribute("quantum_enable", "1");
+		registerOptionalAttribute("quantum_sync", ""); // unaligned or aligned, defaults to the platform mode
+		registerOptionalAttribute("quantum_max", "0"); // adaptive quantum between quantum and quantum_max, 0 for a fixed quantum
+		registerOptionalAttribute("quantum_shrink_threshold", "0"); // interactions per quantum tolerated before shrinking it
 
 		registerOptionalAttribute("wait_for_interrupt", "0");
 		registerOptionalAttribute("gic", "none");
@@ -798,6 +814,16 @@ public:
 			mModulePtr->setQuantumEnable(false);
 		}
 
+		if (!getAttr("quantum_sync").empty()) {
+			mModulePtr->setQuantumSyncMode(ParallelQuantumKeeper::parseSyncMode(getAttr("quantum_sync")));
+		}
+
+		if (getAttrAsUInt64("quantum_max")) {
+			mModulePtr->setAdaptiveQuantum(sc_time(getAttrAsUInt64("quantum")/1000, SC_NS),
+					sc_time(getAttrAsUInt64("quantum_max")/1000, SC_NS),
+					getAttrAsUInt64("quantum_shrink_threshold"));
+		}
+
 		mModulePtr->setIoOnly(getAttrAsUInt64("io_only"));
 		//mModulePtr->setDelayBeforeBoot(sc_time(getAttrAsUInt64("delay_before_boot"),SC_PS));
 		mModulePtr->setDelayBeforeBoot(sc_time(getAttrAsUInt64("delay_before_boot"),SC_NS));
@@ -1170,6 +1196,9 @@ struct DynamicCache : public VpsimIp<InPortType, OutPortType> {
       registerOptionalAttribute("home_base_address", "0");
       registerOptionalAttribute("home_size", "0");
       registerOptionalAttribute("l1i_simulate", "0");
+      registerOptionalAttribute("set_layout", "lines"); // lines, or tags to search the sets in tag arrays
+      registerOptionalAttribute("repl_seed", "1"); // seed of the RANDOM and BRRIP policies
+      registerOptionalAttribute("phys_addr_bits", "64"); // width of the physical addresses, bounding the width of the tags
     }
     inline unsigned int getnIn () {
       unsigned int nin = 1; // port for data from Level-1
@@ -1206,11 +1235,7 @@ struct DynamicCache : public VpsimIp<InPortType, OutPortType> {
     virtual void make() override {
       if (mModulePtr != nullptr) throw runtime_error("make() already called for DynamicCache");
       checkAttributes();
-      CacheReplacementPolicy repl;
-      if (getAttr("repl_policy") == "LRU") repl = LRU;
-      else if (getAttr("repl_policy") == "FIFO") repl = FIFO;
-      else if (getAttr("repl_policy") == "MRU") repl = MRU;
-      else throw runtime_error(getAttr("repl_policy") + " Unknown replacement policy");
+      CacheReplacementPolicy repl = getReplacementPolicy(getAttr("repl_policy")); // LRU, FIFO, MRU, PLRU, RANDOM, SRRIP or BRRIP
       CacheWritePolicy writePol;
       if (getAttr("writing_policy") == "WBack") writePol = WBack;
       else if (getAttr("writing_policy") == "WThrough") writePol = WThrough;
@@ -1253,6 +1278,10 @@ struct DynamicCache : public VpsimIp<InPortType, OutPortType> {
                              getAttrAsUInt64("is_home"),
                              getAttrAsUInt64("is_coherent"));
       setId(getAttrAsUInt64("id"));
+      mModulePtr->setPhysicalAddressBits(getAttrAsUInt64("phys_addr_bits"));
+      if (getAttr("set_layout") == "tags") mModulePtr->setSetLayout(TagArray);
+      else if (getAttr("set_layout") != "lines") throw runtime_error(getAttr("set_layout") + " Unknown set layout");
+      mModulePtr->setReplacementSeed(getAttrAsUInt64("repl_seed"));
 	  setDelayStatCapture(true);
       if (getAttrAsUInt64("local")) {
         mModulePtr->setIsPriv(true);
@@ -1717,11 +1746,11 @@ struct DynamicCache : public VpsimIp<InPortType, OutPortType> {
      virtual void connect(std::string outPortAlias, VpsimIp<InPortType,OutPortType>* otherIp, std::string inPortAlias) override {
        if (otherIp->isMemoryMapped()&&otherIp->isIdMapped())
          mModulePtr->
-           set_home_output (mConnectionCounter_home++, otherIp->getId(), otherIp->getBaseAddress(), otherIp->getSize());
+           set_home_output (mConnectionCounter_home++, otherIp->getId(), otherIp->getBaseAddress(), otherIp->getSize(), otherIp->getName());
        else if (otherIp->isIdMapped())
          mModulePtr-> set_cache_id (mConnectionCounter_cache++, otherIp->getId(), outPortAlias);
        else if (otherIp->isMemoryMapped())
-         mModulePtr-> set_mmapped_output (mConnectionCounter_mmapped++, otherIp->getBaseAddress(), otherIp->getSize());
+         mModulePtr-> set_mmapped_output (mConnectionCounter_mmapped++, otherIp->getBaseAddress(), otherIp->getSize(), otherIp->getName());
        else
          throw runtime_error ("Component is not id-mapped nor home nor memory-mmaped\n");
        VpsimIp<InPortType,OutPortType>::connect(outPortAlias, otherIp, inPortAlias);
@@ -1938,6 +1967,10 @@ struct DynamicNoCDeviceController
  		registerRequiredAttribute("mesh_x");
  		registerRequiredAttribute("mesh_y");
  		registerRequiredAttribute("router_latency");
+
+		registerOptionalAttribute("bytes_per_cycle", "0"); // bandwidth of each output port, 0 for no contention model
+		registerOptionalAttribute("cycle_ps", "1000");
+		registerOptionalAttribute("max_outstanding", "0"); // transactions in flight on each output port, 0 for no limit
  	}
 
      void pushStats() override {
@@ -1975,6 +2008,12 @@ struct DynamicNoCDeviceController
 			for (unsigned i = 0; i < getMaxOutPortCount(); i++) {
 				mStats[string("written_bytes[") + tostr(i) + "]"] = tostr(mModulePtr->getWriteCount(i));
 				mStats[string("read_bytes[") + tostr(i) + "]"] = tostr(mModulePtr->getReadCount(i));
+				if (getAttrAsUInt64("bytes_per_cycle") || getAttrAsUInt64("max_outstanding")) {
+					mStats[string("utilization[") + tostr(i) + "]"] = tostr(mModulePtr->getPortUtilization(i));
+					mStats[string("queued_accesses[") + tostr(i) + "]"] = tostr(mModulePtr->getPortQueuedCount(i));
+					mStats[string("queueing_delay_ns[") + tostr(i) + "]"] = tostr(mModulePtr->getPortQueueingDelay(i).to_seconds() * 1e9);
+					mStats[string("peak_occupancy[") + tostr(i) + "]"] = tostr(mModulePtr->getPortPeakOccupancy(i));
+				}
 			}
 			delete mModulePtr;
 		}
@@ -2014,17 +2053,21 @@ struct DynamicNoCDeviceController
 			mModulePtr->set_enable_latency(true);
  		} else {
  			mModulePtr->set_is_mesh(true);
- 			mModulePtr->set_mesh_coord(getAttrAsUInt64("mesh_x"),getAttrAsUInt64("mesh_x"));
+ 			mModulePtr->set_mesh_coord(getAttrAsUInt64("mesh_x"),getAttrAsUInt64("mesh_y"));
  			mModulePtr->set_router_latency(getAttrAsUInt64("router_latency"));
 			mModulePtr->set_enable_latency(false);
  		}
+		for (uint32_t i = 0; i < nOutPorts; i++) {
+			mModulePtr->set_port_bandwidth(i, getAttrAsUInt64("bytes_per_cycle"), sc_time(getAttrAsUInt64("cycle_ps"), SC_PS));
+			mModulePtr->set_port_max_outstanding(i, getAttrAsUInt64("max_outstanding"));
+		}
  	}
 
  	virtual void connect(std::string outPortAlias, VpsimIp<InPortType,OutPortType>* otherIp, std::string inPortAlias) override {
  		// set address before connecting (used for forwarding)
  		if (otherIp->isMemoryMapped()) {
  			cout<<"MAP : "<<otherIp->getBaseAddress()<<" - "<<otherIp->getSize()<<endl;
- 			mModulePtr->set_socket_out_addr(mConnectionCounter++, otherIp->getBaseAddress(), otherIp->getSize());
+ 			mModulePtr->set_socket_out_addr(mConnectionCounter++, otherIp->getBaseAddress(), otherIp->getSize(), otherIp->getName());
  		} else {
  			mModulePtr->setDefaultRoute(mConnectionCounter++);
  		}
@@ -2148,6 +2191,14 @@ struct DynamicMemory
 		registerOptionalAttribute("latency_enable", "1");
 		registerRequiredAttribute("dmi_enable");
 
+		//Host pages backing the memory are only committed when first accessed
+		registerOptionalAttribute("sparse", "0");
+
+		//Initial content mapped copy-on-write from a file (implies sparse), final content saved to a file
+		registerOptionalAttribute("image_file", "");
+		registerOptionalAttribute("image_offset", "0");
+		registerOptionalAttribute("save_image", "");
+
 		//registerRequiredAttribute("noc");
 
 	}
@@ -2174,6 +2225,10 @@ struct DynamicMemory
 		if (mModulePtr) {
 			mStats["reads"] = tostr(mModulePtr->getReadCount());
 			mStats["writes"] = tostr(mModulePtr->getWriteCount());
+			mStats["resident_bytes"] = tostr(mModulePtr->getResidentBytes());
+			if (!getAttr("save_image").empty()) {
+				mModulePtr->saveImage(getAttr("save_image"));
+			}
 			delete mModulePtr;
 		}
 	}
@@ -2199,7 +2254,12 @@ struct DynamicMemory
 		}
 		checkAttributes();
 		mModulePtr = new memory ( getName().c_str(),
-				getAttrAsUInt64("size") );
+				getAttrAsUInt64("size"), false, false,
+				getAttrAsUInt64("sparse") || !getAttr("image_file").empty() );
+
+		if (!getAttr("image_file").empty()) {
+			mModulePtr->loadBlob(getAttr("image_file"), 0, getAttrAsUInt64("image_offset"));
+		}
 
 		setDelayStatCapture(true);
 		mModulePtr->setBaseAddress(getAttrAsUInt64("base_address"));
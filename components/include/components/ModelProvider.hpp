@@ -48,7 +48,7 @@ namespace vpsim {
 				uint64_t CacheLineSize,
 				uint64_t Associativity,
 				CacheReplacementPolicy ReplPolicy=LRU)
-		: CacheBase<uint64_t,uint64_t>(name,CacheSize,CacheLineSize,Associativity,ReplPolicy){
+		: CacheBase<uint64_t,uint64_t>(name,CacheSize,CacheLineSize,Associativity,0,ReplPolicy){
 			// anything ?
 			SetEvictionNotifier(StandaloneInstructionCache::OnLineEvicted);
 			mCpuId=cpu_id;
@@ -445,6 +445,7 @@ namespace vpsim {
         uint64_t do_read(uint64_t addr,
                 unsigned size) {
             uint64_t res = 0;
+            if (!isMappedMemory(addr)) ParallelQuantumKeeper::notifyInteraction();
             InitiatorIf::tlm_error_checking(
                     InitiatorIf::target_mem_access(0, addr, size, (uint8_t *) & res,
                     READ, local_bias, index)
@@ -455,6 +456,7 @@ namespace vpsim {
         void do_write(uint64_t addr,
                 uint64_t data,
                 unsigned size) {
+            if (!isMappedMemory(addr)) ParallelQuantumKeeper::notifyInteraction();
             InitiatorIf::tlm_error_checking(
                     InitiatorIf::target_mem_access(0, addr, size, (uint8_t *) & data,
                     WRITE, local_bias, index)
@@ -518,6 +520,14 @@ namespace vpsim {
 			}
 			return false;
 		}
+
+    	//! @return true if addr belongs to a memory mapped in the model, anything else being a device
+    	bool isMappedMemory(uint64_t addr) {
+			for (auto& t: mMaps) {
+				if (addr >= get<1>(t) && addr - get<1>(t) < get<2>(t)) return true;
+			}
+			return false;
+    	}
     };
 
     uint64_t model_provider_read_cb(void *opaque,
@@ -605,6 +615,10 @@ namespace vpsim {
             registerRequiredAttribute("icache_associativity");
             registerRequiredAttribute("icache_line_size");
             // registerRequiredAttribute("intc");
+
+            registerOptionalAttribute("quantum_sync", ""); // unaligned or aligned, defaults to the platform mode
+            registerOptionalAttribute("quantum_max", "0"); // adaptive quantum between quantum and quantum_max, 0 for a fixed quantum
+            registerOptionalAttribute("quantum_shrink_threshold", "0"); // interactions per quantum tolerated before shrinking it
         }
 
 
@@ -693,6 +707,16 @@ namespace vpsim {
 					/*assoc*/ getAttrAsUInt64("icache_associativity"),
 					/*repl*/ LRU
             );
+
+            if (!getAttr("quantum_sync").empty()) {
+                mModulePtr->quantum_keeper.setSyncMode(ParallelQuantumKeeper::parseSyncMode(getAttr("quantum_sync")));
+            }
+
+            if (getAttrAsUInt64("quantum_max")) {
+                mModulePtr->quantum_keeper.setAdaptiveQuantum(sc_time(getAttrAsUInt64("quantum"), SC_NS),
+                        sc_time(getAttrAsUInt64("quantum_max"), SC_NS),
+                        getAttrAsUInt64("quantum_shrink_threshold"));
+            }
         }
 
         virtual void addDmiAddress(std::string targetIpName, uint64_t baseAddr, uint64_t size, unsigned char* pointer, bool cached, bool has_dmi) override {
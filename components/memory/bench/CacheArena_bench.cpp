@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/*
+ * Startup time and resident memory of the sets of 16 way caches of 64 byte
+ * lines holding data, from 8 MB to 512 MB. The lines, replacement data and
+ * line data are allocated set by set and line by line, as CacheBase did
+ * before, or taken from the three arenas of the cache as it does now.
+ * Resident memory is read once the sets are built and again after the data
+ * of two ways of every set has been written, a cache only partly filled by
+ * the simulation. Each measure runs in its own process.
+ */
+
+#include "global.hpp"
+#include "CacheLine.hpp"
+#include "CacheSet.hpp"
+#include "CacheArena.hpp"
+#include <chrono>
+#include <iomanip>
+#include <fstream>
+#include <unistd.h>
+#include <sys/wait.h>
+
+using namespace vpsim;
+using namespace std;
+
+typedef CacheLine<uint64_t> Line;
+typedef CacheSet<Line, uint64_t> Set;
+
+static const unsigned LINE_SIZE = 64;
+static const unsigned ASSOC = 16;
+
+//! @return the resident memory of the process in MB
+static double residentMB() {
+	uint64_t pages = 0, resident = 0;
+	ifstream statm("/proc/self/statm");
+	statm >> pages >> resident;
+	return resident * (double) sysconf(_SC_PAGESIZE) / (1 << 20);
+}
+
+struct Result { double Startup, Built, Filled; };
+
+//Writes the data of two ways of every set, one line in eight
+static void fill(vector<Set>& sets, uint64_t& checksum) {
+	for (uint64_t s = 0; s < sets.size(); s++)
+		for (unsigned w = 0; w < 2; w++) {
+			unsigned char* data = sets[s].getLine(w).getDataPtr();
+			data[0] = s;
+			checksum += data[0] + data[LINE_SIZE - 1];
+		}
+}
+
+//Runs measure in a child process, so that each measure starts from the same heap
+static Result isolated(Result (*measure)(uint64_t, uint64_t&), uint64_t cacheSize, uint64_t& checksum) {
+	struct { Result R; uint64_t Checksum; } out = { { 0, 0, 0 }, 0 };
+	int fds[2];
+	if (pipe(fds) != 0) throw runtime_error("pipe failed");
+	pid_t pid = fork();
+	if (pid == 0) {
+		out.R = measure(cacheSize, out.Checksum);
+		if (write(fds[1], &out, sizeof(out)) != sizeof(out)) _exit(1);
+		_exit(0);
+	}
+	if (read(fds[0], &out, sizeof(out)) != sizeof(out)) throw runtime_error("measure failed");
+	waitpid(pid, NULL, 0);
+	close(fds[0]);
+	close(fds[1]);
+	checksum += out.Checksum;
+	return out.R;
+}
+
+static Result perLine(uint64_t cacheSize, uint64_t& checksum) {
+	const uint64_t nbSets = cacheSize / LINE_SIZE / ASSOC;
+	const double base = residentMB();
+	Result r;
+	auto start = chrono::steady_clock::now();
+	vector<Set> sets;
+	sets.reserve(nbSets);
+	for (uint64_t s = 0; s < nbSets; s++) {
+		sets.emplace_back(LINE_SIZE, ASSOC, LRU);
+		for (unsigned w = 0; w < ASSOC; w++) sets.back().getLine(w).setDataPtr(new unsigned char [LINE_SIZE] ());
+	}
+	r.Startup = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+	r.Built = residentMB() - base;
+	fill(sets, checksum);
+	r.Filled = residentMB() - base;
+	return r;
+}
+
+static Result arenas(uint64_t cacheSize, uint64_t& checksum) {
+	const uint64_t nbLines = cacheSize / LINE_SIZE;
+	const uint64_t nbSets = nbLines / ASSOC;
+	const double base = residentMB();
+	Result r;
+	auto start = chrono::steady_clock::now();
+	CacheArena<Line> lines(nbLines);
+	CacheArena<unsigned> ages(nbLines);
+	CacheArena<unsigned char> data(cacheSize);
+	vector<Set> sets;
+	sets.reserve(nbSets);
+	for (uint64_t s = 0; s < nbSets; s++) {
+		sets.emplace_back(&lines[s * ASSOC], &ages[s * ASSOC], LINE_SIZE, ASSOC, LRU);
+		sets.back().setData(&data[s * ASSOC * LINE_SIZE]);
+	}
+	r.Startup = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+	r.Built = residentMB() - base;
+	fill(sets, checksum);
+	r.Filled = residentMB() - base;
+	return r;
+}
+
+int sc_main(int argc, char* argv[])
+{
+	uint64_t checksum = 0;
+	cout << setw(8) << "size" << setw(12) << "layout" << setw(14) << "startup (ms)" << setw(14) << "built (MB)" << setw(14) << "filled (MB)" << endl;
+	for (uint64_t mb : { 8u, 64u, 512u }) {
+		Result p = isolated(perLine, mb << 20, checksum);
+		Result a = isolated(arenas, mb << 20, checksum);
+		cout << fixed << setprecision(1);
+		cout << setw(6) << mb << "MB" << setw(12) << "per line" << setw(14) << p.Startup << setw(14) << p.Built << setw(14) << p.Filled << endl;
+		cout << setw(8) << "" << setw(12) << "arenas" << setw(14) << a.Startup << setw(14) << a.Built << setw(14) << a.Filled << endl;
+	}
+	cout << "checksum " << checksum << endl;
+	return 0;
+}
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0 
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/*
+ * Coherence messages per second on a synthetic sharing workload: 16 coherent
+ * L1 caches and one home cache, connected by a minimal NoC that routes each
+ * message to its destination without timing. Every core reads and writes a
+ * small set of shared lines and a private region, so that most accesses
+ * trigger GetS/GetM requests, forwards and invalidations.
+ */
+
+#include "Cache.hpp"
+#include <chrono>
+#include <iomanip>
+#include <random>
+
+using namespace vpsim;
+using namespace sc_core;
+using namespace std;
+
+static const uint32_t NB_CORES = 16;
+static const idx_t HOME_ID = NB_CORES;
+static const uint64_t LINE_SIZE = 64;
+static const uint64_t SHARED_LINES = 64;
+static const uint64_t PRIVATE_SIZE = 256 * 1024;
+static const uint64_t ACCESSES = 1 << 22;
+
+typedef Cache<uint64_t, uint64_t> BenchCache;
+
+//Routes requests of the L1s to the home, and messages of the home to the L1s it targets
+class BenchNoc : public sc_module
+{
+public:
+	std::deque<tlm_utils::simple_target_socket<BenchNoc>> socket_in;
+	std::deque<tlm_utils::simple_initiator_socket<BenchNoc>> socket_out;
+	uint64_t Messages;
+
+	BenchNoc(sc_module_name name): sc_module(name), Messages(0) {
+		char name_socket[100];
+		for (uint32_t i = 0; i <= NB_CORES; i++) {
+			sprintf(name_socket, "socket_in[%u]", i);
+			socket_in.emplace_back(name_socket);
+			socket_in[i].register_b_transport(this, &BenchNoc::b_transport);
+			sprintf(name_socket, "socket_out[%u]", i);
+			socket_out.emplace_back(name_socket);
+		}
+	}
+
+	void b_transport(tlm::tlm_generic_payload& trans, sc_time& delay) {
+		CoherencePayloadExtension* ext;
+		trans.get_extension<CoherencePayloadExtension>(ext);
+		Messages++;
+		trans.set_response_status(tlm::TLM_OK_RESPONSE);
+		if (ext->getToHome()) {
+			socket_out[HOME_ID]->b_transport(trans, delay);
+		} else if (trans.get_command() == tlm::TLM_IGNORE_COMMAND) {
+			for (idx_t id : ext->getTargetIds())
+				socket_out[id]->b_transport(trans, delay);
+		}
+		//Reads and writes of the home go to memory, which answers immediately
+	}
+};
+
+int sc_main(int argc, char* argv[])
+{
+	BenchNoc noc("noc");
+	std::vector<BenchCache*> l1;
+	for (uint32_t i = 0; i < NB_CORES; i++) {
+		l1.push_back(new BenchCache(sc_module_name(("l1_" + to_string(i)).c_str()),
+				sc_time(1, SC_NS), 32 * 1024, LINE_SIZE, 4, 1, LRU, WBack, WAllocate, false,
+				i, 1, 1, 1, NINE, NINE, false, true));
+		l1[i]->socket_out[0].bind(noc.socket_in[i]);
+		noc.socket_out[i].bind(l1[i]->socket_in[0]);
+	}
+	BenchCache home("home", sc_time(10, SC_NS), 1024 * 1024, LINE_SIZE, 16, 1, LRU, WBack, WAllocate, false,
+			HOME_ID, 2, 1, 1, NINE, NINE, true, true);
+	home.socket_out[0].bind(noc.socket_in[HOME_ID]);
+	noc.socket_out[HOME_ID].bind(home.socket_in[0]);
+	sc_start(SC_ZERO_TIME);
+
+	mt19937_64 rng(42);
+	uint64_t value = 0;
+	sc_time delay = SC_ZERO_TIME;
+	tlm::tlm_generic_payload trans;
+	SourceCpuExtension src;
+	src.type = 0;
+	trans.set_data_ptr((unsigned char*) &value);
+	trans.set_data_length(8);
+	trans.set_streaming_width(8);
+	trans.set_byte_enable_ptr(nullptr);
+
+	auto start = chrono::steady_clock::now();
+	for (uint64_t i = 0; i < ACCESSES; i++) {
+		uint32_t core = i % NB_CORES;
+		uint64_t r = rng();
+		uint64_t addr = (r & 1)
+				? ((r >> 8) % SHARED_LINES) * LINE_SIZE
+				: (core + 1) * PRIVATE_SIZE * 4 + (((r >> 8) % PRIVATE_SIZE) & ~7ULL);
+		trans.set_address(addr);
+		trans.set_command(((r >> 1) & 3) == 0 ? tlm::TLM_WRITE_COMMAND : tlm::TLM_READ_COMMAND);
+		trans.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
+		src.cpu_id = core;
+		src.time_stamp = SC_ZERO_TIME;
+		trans.set_extension<SourceCpuExtension>(&src); //the L1 detaches it
+		l1[core]->b_transport(trans, delay);
+		trans.clear_extension(&src);
+	}
+	auto stop = chrono::steady_clock::now();
+
+	double seconds = chrono::duration<double>(stop - start).count();
+	cout << NB_CORES << " cores, " << ACCESSES << " accesses in " << fixed << setprecision(3) << seconds << " s" << endl;
+	cout << "coherence messages: " << noc.Messages << endl;
+	cout << "Mmessages/s: " << setprecision(2) << noc.Messages / seconds / 1e6 << endl;
+
+	for (BenchCache* c : l1) delete c;
+	return 0;
+}
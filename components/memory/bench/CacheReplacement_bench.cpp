@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/*
+ * Accesses per microsecond and miss rate of each replacement policy in a
+ * 256 KB, 16 way cache of 64 byte lines, on three synthetic traces:
+ * uniform random lines over twice the cache, a loop over 1.25 times the
+ * cache, and a hot quarter of the cache taking 90% of the accesses with the
+ * rest scanning through memory.
+ */
+
+#include "global.hpp"
+#include "CacheLine.hpp"
+#include "CacheSet.hpp"
+#include <chrono>
+#include <iomanip>
+
+using namespace vpsim;
+using namespace std;
+
+typedef CacheLine<uint64_t> Line;
+typedef CacheSet<Line, uint64_t> Set;
+
+static const unsigned LINE_SIZE = 64;
+static const unsigned CACHE_SIZE = 256 << 10;
+static const unsigned ASSOC = 16;
+static const unsigned NB_LINES = CACHE_SIZE / LINE_SIZE;
+static const unsigned NB_SETS = NB_LINES / ASSOC;
+static const uint64_t ACCESSES = 1 << 24;
+
+//Line numbers of the accesses
+static vector<uint64_t> makeTrace(const string& name) {
+	vector<uint64_t> trace(ACCESSES);
+	uint64_t rng = 1, scan = 0;
+	for (uint64_t i = 0; i < ACCESSES; i++) {
+		rng = rng * 6364136223846793005ull + 1442695040888963407ull;
+		if (name == "random") trace[i] = (rng >> 33) % (2 * NB_LINES);
+		else if (name == "loop") trace[i] = i % (NB_LINES + NB_LINES / 4);
+		else if ((rng >> 33) % 10) trace[i] = (rng >> 13) % (NB_LINES / 4);
+		else trace[i] = NB_LINES + scan++;
+	}
+	return trace;
+}
+
+static double run(CacheReplacementPolicy policy, const vector<uint64_t>& trace, double& missRate) {
+	vector<Set> sets(NB_SETS);
+	for (unsigned s = 0; s < NB_SETS; s++) {
+		sets[s] = Set(LINE_SIZE, ASSOC, policy);
+		sets[s].setSeed(s + 1);
+	}
+
+	uint64_t misses = 0;
+	auto start = chrono::steady_clock::now();
+	for (uint64_t lineNb : trace) {
+		Line* line = NULL;
+		const unsigned tag = lineNb / NB_SETS;
+		if (!sets[lineNb % NB_SETS].accessSet(tag, &line)) {
+			line->setNewLine(lineNb * LINE_SIZE, tag);
+			line->setState(Shared);
+			misses++;
+		}
+	}
+	auto stop = chrono::steady_clock::now();
+	missRate = 100.0 * misses / trace.size();
+	return trace.size() / chrono::duration<double, micro>(stop - start).count();
+}
+
+int sc_main(int argc, char* argv[])
+{
+	const pair<CacheReplacementPolicy, string> policies[] = {
+		{ LRU, "LRU" }, { FIFO, "FIFO" }, { MRU, "MRU" }, { PLRU, "PLRU" },
+		{ RANDOM, "RANDOM" }, { SRRIP, "SRRIP" }, { BRRIP, "BRRIP" } };
+
+	cout << setw(10) << "trace" << setw(10) << "policy" << setw(20) << "access/us" << setw(16) << "miss rate %" << endl;
+	for (const string name : { "random", "loop", "hot+scan" }) {
+		const vector<uint64_t> trace = makeTrace(name);
+		for (auto& policy : policies) {
+			double missRate;
+			const double speed = run(policy.first, trace, missRate);
+			cout << setw(10) << name << setw(10) << policy.second
+			     << setw(20) << fixed << setprecision(1) << speed << setw(16) << setprecision(2) << missRate << endl;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/*
+ * Tag lookups per microsecond in a 1 MB cache of 64 byte lines, 4 to 32
+ * ways, with the sets stored as lines and as tag arrays of 32 bit words
+ * (tags of up to 31 bits) or 64 bit words. Every set is full, lookups go to
+ * random sets and hit a random way half of the time.
+ */
+
+#include "global.hpp"
+#include "CacheLine.hpp"
+#include "CacheSet.hpp"
+#include <chrono>
+#include <iomanip>
+
+using namespace vpsim;
+using namespace std;
+
+typedef CacheLine<uint64_t> Line;
+typedef CacheSet<Line, uint64_t> Set;
+
+static const unsigned LINE_SIZE = 64;
+static const unsigned CACHE_SIZE = 1 << 20;
+static const uint64_t LOOKUPS = 1 << 24;
+
+static double run(unsigned assoc, CacheSetLayout layout, unsigned tagBits, const vector<pair<uint32_t, unsigned>>& lookups, uint64_t& checksum) {
+	const unsigned nbSets = CACHE_SIZE / LINE_SIZE / assoc;
+	vector<Set> sets(nbSets);
+	for (unsigned s = 0; s < nbSets; s++) {
+		sets[s] = Set(LINE_SIZE, assoc, LRU);
+		sets[s].setLayout(layout, tagBits);
+		for (unsigned w = 0; w < assoc; w++) {
+			//Tags of way w are 2*w+1, misses look for even tags
+			sets[s].getLine(w).setNewLine(0, 2 * w + 1);
+			sets[s].getLine(w).setState(Shared);
+		}
+	}
+
+	auto start = chrono::steady_clock::now();
+	for (auto& lookup : lookups) {
+		checksum += sets[lookup.first % nbSets].locateLineInSet(lookup.second % (2 * assoc));
+	}
+	auto stop = chrono::steady_clock::now();
+	return LOOKUPS / chrono::duration<double, micro>(stop - start).count();
+}
+
+int sc_main(int argc, char* argv[])
+{
+	vector<pair<uint32_t, unsigned>> lookups(LOOKUPS);
+	uint64_t rng = 1;
+	for (auto& lookup : lookups) {
+		rng = rng * 6364136223846793005ull + 1442695040888963407ull;
+		lookup = make_pair(rng >> 40, rng >> 16 & 0xffff);
+	}
+
+	uint64_t checksum = 0;
+	cout << setw(10) << "ways" << setw(22) << "lines (lookup/us)" << setw(22) << "tags32 (lookup/us)" << setw(22) << "tags64 (lookup/us)" << endl;
+	for (unsigned assoc : { 4u, 8u, 16u, 32u }) {
+		double lines = run(assoc, LineArray, 63, lookups, checksum);
+		double tags32 = run(assoc, TagArray, 31, lookups, checksum);
+		double tags64 = run(assoc, TagArray, 63, lookups, checksum);
+		cout << setw(10) << assoc << setw(22) << fixed << setprecision(1) << lines << setw(22) << tags32 << setw(22) << tags64 << endl;
+	}
+	cout << "checksum " << checksum << endl;
+	return 0;
+}
@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/*
+ * Directory requests per microsecond of a home tracking 16 cores, each with
+ * a private 4 MB direct-mapped cache, so up to a million lines are tracked.
+ * Every core reads and writes a set of shared lines and a private region
+ * four times larger than its cache, which sends GetS/GetM requests and
+ * PutS/PutM evictions to the home. The directory is kept as CacheBase kept
+ * it before, a std::map looked up again for each use whose entries are
+ * never erased, and as it keeps it now, a DirectoryTable looked up once per
+ * request whose Invalid entries are erased.
+ */
+
+#include "global.hpp"
+#include "CacheLine.hpp"
+#include "CoherenceExtension.hpp"
+#include "DirectoryTable.hpp"
+#include <map>
+#include <chrono>
+#include <iomanip>
+
+using namespace vpsim;
+using namespace std;
+
+static const idx_t NB_CORES = 16;
+static const uint64_t PRIVATE_LINES = 1 << 16;
+static const uint64_t SHARED_LINES = 4096;
+static const uint64_t ACCESSES = 1 << 22;
+
+struct DirectoryEntry { CoherenceState State; idx_t Owner; SharerSet Sharers; };
+
+//Private cache of a core, the line held by each slot and its state
+struct PrivateCache {
+	vector<uint64_t> Lines;
+	vector<CoherenceState> States;
+	PrivateCache() : Lines(PRIVATE_LINES, 0), States(PRIVATE_LINES, Invalid) {}
+};
+
+//Counts the forwarded requests and invalidations, and applies them to the private caches
+struct Messages {
+	vector<PrivateCache>& Cores;
+	uint64_t Count;
+	explicit Messages(vector<PrivateCache>& cores) : Cores(cores), Count(0) {}
+	void send(const SharerSet& ids, uint64_t line, CoherenceState state) {
+		for (idx_t id : ids) {
+			PrivateCache& core = Cores[id];
+			if (core.Lines[line % PRIVATE_LINES] == line) core.States[line % PRIVATE_LINES] = state;
+			Count++;
+		}
+	}
+};
+
+struct MapDirectory {
+	map<uint64_t, DirectoryEntry> Directory;
+
+	void getS(uint64_t line, idx_t core, Messages& msg) {
+		if (Directory.find(line) == Directory.end()) {
+			Directory[line] = { Shared, NULL_IDX, {core} };
+			return;
+		}
+		switch (Directory[line].State) {
+		case Invalid: Directory[line] = { Shared, NULL_IDX, {core} }; break;
+		case Shared: Directory[line].Sharers.insert(core); break;
+		case Modified:
+			msg.send({Directory[line].Owner}, line, Shared);
+			Directory[line] = { Shared, NULL_IDX, {core, Directory[line].Owner} };
+			break;
+		}
+	}
+	void getM(uint64_t line, idx_t core, Messages& msg) {
+		if (Directory.find(line) == Directory.end()) {
+			Directory[line] = { Modified, core, {} };
+			return;
+		}
+		switch (Directory[line].State) {
+		case Invalid: break;
+		case Shared:
+			Directory[line].Sharers.erase(core);
+			if (Directory[line].Sharers.size() != 0) msg.send(Directory[line].Sharers, line, Invalid);
+			break;
+		case Modified: msg.send({Directory[line].Owner}, line, Invalid); break;
+		}
+		Directory[line] = { Modified, core, {} };
+	}
+	void put(uint64_t line, idx_t core) {
+		if (Directory[line].State == Modified) Directory[line] = { Invalid, NULL_IDX, {} };
+		else {
+			Directory[line].Sharers.erase(core);
+			if (Directory[line].Sharers.size() == 0) Directory[line] = { Invalid, NULL_IDX, {} };
+		}
+	}
+	size_t size() const { return Directory.size(); }
+};
+
+struct TableDirectory {
+	DirectoryTable<uint64_t, DirectoryEntry> Directory;
+
+	TableDirectory() : Directory(DirectoryEntry { Invalid, NULL_IDX, {} }) {}
+
+	void getS(uint64_t line, idx_t core, Messages& msg) {
+		DirectoryEntry& entry = Directory[line];
+		switch (entry.State) {
+		case Invalid: entry = { Shared, NULL_IDX, {core} }; break;
+		case Shared: entry.Sharers.insert(core); break;
+		case Modified:
+			msg.send({entry.Owner}, line, Shared);
+			entry = { Shared, NULL_IDX, {core, entry.Owner} };
+			break;
+		}
+	}
+	void getM(uint64_t line, idx_t core, Messages& msg) {
+		DirectoryEntry& entry = Directory[line];
+		switch (entry.State) {
+		case Invalid: break;
+		case Shared:
+			entry.Sharers.erase(core);
+			if (entry.Sharers.size() != 0) msg.send(entry.Sharers, line, Invalid);
+			break;
+		case Modified: msg.send({entry.Owner}, line, Invalid); break;
+		}
+		entry = { Modified, core, {} };
+	}
+	void put(uint64_t line, idx_t core) {
+		DirectoryEntry* entry = Directory.find(line);
+		if (entry->State == Shared) {
+			entry->Sharers.erase(core);
+			if (entry->Sharers.size() != 0) return;
+		}
+		Directory.erase(line);
+	}
+	size_t size() const { return Directory.size(); }
+};
+
+template <typename Directory>
+static double run(const vector<uint64_t>& trace, uint64_t& messages, size_t& entries) {
+	vector<PrivateCache> cores(NB_CORES);
+	Messages msg(cores);
+	Directory dir;
+	uint64_t requests = 0;
+
+	auto start = chrono::steady_clock::now();
+	for (uint64_t i = 0; i < trace.size(); i++) {
+		const idx_t core = i % NB_CORES;
+		const uint64_t line = trace[i] >> 1;
+		const bool write = trace[i] & 1;
+		const uint64_t slot = line % PRIVATE_LINES;
+		PrivateCache& cache = cores[core];
+		if (cache.Lines[slot] != line && cache.States[slot] != Invalid) {
+			dir.put(cache.Lines[slot], core);
+			requests++;
+		}
+		const CoherenceState state = cache.Lines[slot] == line ? cache.States[slot] : Invalid;
+		cache.Lines[slot] = line;
+		if (write && state != Modified) {
+			dir.getM(line, core, msg);
+			cache.States[slot] = Modified;
+			requests++;
+		} else if (state == Invalid) {
+			dir.getS(line, core, msg);
+			cache.States[slot] = Shared;
+			requests++;
+		}
+	}
+	auto stop = chrono::steady_clock::now();
+	messages += msg.Count;
+	entries = dir.size();
+	return requests / chrono::duration<double, micro>(stop - start).count();
+}
+
+int sc_main(int argc, char* argv[])
+{
+	//Line number and write bit of each access
+	vector<uint64_t> trace(ACCESSES);
+	uint64_t rng = 1;
+	for (uint64_t i = 0; i < ACCESSES; i++) {
+		rng = rng * 6364136223846793005ull + 1442695040888963407ull;
+		const uint64_t core = i % NB_CORES;
+		const uint64_t r = rng >> 16;
+		const uint64_t line = (r & 7) == 0
+				? SHARED_LINES * (r >> 3 & 1) + ((r >> 4) % SHARED_LINES) //Lines shared by all the cores, shifted from the private slots
+				: (core + 1) * 16 * PRIVATE_LINES + (r >> 4) % (4 * PRIVATE_LINES);
+		trace[i] = line << 1 | (((r >> 40) & 3) == 0);
+	}
+
+	uint64_t messages[2] = { 0, 0 };
+	size_t entries[2];
+	const double map = run<MapDirectory>(trace, messages[0], entries[0]);
+	const double table = run<TableDirectory>(trace, messages[1], entries[1]);
+	cout << setw(18) << "directory" << setw(20) << "requests/us" << setw(12) << "entries" << setw(14) << "messages" << endl;
+	cout << setw(18) << "std::map" << setw(20) << fixed << setprecision(1) << map << setw(12) << entries[0] << setw(14) << messages[0] << endl;
+	cout << setw(18) << "DirectoryTable" << setw(20) << table << setw(12) << entries[1] << setw(14) << messages[1] << endl;
+	return 0;
+}
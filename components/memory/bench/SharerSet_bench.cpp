@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0 
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/*
+ * Cost of the directory operations on sharer sets, std::set against
+ * SharerSet, for 8, 64 and 256 sharers: fill the set of a line, copy it
+ * into a message, fan out over its ids, then reset it.
+ */
+
+#include "global.hpp"
+#include "SharerSet.hpp"
+#include <chrono>
+#include <iomanip>
+
+using namespace vpsim;
+using namespace std;
+
+static const uint64_t ROUNDS = 1 << 16;
+
+template <typename SetType>
+static double run(uint32_t sharers, uint64_t& checksum) {
+	SetType entry, message;
+	auto start = chrono::steady_clock::now();
+	for (uint64_t r = 0; r < ROUNDS; r++) {
+		for (uint32_t id = 0; id < sharers; id++)
+			entry.insert((id * 7 + r) % sharers);
+		message = entry;
+		for (uint32_t id : message)
+			checksum += id;
+		checksum += message.size();
+		entry.clear();
+	}
+	auto stop = chrono::steady_clock::now();
+	return chrono::duration<double, nano>(stop - start).count() / ROUNDS;
+}
+
+int sc_main(int argc, char* argv[])
+{
+	uint64_t checksum = 0;
+	cout << setw(10) << "sharers" << setw(18) << "std::set (ns)" << setw(18) << "SharerSet (ns)" << endl;
+	for (uint32_t sharers : { 8u, 64u, 256u }) {
+		double ref = run<set<uint32_t>>(sharers, checksum);
+		double bits = run<SharerSet>(sharers, checksum);
+		cout << setw(10) << sharers << setw(18) << fixed << setprecision(1) << ref << setw(18) << bits << endl;
+	}
+	cout << "checksum " << checksum << endl;
+	return 0;
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0 
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/*
+ * Startup time of a memory initialized from a large image file: copied in an
+ * eager memory, or mapped copy-on-write in a sparse one. The image size in
+ * MiB can be given as first argument (default 512). The file is written once
+ * before the measures, so that both loads start from a warm page cache.
+ */
+
+#include "memory.hpp"
+#include <chrono>
+#include <iomanip>
+#include <unistd.h>
+
+using namespace vpsim;
+using namespace sc_core;
+using namespace std;
+
+static const string IMAGE_NAME = "memoryImage_bench.bin";
+
+static double load(const string& name, uint64_t size, bool sparse, uint64_t& resident) {
+	auto start = chrono::steady_clock::now();
+	memory mem(name.c_str(), size, false, true, sparse);
+	mem.loadBlob(IMAGE_NAME, 0);
+	auto stop = chrono::steady_clock::now();
+
+	resident = mem.getResidentBytes();
+	return chrono::duration<double, milli>(stop - start).count();
+}
+
+int sc_main(int argc, char* argv[])
+{
+	const uint64_t size = (argc > 1 ? stoull(argv[1]) : 512) << 20;
+
+	vector<unsigned char> chunk(1 << 20);
+	for (size_t i = 0; i < chunk.size(); i++)
+		chunk[i] = (unsigned char) i;
+	FILE* f = fopen(IMAGE_NAME.c_str(), "wb");
+	for (uint64_t off = 0; off < size; off += chunk.size())
+		fwrite(chunk.data(), 1, chunk.size(), f);
+	fclose(f);
+
+	uint64_t copiedRes = 0, mappedRes = 0;
+	double copied = load("copied", size, false, copiedRes);
+	double mapped = load("mapped", size, true, mappedRes);
+
+	cout << "image of " << (size >> 20) << " MiB" << endl;
+	cout << setw(10) << "mode" << setw(16) << "startup (ms)" << setw(18) << "resident (MiB)" << endl;
+	cout << setw(10) << "copied" << setw(16) << fixed << setprecision(2) << copied << setw(18) << (copiedRes >> 20) << endl;
+	cout << setw(10) << "mapped" << setw(16) << fixed << setprecision(2) << mapped << setw(18) << (mappedRes >> 20) << endl;
+
+	unlink(IMAGE_NAME.c_str());
+	return 0;
+}
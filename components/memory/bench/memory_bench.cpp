@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0 
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/*
+ * Throughput of memory::b_transport for bursts from 1 B to 64 KiB, with
+ * latency enabled on a byte-wide channel (the default of the memory).
+ */
+
+#include "memory.hpp"
+#include <chrono>
+#include <iomanip>
+
+using namespace vpsim;
+using namespace sc_core;
+using namespace std;
+
+static const uint64_t MEM_BASE = 0x80000000;
+static const uint64_t MEM_SIZE = 0x100000;
+static const uint64_t BYTES_PER_RUN = 64ULL << 20;
+
+static double run(memory& mem, vector<unsigned char>& buf, unsigned int len) {
+	sc_time delay = SC_ZERO_TIME;
+	tlm::tlm_generic_payload trans;
+	trans.set_data_ptr(buf.data());
+	trans.set_data_length(len);
+	trans.set_streaming_width(len);
+	trans.set_byte_enable_ptr(nullptr);
+
+	const uint64_t accesses = BYTES_PER_RUN / len;
+	auto start = chrono::steady_clock::now();
+	for (uint64_t i = 0; i < accesses; i++) {
+		trans.set_address(MEM_BASE + ((i * len) & (MEM_SIZE - 1)));
+		trans.set_command((i & 1) ? tlm::TLM_READ_COMMAND : tlm::TLM_WRITE_COMMAND);
+		trans.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
+		mem.b_transport(trans, delay);
+	}
+	auto stop = chrono::steady_clock::now();
+
+	return accesses * len / chrono::duration<double>(stop - start).count();
+}
+
+int sc_main(int argc, char* argv[])
+{
+	memory mem("mem", MEM_SIZE);
+	mem.setBaseAddress(MEM_BASE);
+	mem.setEnableLatency(true);
+	mem.ReadLatency = sc_time(1, SC_NS);
+	mem.WriteLatency = sc_time(1, SC_NS);
+	sc_start(SC_ZERO_TIME);
+
+	vector<unsigned char> buf(64 * 1024, 0x5a);
+
+	cout << setw(12) << "burst (B)" << setw(16) << "MiB/s" << endl;
+	for (unsigned int len = 1; len <= 64 * 1024; len *= 2) {
+		double bps = run(mem, buf, len);
+		cout << setw(12) << len << setw(16) << fixed << setprecision(1) << bps / (1 << 20) << endl;
+	}
+
+	return 0;
+}
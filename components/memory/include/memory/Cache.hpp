@@ -24,6 +24,9 @@
 #include "DmiKeeper.hpp"
 #include "MainMemCosim.hpp"
 #include "CoherenceExtension.hpp"
+#include "CoherencePayloadPool.hpp"
+#include "VectoredTransport.hpp"
+#include "quantum.hpp"
 #include <functional>
 #include "log.hpp"
 
@@ -108,7 +111,7 @@ public:
       if (this->DataSupport) return send_transaction (lineDataPtr, addr, size, requesterId, tlm::TLM_READ_COMMAND, delay, timestamp);
       else                   return send_transaction (NULL       , addr, size, requesterId, tlm::TLM_READ_COMMAND, delay, timestamp);
   }
-  inline tlm::tlm_response_status BackwardRead (unsigned char* lineDataPtr, AddressType addr, size_t size, idx_t requesterId, set<idx_t> targetIds, sc_time& delay, sc_time timestamp) override {
+  inline tlm::tlm_response_status BackwardRead (unsigned char* lineDataPtr, AddressType addr, size_t size, idx_t requesterId, const SharerSet& targetIds, sc_time& delay, sc_time timestamp) override {
     assert (targetIds.size()>=0);
     if (this->DataSupport) return send_readback_transaction (lineDataPtr, addr, size, requesterId, targetIds, delay, timestamp);
     else                   return send_readback_transaction (NULL       , addr, size, requesterId, targetIds, delay, timestamp);
@@ -120,7 +123,7 @@ public:
   /*inline tlm::tlm_response_status BackInvalidate (AddressType addr, sc_time& delay) override {
     return send_invalidate_transaction (addr, delay);
     }*/
-  inline tlm::tlm_response_status BackInvalidate (AddressType addr, set<idx_t> targetIds, sc_time& delay, sc_time timestamp) override {
+  inline tlm::tlm_response_status BackInvalidate (AddressType addr, const SharerSet& targetIds, sc_time& delay, sc_time timestamp) override {
     assert (targetIds.size()>=0);
     return send_invalidate_transaction (addr, targetIds, delay, timestamp);
   }
@@ -129,37 +132,37 @@ public:
     else                   return send_evict_transaction (NULL       , addr, size, requesterID, delay, timestamp);
   }
   inline tlm::tlm_response_status SendGetS (unsigned char* lineDataPtr, AddressType addr, size_t size, idx_t requesterID, sc_time& delay, sc_time timestamp) override {
-    if (this->DataSupport) return send_coherence_transaction (lineDataPtr, addr, size, requesterID, this->Id, std::set<idx_t>(), GetS, delay, timestamp);
-    else                   return send_coherence_transaction (NULL       , addr, size, requesterID, this->Id, std::set<idx_t>(), GetS, delay, timestamp);
+    if (this->DataSupport) return send_coherence_transaction (lineDataPtr, addr, size, requesterID, this->Id, SharerSet(), GetS, delay, timestamp);
+    else                   return send_coherence_transaction (NULL       , addr, size, requesterID, this->Id, SharerSet(), GetS, delay, timestamp);
   }
   inline tlm::tlm_response_status SendGetM (unsigned char* lineDataPtr, AddressType addr, size_t size, idx_t requesterID, sc_time& delay, sc_time timestamp) override {
-    if (this->DataSupport) return send_coherence_transaction (lineDataPtr, addr, size, requesterID, this->Id, std::set<idx_t>(), GetM, delay, timestamp);
-    else                   return send_coherence_transaction (NULL       , addr, size, requesterID, this->Id, std::set<idx_t>(), GetM, delay, timestamp);
+    if (this->DataSupport) return send_coherence_transaction (lineDataPtr, addr, size, requesterID, this->Id, SharerSet(), GetM, delay, timestamp);
+    else                   return send_coherence_transaction (NULL       , addr, size, requesterID, this->Id, SharerSet(), GetM, delay, timestamp);
   }
   inline tlm::tlm_response_status SendPutS (unsigned char* lineDataPtr, AddressType addr, size_t size, idx_t requesterID, sc_time& delay, sc_time timestamp) override {
-    if (this->DataSupport) return send_coherence_transaction (lineDataPtr, addr, size, requesterID, this->Id, std::set<idx_t>(), PutS, delay, timestamp);
-    else                   return send_coherence_transaction (NULL       , addr, size, requesterID, this->Id, std::set<idx_t>(), PutS, delay, timestamp);
+    if (this->DataSupport) return send_coherence_transaction (lineDataPtr, addr, size, requesterID, this->Id, SharerSet(), PutS, delay, timestamp);
+    else                   return send_coherence_transaction (NULL       , addr, size, requesterID, this->Id, SharerSet(), PutS, delay, timestamp);
   }
   inline tlm::tlm_response_status SendPutM (unsigned char* lineDataPtr, AddressType addr, size_t size, idx_t requesterID, sc_time& delay, sc_time timestamp) override {
-    if (this->DataSupport) return send_coherence_transaction (lineDataPtr, addr, size, requesterID, this->Id, std::set<idx_t>(), PutM, delay, timestamp);
-    else                   return send_coherence_transaction (NULL       , addr, size, requesterID, this->Id, std::set<idx_t>(), PutM, delay, timestamp);
+    if (this->DataSupport) return send_coherence_transaction (lineDataPtr, addr, size, requesterID, this->Id, SharerSet(), PutM, delay, timestamp);
+    else                   return send_coherence_transaction (NULL       , addr, size, requesterID, this->Id, SharerSet(), PutM, delay, timestamp);
   }
-  inline tlm::tlm_response_status SendFwdGetS (unsigned char* lineDataPtr, AddressType addr, size_t size, idx_t requesterID, set<idx_t> targetIds /*,const int targetId*/, sc_time& delay, sc_time timestamp) override {
+  inline tlm::tlm_response_status SendFwdGetS (unsigned char* lineDataPtr, AddressType addr, size_t size, idx_t requesterID, const SharerSet& targetIds /*,const int targetId*/, sc_time& delay, sc_time timestamp) override {
     //assert (targetId!=NULL_IDX);
     if (this->DataSupport) return send_coherence_transaction (lineDataPtr, addr, size, requesterID, this->Id, targetIds, FwdGetS, delay, timestamp);
     else                   return send_coherence_transaction (NULL       , addr, size, requesterID, this->Id, targetIds, FwdGetS, delay, timestamp);
   }
-  inline tlm::tlm_response_status SendFwdGetM (unsigned char* lineDataPtr, AddressType addr, size_t size, idx_t requesterID, set<idx_t> targetIds, sc_time& delay, sc_time timestamp) override {
+  inline tlm::tlm_response_status SendFwdGetM (unsigned char* lineDataPtr, AddressType addr, size_t size, idx_t requesterID, const SharerSet& targetIds, sc_time& delay, sc_time timestamp) override {
     //assert (targetIds!=NULL_IDX);
     if (this->DataSupport) return send_coherence_transaction (lineDataPtr, addr, size, requesterID, this->Id, targetIds, FwdGetM, delay, timestamp);
     else                   return send_coherence_transaction (NULL       , addr, size, requesterID, this->Id, targetIds, FwdGetM, delay, timestamp);
   }
-  inline tlm::tlm_response_status SendPutI (unsigned char* lineDataPtr, AddressType addr, size_t size, idx_t requesterID, set<idx_t> targetIds, sc_time& delay, sc_time timestamp) override {
+  inline tlm::tlm_response_status SendPutI (unsigned char* lineDataPtr, AddressType addr, size_t size, idx_t requesterID, const SharerSet& targetIds, sc_time& delay, sc_time timestamp) override {
     assert (targetIds.size()>0);
     if (this->DataSupport) return send_coherence_transaction (lineDataPtr, addr, size, requesterID, this->Id, targetIds, PutI, delay, timestamp);
     else                   return send_coherence_transaction (NULL       , addr, size, requesterID, this->Id, targetIds, PutI, delay, timestamp);
   }
-  inline tlm::tlm_response_status SendInvS (unsigned char* lineDataPtr, AddressType addr, size_t size, idx_t requesterID, set<idx_t> targetIds, sc_time& delay, sc_time timestamp) override {
+  inline tlm::tlm_response_status SendInvS (unsigned char* lineDataPtr, AddressType addr, size_t size, idx_t requesterID, const SharerSet& targetIds, sc_time& delay, sc_time timestamp) override {
     assert (targetIds.size()>0);
     if (this->DataSupport) return send_coherence_transaction (lineDataPtr, addr, size, requesterID, this->Id, targetIds, InvS, delay, timestamp);
     else                   return send_coherence_transaction (NULL       , addr, size, requesterID, this->Id, targetIds, InvS, delay, timestamp);
@@ -181,6 +184,7 @@ public:
   uint64_t getBackInvals()  { return this->NBackInvals;  }
   uint64_t getEvictions()   { return this->NEvicts;      }
   uint64_t getEvictBacks()  { return this->EvictBacks;   }
+  uint64_t getAddrErrors()  { return this->NAddrErrors;  }
 
   uint64_t getPutS()    { return this->NPutS;    }
   uint64_t getPutM()    { return this->NPutM;    }
@@ -201,46 +205,48 @@ private:
   bool DataSupport;
   uint32_t Level;
   bool IsHome;
+  CoherencePayloadPool PayloadPool; //!< payloads of the messages sent by this cache
 
-  tlm::tlm_response_status send_transaction (unsigned char* lineDataPtr, AddressType addr, size_t size, idx_t requesterId, const tlm::tlm_command command, sc_time& delay, sc_time timestamp){
-    size_t nb_bytes = size;
-    tlm::tlm_generic_payload trans;
+  //! Takes a payload from the pool and fills the fields shared by every message sent by this cache
+  CoherencePayloadPool::Payload& allocate_payload (tlm::tlm_command command, unsigned char* lineDataPtr, AddressType addr, size_t size, sc_time timestamp) {
+    CoherencePayloadPool::Payload& trans = PayloadPool.allocate();
     trans.set_command (command);
     trans.set_address (addr);
-    trans.set_data_length (nb_bytes);
+    trans.set_data_length (size);
     trans.set_data_ptr (lineDataPtr);
     trans.set_byte_enable_ptr (NULL);
     trans.set_byte_enable_length (0);
+    trans.set_dmi_allowed (false);
     trans.set_gp_option (tlm::TLM_MIN_PAYLOAD); //It is not a real TLM access
     trans.set_response_status (tlm::TLM_INCOMPLETE_RESPONSE);
+    trans.Coherence.clear();
+    trans.Source.type = 0;
+    trans.Source.cpu_id = this->Id; //TODO change
+    trans.Source.time_stamp = timestamp;
+    return trans;
+  }
+
+  //! Hands the payload back to the pool and returns its response status
+  tlm::tlm_response_status release_payload (CoherencePayloadPool::Payload& trans) {
+    tlm::tlm_response_status rsp = trans.get_response_status();
+    trans.release();
+    return rsp;
+  }
+
+  tlm::tlm_response_status send_transaction (unsigned char* lineDataPtr, AddressType addr, size_t size, idx_t requesterId, const tlm::tlm_command command, sc_time& delay, sc_time timestamp){
     assert (command != tlm::TLM_IGNORE_COMMAND);
-    CoherencePayloadExtension ext;
+    CoherencePayloadPool::Payload& trans = allocate_payload (command, lineDataPtr, addr, size, timestamp);
+    CoherencePayloadExtension& ext = trans.Coherence;
     ext.setToHome (!IsHome); // No communication between homes
     ext.setInitiatorId (this->Id); // Use cpu Ids for transactions between cpu private caches and shared LLCs
     ext.setRequesterId (requesterId);
-    trans.set_extension<CoherencePayloadExtension>(&ext);
-    SourceCpuExtension src;
-    src.cpu_id = this->Id;  //TODO change
-    src.time_stamp = timestamp;
-    trans.set_extension<SourceCpuExtension>(&src);
     socket_out[0] -> b_transport (trans, delay);
-    trans.clear_extension(&ext);
-    trans.clear_extension(&src);
-    return (trans.get_response_status());
+    return release_payload (trans);
   }
 
-  tlm::tlm_response_status send_coherence_transaction (unsigned char* lineDataPtr, AddressType addr, size_t size, idx_t requesterId, idx_t initiatorId, set<idx_t> targetIds, const CoherenceCommand command,  sc_time& delay, sc_time timestamp) {
-    size_t nb_bytes = size;
-    tlm::tlm_generic_payload trans;
-    trans.set_command (tlm::TLM_IGNORE_COMMAND);
-    trans.set_address (addr);
-    trans.set_data_length (nb_bytes);
-    trans.set_data_ptr (lineDataPtr);
-    trans.set_byte_enable_ptr (NULL);
-    trans.set_byte_enable_length (0);
-    trans.set_gp_option (tlm::TLM_MIN_PAYLOAD);
-    trans.set_response_status (tlm::TLM_INCOMPLETE_RESPONSE);
-    CoherencePayloadExtension ext;
+  tlm::tlm_response_status send_coherence_transaction (unsigned char* lineDataPtr, AddressType addr, size_t size, idx_t requesterId, idx_t initiatorId, const SharerSet& targetIds, const CoherenceCommand command,  sc_time& delay, sc_time timestamp) {
+    CoherencePayloadPool::Payload& trans = allocate_payload (tlm::TLM_IGNORE_COMMAND, lineDataPtr, addr, size, timestamp);
+    CoherencePayloadExtension& ext = trans.Coherence;
     ext.setToHome (!IsHome);
     ext.setCoherenceCommand (command);
     //ext.setInitiatorId (Id); // Use cache ids
@@ -248,14 +254,8 @@ private:
     ext.setRequesterId (requesterId);
     if (command==FwdGetS||command==FwdGetM||command==PutI||command==InvS||command==InvM){
       if (IsHome) assert (targetIds.size()>0);
-      ext.setTargetIds (targetIds);
+      ext.setTargetIds (targetIds); // copied: targetIds may be a directory entry updated by nested messages
     }
-    trans.set_extension<CoherencePayloadExtension>(&ext);
-
-    SourceCpuExtension src;
-    src.cpu_id = this->Id; //TODO change
-    src.time_stamp = timestamp;
-    trans.set_extension<SourceCpuExtension>(&src);
 
     switch (command) {
     case Read: case Write: // downstream, to memory
@@ -263,6 +263,7 @@ private:
       socket_out[0]-> b_transport (trans, delay);
       break;
     case FwdGetS: case FwdGetM: case PutI: case InvS: case InvM: // upstream
+      if (command != PutI) ParallelQuantumKeeper::notifyInteraction(); // line shared with another cpu
       if (IsHome) socket_out[0]-> b_transport (trans, delay); // from home via NOC
       else        socket_out[1]-> b_transport (trans, delay); // from lower cache
       break;
@@ -270,93 +271,63 @@ private:
       socket_out[1]-> b_transport (trans, delay);
       break;
     }
-    trans.clear_extension(&ext);
-    trans.clear_extension(&src);
-    return (trans.get_response_status());
+    return release_payload (trans);
   }
 
-  tlm::tlm_response_status send_invalidate_transaction (AddressType addr, set<idx_t> targetIds, sc_time& delay, sc_time timestamp) {
-    tlm::tlm_generic_payload trans;
-    trans.set_command (tlm::TLM_IGNORE_COMMAND);
-    trans.set_address (addr);
-    trans.set_data_length (0);
-    trans.set_data_ptr (NULL);
-    trans.set_byte_enable_ptr (NULL);
-    trans.set_byte_enable_length (0);
-    trans.set_gp_option (tlm::TLM_MIN_PAYLOAD); //It is not a real TLM access
-    trans.set_response_status (tlm::TLM_INCOMPLETE_RESPONSE);
-    CoherencePayloadExtension ext;
+  tlm::tlm_response_status send_invalidate_transaction (AddressType addr, const SharerSet& targetIds, sc_time& delay, sc_time timestamp) {
+    CoherencePayloadPool::Payload& trans = allocate_payload (tlm::TLM_IGNORE_COMMAND, NULL, addr, 0, timestamp);
+    CoherencePayloadExtension& ext = trans.Coherence;
     ext.setInitiatorId (this->Id); // Use cache Ids for transactions between private caches of the same cpu
     //ext.disableDefaultTarget();
     ext.setCoherenceCommand (Invalidate);
     ext.setToHome (!IsHome);
     if (IsHome) assert (targetIds.size()>0);
     ext.setTargetIds (targetIds);
-    trans.set_extension<CoherencePayloadExtension>(&ext);
-    SourceCpuExtension src;
-    src.cpu_id = this->Id; //TODO change
-    src.time_stamp = timestamp;
-    trans.set_extension<SourceCpuExtension>(&src);
     if (IsHome) socket_out[0] -> b_transport (trans, delay);
     else socket_out[1] -> b_transport (trans, delay);
-    trans.clear_extension(&ext);
-    trans.clear_extension(&src);
-    return (trans.get_response_status());
+    return release_payload (trans);
   }
 
   tlm::tlm_response_status send_evict_transaction (unsigned char* lineDataPtr, AddressType addr, size_t size, idx_t requesterID, sc_time& delay, sc_time timestamp) {
-    size_t nb_bytes = size;
-    tlm::tlm_generic_payload trans;
-    trans.set_command (tlm::TLM_IGNORE_COMMAND);
-    trans.set_address (addr);
-    trans.set_data_length (nb_bytes);
-    trans.set_data_ptr (lineDataPtr);
-    trans.set_byte_enable_ptr (NULL);
-    trans.set_byte_enable_length (0);
-    trans.set_gp_option (tlm::TLM_MIN_PAYLOAD); //It is not a real TLM access
-    trans.set_response_status (tlm::TLM_INCOMPLETE_RESPONSE);
-    CoherencePayloadExtension ext;
+    CoherencePayloadPool::Payload& trans = allocate_payload (tlm::TLM_IGNORE_COMMAND, lineDataPtr, addr, size, timestamp);
+    CoherencePayloadExtension& ext = trans.Coherence;
     ext.setInitiatorId (this->Id); // Use cache Ids for transactions between private caches of the same cpu
     ext.setCoherenceCommand (Evict);
     ext.setToHome (!IsHome);
-    trans.set_extension<CoherencePayloadExtension>(&ext);
-    SourceCpuExtension src;
-    src.cpu_id = this->Id; //TODO change
-    src.time_stamp = timestamp;
-    trans.set_extension<SourceCpuExtension>(&src);
     socket_out[0] -> b_transport (trans, delay);
-    trans.clear_extension(&ext);
-    trans.clear_extension(&src);
-    return (trans.get_response_status());
+    return release_payload (trans);
   }
 
-    tlm::tlm_response_status send_readback_transaction (unsigned char* lineDataPtr, AddressType addr, size_t size, idx_t requesterId, set<idx_t> targetIds, sc_time& delay, sc_time timestamp) {
-    size_t nb_bytes = size;
-    tlm::tlm_generic_payload trans;
-    trans.set_command (tlm::TLM_IGNORE_COMMAND);
-    trans.set_address (addr);
-    trans.set_data_length (nb_bytes);
-    trans.set_data_ptr (lineDataPtr);
-    trans.set_byte_enable_ptr (NULL);
-    trans.set_byte_enable_length (0);
-    trans.set_gp_option (tlm::TLM_MIN_PAYLOAD);
-    trans.set_response_status (tlm::TLM_INCOMPLETE_RESPONSE);
-    CoherencePayloadExtension ext;
+  tlm::tlm_response_status send_readback_transaction (unsigned char* lineDataPtr, AddressType addr, size_t size, idx_t requesterId, const SharerSet& targetIds, sc_time& delay, sc_time timestamp) {
+    CoherencePayloadPool::Payload& trans = allocate_payload (tlm::TLM_IGNORE_COMMAND, lineDataPtr, addr, size, timestamp);
+    CoherencePayloadExtension& ext = trans.Coherence;
     ext.setInitiatorId (this->Id);
     ext.setCoherenceCommand (ReadBack);
     ext.setToHome (!IsHome);
     if (IsHome) assert (targetIds.size()>0);
     ext.setTargetIds (targetIds);
-    trans.set_extension<CoherencePayloadExtension>(&ext);
-    SourceCpuExtension src;
-    src.cpu_id = this->Id; //TODO change 
-    src.time_stamp = timestamp;
-    trans.set_extension<SourceCpuExtension>(&src);
     if (IsHome) socket_out[0] -> b_transport (trans, delay);
     else socket_out[1] -> b_transport (trans, delay);
-    trans.clear_extension(&ext);
-    trans.clear_extension(&src);
-    return (trans.get_response_status());
+    return release_payload (trans);
+  }
+
+  //! Services every segment of a vectored read or write, in order, up to the first failing one
+  template<CoherenceCommand accessMode>
+  tlm::tlm_response_status accessVectored (VectoredExtension& vec, idx_t requesterId, idx_t srcId, sc_time& delay, sc_time timestamp) {
+    tlm::tlm_response_status rsp = tlm::TLM_OK_RESPONSE;
+    vec.Serviced = 0;
+    for (const VectoredSegment& seg : vec.Segments) {
+      if (accessMode==Write) {
+        rsp = this-> WriteData (seg.ptr, (AddressType) seg.addr, seg.len, requesterId, srcId, delay, timestamp, nullptr);
+        if (Level==1) delay += Latency;
+      } else {
+        rsp = this-> ReadData (seg.ptr, (AddressType) seg.addr, seg.len, requesterId, srcId, delay, timestamp, nullptr);
+        delay += Latency;
+      }
+      if (rsp != tlm::TLM_OK_RESPONSE) break;
+      vec.Serviced++;
+    }
+    return rsp;
   }
 
 protected:
@@ -406,12 +377,15 @@ public:
           ||  ((Level!=1)&&(trans.get_command()==tlm::TLM_READ_COMMAND)))
         delay += Latency;
     */
+    VectoredExtension* vec = trans.get_extension<VectoredExtension>();
     switch (trans.get_command()) {
     case tlm::TLM_WRITE_COMMAND : // From CPU in coherent mode, From CPU or higher caches in non-coherent mode
+      if (vec) { rsp = accessVectored<Write> (*vec, requesterId, srcId, delay, timestamp); break; }
       rsp = this-> WriteData (trans.get_data_ptr(), addr, trans.get_data_length(), requesterId, srcId, delay, timestamp, nullptr);
       if (Level==1) delay += Latency;
       break;
     case tlm::TLM_READ_COMMAND : // From CPU in coherent mode, From CPU or higher caches in non-coherent mode
+      if (vec) { rsp = accessVectored<Read> (*vec, requesterId, srcId, delay, timestamp); break; }
       rsp = this-> ReadData (trans.get_data_ptr(), addr, trans.get_data_length(), requesterId, srcId, delay, timestamp, nullptr);
       delay += Latency;
       break;
@@ -477,10 +451,24 @@ public:
       return socket_out[1] -> get_direct_mem_ptr (trans, dmi_data);
     } else return socket_out[0] -> get_direct_mem_ptr (trans, dmi_data);
   }
+  //! Debug accesses are forwarded downstream, then completed with the data of this cache, which is more
+  //! recent. A debug ReadBack is a snoop from a coherent interconnect: it only reaches this cache and the
+  //! caches above it, so that the most recent data ends up in the payload whatever the cache holding it.
   unsigned int transport_dbg (tlm::tlm_generic_payload& trans) override {
-    //return mInitiatorSocket -> transport_dbg ( trans );
-    trans.set_response_status (tlm::tlm_response_status::TLM_OK_RESPONSE);
-    throw;
+    const bool write = trans.get_command() == tlm::TLM_WRITE_COMMAND;
+    CoherencePayloadExtension* ext;
+    trans.get_extension<CoherencePayloadExtension>(ext);
+
+    if (ext && ext->getCoherenceCommand() == ReadBack) {
+      this->debugAccess (trans.get_data_ptr(), (AddressType) trans.get_address(), trans.get_data_length(), write);
+      if (!IsHome && NUM_PORT_OUT>1) socket_out[1] -> transport_dbg (trans);
+      trans.set_response_status (tlm::TLM_OK_RESPONSE);
+      return trans.get_data_length();
+    }
+
+    unsigned int nb_bytes = socket_out[0] -> transport_dbg (trans);
+    this->debugAccess (trans.get_data_ptr(), (AddressType) trans.get_address(), nb_bytes, write);
+    return nb_bytes;
   }
   tlm::tlm_sync_enum nb_transport_bw (tlm::tlm_generic_payload& trans, tlm::tlm_phase& phase, sc_core::sc_time& t) override {
     //return mTargetSocket -> nb_transport_bw ( trans, phase, t );
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef CACHEARENA_HPP_
+#define CACHEARENA_HPP_
+
+#include <cstdint>
+#include <cstddef>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <sys/mman.h>
+
+namespace vpsim {
+
+  //!
+  //! Array of the lines, replacement data or line data of a whole cache, in one anonymous
+  //! mapping. The array is page aligned, hence aligned on any line size up to a page, and
+  //! its pages are only backed (and zeroed) by the kernel on first touch: the data of the
+  //! lines a simulation never fills costs address space, not memory.
+  //! Elements of non trivial types are constructed, which touches their pages.
+  //!
+  template <typename T>
+  class CacheArena {
+
+  public:
+
+    CacheArena () : mBase (NULL), mCount (0) {}
+    explicit CacheArena (size_t count) : mBase (NULL), mCount (0) { allocate (count); }
+    ~CacheArena () { release (); }
+
+    CacheArena (const CacheArena&) = delete;
+    CacheArena& operator= (const CacheArena&) = delete;
+
+    //! replaces the content of the arena by count value-initialized elements
+    void allocate (size_t count) {
+      release ();
+      if (count == 0) return;
+      void* mem = mmap (NULL, count * sizeof (T), PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+      if (mem == MAP_FAILED)
+        throw std::runtime_error ("CacheArena: unable to reserve " + std::to_string (count * sizeof (T)) + " bytes");
+      mBase = (T*) mem;
+      mCount = count;
+      if (!std::is_trivial<T>::value)
+        for (size_t i = 0; i < mCount; i++) new (&mBase[i]) T ();
+    }
+
+    void release () {
+      if (!mBase) return;
+      if (!std::is_trivial<T>::value)
+        for (size_t i = 0; i < mCount; i++) mBase[i].~T ();
+      munmap (mBase, mCount * sizeof (T));
+      mBase = NULL;
+      mCount = 0;
+    }
+
+    inline T* data () { return mBase; }
+    inline T& operator[] (size_t i) { return mBase[i]; }
+    inline size_t size () const { return mCount; }
+    //! @return the bytes reserved, whether or not they have been touched yet
+    inline size_t bytes () const { return mCount * sizeof (T); }
+
+  private:
+
+    T*     mBase;
+    size_t mCount;
+  };
+}
+
+#endif /* CACHEARENA_HPP_ */
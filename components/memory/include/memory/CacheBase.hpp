@@ -27,6 +27,8 @@
 #include "systemc.h"
 #include "CacheLine.hpp"
 #include "CacheSet.hpp"
+#include "CacheArena.hpp"
+#include "DirectoryTable.hpp"
 #include "CoherenceExtension.hpp"
 
 using namespace std;
@@ -95,7 +97,7 @@ namespace vpsim{
   //! @tparam CacheLineSize	the size (in Bytes) of each line of data in the cache
   //! @tparam Associativity	the associativity degree of the cache. An Associativity shall be >0, Associativity of 1 stands for direct mapped cache
   //!  Increasing the Associativity does not increase the size of the cache.
-  //! @tparam ReplPolicy		the replacement policy of the cache (defaults to LRU, other values are not implemented yet)
+  //! @tparam ReplPolicy		the replacement policy of the cache (defaults to LRU, see CacheReplacementPolicy)
   //! @tparam WritePolicy		the write policy of the cache (defaults to write-back)
   //! @tparam AllocPolicy		the allocation policy of the cache (defaults to write Allocate)
   //!
@@ -112,6 +114,7 @@ namespace vpsim{
     // address bits
     // the address to a Bytes is of size [AddressBits] that can be decomposed in several fields [TagBits|IndexBits|OffsetBits]
     uint64_t AddressBits;                                     //!< number of bits composing a data address in the cache
+    uint64_t PhysAddrBits;                                    //!< number of bits of the physical addresses reaching the cache, at most AddressBits
     uint64_t OffsetBits;                                      //!< number of bits necessary to address a specific byte within a given CacheLine
     uint64_t InterleaveBits;
     uint64_t IndexBits;                                       //!< number of bits necessary to address a specific cache set
@@ -120,6 +123,7 @@ namespace vpsim{
     uint64_t OffsetMask;                                      //!< mask for the leastx-significant OffsetBits bits in a full AddressType
     uint64_t IndexMask;                                       //!< mask for the least-significant IndexBits bits in a full AddressType
     uint64_t TagMask;                                         //!< mask for the least-significant TagBits bits in a full AddressType
+    uint64_t PhysAddrMask;                                    //!< mask for the least-significant PhysAddrBits bits in a full AddressType
     //address Shifts
     uint64_t IndexShift;                                      //!< offset of the Index bits in the AddressType
     uint64_t TagShift;                                        //!< offset of the tag bits in the AddressType
@@ -138,6 +142,9 @@ namespace vpsim{
     typedef vector<CacheSetState> CacheState;                   //!< structure representing the state of a CacheBase, i.e. the state of all its CacheSet(s)
 
     CacheState CacheLines;                                      //!< the current state of the CacheBase
+    CacheArena<CacheLineType> LineArena;                        //!< lines of all the sets, set after set
+    CacheArena<unsigned> AgeArena;                              //!< replacement data of all the lines
+    CacheArena<unsigned char> DataArena;                        //!< data of all the lines, empty without data support
     uint64_t NbLines;                                           //!< number of cache lines in the cache
     uint64_t NbSets;                                            //!< the number of sets in the cache
     // indeed associativity = NbLinesPerSet
@@ -158,15 +165,43 @@ namespace vpsim{
 
     //uint64_t MaxLineSharers;
     //typedef uint64_t SharerIds [MaxLineSharers];
-    typedef  set<idx_t> SharerIds;
+    typedef  SharerSet SharerIds;
     struct DirectoryEntry { CoherenceState State; idx_t Owner; SharerIds Sharers; };
-    map<AddressType, DirectoryEntry> Directory; // Directory[3] = {Invalid, NULL_IDX, {0, 0, 0, 0} };
-    map<AddressType, SharerIds> Sharers;
+    DirectoryTable<AddressType, DirectoryEntry> Directory; //!< lines held by higher coherent caches, absent when Invalid
+    DirectoryTable<AddressType, SharerIds> Sharers;        //!< lines held by higher non-coherent caches, absent when none
+
+    //! derives TagBits, TagMask and PhysAddrMask from PhysAddrBits
+    void setTagFields () {
+      TagBits      = PhysAddrBits - IndexBits - InterleaveBits - OffsetBits; //!< number of bits that are to be stored as tags to uniquely identify a CacheLine from within a set
+      TagMask      = TagBits < 64 ? (1ULL<<TagBits)-1 : ~0ULL;
+      PhysAddrMask = PhysAddrBits < 64 ? (1ULL<<PhysAddrBits)-1 : ~0ULL;
+    }
+
+    //! @return the directory state of the line at addr, without creating its entry
+    inline CoherenceState directoryState (AddressType addr) {
+      DirectoryEntry* entry = Directory.find (addr);
+      return entry ? entry->State : Invalid;
+    }
+    //! forgets the line at addr once no higher cache holds it, so the directory only grows with the lines cached above
+    inline void releaseIfInvalid (AddressType addr, const DirectoryEntry& entry) {
+      if (entry.State == Invalid) Directory.erase (addr);
+    }
+    //! removes id from the sharers of the line at addr, and the line from Sharers once it has none
+    //! @return the remaining sharers, NULL if there are none
+    inline SharerIds* removeSharer (AddressType addr, idx_t id) {
+      SharerIds* sharers = Sharers.find (addr);
+      if (!sharers) return NULL;
+      sharers->erase (id);
+      if (!sharers->empty ()) return sharers;
+      Sharers.erase (addr);
+      return NULL;
+    }
 
   public :
 
     uint64_t MissCount, HitCount, NReads, NWrites, NInvals, NTotalInvals, NBackInvals, NEvicts, WriteBacks, EvictBacks,
-      HitReads, HitWrites, MissReads, MissWrites, NPutS, NPutM, NPutI, NGetS, NGetM, NFwdGetS, NFwdGetM, ReadBacks;
+      HitReads, HitWrites, MissReads, MissWrites, NPutS, NPutM, NPutI, NGetS, NGetM, NFwdGetS, NFwdGetM, ReadBacks,
+      NAddrErrors; //!< accesses rejected for being beyond the physical address width
     CacheInclusionPolicy InclusionOfHigher, InclusionOfLower;
     idx_t Id;
 
@@ -202,6 +237,7 @@ namespace vpsim{
     , ReplPolicy        (replPolicy)
     , WritePolicy       (writePolicy)
     , AllocPolicy       (allocPolicy)
+    , Directory         (DirectoryEntry { Invalid, NULL_IDX, {} })
     , MissCount         (0)
     , HitCount          (0)
     , InclusionOfHigher (inclusionOfHigher)
@@ -216,23 +252,28 @@ namespace vpsim{
       //address bits
       // the address to a Bytes is of size [AddressBits] that can be decomposed in several fields [TagBits|IndexBits|OffsetBits]
       AddressBits = sizeof(AddressType) * 8;              //!< number of bits composing a data address in the cache
+      PhysAddrBits = AddressBits;                         //!< see setPhysicalAddressBits
       OffsetBits  = (log2 (CacheLineSize));               //!< number of bits necessary to address a specific byte within a given CacheLine
       InterleaveBits  = NbInterleavedCaches > 0 ? log2 (NbInterleavedCaches): 0;
       IndexBits   = (log2 (NbSets));                      //!< number of bits necessary to address a specific cache set
-      TagBits     = AddressBits - IndexBits - InterleaveBits - OffsetBits; //!< number of bits that are to be stored as tags to uniquely identify a CacheLine from within a set
       //address masks
       OffsetMask  = (1ULL<<OffsetBits)-1;                 //!< mask for the least-significant OffsetBits bits in a full AddressType
       IndexMask   = (1ULL<<IndexBits)-1;                  //!< mask for the least-significant IndexBits bits in a full AddressType
-      TagMask     = (1ULL<<TagBits)-1;                    //!< mask for the least-significant TagBits bits in a full AddressType
+      setTagFields ();
       //address Shifts
       IndexShift = OffsetBits + InterleaveBits;           //!< offset of the Index bits in the AddressType
       TagShift = IndexBits + OffsetBits + InterleaveBits; //!< offset of the tag bits in the AddressType
 
       assert (ReplPolicy == LRU || !WCETMode);
-      CacheLines.resize(NbSets);
-
-      for (auto& set: CacheLines)
-        set = CacheSet <CacheLineType, AddressType> (CacheLineSize, Associativity, ReplPolicy/*, higherCachesNb*/);
+      // the sets share three arenas sized exactly NbSets x Associativity (x CacheLineSize for the data)
+      LineArena.allocate (NbLines);
+      AgeArena.allocate (NbLines);
+      if (DataSupport) DataArena.allocate (NbLines * CacheLineSize);
+      CacheLines.reserve(NbSets);
+      for (uint64_t i = 0; i < NbSets; i++) {
+        CacheLines.emplace_back (&LineArena[i * Associativity], &AgeArena[i * Associativity], CacheLineSize, Associativity, ReplPolicy);
+        if (DataSupport) CacheLines.back().setData (&DataArena[i * Associativity * CacheLineSize]);
+      }
 
       cout << "Cache parameters: " << endl;
       cout << "Address bits: "     << AddressBits   << endl;
@@ -247,12 +288,46 @@ namespace vpsim{
 
       NReads = NWrites = NInvals = NTotalInvals = NBackInvals = NEvicts = WriteBacks = EvictBacks = 0;
       NPutS = NPutM = NPutI = NGetS = NGetM = NFwdGetS = NFwdGetM = ReadBacks = 0;
+      NAddrErrors = 0;
     }
 
     //!
     //! Default destructor that displays stats for CacheBase upon destruction
     //!
-    ~CacheBase() { displayStats(); }
+    ~CacheBase() {
+      displayStats();
+    }
+
+    //!
+    //! selects how the ways of every set are stored and searched, the content of the cache is kept
+    //!
+    void setSetLayout (CacheSetLayout layout) {
+      for (auto& set: CacheLines) set.setLayout (layout, TagBits);
+    }
+
+    //!
+    //! sets the width of the physical addresses reaching the cache (AddressBits by default), which
+    //! bounds the width of the tags: tag arrays pack the tags of up to 31 bits and their valid bit
+    //! in 32 bit words, twice as many ways per compare. To be called before the first access.
+    //! Accesses to addresses of more than bits bits are rejected rather than aliased.
+    //!
+    void setPhysicalAddressBits (unsigned bits) {
+      if (bits > AddressBits || bits <= TagShift)
+        throw runtime_error (string (name ()) + ": physical address width " + to_string (bits) + " out of the address bits or not above the index bits");
+      PhysAddrBits = bits;
+      setTagFields ();
+      for (auto& set: CacheLines) set.setLayout (set.getLayout (), TagBits);
+    }
+    inline unsigned getTagBits () const {
+      return TagBits;
+    }
+
+    //!
+    //! seeds the victim generators of the RANDOM and BRRIP policies, each set from its own seed
+    //!
+    void setReplacementSeed (uint64_t seed) {
+      for (uint64_t i = 0; i < NbSets; i++) CacheLines[i].setSeed (seed ^ (i * 0x9e3779b97f4a7c15ULL));
+    }
 
     void SetEvictionNotifier(void(*ev)(void*)) {
       NotifyEvictions=true;
@@ -298,11 +373,12 @@ namespace vpsim{
     } else if (!isHit && InclusionOfHigher==Exclusive && accessMode==Read) {
       assert(Level!=1); // addr is the line base address
       NReads++;
-      if (Sharers.find(addr)!=Sharers.end() && Sharers[addr].size()!=0)
-        stat = BackwardRead (src_data_ptr, addr, CacheLineSize, requesterId, Sharers[addr], delay, timestamp);
+      SharerIds& sharers = Sharers[addr];
+      if (sharers.size()!=0)
+        stat = BackwardRead (src_data_ptr, addr, CacheLineSize, requesterId, sharers, delay, timestamp);
       else
         stat = ForwardReadData (src_data_ptr, addr, CacheLineSize, requesterId, delay, timestamp);
-      Sharers[addr].insert(initiatorId);
+      sharers.insert(initiatorId);
       return stat; //"return" & multiline accesses: "return" can be used safely here since size=CacheLineSize if Level>1
 
     } else {
@@ -320,11 +396,14 @@ namespace vpsim{
         EvictBacks++;
       }
       // Invalidation, assumes inclusive policy with higher cache
-      if (InclusionOfHigher==Inclusive && !isHit && Sharers[line->getAddress()].size()!=0) {
-        //stat = BackInvalidate (line->getAddress(), delay);
-        stat = BackInvalidate (line->getAddress(), Sharers[line->getAddress()], delay, timestamp);
-        Sharers[line->getAddress()].clear();
-        NBackInvals++;
+      if (InclusionOfHigher==Inclusive && !isHit) {
+        SharerIds* victimSharers = Sharers.find(line->getAddress());
+        if (victimSharers && victimSharers->size()!=0) {
+          //stat = BackInvalidate (line->getAddress(), delay);
+          stat = BackInvalidate (line->getAddress(), *victimSharers, delay, timestamp);
+          Sharers.erase(line->getAddress());
+          NBackInvals++;
+        }
       }
       // Prepare new line on miss
       if (!isHit && AllocPolicy==WAllocate) {
@@ -350,9 +429,8 @@ namespace vpsim{
         NReads++;
         break;
       case Write:
-        Sharers[line->getAddress()].erase(initiatorId);
         if (InclusionOfHigher==Exclusive && !isHit) {
-          if (Sharers.find(line->getAddress())!=Sharers.end() && Sharers[line->getAddress()].size()!=0) {
+          if (removeSharer(line->getAddress(), initiatorId)) {
             line->setState(Invalid);
           } else {
             stat = ForwardReadData (line->getDataPtr(), line->getAddress(), CacheLineSize, requesterId, delay, timestamp);
@@ -360,6 +438,7 @@ namespace vpsim{
             line->setState(Modified);
           }
         } else {
+          removeSharer(line->getAddress(), initiatorId);
           if (WritePolicy==WThrough) // Forward to next level
             stat = ForwardWriteData (line->getDataPtr(), addr, accessSize/*sizeof(WordType)*/, requesterId, delay, timestamp);
           else { // WritePolicy==WBack
@@ -382,9 +461,8 @@ namespace vpsim{
       case Evict: // From higher cache
         assert (InclusionOfHigher==Exclusive);
         cacheMemcpy (line->getDataPtr()+addr-line->getAddress(), src_data_ptr, accessSize);
-        Sharers[line->getAddress()].erase(initiatorId);
         assert(!isHit||line->getState()==Modified);
-        if (Sharers[line->getAddress()].size()!=0) line->setState(Invalid); else line->setState(Shared);
+        if (removeSharer(line->getAddress(), initiatorId)) line->setState(Invalid); else line->setState(Shared);
         NEvicts++;
         break;
       default:
@@ -531,7 +609,7 @@ namespace vpsim{
     assert (!isHit||(line->getAddress()<=addr && addr-line->getAddress()<CacheLineSize));
 
     assert (!isHit||addr==line->getAddress());
-    assert(!(isHit && line->getState()==Modified && Directory[addr].State==Modified));
+    assert(!(isHit && line->getState()==Modified && directoryState(addr)==Modified));
 
     if (accessMode==GetS) {
       if (isHit) HitCount++; else MissCount++;
@@ -544,84 +622,91 @@ namespace vpsim{
     }
     // Proceed Non-allocating requests
     switch (accessMode) { // should be addr not line->getAddress here
-    case FwdGetS: // In Exclusive L3, Readbacks are FwdGetSs
+    case FwdGetS: { // In Exclusive L3, Readbacks are FwdGetSs
       assert (initiatorId != NULL_IDX);
-      assert (Directory.find(addr) != Directory.end());
-      assert (isHit||Directory[addr].State!=Invalid); // Shared or Modified
-      assert (InclusionOfLower==Exclusive ||  ((isHit&&line->getState()==Modified)||Directory[addr].State==Modified));
+      DirectoryEntry& entry = Directory[addr];
+      assert (isHit||entry.State!=Invalid); // Shared or Modified
+      assert (InclusionOfLower==Exclusive ||  ((isHit&&line->getState()==Modified)||entry.State==Modified));
       if (isHit && line->getState()==Modified) // on miss, line addr!=addr
         line->setState(Shared);
-      if (!isHit&&Directory[addr].State==Shared) // Readback, exclusive policy
-        stat = SendFwdGetS (src_data_ptr, addr, CacheLineSize, requesterId, Directory[addr].Sharers, delay, timestamp);
-      if (Directory[addr].State==Modified) {
-        stat = SendFwdGetS (src_data_ptr, addr, CacheLineSize, requesterId, {Directory[addr].Owner}, delay, timestamp);
-        Directory[addr] = { Shared, NULL_IDX, {Directory[addr].Owner}};
+      if (!isHit&&entry.State==Shared) // Readback, exclusive policy
+        stat = SendFwdGetS (src_data_ptr, addr, CacheLineSize, requesterId, entry.Sharers, delay, timestamp);
+      if (entry.State==Modified) {
+        stat = SendFwdGetS (src_data_ptr, addr, CacheLineSize, requesterId, {entry.Owner}, delay, timestamp);
+        entry = { Shared, NULL_IDX, {entry.Owner}};
       }
-      assert (Directory[addr].State!=Modified);
-      assert (Directory[addr].Owner==NULL_IDX);
+      assert (entry.State!=Modified);
+      assert (entry.Owner==NULL_IDX);
       assert (!isHit || line->getState()==Shared);
+      releaseIfInvalid (addr, entry);
       NFwdGetS++;
       return stat;
-    case FwdGetM:
+    }
+    case FwdGetM: {
       assert (initiatorId != NULL_IDX);
-      assert (Directory.find(addr) != Directory.end());
-      assert((isHit&&line->getState()==Modified)||Directory[addr].State==Modified);
+      DirectoryEntry& entry = Directory[addr];
+      assert((isHit&&line->getState()==Modified)||entry.State==Modified);
       if (isHit)  line->setState(Invalid);
-      switch (Directory[addr].State) { // Invalid clean/dirty copy in L1
+      switch (entry.State) { // Invalid clean/dirty copy in L1
       case Shared:
-        stat = SendFwdGetM (src_data_ptr, addr, CacheLineSize, requesterId, {Directory[addr].Sharers}, delay, timestamp);
-        Directory[addr] = { Invalid, NULL_IDX, {}};
+        stat = SendFwdGetM (src_data_ptr, addr, CacheLineSize, requesterId, {entry.Sharers}, delay, timestamp);
+        entry = { Invalid, NULL_IDX, {}};
         break;
       case Modified:
-        stat = SendFwdGetM (src_data_ptr, addr, CacheLineSize, requesterId, {Directory[addr].Owner}, delay, timestamp);
-        Directory[addr] = { Invalid, NULL_IDX, {}};
+        stat = SendFwdGetM (src_data_ptr, addr, CacheLineSize, requesterId, {entry.Owner}, delay, timestamp);
+        entry = { Invalid, NULL_IDX, {}};
         break;
       case Invalid: break;
       }
       NFwdGetM++;
-      assert (Directory[addr].State==Invalid);
-      assert (Directory[addr].Owner==NULL_IDX);
-      assert (Directory[addr].Sharers.size()==0);
+      assert (entry.State==Invalid);
+      assert (entry.Owner==NULL_IDX);
+      assert (entry.Sharers.size()==0);
       assert (!isHit || line->getState()==Invalid);
+      releaseIfInvalid (addr, entry);
       return stat;
-    case PutS: // Replacement on higher cache, line being in shared state
-      assert (Directory.find(addr) != Directory.end());
-      assert (Directory[addr].State==Shared);
-      Directory[addr].Sharers.erase(initiatorId);
-      if (Directory[addr].Sharers.size()==0) {// Last PutS
-        Directory[addr] = { Invalid, NULL_IDX, {} };
+    }
+    case PutS: { // Replacement on higher cache, line being in shared state
+      DirectoryEntry& entry = Directory[addr];
+      assert (entry.State==Shared);
+      entry.Sharers.erase(initiatorId);
+      if (entry.Sharers.size()==0) {// Last PutS
+        entry = { Invalid, NULL_IDX, {} };
         if (!isHit) stat = SendPutS (src_data_ptr, addr, CacheLineSize, Id, delay, timestamp); // Line is no longer in caches, update LLC
       }
-      assert (Directory[addr].State!=Modified);
-      assert (Directory[addr].Owner==NULL_IDX);
-      //assert (Directory[addr].Sharers.size()==0); // does not hold if L2 is shared
+      assert (entry.State!=Modified);
+      assert (entry.Owner==NULL_IDX);
+      //assert (entry.Sharers.size()==0); // does not hold if L2 is shared
+      releaseIfInvalid (addr, entry);
       NPutS++;
       return stat;
-    case PutI:
-      assert (Directory.find(addr) != Directory.end());
-      assert ((isHit&&line->getState()==Shared)||Directory[addr].State==Shared);
-      assert (!isHit||(line->getState()!=Modified&&Directory[addr].State!=Modified));
+    }
+    case PutI: {
+      DirectoryEntry& entry = Directory[addr];
+      assert ((isHit&&line->getState()==Shared)||entry.State==Shared);
+      assert (!isHit||(line->getState()!=Modified&&entry.State!=Modified));
       if (isHit) line->setState(Invalid);
-      if (Directory[addr].State==Shared) {
-        //assert (Directory[addr].Sharers.size()!=0); // redundant
-        stat = SendPutI (src_data_ptr, addr, CacheLineSize, requesterId, Directory[addr].Sharers, delay, timestamp);
-        Directory[addr] = { Invalid, NULL_IDX, {}};
+      if (entry.State==Shared) {
+        //assert (entry.Sharers.size()!=0); // redundant
+        stat = SendPutI (src_data_ptr, addr, CacheLineSize, requesterId, entry.Sharers, delay, timestamp);
+        entry = { Invalid, NULL_IDX, {}};
       }
       NPutI++;
-      assert (Directory[addr].State==Invalid);
-      assert (Directory[addr].Owner==NULL_IDX);
-      assert (Directory[addr].Sharers.size()==0);
+      assert (entry.State==Invalid);
+      assert (entry.Owner==NULL_IDX);
+      assert (entry.Sharers.size()==0);
       assert (!isHit||line->getState()==Invalid);
+      releaseIfInvalid (addr, entry);
       return stat;
+    }
     default :
       break;
     }
     // Write-back victim line (clean & dirty)
     if (!isHit && line->getState()!=Invalid && WritePolicy==WBack) { // line=victim line != req line
-      assert (Directory.find(line->getAddress()) != Directory.end());
-      //assert (line->getState()!=Modified||Directory[line->getAddress()].State!=Modified);
+      //assert (line->getState()!=Modified||directoryState(line->getAddress())!=Modified);
       WriteBacks++;
-      switch (Directory[line->getAddress()].State) {
+      switch (directoryState(line->getAddress())) {
       case Invalid:
         if (line->getState()==Shared)
           stat = SendPutS (line->getDataPtr(), line->getAddress(), CacheLineSize, Id, delay, timestamp);
@@ -646,110 +731,97 @@ namespace vpsim{
       assert (line->getState()==Invalid);
     }
 
-    // Proceed allocating requests
+    // Proceed allocating requests, an absent directory entry being Invalid
+    const AddressType lineAddr = line->getAddress();
+    DirectoryEntry& entry = Directory[lineAddr];
     switch (accessMode) {
     case PutM: // Replacement on higher cache, line being in modified state
-        assert (Directory.find(line->getAddress()) != Directory.end());
-        switch (Directory[line->getAddress()].State) {
+        switch (entry.State) {
         case Invalid:
           assert(false); break;
         case Shared: // When this case occurs ?
           assert(false);
-          Directory[line->getAddress()].Sharers.erase(initiatorId);
-          if (Directory[line->getAddress()].Sharers.size()==0)  // Last PutM
-            Directory[line->getAddress()] ={ Invalid, NULL_IDX, {} };
+          entry.Sharers.erase(initiatorId);
+          if (entry.Sharers.size()==0)  // Last PutM
+            entry ={ Invalid, NULL_IDX, {} };
           break;
         case Modified:
-          assert (initiatorId == Directory[line->getAddress()].Owner);
+          assert (initiatorId == entry.Owner);
           line->setState(Modified);
-          Directory[line->getAddress()] = { Invalid, NULL_IDX, {} };
+          entry = { Invalid, NULL_IDX, {} };
           break;
         }
         NPutM++;
         break;
 
     case GetS:
-      if (Directory.find(line->getAddress()) == Directory.end()) {
-        assert (!isHit);
-        stat = SendGetS (line->getDataPtr(), addr, CacheLineSize, Id, delay, timestamp);
-        line->setState(Shared);
-        Directory[line->getAddress()] = { Shared, NULL_IDX, {initiatorId} };
-      } else {
-        switch (Directory[line->getAddress()].State) {
-        case Invalid:
-          if (!isHit) {
-            stat = SendGetS (line->getDataPtr(), addr, CacheLineSize, Id, delay, timestamp);
-            line->setState(Shared);
-          }
-          Directory[line->getAddress()] = { Shared, NULL_IDX, {initiatorId} };
-          break;
-        case Shared:
-          assert (find (Directory[line->getAddress()].Sharers.begin(),Directory[line->getAddress()].Sharers.end(),initiatorId)==Directory[line->getAddress()].Sharers.end());
-          if (!isHit) {
-            stat = SendFwdGetS (line->getDataPtr(), line->getAddress(), CacheLineSize, requesterId, Directory[line->getAddress()].Sharers, delay, timestamp);
-            line->setState(Shared);
-          }
-          Directory[line->getAddress()].Sharers.insert(initiatorId);
-          break;
-        case Modified:
-          assert (initiatorId != Directory[line->getAddress()].Owner);
-          stat = SendFwdGetS (line->getDataPtr(), line->getAddress(), CacheLineSize, requesterId, {Directory[line->getAddress()].Owner}, delay, timestamp); // get updated data
-          Directory[line->getAddress()] = {Shared, NULL_IDX, {initiatorId,  Directory[line->getAddress()].Owner}};
-          line->setState(Modified);
-          break;
+      switch (entry.State) {
+      case Invalid: // also when the line has never been requested
+        if (!isHit) {
+          stat = SendGetS (line->getDataPtr(), addr, CacheLineSize, Id, delay, timestamp);
+          line->setState(Shared);
         }
+        entry = { Shared, NULL_IDX, {initiatorId} };
+        break;
+      case Shared:
+        assert (find (entry.Sharers.begin(),entry.Sharers.end(),initiatorId)==entry.Sharers.end());
+        if (!isHit) {
+          stat = SendFwdGetS (line->getDataPtr(), lineAddr, CacheLineSize, requesterId, entry.Sharers, delay, timestamp);
+          line->setState(Shared);
+        }
+        entry.Sharers.insert(initiatorId);
+        break;
+      case Modified:
+        assert (initiatorId != entry.Owner);
+        stat = SendFwdGetS (line->getDataPtr(), lineAddr, CacheLineSize, requesterId, {entry.Owner}, delay, timestamp); // get updated data
+        entry = {Shared, NULL_IDX, {initiatorId,  entry.Owner}};
+        line->setState(Modified);
+        break;
       }
-      assert (Directory[line->getAddress()].State==Shared);
-      assert (Directory[line->getAddress()].Owner==NULL_IDX);
-      assert (Directory[line->getAddress()].Sharers.size()!=0);
+      assert (entry.State==Shared);
+      assert (entry.Owner==NULL_IDX);
+      assert (entry.Sharers.size()!=0);
       NGetS++;
       break;
 
     case GetM:
-      if (Directory.find(line->getAddress()) == Directory.end()) {
-        assert (!isHit);
-        stat = SendGetM (line->getDataPtr(), addr, CacheLineSize, Id, delay, timestamp);
-        Directory[line->getAddress()] = { Modified, initiatorId, {} };
-      } else {
-        switch (Directory[line->getAddress()].State) {
-        case Invalid:
-          if (line->getState()!=Modified) {
-            stat = SendGetM (line->getDataPtr(), addr, CacheLineSize, Id, delay, timestamp);
-          }
-          Directory[line->getAddress()] = { Modified, initiatorId, {} };
-          break;
-        case Shared:
-          if (line->getState()!=Modified) stat = SendGetM (line->getDataPtr(), addr, CacheLineSize, Id, delay, timestamp);
-          Directory[line->getAddress()].Sharers.erase(initiatorId);
-          if (Directory[line->getAddress()].Sharers.size()!=0)
-            stat = SendPutI (line->getDataPtr(), addr, CacheLineSize, requesterId, Directory[line->getAddress()].Sharers, delay, timestamp);
-          Directory[line->getAddress()] = { Modified, initiatorId, {} };
-          break;
-        case Modified: // What should be the line state
-          assert (initiatorId != Directory[line->getAddress()].Owner);
-          stat = SendFwdGetM (line->getDataPtr(), line->getAddress(), CacheLineSize, requesterId, {Directory[line->getAddress()].Owner}, delay, timestamp); // give updated data to requester
-          Directory[line->getAddress()].Owner = initiatorId;
-          break;
+      switch (entry.State) {
+      case Invalid: // also when the line has never been requested
+        if (line->getState()!=Modified) {
+          stat = SendGetM (line->getDataPtr(), addr, CacheLineSize, Id, delay, timestamp);
         }
+        entry = { Modified, initiatorId, {} };
+        break;
+      case Shared:
+        if (line->getState()!=Modified) stat = SendGetM (line->getDataPtr(), addr, CacheLineSize, Id, delay, timestamp);
+        entry.Sharers.erase(initiatorId);
+        if (entry.Sharers.size()!=0)
+          stat = SendPutI (line->getDataPtr(), addr, CacheLineSize, requesterId, entry.Sharers, delay, timestamp);
+        entry = { Modified, initiatorId, {} };
+        break;
+      case Modified: // What should be the line state
+        assert (initiatorId != entry.Owner);
+        stat = SendFwdGetM (line->getDataPtr(), lineAddr, CacheLineSize, requesterId, {entry.Owner}, delay, timestamp); // give updated data to requester
+        entry.Owner = initiatorId;
+        break;
       }
       line->setState(Shared);
-      assert (Directory[line->getAddress()].State==Modified);
-      assert (Directory[line->getAddress()].Owner==initiatorId);
-      assert (Directory[line->getAddress()].Sharers.size()==0);
+      assert (entry.State==Modified);
+      assert (entry.Owner==initiatorId);
+      assert (entry.Sharers.size()==0);
       NGetM++;
       break;
 
     case PutI:
-      assert (Directory.find(line->getAddress()) != Directory.end());
-      assert (line->getState()==Shared||Directory[line->getAddress()].State==Shared);
-      if (Directory[line->getAddress()].State==Shared) {
-        assert (Directory[line->getAddress()].Sharers.size()!=0);
-        stat = SendPutI (line->getDataPtr(), addr, CacheLineSize, requesterId, Directory[line->getAddress()].Sharers, delay, timestamp);
-        Directory[line->getAddress()] = { Invalid, NULL_IDX, {} };
+      assert (line->getState()==Shared||entry.State==Shared);
+      if (entry.State==Shared) {
+        assert (entry.Sharers.size()!=0);
+        stat = SendPutI (line->getDataPtr(), addr, CacheLineSize, requesterId, entry.Sharers, delay, timestamp);
+        entry = { Invalid, NULL_IDX, {} };
       }
-      assert (Directory[line->getAddress()].State==Invalid);
-      assert (Directory[line->getAddress()].Owner==NULL_IDX);
-      assert (Directory[line->getAddress()].Sharers.size()==0);
+      assert (entry.State==Invalid);
+      assert (entry.Owner==NULL_IDX);
+      assert (entry.Sharers.size()==0);
       if (line->getState()!=Invalid) line->setState(Invalid);
       NPutI++;
       break;
@@ -757,10 +829,10 @@ namespace vpsim{
     default:
       assert(false); break; //throw runtime_error ("Command prohibited for local coherent caches\n"); break;
     }
-    assert (Directory.find(line->getAddress())==Directory.end() ||
-            (Directory[addr].State==Invalid    && Directory[addr].Owner==NULL_IDX && Directory[addr].Sharers.size()==0) ||
-            (Directory[addr].State==Shared   && Directory[addr].Owner==NULL_IDX && Directory[addr].Sharers.size()!= 0) ||
-            (Directory[addr].State==Modified && Directory[addr].Owner!=NULL_IDX  && Directory[addr].Sharers.size()==0));
+    assert ((entry.State==Invalid    && entry.Owner==NULL_IDX && entry.Sharers.size()==0) ||
+            (entry.State==Shared   && entry.Owner==NULL_IDX && entry.Sharers.size()!= 0) ||
+            (entry.State==Modified && entry.Owner!=NULL_IDX  && entry.Sharers.size()==0));
+    releaseIfInvalid (lineAddr, entry);
     return stat;
   }
 
@@ -782,7 +854,7 @@ namespace vpsim{
       assert (!isHit||(line->getAddress()<=addr && addr-line->getAddress()<CacheLineSize));
 
       assert (!isHit||addr==line->getAddress());
-      assert(!(isHit && line->getState()==Modified && Directory[addr].State==Modified));
+      assert(!(isHit && line->getState()==Modified && directoryState(addr)==Modified));
 
       if (accessMode==GetS) {
         if (isHit) HitCount++; else MissCount++;
@@ -799,66 +871,60 @@ namespace vpsim{
         // TODO: factorize code GetS/GetM
         // Use addr rather than line (line is possibly not allocated)
         switch (accessMode) {
-        case GetS:
-          if (Directory.find(addr)==Directory.end()) { // Line has never been requested
+        case GetS: {
+          DirectoryEntry& entry = Directory[addr];
+          switch (entry.State) {
+          case Invalid: // Line is not in upper cache, or has never been requested
             stat = ForwardReadData (src_data_ptr, addr, CacheLineSize, requesterId, delay, timestamp);
-            Directory[addr] = { Shared, NULL_IDX, {initiatorId} };
-          } else {
-            switch (Directory[addr].State) {
-            case Invalid: // Line is not in upper cache
-              stat = ForwardReadData (src_data_ptr, addr, CacheLineSize, requesterId, delay, timestamp);
-              Directory[addr] = { Shared, NULL_IDX, {initiatorId} };
-              break;
-            case Shared:// Line is in upper cache
-              stat = SendFwdGetS (src_data_ptr, addr, CacheLineSize, requesterId, Directory[addr].Sharers, delay, timestamp);
-              Directory[addr].Sharers.insert(initiatorId);
-              break;
-            case Modified:
-              // if Owner==initiatorId,  LLC should have latest version
-              if (Directory[addr].Owner!=initiatorId)
-                stat = SendFwdGetS (src_data_ptr, addr, CacheLineSize, requesterId, {Directory[addr].Owner}, delay, timestamp);
-              Directory[addr] = { Shared, NULL_IDX, {initiatorId,  Directory[addr].Owner}};
-              break;
-            }
+            entry = { Shared, NULL_IDX, {initiatorId} };
+            break;
+          case Shared:// Line is in upper cache
+            stat = SendFwdGetS (src_data_ptr, addr, CacheLineSize, requesterId, entry.Sharers, delay, timestamp);
+            entry.Sharers.insert(initiatorId);
+            break;
+          case Modified:
+            // if Owner==initiatorId,  LLC should have latest version
+            if (entry.Owner!=initiatorId)
+              stat = SendFwdGetS (src_data_ptr, addr, CacheLineSize, requesterId, {entry.Owner}, delay, timestamp);
+            entry = { Shared, NULL_IDX, {initiatorId,  entry.Owner}};
+            break;
           }
-          assert (Directory[addr].State==Shared);
-          assert (Directory[addr].Owner==NULL_IDX);
-          assert (Directory[addr].Sharers.size()!=0);
+          assert (entry.State==Shared);
+          assert (entry.Owner==NULL_IDX);
+          assert (entry.Sharers.size()!=0);
           NGetS++;
           return stat;
           //break;
-        case GetM:
-          if (Directory.find(addr)==Directory.end()) { // Line has never been requested
+        }
+        case GetM: {
+          DirectoryEntry& entry = Directory[addr];
+          switch (entry.State) {
+          case Invalid: // Line is not in upper cache, or has never been requested
             stat = ForwardReadData (src_data_ptr, addr, CacheLineSize, requesterId, delay, timestamp);
-            Directory[addr] = { Modified, initiatorId, {} };
-          } else {
-            switch (Directory[addr].State) {
-            case Invalid: // Line is not in upper cache
-              stat = ForwardReadData (src_data_ptr, addr, CacheLineSize, requesterId, delay, timestamp);
-              Directory[addr] = { Modified, initiatorId, {} };
-              break;
-            case Shared: // Line is in upper cache
-              //if (!(Directory[line->getAddress()].Sharers.size()==1&&Directory[line->getAddress()].Sharers.find(initiatorId)))
-              assert (Directory[addr].Sharers.size()!=0);
-              Directory[addr].Sharers.erase(initiatorId);
-              if (Directory[addr].Sharers.size()!=0)
-                stat = SendPutI (src_data_ptr, addr, CacheLineSize, requesterId, Directory[addr].Sharers, delay, timestamp);
-              Directory[addr] = {Modified, initiatorId, {}};
-              break;
-            case Modified:
-              assert (Directory[addr].Owner!=NULL_IDX);
-              assert (Directory[addr].Owner != initiatorId);
-              stat = SendFwdGetM (src_data_ptr, addr, CacheLineSize, requesterId, {Directory[addr].Owner}, delay, timestamp);
-              Directory[addr].Owner = initiatorId;
-              break;
-            }
+            entry = { Modified, initiatorId, {} };
+            break;
+          case Shared: // Line is in upper cache
+            //if (!(entry.Sharers.size()==1&&entry.Sharers.find(initiatorId)))
+            assert (entry.Sharers.size()!=0);
+            entry.Sharers.erase(initiatorId);
+            if (entry.Sharers.size()!=0)
+              stat = SendPutI (src_data_ptr, addr, CacheLineSize, requesterId, entry.Sharers, delay, timestamp);
+            entry = {Modified, initiatorId, {}};
+            break;
+          case Modified:
+            assert (entry.Owner!=NULL_IDX);
+            assert (entry.Owner != initiatorId);
+            stat = SendFwdGetM (src_data_ptr, addr, CacheLineSize, requesterId, {entry.Owner}, delay, timestamp);
+            entry.Owner = initiatorId;
+            break;
           }
-          assert (Directory[addr].State==Modified);
-          assert (Directory[addr].Owner==initiatorId);
-          assert (Directory[addr].Sharers.size()==0);
+          assert (entry.State==Modified);
+          assert (entry.Owner==initiatorId);
+          assert (entry.Sharers.size()==0);
           NGetM++;
           return stat;
           //break;
+        }
         default:
           break;
         }
@@ -874,30 +940,31 @@ namespace vpsim{
         line->handle = handle;
       }
       assert (addr==line->getAddress());
-      // Proceed allocating requests
+      // Proceed allocating requests, an absent directory entry being Invalid
+      const AddressType lineAddr = line->getAddress();
+      DirectoryEntry& entry = Directory[lineAddr];
       switch (accessMode) {
 
       case PutS: //PutS is only allocating in exclusive cache
-        assert (Directory.find(line->getAddress()) != Directory.end());
-        assert (Directory[line->getAddress()].State==Shared);
-        switch (Directory[line->getAddress()].State) {
+        assert (entry.State==Shared);
+        switch (entry.State) {
         case Invalid: case Modified:
           assert (false); // do these cases happen ?
-          assert (Directory[line->getAddress()].Sharers.size()==0);
+          assert (entry.Sharers.size()==0);
           break;
         case Shared:
-            assert (Directory[line->getAddress()].Sharers.size()>0);
-            assert (Directory[line->getAddress()].Owner==NULL_IDX);
+            assert (entry.Sharers.size()>0);
+            assert (entry.Owner==NULL_IDX);
             assert(InclusionOfHigher!=Exclusive||!isHit);
-            Directory[line->getAddress()].Sharers.erase(initiatorId);
-            if (Directory[line->getAddress()].Sharers.size()==0) {// Last PutS
-              Directory[line->getAddress()] = { Invalid, NULL_IDX, {} };
+            entry.Sharers.erase(initiatorId);
+            if (entry.Sharers.size()==0) {// Last PutS
+              entry = { Invalid, NULL_IDX, {} };
               if (InclusionOfHigher==Exclusive) line->setState(Shared);
             }
             break;
         }
-        assert (Directory[line->getAddress()].State!=Modified);
-        assert (Directory[line->getAddress()].Owner==NULL_IDX);
+        assert (entry.State!=Modified);
+        assert (entry.Owner==NULL_IDX);
         NPutS++;
         break;
 
@@ -905,143 +972,126 @@ namespace vpsim{
         // cache behaviour
         line->setState(Modified);
         // directory behaviour
-        assert (Directory.find(line->getAddress()) != Directory.end());
-        switch (Directory[line->getAddress()].State) {
+        switch (entry.State) {
         case Invalid: case Shared: assert(false); break; // Maybe for shared, remove req from sharers
         case Modified:
-          assert (Directory[line->getAddress()].Owner!=NULL_IDX);
-          assert (Directory[line->getAddress()].Sharers.size()==0);
-          assert (initiatorId == Directory[line->getAddress()].Owner);
-          Directory[line->getAddress()] = { Invalid, NULL_IDX, {} };
+          assert (entry.Owner!=NULL_IDX);
+          assert (entry.Sharers.size()==0);
+          assert (initiatorId == entry.Owner);
+          entry = { Invalid, NULL_IDX, {} };
           break;
         }
         NPutM++;
         break;
 
       case GetS: // TODO: on GetS, line should be either in L2 or in L3
-        if (Directory.find(line->getAddress())==Directory.end()) { // Line has never been requested
-          assert (!isHit); // first request
-          assert (InclusionOfHigher!=Exclusive);
-          stat = ForwardReadData (src_data_ptr, line->getAddress(), CacheLineSize, requesterId, delay, timestamp);
-          line->setState(Shared);
-          Directory[line->getAddress()] = { Shared, NULL_IDX, {initiatorId} };
-        } else {
-          switch (Directory[line->getAddress()].State) {
-          case Invalid: // Line is not in upper cache
-            assert (Directory[line->getAddress()].Sharers.size()==0);
-            assert (Directory[line->getAddress()].Owner==NULL_IDX);
-            if (!isHit) {
-              assert (InclusionOfHigher!=Exclusive);
-              stat = ForwardReadData (src_data_ptr, line->getAddress(), CacheLineSize, requesterId, delay, timestamp);
-              line->setState(Shared);
-            } else if (InclusionOfHigher==Exclusive) {
-              if (line->getState()==Modified)
-                stat = ForwardWriteData (line->getDataPtr(), line->getAddress(), CacheLineSize, requesterId, delay, timestamp); // clean line
-              line->setState(Invalid);
-            }
-            Directory[line->getAddress()] = { Shared, NULL_IDX, {initiatorId} };
-            break;
-          case Shared: // Line is clean in upper cache
-            assert (Directory[line->getAddress()].Owner==NULL_IDX);
-            assert (Directory[line->getAddress()].Sharers.size()>0);
-            if (!isHit) {
-              assert (InclusionOfHigher!=Exclusive);
-              stat = SendFwdGetS (line->getDataPtr(), line->getAddress(), CacheLineSize, requesterId, Directory[line->getAddress()].Sharers, delay, timestamp);
-              line->setState(Shared);
-            } else if (InclusionOfHigher==Exclusive) {
-              if (line->getState()==Modified)
-                stat = ForwardWriteData (line->getDataPtr(), line->getAddress(), CacheLineSize, requesterId, delay, timestamp); // clean line
-              line->setState(Invalid);
-            }
-            Directory[line->getAddress()].Sharers.insert(initiatorId);
-            break;
-          case Modified: // Line is dirty in upper cache
-            assert (Directory[line->getAddress()].Sharers.size()==0);
-            assert (Directory[line->getAddress()].Owner!= NULL_IDX);
-            //if (Directory[line->getAddress()].Owner!=initiatorId) // should neccesssarily be owner!=initiatorId if correctly designed
-            if (Directory[line->getAddress()].Owner!=initiatorId) // possible if eq to PutMGetS
-              stat = SendFwdGetS (line->getDataPtr(), line->getAddress(), CacheLineSize, requesterId, {Directory[line->getAddress()].Owner}, delay, timestamp); // get updated data
-            Directory[line->getAddress()] = {Shared, NULL_IDX, {initiatorId,  Directory[line->getAddress()].Owner}};
-            if (InclusionOfHigher==Exclusive) {
-              assert (isHit); // Exclusive is non-allocating
-              stat = ForwardWriteData (line->getDataPtr(), line->getAddress(), CacheLineSize, requesterId, delay, timestamp);
-              line->setState(Invalid);
-            } else line->setState(Modified);
-            break;
+        switch (entry.State) {
+        case Invalid: // Line is not in upper cache, or has never been requested
+          assert (entry.Sharers.size()==0);
+          assert (entry.Owner==NULL_IDX);
+          if (!isHit) {
+            assert (InclusionOfHigher!=Exclusive);
+            stat = ForwardReadData (src_data_ptr, lineAddr, CacheLineSize, requesterId, delay, timestamp);
+            line->setState(Shared);
+          } else if (InclusionOfHigher==Exclusive) {
+            if (line->getState()==Modified)
+              stat = ForwardWriteData (line->getDataPtr(), lineAddr, CacheLineSize, requesterId, delay, timestamp); // clean line
+            line->setState(Invalid);
           }
+          entry = { Shared, NULL_IDX, {initiatorId} };
+          break;
+        case Shared: // Line is clean in upper cache
+          assert (entry.Owner==NULL_IDX);
+          assert (entry.Sharers.size()>0);
+          if (!isHit) {
+            assert (InclusionOfHigher!=Exclusive);
+            stat = SendFwdGetS (line->getDataPtr(), lineAddr, CacheLineSize, requesterId, entry.Sharers, delay, timestamp);
+            line->setState(Shared);
+          } else if (InclusionOfHigher==Exclusive) {
+            if (line->getState()==Modified)
+              stat = ForwardWriteData (line->getDataPtr(), lineAddr, CacheLineSize, requesterId, delay, timestamp); // clean line
+            line->setState(Invalid);
+          }
+          entry.Sharers.insert(initiatorId);
+          break;
+        case Modified: // Line is dirty in upper cache
+          assert (entry.Sharers.size()==0);
+          assert (entry.Owner!= NULL_IDX);
+          //if (entry.Owner!=initiatorId) // should neccesssarily be owner!=initiatorId if correctly designed
+          if (entry.Owner!=initiatorId) // possible if eq to PutMGetS
+            stat = SendFwdGetS (line->getDataPtr(), lineAddr, CacheLineSize, requesterId, {entry.Owner}, delay, timestamp); // get updated data
+          entry = {Shared, NULL_IDX, {initiatorId,  entry.Owner}};
+          if (InclusionOfHigher==Exclusive) {
+            assert (isHit); // Exclusive is non-allocating
+            stat = ForwardWriteData (line->getDataPtr(), lineAddr, CacheLineSize, requesterId, delay, timestamp);
+            line->setState(Invalid);
+          } else line->setState(Modified);
+          break;
         }
         NGetS++;
-        assert (Directory[line->getAddress()].State==Shared);
-        assert (Directory[line->getAddress()].Owner==NULL_IDX);
-        assert (Directory[line->getAddress()].Sharers.size()!=0);
+        assert (entry.State==Shared);
+        assert (entry.Owner==NULL_IDX);
+        assert (entry.Sharers.size()!=0);
         break;
 
       case GetM:
-        if (Directory.find(line->getAddress())==Directory.end()) { // Line has never been requested
-          assert (!isHit); // first request
-          assert (InclusionOfHigher!=Exclusive); // No line allocation in exclusive caches
-          stat = ForwardReadData (src_data_ptr, line->getAddress(), CacheLineSize, requesterId, delay, timestamp);
-          line->setState(Shared); // Line is not dirty yet
-          Directory[line->getAddress()] = { Modified, initiatorId, {} };
-        } else {
-          switch (Directory[line->getAddress()].State) {
-          case Invalid: // Line is not in upper cache
-            assert (Directory[line->getAddress()].Sharers.size()==0);
-            assert (Directory[line->getAddress()].Owner==NULL_IDX);
-            if (!isHit) {
-              assert (InclusionOfHigher!=Exclusive); // No line allocation in exclusive caches
-              stat = ForwardReadData (src_data_ptr, line->getAddress(), CacheLineSize, requesterId, delay, timestamp);
-              line->setState(Shared); // Line is not dirty yet
-            } else if (InclusionOfHigher==Exclusive && line->getState()==Modified) { // clean line before invalidation
-              stat = ForwardWriteData (line->getDataPtr(), line->getAddress(), CacheLineSize, requesterId, delay, timestamp);
-              line->setState(Invalid);
-            }
-            Directory[line->getAddress()] = { Modified, initiatorId, {} };
-            break;
-          case Shared: // Line is clean in upper cache
-            assert (Directory[line->getAddress()].Owner==NULL_IDX);
-            assert (Directory[line->getAddress()].Sharers.size()>0);
-            if (!isHit) {
-              assert (InclusionOfHigher!=Exclusive); // No line allocation in exclusive caches
-              stat = SendFwdGetS (line->getDataPtr(), line->getAddress(), CacheLineSize, requesterId, Directory[line->getAddress()].Sharers, delay, timestamp);
-              line->setState(Shared);
-            } else if (InclusionOfHigher==Exclusive && line->getState()==Modified) { // clean line before invalidation
-              stat = ForwardWriteData (line->getDataPtr(), line->getAddress(), CacheLineSize, requesterId, delay, timestamp);
-              line->setState(Invalid);
-            }
-            Directory[line->getAddress()].Sharers.erase(initiatorId);
-            assert(Directory[line->getAddress()].Sharers.find(initiatorId) == Directory[line->getAddress()].Sharers.end());
-            if (Directory[line->getAddress()].Sharers.size() != 0) // Invalidate all sharers
-              stat = SendPutI (line->getDataPtr(), addr, CacheLineSize, requesterId, Directory[line->getAddress()].Sharers, delay, timestamp);
-            Directory[line->getAddress()] = { Modified, initiatorId, {} };
-            break;
-          case Modified: // Line is dirty in upper cache
-            assert (Directory[line->getAddress()].Owner!=NULL_IDX);
-            assert (Directory[line->getAddress()].Owner != initiatorId);
-            assert (Directory[line->getAddress()].Sharers.size()==0);
-            stat = SendFwdGetM (line->getDataPtr(), line->getAddress(), CacheLineSize, requesterId, {Directory[line->getAddress()].Owner}, delay, timestamp);
-            Directory[line->getAddress()].Owner = initiatorId;
-            // Line is home and up-to-date, give dirty line to requester, no need for writeback
-            //stat = ForwardWriteData (line->getDataPtr(), line->getAddress(), CacheLineSize, delay, timestamp);
-            if (InclusionOfHigher==Exclusive) line->setState(Invalid);
-            // else line->setState(Modified);
-            break;
+        switch (entry.State) {
+        case Invalid: // Line is not in upper cache, or has never been requested
+          assert (entry.Sharers.size()==0);
+          assert (entry.Owner==NULL_IDX);
+          if (!isHit) {
+            assert (InclusionOfHigher!=Exclusive); // No line allocation in exclusive caches
+            stat = ForwardReadData (src_data_ptr, lineAddr, CacheLineSize, requesterId, delay, timestamp);
+            line->setState(Shared); // Line is not dirty yet
+          } else if (InclusionOfHigher==Exclusive && line->getState()==Modified) { // clean line before invalidation
+            stat = ForwardWriteData (line->getDataPtr(), lineAddr, CacheLineSize, requesterId, delay, timestamp);
+            line->setState(Invalid);
+          }
+          entry = { Modified, initiatorId, {} };
+          break;
+        case Shared: // Line is clean in upper cache
+          assert (entry.Owner==NULL_IDX);
+          assert (entry.Sharers.size()>0);
+          if (!isHit) {
+            assert (InclusionOfHigher!=Exclusive); // No line allocation in exclusive caches
+            stat = SendFwdGetS (line->getDataPtr(), lineAddr, CacheLineSize, requesterId, entry.Sharers, delay, timestamp);
+            line->setState(Shared);
+          } else if (InclusionOfHigher==Exclusive && line->getState()==Modified) { // clean line before invalidation
+            stat = ForwardWriteData (line->getDataPtr(), lineAddr, CacheLineSize, requesterId, delay, timestamp);
+            line->setState(Invalid);
           }
+          entry.Sharers.erase(initiatorId);
+          assert(!entry.Sharers.contains(initiatorId));
+          if (entry.Sharers.size() != 0) // Invalidate all sharers
+            stat = SendPutI (line->getDataPtr(), addr, CacheLineSize, requesterId, entry.Sharers, delay, timestamp);
+          entry = { Modified, initiatorId, {} };
+          break;
+        case Modified: // Line is dirty in upper cache
+          assert (entry.Owner!=NULL_IDX);
+          assert (entry.Owner != initiatorId);
+          assert (entry.Sharers.size()==0);
+          stat = SendFwdGetM (line->getDataPtr(), lineAddr, CacheLineSize, requesterId, {entry.Owner}, delay, timestamp);
+          entry.Owner = initiatorId;
+          // Line is home and up-to-date, give dirty line to requester, no need for writeback
+          //stat = ForwardWriteData (line->getDataPtr(), lineAddr, CacheLineSize, delay, timestamp);
+          if (InclusionOfHigher==Exclusive) line->setState(Invalid);
+          // else line->setState(Modified);
+          break;
         }
         NGetM++;
-        assert (Directory[line->getAddress()].State==Modified);
-        assert (Directory[line->getAddress()].Owner==initiatorId);
-        assert (Directory[line->getAddress()].Sharers.size()==0);
+        assert (entry.State==Modified);
+        assert (entry.Owner==initiatorId);
+        assert (entry.Sharers.size()==0);
         break;
 
       default:
         assert(false); break; //throw runtime_error ("Command non allowed for home\n");
       }
 
-      assert (Directory.find(line->getAddress())==Directory.end() ||
-              (Directory[addr].State==Invalid    && Directory[addr].Owner==NULL_IDX && Directory[addr].Sharers.size()==0) ||
-              (Directory[addr].State==Shared   && Directory[addr].Owner==NULL_IDX && Directory[addr].Sharers.size()!= 0)  ||
-              ( Directory[addr].State==Modified && Directory[addr].Owner!=NULL_IDX && Directory[addr].Sharers.size()==0));
+      assert ((entry.State==Invalid    && entry.Owner==NULL_IDX && entry.Sharers.size()==0) ||
+              (entry.State==Shared   && entry.Owner==NULL_IDX && entry.Sharers.size()!= 0)  ||
+              ( entry.State==Modified && entry.Owner!=NULL_IDX && entry.Sharers.size()==0));
+      releaseIfInvalid (lineAddr, entry);
 
       return stat;
     }
@@ -1067,6 +1117,11 @@ namespace vpsim{
   template<CoherenceCommand accessMode>
   tlm::tlm_response_status accessCache (unsigned char* src_data_ptr, size_t size, AddressType addr, idx_t requesterId, idx_t initiatorId, sc_time& delay, sc_time timestamp=sc_time(0,SC_NS), void* handle=nullptr) {
     tlm::tlm_response_status stat = tlm::TLM_OK_RESPONSE;
+    if ((uint64_t) addr & ~PhysAddrMask) {
+      //the tags cannot tell such an address from the one it aliases within the width
+      NAddrErrors++;
+      return tlm::TLM_ADDRESS_ERROR_RESPONSE;
+    }
     if (!IsCoherent)
       stat = this-> accessNonCoherentCache<accessMode>(src_data_ptr, size, addr, requesterId, initiatorId, delay, timestamp, handle);
     else {
@@ -1090,6 +1145,62 @@ namespace vpsim{
     inline bool isDataSupported (){
       return DataSupport;
     }
+
+    //! @return the number of lines held by higher caches that the cache keeps track of
+    inline size_t getDirectorySize () const {
+      return Directory.size() + Sharers.size();
+    }
+    //! @return the bytes reserved for the lines and their replacement data
+    inline size_t getMetadataBytes () const {
+      return LineArena.bytes() + AgeArena.bytes();
+    }
+    //! @return the bytes reserved for the data of the lines, 0 without data support
+    inline size_t getDataBytes () const {
+      return DataArena.bytes();
+    }
+
+    //!
+    //! Debug access to the lines of the cache overlapping [addr, addr+size), without any effect on the
+    //! cache state, the replacement data or the statistics.
+    //! A read copies to data_ptr the bytes of the lines holding more recent data than the lower levels,
+    //! a write updates every copy of the written bytes held by the cache.
+    //!
+    void debugAccess (unsigned char* data_ptr, AddressType addr, size_t size, bool write) {
+      if (!DataSupport || !data_ptr || size == 0 || ((uint64_t) addr & ~PhysAddrMask)) return;
+
+      const AddressType last = addr + size - 1;
+      auto access = [&] (CacheLineType& line) {
+        const AddressType lineAddr = line.getAddress();
+        if (line.getState() == Invalid || !line.getDataPtr()) return;
+        if (lineAddr > last || lineAddr + CacheLineSize - 1 < addr) return;
+        const AddressType begin = max (addr, lineAddr);
+        const AddressType end = min (last, (AddressType) (lineAddr + CacheLineSize - 1));
+        if (write) memcpy (line.getDataPtr() + (begin - lineAddr), data_ptr + (begin - addr), end - begin + 1);
+        else if (holdsLatestData (line)) memcpy (data_ptr + (begin - addr), line.getDataPtr() + (begin - lineAddr), end - begin + 1);
+      };
+
+      //Large transfers (e.g. loaders) visit the lines of the cache rather than the lines of the transfer
+      if (size / CacheLineSize >= NbLines) {
+        for (auto& set: CacheLines)
+          for (unsigned way = 0; way < set.getAssociativity(); way++) access (set.getLine (way));
+        return;
+      }
+      for (AddressType lineAddr = addr & ~OffsetMask; lineAddr <= last; lineAddr += CacheLineSize) {
+        CacheLineType* line = CacheLines [(lineAddr>>IndexShift) & IndexMask].peekLine ((lineAddr>>TagShift) & TagMask);
+        //Interleave bits are not part of the tag
+        if (line && line->getAddress() == lineAddr) access (*line);
+        if (lineAddr + CacheLineSize < lineAddr) break;
+      }
+    }
+
+    //!
+    //! @return true if line holds more recent data than the lower levels: a dirty line, or for a
+    //! coherent home, a line that no higher-level cache holds in Modified state
+    //!
+    inline bool holdsLatestData (CacheLineType& line) {
+      if (IsCoherent && IsHome) return line.getState() == Shared;
+      return line.getState() == Modified;
+    }
     inline void cacheMemcpy (unsigned char* dest_ptr, unsigned char* src_ptr, size_t size){
       if (DataSupport) memcpy (dest_ptr, src_ptr, size);
       else return;
@@ -1107,6 +1218,7 @@ namespace vpsim{
       if (InclusionOfLower==Inclusive)  cout << " total invalidations: " << NTotalInvals << " real invalidations: " << NInvals;
 
       if (InclusionOfLower==Exclusive) cout << " evictions: " << NEvicts;
+      if (NAddrErrors) cout << " address errors: " << NAddrErrors;
       cout << endl;
     }
 
@@ -1125,7 +1237,7 @@ namespace vpsim{
     };
 
     virtual tlm::tlm_response_status ForwardReadData (unsigned char* cacheLineData, AddressType Addr, size_t size, idx_t requesterId, sc_time& delay, sc_time timestamp) { return tlm::TLM_OK_RESPONSE; }
-    virtual tlm::tlm_response_status BackwardRead (unsigned char* lineDataPtr, AddressType addr, size_t size, idx_t requesterId, set<idx_t> sharerIds, sc_time& delay, sc_time timestamp) { return tlm::TLM_OK_RESPONSE; }
+    virtual tlm::tlm_response_status BackwardRead (unsigned char* lineDataPtr, AddressType addr, size_t size, idx_t requesterId, const SharerSet& sharerIds, sc_time& delay, sc_time timestamp) { return tlm::TLM_OK_RESPONSE; }
 
     //!
     //! Function called by the cache itself whenever it must forward a write access to a next-level cache
@@ -1138,15 +1250,15 @@ namespace vpsim{
     virtual tlm::tlm_response_status ForwardWriteData (unsigned char* cacheLineData, AddressType addr, size_t size, idx_t requesterId, sc_time& delay, sc_time timestamp) { return tlm::TLM_OK_RESPONSE; }
     virtual tlm::tlm_response_status ForwardEvict (unsigned char* cacheLineData, AddressType addr, size_t size, idx_t requesterId, sc_time& delay, sc_time timestamp) { return tlm::TLM_OK_RESPONSE; }
     //virtual tlm::tlm_response_status BackInvalidate (AddressType addr, sc_time& delay) { return tlm::TLM_OK_RESPONSE; }
-    virtual tlm::tlm_response_status BackInvalidate (AddressType addr, set<idx_t> sharerIds, sc_time& delay, sc_time timestamp) { return tlm::TLM_OK_RESPONSE; }
+    virtual tlm::tlm_response_status BackInvalidate (AddressType addr, const SharerSet& sharerIds, sc_time& delay, sc_time timestamp) { return tlm::TLM_OK_RESPONSE; }
     virtual tlm::tlm_response_status SendGetS (unsigned char* lineDataPtr, AddressType addr, size_t size, idx_t requesterId, sc_time& delay, sc_time timestamp) { return tlm::TLM_OK_RESPONSE; }
     virtual tlm::tlm_response_status SendGetM (unsigned char* lineDataPtr, AddressType addr, size_t size, idx_t requesterId, sc_time& delay, sc_time timestamp) { return tlm::TLM_OK_RESPONSE; }
     virtual tlm::tlm_response_status SendPutS (unsigned char* lineDataPtr, AddressType addr, size_t size, idx_t requesterId, sc_time& delay, sc_time timestamp) { return tlm::TLM_OK_RESPONSE; }
     virtual tlm::tlm_response_status SendPutM (unsigned char* lineDataPtr, AddressType addr, size_t size, idx_t requesterId, sc_time& delay, sc_time timestamp) { return tlm::TLM_OK_RESPONSE; }
-    virtual tlm::tlm_response_status SendFwdGetS (unsigned char* lineDataPtr, AddressType addr, size_t size, idx_t requesterId, set<idx_t> sharerIds, sc_time& delay, sc_time timestamp) { return tlm::TLM_OK_RESPONSE; }
-    virtual tlm::tlm_response_status SendFwdGetM (unsigned char* lineDataPtr, AddressType addr, size_t size, idx_t requesterId, set<idx_t> ids, sc_time& delay, sc_time timestamp) { return tlm::TLM_OK_RESPONSE; }
-    virtual tlm::tlm_response_status SendPutI (unsigned char* lineDataPtr, AddressType addr, size_t size, idx_t requesterId, set<idx_t> sharerIds, sc_time& delay, sc_time timestamp) { return tlm::TLM_OK_RESPONSE; }
-    virtual tlm::tlm_response_status SendInvS (unsigned char* lineDataPtr, AddressType addr, size_t size, idx_t requesterId, set<idx_t> sharerIds, sc_time& delay, sc_time timestamp) { return tlm::TLM_OK_RESPONSE; }
+    virtual tlm::tlm_response_status SendFwdGetS (unsigned char* lineDataPtr, AddressType addr, size_t size, idx_t requesterId, const SharerSet& sharerIds, sc_time& delay, sc_time timestamp) { return tlm::TLM_OK_RESPONSE; }
+    virtual tlm::tlm_response_status SendFwdGetM (unsigned char* lineDataPtr, AddressType addr, size_t size, idx_t requesterId, const SharerSet& ids, sc_time& delay, sc_time timestamp) { return tlm::TLM_OK_RESPONSE; }
+    virtual tlm::tlm_response_status SendPutI (unsigned char* lineDataPtr, AddressType addr, size_t size, idx_t requesterId, const SharerSet& sharerIds, sc_time& delay, sc_time timestamp) { return tlm::TLM_OK_RESPONSE; }
+    virtual tlm::tlm_response_status SendInvS (unsigned char* lineDataPtr, AddressType addr, size_t size, idx_t requesterId, const SharerSet& sharerIds, sc_time& delay, sc_time timestamp) { return tlm::TLM_OK_RESPONSE; }
     virtual tlm::tlm_response_status SendInvM (unsigned char* lineDataPtr, AddressType addr, size_t size, idx_t requesterId, idx_t initiatorId, sc_time& delay, sc_time timestamp) { return tlm::TLM_OK_RESPONSE; }
 
 
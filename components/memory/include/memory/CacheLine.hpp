@@ -55,7 +55,7 @@ namespace vpsim{
 
     AddressType    Address;        //!< Address of the line in cache (base address aligned on Line size)
     unsigned       LineSize;       //!< the value of the data in the line
-    unsigned       Tag;            //!< most significant bits of the address, checked against all rows in the current set
+    AddressType    Tag;            //!< most significant bits of the address, checked against all rows in the current set
     unsigned char* Data;
     //bool           Valid;          //!< true if line is valid, ie if contains up to date data
     //bool           Dirty;       //!< true if the line was written to
@@ -64,6 +64,10 @@ namespace vpsim{
     CoherenceState State = Invalid;
     int OwnerId;
     CoherenceState HigherState = Invalid;
+    //Tag array of the set, for the sets keeping the tags of their lines apart (see CacheSetLayout):
+    //the word of the line packs its tag and, in the top bit, its validity
+    uint32_t*      TagSlot32;      //!< word of the line if its set packs tags in 32 bits, else NULL
+    uint64_t*      TagSlot64;      //!< word of the line if its set packs tags in 64 bits, else NULL
 
   public :
 
@@ -79,10 +83,12 @@ namespace vpsim{
       : Address  (0)
       , LineSize (0)
       , Tag      (0)
+      , Data     (NULL)
       , State (Invalid)
-        //, Data     (NULL)
         //, Valid    (false)
         //, Dirty (false)
+      , TagSlot32 (NULL)
+      , TagSlot64 (NULL)
     {};
 
     CacheLine<AddressType>(unsigned lineSize/*, unsigned higherCacheNb*/)
@@ -94,6 +100,8 @@ namespace vpsim{
       //, Dirty (false)
       //, HigherCacheNb (higherCacheNb)
       , State (Invalid)
+      , TagSlot32 (NULL)
+      , TagSlot64 (NULL)
     {
       //Data = new unsigned char [LineSize];
       //SharerIds.resize(higherCacheNb, -1);
@@ -103,7 +111,10 @@ namespace vpsim{
     //! deep copy of the source line
     //! @param OtherLine another cacheline reference with the same template parameters
     //!
-    CacheLine< AddressType>(const CacheLine< AddressType> & OtherLine) {};
+    CacheLine< AddressType>(const CacheLine< AddressType> & OtherLine)
+      : TagSlot32 (NULL)
+      , TagSlot64 (NULL)
+    {};
     //!
     //! CacheLine destructor
     //!
@@ -125,11 +136,13 @@ namespace vpsim{
     inline void setAddress (const AddressType value) {
       Address = value;
     }
-    inline void setTag (const unsigned value) {
+    inline void setTag (const AddressType value) {
       Tag = value;
+      updateTagSlot ();
     }
     inline void setState (const CoherenceState state) {
       State = state;
+      updateTagSlot ();
     }
     inline void setOwner (const int owner) {
       OwnerId = owner;
@@ -140,15 +153,26 @@ namespace vpsim{
       Valid    = valid;
       SharerIds.assign (HigherCacheNb, -1);
     }*/
-    inline void setNewLine (const AddressType address, const unsigned tag) {
+    inline void setNewLine (const AddressType address, const AddressType tag) {
       Address  = address;
-      Tag      = tag;
-      State    = Invalid;
+      setTag (tag);
+      setState (Invalid);
       //SharerIds.assign (HigherCacheNb, -1);
     }
+    //! keeps the tag and the validity of the line up to date in the word of its set from now on,
+    //! at most one of slot32 and slot64 being non NULL
+    inline void setTagSlot (uint32_t* slot32, uint64_t* slot64) {
+      TagSlot32 = slot32;
+      TagSlot64 = slot64;
+      updateTagSlot ();
+    }
     inline void setHigherState (CoherenceState s) {
       HigherState = s;
     }
+    //! gives the line LineSize bytes of data at data, owned by the cache (see CacheArena)
+    inline void setDataPtr (unsigned char* data) {
+      Data = data;
+    }
 
     /*inline void addSharer (int id) {
       assert (SharerIds.size() != 0);
@@ -167,7 +191,7 @@ namespace vpsim{
     inline AddressType getAddress () const {
       return Address;
     }
-    inline unsigned getTag () const {
+    inline AddressType getTag () const {
       return Tag;
     }
     inline CoherenceState getState () const {
@@ -204,6 +228,15 @@ namespace vpsim{
       //for (unsigned i=0; i< LineSize; i++) cout << (unsigned) Data[i];
       //cout << "]" << endl;
       }*/
+  private :
+
+    inline void updateTagSlot () {
+      if (TagSlot32) *TagSlot32 = (uint32_t) Tag | (uint32_t) (State != Invalid) << 31;
+      else if (TagSlot64) *TagSlot64 = (uint64_t) Tag | (uint64_t) (State != Invalid) << 63;
+    }
+
+  public :
+
     //!
     //! ostream operator is friend on the CacheLine to support CacheLine cout
     //!
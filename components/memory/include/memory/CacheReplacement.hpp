@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef CACHEREPLACEMENT_HPP
+#define CACHEREPLACEMENT_HPP
+
+#include <stdint.h>
+#include <stdexcept>
+#include <string>
+
+namespace vpsim{
+
+  //!
+  //! All available replacement policies for caches
+  //!
+  enum  CacheReplacementPolicy {
+    FIFO,   //!< first-in-first-out replacement policy
+    LRU,    //!< Least recently used replacement policy
+    MRU,    //!< most recently used, once every way was filled
+    PLRU,   //!< tree pseudo-LRU, for a power of two associativity up to 64
+    RANDOM, //!< random victim, from a seeded generator
+    SRRIP,  //!< static re-reference interval prediction
+    BRRIP   //!< bimodal re-reference interval prediction
+  };
+
+  //!
+  //! @return the policy named name (e.g. "LRU" or "SRRIP"), throws if there is none
+  //!
+  inline CacheReplacementPolicy getReplacementPolicy (const std::string& name) {
+    if (name == "FIFO")   return FIFO;
+    if (name == "LRU")    return LRU;
+    if (name == "MRU")    return MRU;
+    if (name == "PLRU")   return PLRU;
+    if (name == "RANDOM" || name == "Random") return RANDOM;
+    if (name == "SRRIP")  return SRRIP;
+    if (name == "BRRIP")  return BRRIP;
+    throw std::runtime_error (name + " Unknown replacement policy");
+  }
+
+  //!
+  //! Replacement state of a set, each policy using its own part of it
+  //!
+  struct ReplacementState {
+    unsigned  Associativity;
+    unsigned* Ages;     //!< per way, LRU age (0 for the most recent) or RRIP re-reference prediction
+    uint64_t  Bits;     //!< PLRU tree nodes, MRU way
+    uint64_t  Seed;     //!< generator of RANDOM and BRRIP, never 0
+    unsigned  Next;     //!< next victim of LRU and FIFO, ways filled so far by MRU
+  };
+
+  //!
+  //! A replacement policy is a class of static functions on a ReplacementState:
+  //! init    resets the state of an empty set
+  //! touch   records a hit on way
+  //! victim  elects the way to replace on a miss
+  //! fill    records that victim was filled with a new line
+  //!
+
+  //! xorshift64*, small and good enough to spread the victims
+  inline uint64_t nextRandom (uint64_t& seed) {
+    seed ^= seed >> 12;
+    seed ^= seed << 25;
+    seed ^= seed >> 27;
+    return seed * 2685821657736338717ULL;
+  }
+
+  //! Ages ordered from 0 (most recent) to Associativity-1 (least recent)
+  struct LruReplacement {
+    static void init (ReplacementState& s) {
+      for (unsigned i = 0; i < s.Associativity; i++) s.Ages[i] = s.Associativity - i - 1;
+      s.Next = 0;
+    }
+    //! the victim is elected in the same pass, it cannot be way
+    static void touch (ReplacementState& s, unsigned way) {
+      const unsigned age = s.Ages[way];
+      for (unsigned i = 0; i < s.Associativity; i++) {
+        if (s.Ages[i] < age) s.Ages[i]++;
+        if (s.Ages[i] == s.Associativity - 1 && i != way) s.Next = i;
+      }
+      s.Ages[way] = 0;
+    }
+    static unsigned victim (ReplacementState& s) { return s.Next; }
+    static void fill (ReplacementState& s, unsigned way) { touch (s, way); }
+  };
+
+  //! Ways filled in turn, hits do not matter
+  struct FifoReplacement {
+    static void init (ReplacementState& s) { s.Next = 0; }
+    static void touch (ReplacementState& s, unsigned way) {}
+    static unsigned victim (ReplacementState& s) { return s.Next; }
+    static void fill (ReplacementState& s, unsigned way) { s.Next = (way + 1) % s.Associativity; }
+  };
+
+  //! Ways filled in turn until the set is full, then the most recently used way is replaced
+  struct MruReplacement {
+    static void init (ReplacementState& s) { s.Next = 0; s.Bits = 0; }
+    static void touch (ReplacementState& s, unsigned way) { s.Bits = way; }
+    static unsigned victim (ReplacementState& s) { return s.Next < s.Associativity ? s.Next : s.Bits; }
+    static void fill (ReplacementState& s, unsigned way) {
+      if (s.Next < s.Associativity) s.Next++;
+      s.Bits = way;
+    }
+  };
+
+  //!
+  //! Binary tree over the ways, node n having children 2n+1 and 2n+2, one bit per node
+  //! pointing to the half holding the victim: 0 for the lower ways, 1 for the upper ones
+  //!
+  struct PlruReplacement {
+    static void init (ReplacementState& s) {
+      if (s.Associativity > 64 || (s.Associativity & (s.Associativity - 1)))
+        throw std::runtime_error ("Tree PLRU needs a power of two associativity, up to 64 ways");
+      s.Bits = 0;
+    }
+    //! points every node on the path of way to the other half
+    static void touch (ReplacementState& s, unsigned way) {
+      unsigned node = 0;
+      for (unsigned half = s.Associativity / 2; half; half /= 2) {
+        const unsigned upper = (way & half) ? 1 : 0;
+        if (upper) s.Bits &= ~(1ULL << node);
+        else s.Bits |= 1ULL << node;
+        node = 2 * node + 1 + upper;
+      }
+    }
+    static unsigned victim (ReplacementState& s) {
+      unsigned node = 0, way = 0;
+      for (unsigned half = s.Associativity / 2; half; half /= 2) {
+        const unsigned upper = (s.Bits >> node) & 1;
+        if (upper) way |= half;
+        node = 2 * node + 1 + upper;
+      }
+      return way;
+    }
+    static void fill (ReplacementState& s, unsigned way) { touch (s, way); }
+  };
+
+  struct RandomReplacement {
+    static void init (ReplacementState& s) {}
+    static void touch (ReplacementState& s, unsigned way) {}
+    static unsigned victim (ReplacementState& s) { return nextRandom (s.Seed) % s.Associativity; }
+    static void fill (ReplacementState& s, unsigned way) {}
+  };
+
+  //!
+  //! Re-reference interval prediction (Jaleel et al., ISCA 2010) on 2 bits: a hit predicts a
+  //! near re-reference (0), the victim is the first way predicted distant (3), all the ways
+  //! ageing until one is. SRRIP inserts lines with a long interval (2), BRRIP mostly with a
+  //! distant one (3) and with a long one once in BRRIP_LONG_ONE_IN fills.
+  //!
+  template <bool Bimodal>
+  struct RripReplacement {
+    static const unsigned MAX_RRPV = 3;
+    static const unsigned BRRIP_LONG_ONE_IN = 32;
+
+    static void init (ReplacementState& s) {
+      for (unsigned i = 0; i < s.Associativity; i++) s.Ages[i] = MAX_RRPV;
+    }
+    static void touch (ReplacementState& s, unsigned way) { s.Ages[way] = 0; }
+    static unsigned victim (ReplacementState& s) {
+      for (;;) {
+        for (unsigned i = 0; i < s.Associativity; i++)
+          if (s.Ages[i] == MAX_RRPV) return i;
+        for (unsigned i = 0; i < s.Associativity; i++) s.Ages[i]++;
+      }
+    }
+    static void fill (ReplacementState& s, unsigned way) {
+      if (Bimodal && nextRandom (s.Seed) % BRRIP_LONG_ONE_IN) s.Ages[way] = MAX_RRPV;
+      else s.Ages[way] = MAX_RRPV - 1;
+    }
+  };
+
+  typedef RripReplacement<false> SrripReplacement;
+  typedef RripReplacement<true>  BrripReplacement;
+}
+
+#endif //CACHEREPLACEMENT_HPP
@@ -17,18 +17,23 @@
 #ifndef CACHESET_HPP
 #define CACHESET_HPP
 
+#include <memory>
+#include <stdexcept>
+#include "CacheReplacement.hpp"
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
 using namespace std;
 
 namespace vpsim{
 
-  //fwd declaration
   //!
-  //! All available replacement policies for caches
+  //! Layouts of the ways of a set
   //!
-  enum  CacheReplacementPolicy {
-    FIFO, //!< first-in-first-out replacement policy
-    LRU,  //!< Least recently used replacement policy
-    MRU   // most recently used
+  enum CacheSetLayout {
+    LineArray, //!< lines stored one after the other, searched line by line
+    TagArray   //!< tags and valid bits of the lines also packed in an array of words, searched a whole set at a time
   };
 
 
@@ -51,33 +56,59 @@ namespace vpsim{
 
   private :
 
-    struct _LineWrapper {
-      CacheLineType line;
-      unsigned repl_data;
-    };
     unsigned Associativity;
     CacheReplacementPolicy Policy;
-    _LineWrapper* Lines;
-    int NextVictim;
-    unsigned CountUntilRepl;
+    CacheLineType* Lines;
+    ReplacementState Repl;  //!< ages of the ways in Repl.Ages
+    //TagArray layout, the lines writing their tag and validity through: tag | valid << top bit of
+    //each way, padded to TAG_BLOCK ways with never valid words. One of the arrays is used, the
+    //narrow one when the tags fit in 31 bits
+    uint32_t* Tags32;
+    uint64_t* Tags64;
+    //Lines and ages allocated by the set itself, NULL when they belong to the caller (arenas of a cache)
+    unique_ptr<CacheLineType[]> OwnedLines;
+    unique_ptr<unsigned[]> OwnedAges;
+
+    static const unsigned TAG_BLOCK = 8; //!< ways compared at once by the widest compare
 
   public :
 
     CacheSet (unsigned lineSize, uint64_t assoc, CacheReplacementPolicy pol/*, unsigned higherCacheNb*/)
       : Associativity  (assoc)
       , Policy         (pol)
-      , NextVictim     (0)
-      , CountUntilRepl (0)
+      , Lines          (NULL)
+      , Tags32         (NULL)
+      , Tags64         (NULL)
+      , OwnedLines     (new CacheLineType [assoc])
+      , OwnedAges      (new unsigned [assoc] ())
     {
-      initSet (lineSize/*, higherCacheNb*/);
+      initSet (lineSize, OwnedLines.get(), OwnedAges.get()/*, higherCacheNb*/);
      }
 
+    //! builds a set over assoc lines and ages owned by the caller, e.g. a slice of the arenas of a cache
+    CacheSet (CacheLineType* lines, unsigned* ages, unsigned lineSize, uint64_t assoc, CacheReplacementPolicy pol)
+      : Associativity  (assoc)
+      , Policy         (pol)
+      , Lines          (NULL)
+      , Tags32         (NULL)
+      , Tags64         (NULL)
+    {
+      initSet (lineSize, lines, ages);
+    }
+
     CacheSet ()
       : Associativity  (0) //TODO
       , Policy         (LRU)
-      , NextVictim     (0)
-      , CountUntilRepl (0)
-    {}
+      , Lines          (NULL)
+      , Tags32         (NULL)
+      , Tags64         (NULL)
+    {
+      Repl.Associativity = 0;
+      Repl.Ages = NULL;
+      Repl.Bits = 0;
+      Repl.Seed = 1;
+      Repl.Next = 0;
+    }
     // setters to be used with the default constructor
     void setAssociativity (uint64_t assoc) {
       Associativity = assoc;
@@ -85,150 +116,216 @@ namespace vpsim{
     void setPolicy (CacheReplacementPolicy pol) {
       Policy = pol;
     }
+    //! seeds the generator of the RANDOM and BRRIP policies, 0 is replaced by 1
+    void setSeed (uint64_t seed) {
+      Repl.Seed = seed ? seed : 1;
+    }
+
+    //!
+    //! selects the layout of the set, the lines are kept.
+    //! The TagArray layout supports up to 64 ways, and tags of up to 63 bits: tagBits, the width of
+    //! the tags given to the set, selects 32 bit words up to 31 bits, 64 bit words above.
+    //!
+    void setLayout (CacheSetLayout layout, unsigned tagBits = 8 * sizeof (AddrType) - 1) {
+      const bool narrow = tagBits <= 31;
+      if (layout == LineArray ? !Tags32 && !Tags64 : (narrow ? Tags32 != NULL : Tags64 != NULL)) return;
+      if (layout == TagArray) {
+        if (Associativity > 64) throw runtime_error ("The tag array layout supports up to 64 ways");
+        if (tagBits > 63) throw runtime_error ("The tag array layout supports tags of up to 63 bits");
+      }
+      for (unsigned i = 0; i < Associativity; i++) Lines[i].setTagSlot (NULL, NULL);
+      delete [] Tags32;
+      delete [] Tags64;
+      Tags32 = NULL;
+      Tags64 = NULL;
+      if (layout == LineArray) return;
+      const unsigned ways = (Associativity + TAG_BLOCK - 1) / TAG_BLOCK * TAG_BLOCK;
+      if (narrow) Tags32 = new uint32_t [ways] ();
+      else Tags64 = new uint64_t [ways] ();
+      for (unsigned i = 0; i < Associativity; i++)
+        Lines[i].setTagSlot (Tags32 ? &Tags32[i] : NULL, Tags64 ? &Tags64[i] : NULL);
+    }
+    CacheSetLayout getLayout () const {
+      return Tags32 || Tags64 ? TagArray : LineArray;
+    }
+
+    //! the set owns its tag array, which its lines point to, and possibly its lines: sets are moved, not copied
+    CacheSet (const CacheSet&) = delete;
+    CacheSet& operator= (const CacheSet&) = delete;
+
+    CacheSet (CacheSet&& other) noexcept
+      : Associativity  (other.Associativity)
+      , Policy         (other.Policy)
+      , Lines          (other.Lines)
+      , Repl           (other.Repl)
+      , Tags32         (other.Tags32)
+      , Tags64         (other.Tags64)
+      , OwnedLines     (move (other.OwnedLines))
+      , OwnedAges      (move (other.OwnedAges))
+    {
+      other.Tags32 = NULL;
+      other.Tags64 = NULL;
+    }
+
+    CacheSet& operator= (CacheSet&& other) noexcept {
+      if (this == &other) return *this;
+      delete [] Tags32;
+      delete [] Tags64;
+      Associativity = other.Associativity;
+      Policy = other.Policy;
+      Lines = other.Lines;
+      Repl = other.Repl;
+      Tags32 = other.Tags32;
+      Tags64 = other.Tags64;
+      OwnedLines = move (other.OwnedLines);
+      OwnedAges = move (other.OwnedAges);
+      other.Tags32 = NULL;
+      other.Tags64 = NULL;
+      return *this;
+    }
 
-    ~CacheSet() {}
+    ~CacheSet() {
+      delete [] Tags32;
+      delete [] Tags64;
+    }
 
     void printSet () {
       cout.clear();
       for (unsigned i = 0; i < Associativity; i++) {
-        Lines[i].line.printLine();
-        cout << " || ReplData: " << Lines[i].repl_data << endl;
+        Lines[i].printLine();
+        cout << " || ReplData: " << Repl.Ages[i] << endl;
       }
     }
-    void printCountAcess () {
-      cout << ", CountUntilRepl: " << CountUntilRepl << flush;
-    }
     void printReplacementData () {
       for (unsigned i = 0; i < Associativity; i++)
-        cout  << "Line [" << i << "] -> " << Lines[i].repl_data << endl;
-    }
-    inline void incrementCountUntilRepl (){
-      // TODO: verify wether it is okay for MRU
-      if (CountUntilRepl < Associativity){
-        for (unsigned i = 0; i < Associativity; i++)
-          if (Lines[i].line.getTag() == 0){
-            CountUntilRepl++;
-            return;
-          }
-      }
+        cout  << "Line [" << i << "] -> " << Repl.Ages[i] << endl;
     }
-    inline bool accessSet (unsigned line_tag, CacheLineType** linePtrAddr) {
-      int  lineIndex = locateLineInSet (line_tag);
-      bool lineInCache  = (-1 < lineIndex) && ((unsigned) lineIndex < Associativity);
+
+    //!
+    //! looks tag up and updates the replacement data: on a hit *linePtrAddr is the line
+    //! holding tag, on a miss the victim line to be filled with it.
+    //! @return true on a hit
+    //!
+    inline bool accessSet (AddrType line_tag, CacheLineType** linePtrAddr) {
       switch (Policy) {
-      case LRU:
-        if (lineInCache){ // hit
-          *linePtrAddr = &Lines[lineIndex].line;
-          updateReplacementData (lineIndex);
-        } else { // miss
-          *linePtrAddr = &Lines[NextVictim].line;
-          updateReplacementData (NextVictim);
-          //electNextVictim (); merged with updateReplacementData to enhance performance
-        };
-        break;
-      case MRU: // TODO: Not tested, perhaps a bit more complicated
-        if (lineInCache){ // hit
-          *linePtrAddr = &Lines[lineIndex].line;
-          updateReplacementData (lineIndex);
-          //electNextVictim ();
-        } else { // miss
-          *linePtrAddr = &Lines[NextVictim].line;
-          updateReplacementData (NextVictim);
-          //electNextVictim ();
-          // todo : what to do with cacheline flag and data
-          // updateCacheLine();
-        };
-        break;
-      case FIFO: // TODO
-        break;
+      case LRU:    return accessWith <LruReplacement>    (line_tag, linePtrAddr);
+      case FIFO:   return accessWith <FifoReplacement>   (line_tag, linePtrAddr);
+      case MRU:    return accessWith <MruReplacement>    (line_tag, linePtrAddr);
+      case PLRU:   return accessWith <PlruReplacement>   (line_tag, linePtrAddr);
+      case RANDOM: return accessWith <RandomReplacement> (line_tag, linePtrAddr);
+      case SRRIP:  return accessWith <SrripReplacement>  (line_tag, linePtrAddr);
+      case BRRIP:  return accessWith <BrripReplacement>  (line_tag, linePtrAddr);
       }
-      return lineInCache;
+      throw runtime_error ("Unknown replacement policy");
     }
 
-  private :
-
-    void initSet (unsigned lineSize/*, unsigned higherCacheNb*/) {
-      //Lines.resize(Associativity);
-      Lines = new _LineWrapper [lineSize];
-      switch (Policy) {
-      case LRU:
-        for (unsigned i = 0; i < Associativity; i++) {
-          Lines[i].line = CacheLine<AddrType>(lineSize/*, higherCacheNb*/);
-          Lines[i].repl_data = Associativity - i - 1;
-        }
-        break;
-      case MRU:
-        for (unsigned i = 0; i < Associativity; i++) {
-          Lines[i].line = CacheLine<AddrType>(lineSize/*, higherCacheNb*/);
-          Lines[i].repl_data = Associativity - i - 1;
-        }
-        break;
-      case FIFO:
-        for (unsigned i = 0; i < Associativity; i++) {
-          Lines[i].line = CacheLine<AddrType>(lineSize/*, higherCacheNb*/);
-          Lines[i].repl_data = 0;
-          }
-          break;
+    //! accessSet with the policy known at compile time
+    template <class Replacement>
+    inline bool accessWith (AddrType line_tag, CacheLineType** linePtrAddr) {
+      int lineIndex = locateLineInSet (line_tag);
+      if (lineIndex >= 0) { // hit
+        Replacement::touch (Repl, lineIndex);
+        *linePtrAddr = &Lines[lineIndex];
+        return true;
       }
+      // miss
+      const unsigned victim = Replacement::victim (Repl);
+      Replacement::fill (Repl, victim);
+      *linePtrAddr = &Lines[victim];
+      return false;
     }
 
-    void updateReplacementData (int line_id) {
-      // update replacement data and elect next victim
-      // update attribute next_victim
-      switch (Policy) {
-      case LRU:
-        for (unsigned i = 0; i < Associativity; i++){
-           if (Lines[i].repl_data < Lines[line_id].repl_data) Lines[i].repl_data++;
-          if (Lines[i].repl_data == Associativity - 1) NextVictim = i;
-        }
-        Lines[line_id].repl_data = 0;
-        break;
-      case MRU: // TODO: check
-        assert (CountUntilRepl < Associativity);
-        for (unsigned i = 0; i < Associativity; i++){
-          if (Lines[i].repl_data > Lines[line_id].repl_data) Lines[i].repl_data--;
-          if (Lines[i].repl_data == Associativity-1 && CountUntilRepl >= Associativity-1) NextVictim = i;
-        }
-        if (CountUntilRepl < Associativity-1) { // Still free space on cache
-          NextVictim++;
-          CountUntilRepl++;
-        }
-        Lines[line_id].repl_data = Associativity - 1;
-        break;
-      case FIFO:
-        NextVictim = (NextVictim + 1) % Associativity;
-        break;
-      }
+    //! @return the valid line of the set matching tag, or NULL, without updating the replacement data
+    inline CacheLineType* peekLine (AddrType tag) {
+      int lineIndex = locateLineInSet (tag);
+      return lineIndex < 0 ? NULL : &Lines[lineIndex];
     }
-    void electNextVictim () { // Merged with updateReplacementData to enhance performance
-      // update NextVictim and CountUntilRepl
-      switch (Policy) {
-      case LRU:
-        for (unsigned i = 0; i < Associativity; i++)
-          if (Lines[i].repl_data == Associativity - 1) NextVictim = i;
-        break;
-      case MRU:
-        assert (CountUntilRepl < Associativity);
-        if (CountUntilRepl < Associativity - 1) { // Still free space on cache
-          NextVictim++;
-         CountUntilRepl++;
-        } else { // No free space on cache, old data should be replaced
-          for (unsigned i = 0; i < Associativity; i++)
-            if (Lines[i].repl_data ==  Associativity - 1) NextVictim = i;
-        }
-        break;
-      case FIFO: // TODO: verify
-        NextVictim = (NextVictim + 1) % Associativity;
-        break;
-      }
+    inline CacheLineType& getLine (unsigned way) {
+      return Lines[way];
+    }
+    inline unsigned getAssociativity () const {
+      return Associativity;
     }
-    int locateLineInSet (unsigned tag) {
+    //! gives the lines of the set their data, one after the other from data on
+    void setData (unsigned char* data) {
+      for (unsigned i = 0; i < Associativity; i++) Lines[i].setDataPtr (data + (size_t) i * Lines[i].getSize());
+    }
+    //! @return the way of the valid line matching tag, -1 if none
+    inline int locateLineInSet (AddrType tag) {
+      if (Tags32) return locateTag32 ((uint32_t) tag | 1U << 31);
+      if (Tags64) return locateTag64 ((uint64_t) tag | 1ULL << 63);
       for (unsigned i = 0; i < Associativity; i++)
-        if (Lines[i].line.getTag() == tag && Lines[i].line.getState() != Invalid){
+        if (Lines[i].getTag() == tag && Lines[i].getState() != Invalid){
           return i;
         }
       return -1;
     }
+
+  private :
+
+    //! TagArray layout: compares the words of TAG_BLOCK ways at a time with key, the tag of a valid line
+    inline int locateTag32 (uint32_t key) const {
+      uint64_t hits = 0;
+#if defined(__AVX2__)
+      const __m256i keys = _mm256_set1_epi32 (key);
+      for (unsigned i = 0; i < Associativity; i += 8) {
+        const __m256i ways = _mm256_loadu_si256 ((const __m256i*) &Tags32[i]);
+        hits |= (uint64_t) (unsigned) _mm256_movemask_ps (_mm256_castsi256_ps (_mm256_cmpeq_epi32 (ways, keys))) << i;
+      }
+#elif defined(__SSE2__)
+      const __m128i keys = _mm_set1_epi32 (key);
+      for (unsigned i = 0; i < Associativity; i += 4) {
+        const __m128i ways = _mm_loadu_si128 ((const __m128i*) &Tags32[i]);
+        hits |= (uint64_t) (unsigned) _mm_movemask_ps (_mm_castsi128_ps (_mm_cmpeq_epi32 (ways, keys))) << i;
+      }
+#else
+      for (unsigned i = 0; i < Associativity; i++) hits |= (uint64_t) (Tags32[i] == key) << i;
+#endif
+      //Padding ways never match, their valid bit being clear
+      return hits ? __builtin_ctzll (hits) : -1;
+    }
+
+    inline int locateTag64 (uint64_t key) const {
+      uint64_t hits = 0;
+#if defined(__AVX2__)
+      const __m256i keys = _mm256_set1_epi64x (key);
+      for (unsigned i = 0; i < Associativity; i += 4) {
+        const __m256i ways = _mm256_loadu_si256 ((const __m256i*) &Tags64[i]);
+        hits |= (uint64_t) (unsigned) _mm256_movemask_pd (_mm256_castsi256_pd (_mm256_cmpeq_epi64 (ways, keys))) << i;
+      }
+#elif defined(__SSE2__)
+      //No 64 bit compare before SSE4.1: both 32 bit halves must match
+      const __m128i keys = _mm_set1_epi64x (key);
+      for (unsigned i = 0; i < Associativity; i += 2) {
+        const __m128i halves = _mm_cmpeq_epi32 (_mm_loadu_si128 ((const __m128i*) &Tags64[i]), keys);
+        const __m128i eq = _mm_and_si128 (halves, _mm_shuffle_epi32 (halves, _MM_SHUFFLE (2, 3, 0, 1)));
+        hits |= (uint64_t) (unsigned) _mm_movemask_pd (_mm_castsi128_pd (eq)) << i;
+      }
+#else
+      for (unsigned i = 0; i < Associativity; i++) hits |= (uint64_t) (Tags64[i] == key) << i;
+#endif
+      return hits ? __builtin_ctzll (hits) : -1;
+    }
+
+    void initSet (unsigned lineSize, CacheLineType* lines, unsigned* ages/*, unsigned higherCacheNb*/) {
+      Lines = lines;
+      for (unsigned i = 0; i < Associativity; i++)
+        Lines[i] = CacheLine<AddrType>(lineSize/*, higherCacheNb*/);
+      Repl.Associativity = Associativity;
+      Repl.Ages = ages;
+      Repl.Bits = 0;
+      Repl.Seed = 1;
+      Repl.Next = 0;
+      switch (Policy) {
+      case LRU:    LruReplacement::init (Repl);    break;
+      case FIFO:   FifoReplacement::init (Repl);   break;
+      case MRU:    MruReplacement::init (Repl);    break;
+      case PLRU:   PlruReplacement::init (Repl);   break;
+      case RANDOM: RandomReplacement::init (Repl); break;
+      case SRRIP:  SrripReplacement::init (Repl);  break;
+      case BRRIP:  BrripReplacement::init (Repl);  break;
+      }
+    }
   };
 }
 
@@ -17,6 +17,8 @@
 #ifndef COHERENCEEXTENSION_HPP_
 #define COHERENCEEXTENSION_HPP_
 
+#include "SharerSet.hpp"
+
 namespace vpsim {
 
   //idx_t is the type to use for index or ids
@@ -29,7 +31,7 @@ namespace vpsim {
 
     idx_t initiatorId ;
     idx_t requesterId = NULL_IDX;
-    set<idx_t> targetIds = set<idx_t>();
+    SharerSet targetIds;
     CoherenceCommand Command;
     bool ToHome = false; // Used in non-coherent mode, to determine the target of RD/WR commands
     /* bool defaultTargetEnabled = false;
@@ -51,8 +53,16 @@ namespace vpsim {
     inline void setRequesterId  (const idx_t id)  { requesterId = id; }
     inline idx_t getRequesterId ()                { return requesterId; }
 
-    inline void setTargetIds    (set<idx_t> ids)  { targetIds = ids; }
-    inline set<idx_t> getTargetIds()              { return targetIds; }
+    inline void setTargetIds    (const SharerSet& ids) { targetIds = ids; }
+    inline const SharerSet& getTargetIds()               { return targetIds; }
+
+    //! restores the values of a newly constructed extension, used when the extension is recycled
+    inline void clear () {
+      initiatorId = NULL_IDX;
+      requesterId = NULL_IDX;
+      targetIds.clear();
+      ToHome = false;
+    }
 
     /*
       void setSharerIds (vector<int>& sharerIds){ targetIds = sharerIds; }
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0 
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef COHERENCEPAYLOADPOOL_HPP_
+#define COHERENCEPAYLOADPOOL_HPP_
+
+#include "global.hpp"
+#include "CoherenceExtension.hpp"
+#include "CosimExtensions.hpp"
+
+namespace vpsim {
+
+  //!
+  //! Pool of generic payloads used for coherence messages.
+  //! Every payload owns a CoherencePayloadExtension and a SourceCpuExtension, attached for its whole life.
+  //! allocate() hands out an acquired payload, which goes back to the pool through the TLM memory
+  //! management interface when it is released. Payloads in flight are never reused, so messages
+  //! sent while handling another one (nested b_transport calls) get their own payload.
+  //!
+  class CoherencePayloadPool : public tlm::tlm_mm_interface {
+
+  public:
+
+    struct Payload : public tlm::tlm_generic_payload {
+      CoherencePayloadExtension Coherence;
+      SourceCpuExtension Source;
+
+      Payload (tlm::tlm_mm_interface* mm) : tlm::tlm_generic_payload (mm) {}
+
+      // The extensions are members: detach them so that the base destructor does not free them
+      ~Payload () {
+        clear_extension (&Coherence);
+        clear_extension (&Source);
+      }
+    };
+
+    CoherencePayloadPool () {}
+    CoherencePayloadPool (const CoherencePayloadPool&) = delete;
+    CoherencePayloadPool& operator= (const CoherencePayloadPool&) = delete;
+
+    ~CoherencePayloadPool () {
+      for (Payload* p : mPayloads) delete p;
+    }
+
+    //! @return a payload with both extensions attached, acquired once on behalf of the caller
+    Payload& allocate () {
+      Payload* p;
+      if (mFree.empty()) {
+        p = new Payload (this);
+        mPayloads.push_back (p);
+      } else {
+        p = mFree.back ();
+        mFree.pop_back ();
+      }
+      // Cheap, and restores an extension a target may have cleared
+      p->set_extension<CoherencePayloadExtension> (&p->Coherence);
+      p->set_extension<SourceCpuExtension> (&p->Source);
+      p->acquire ();
+      return *p;
+    }
+
+    //! called by tlm_generic_payload::release() once the last reference is dropped
+    void free (tlm::tlm_generic_payload* trans) override {
+      mFree.push_back (static_cast<Payload*> (trans));
+    }
+
+    //! @return the number of payloads created so far, i.e. the maximum number of messages in flight
+    size_t size () const { return mPayloads.size (); }
+
+  private:
+
+    vector<Payload*> mPayloads; //!< every payload of the pool
+    vector<Payload*> mFree;     //!< payloads not in flight
+
+  };
+}
+
+#endif /* COHERENCEPAYLOADPOOL_HPP_ */
@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef DIRECTORYTABLE_HPP_
+#define DIRECTORYTABLE_HPP_
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <memory>
+#include <stdexcept>
+
+namespace vpsim {
+
+  //!
+  //! Hash table from line addresses to directory entries, for the directories of the caches.
+  //! The index is a flat open-addressing table with linear probing, holding the keys and the
+  //! positions of the entries, so a lookup walks a few contiguous slots instead of a tree.
+  //! The entries themselves are allocated by chunks and never move: like with std::map, a
+  //! reference to an entry stays valid until its key is erased, even if the caller inserts
+  //! other keys meanwhile (e.g. when a back-invalidation re-enters the cache).
+  //! Erased entries are recycled, so the memory used follows the number of keys present.
+  //!
+  template <typename KeyType, typename ValueType>
+  class DirectoryTable {
+
+  public:
+
+    static const size_t CHUNK_SIZE   = 1024; //!< entries allocated at once
+    static const size_t MIN_CAPACITY = 64;   //!< slots of the index of an empty table
+
+    //! @param blank the value of the entries created by operator[]
+    explicit DirectoryTable (const ValueType& blank = ValueType ())
+      : mBlank (blank)
+      , mCount (0)
+      , mNextEntry (0)
+    {
+      rehash (MIN_CAPACITY);
+    }
+
+    //! @return the entry of key, or NULL if there is none
+    inline ValueType* find (KeyType key) {
+      for (size_t s = slotOf (key); mSlots[s].Entry != FREE; s = (s + 1) & mMask)
+        if (mSlots[s].Key == key) return &entry (mSlots[s].Entry);
+      return NULL;
+    }
+
+    //! @return the entry of key, created from the blank value if there was none
+    inline ValueType& operator[] (KeyType key) {
+      size_t s = slotOf (key);
+      for (; mSlots[s].Entry != FREE; s = (s + 1) & mMask)
+        if (mSlots[s].Key == key) return entry (mSlots[s].Entry);
+      if (2 * (mCount + 1) > mSlots.size ()) {
+        rehash (2 * mSlots.size ());
+        for (s = slotOf (key); mSlots[s].Entry != FREE; s = (s + 1) & mMask) ;
+      }
+      const uint32_t e = allocate ();
+      mSlots[s].Key = key;
+      mSlots[s].Entry = e;
+      mCount++;
+      return entry (e) = mBlank;
+    }
+
+    //! removes the entry of key, the entries following it in the probe sequence shift back
+    //! @return false if there was none
+    bool erase (KeyType key) {
+      size_t hole = slotOf (key);
+      for (; mSlots[hole].Entry != FREE; hole = (hole + 1) & mMask)
+        if (mSlots[hole].Key == key) break;
+      if (mSlots[hole].Entry == FREE) return false;
+      mFreeEntries.push_back (mSlots[hole].Entry);
+      for (size_t s = (hole + 1) & mMask; mSlots[s].Entry != FREE; s = (s + 1) & mMask) {
+        //A key may fill the hole if the hole lies between its home slot and its slot
+        if (((s - slotOf (mSlots[s].Key)) & mMask) >= ((s - hole) & mMask)) {
+          mSlots[hole] = mSlots[s];
+          hole = s;
+        }
+      }
+      mSlots[hole].Entry = FREE;
+      mCount--;
+      return true;
+    }
+
+    inline size_t size () const { return mCount; }
+    inline bool empty () const { return mCount == 0; }
+    //! @return the number of slots of the index
+    inline size_t capacity () const { return mSlots.size (); }
+
+    //! sizes the index for n keys, avoiding the rehashes while they are inserted
+    void reserve (size_t n) {
+      size_t capacity = mSlots.size ();
+      while (capacity < 2 * n) capacity *= 2;
+      if (capacity != mSlots.size ()) rehash (capacity);
+    }
+
+    //! removes every key and releases the entries
+    void clear () {
+      mChunks.clear ();
+      mFreeEntries.clear ();
+      mNextEntry = 0;
+      mCount = 0;
+      mSlots.clear ();
+      rehash (MIN_CAPACITY);
+    }
+
+  private:
+
+    static const uint32_t FREE = UINT32_MAX; //!< entry of an empty slot
+
+    struct Slot {
+      KeyType  Key;
+      uint32_t Entry;
+    };
+
+    ValueType mBlank;
+    std::vector<Slot> mSlots;   //!< index, a power of two slots at most half full
+    size_t mMask;
+    unsigned mShift;
+    size_t mCount;
+    std::vector<std::unique_ptr<ValueType[]>> mChunks;
+    std::vector<uint32_t> mFreeEntries;  //!< entries of erased keys, reused first
+    uint32_t mNextEntry;                 //!< first entry never used
+
+    //! Fibonacci hashing, the low bits of line addresses being all zeros
+    inline size_t slotOf (KeyType key) const {
+      return (size_t) (((uint64_t) key * 0x9e3779b97f4a7c15ULL) >> mShift);
+    }
+
+    inline ValueType& entry (uint32_t e) {
+      return mChunks[e / CHUNK_SIZE][e % CHUNK_SIZE];
+    }
+
+    uint32_t allocate () {
+      if (!mFreeEntries.empty ()) {
+        const uint32_t e = mFreeEntries.back ();
+        mFreeEntries.pop_back ();
+        return e;
+      }
+      if (mNextEntry == FREE) throw std::length_error ("DirectoryTable: too many entries");
+      if (mNextEntry % CHUNK_SIZE == 0) mChunks.emplace_back (new ValueType [CHUNK_SIZE]);
+      return mNextEntry++;
+    }
+
+    //! rebuilds the index with capacity slots, the entries stay in place
+    void rehash (size_t capacity) {
+      std::vector<Slot> old;
+      old.swap (mSlots);
+      mSlots.assign (capacity, Slot ());
+      for (Slot& s : mSlots) s.Entry = FREE;
+      mMask = capacity - 1;
+      mShift = 64;
+      for (size_t c = capacity; c > 1; c /= 2) mShift--;
+      for (const Slot& o : old) {
+        if (o.Entry == FREE) continue;
+        size_t s = slotOf (o.Key);
+        while (mSlots[s].Entry != FREE) s = (s + 1) & mMask;
+        mSlots[s] = o;
+      }
+    }
+  };
+}
+
+#endif /* DIRECTORYTABLE_HPP_ */
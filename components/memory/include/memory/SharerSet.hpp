@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0 
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef SHARERSET_HPP_
+#define SHARERSET_HPP_
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
+
+namespace vpsim {
+
+  //!
+  //! Set of cache ids, stored as a bitmask.
+  //! Ids below INLINE_BITS live in the object itself, so copying or clearing the set of a
+  //! system with up to INLINE_BITS caches never allocates. Larger ids are kept in an
+  //! overflow vector, grown on demand up to MAX_ID.
+  //! Iteration visits the ids in increasing order, like std::set.
+  //!
+  class SharerSet {
+
+  public:
+
+    typedef uint32_t value_type;
+
+    static const size_t INLINE_WORDS = 2;
+    static const size_t INLINE_BITS  = INLINE_WORDS * 64;
+    static const value_type MAX_ID   = (1 << 16) - 1; //!< largest id that can be stored
+
+    class const_iterator {
+    public:
+      typedef std::forward_iterator_tag iterator_category;
+      typedef SharerSet::value_type value_type;
+      typedef std::ptrdiff_t difference_type;
+      typedef const value_type* pointer;
+      typedef value_type reference;
+
+      const_iterator (const SharerSet* set, size_t pos) : mSet (set), mPos (pos) { seek (); }
+
+      value_type operator* () const { return (value_type) mPos; }
+      const_iterator& operator++ () { mPos++; seek (); return *this; }
+      const_iterator operator++ (int) { const_iterator tmp = *this; ++*this; return tmp; }
+      bool operator== (const const_iterator& other) const { return mPos == other.mPos; }
+      bool operator!= (const const_iterator& other) const { return mPos != other.mPos; }
+
+    private:
+      //! moves mPos to the next set bit at or after mPos, or to the end
+      void seek () {
+        const size_t words = mSet->wordCount ();
+        size_t w = mPos / 64;
+        if (w >= words) { mPos = mSet->endPos (); return; }
+        uint64_t bits = mSet->word (w) & (~0ULL << (mPos % 64));
+        while (!bits) {
+          if (++w >= words) { mPos = mSet->endPos (); return; }
+          bits = mSet->word (w);
+        }
+        mPos = w * 64 + __builtin_ctzll (bits);
+      }
+
+      const SharerSet* mSet;
+      size_t mPos;
+    };
+    typedef const_iterator iterator;
+
+    SharerSet () : mInline () {}
+    SharerSet (std::initializer_list<value_type> ids) : mInline () {
+      for (value_type id : ids) insert (id);
+    }
+
+    //---------------------------------------------------
+    //Elements
+
+    inline void insert (value_type id) {
+      if (id >= INLINE_BITS) grow (id);
+      wordRef (id / 64) |= 1ULL << (id % 64);
+    }
+
+    inline void erase (value_type id) {
+      if (id / 64 < wordCount ()) wordRef (id / 64) &= ~(1ULL << (id % 64));
+    }
+
+    inline size_t count (value_type id) const {
+      return (id / 64 < wordCount ()) ? (word (id / 64) >> (id % 64)) & 1 : 0;
+    }
+    inline bool contains (value_type id) const { return count (id); }
+
+    //! @return the number of ids in the set
+    inline size_t size () const {
+      size_t n = 0;
+      for (size_t w = 0; w < wordCount (); w++) n += __builtin_popcountll (word (w));
+      return n;
+    }
+
+    inline bool empty () const {
+      for (size_t w = 0; w < wordCount (); w++) if (word (w)) return false;
+      return true;
+    }
+
+    //! removes every id, keeping the overflow storage for later use
+    inline void clear () {
+      for (size_t w = 0; w < INLINE_WORDS; w++) mInline[w] = 0;
+      for (uint64_t& w : mOverflow) w = 0;
+    }
+
+    const_iterator begin () const { return const_iterator (this, 0); }
+    const_iterator end ()   const { return const_iterator (this, endPos ()); }
+
+    //---------------------------------------------------
+    //Set operations
+
+    SharerSet& operator|= (const SharerSet& other) {
+      if (other.wordCount () > wordCount ()) mOverflow.resize (other.wordCount () - INLINE_WORDS, 0);
+      for (size_t w = 0; w < other.wordCount (); w++) wordRef (w) |= other.word (w);
+      return *this;
+    }
+
+    SharerSet& operator&= (const SharerSet& other) {
+      for (size_t w = 0; w < wordCount (); w++) wordRef (w) &= other.wordOrZero (w);
+      return *this;
+    }
+
+    //! removes the ids of other
+    SharerSet& operator-= (const SharerSet& other) {
+      for (size_t w = 0; w < wordCount (); w++) wordRef (w) &= ~other.wordOrZero (w);
+      return *this;
+    }
+
+    friend SharerSet operator| (SharerSet a, const SharerSet& b) { return a |= b; }
+    friend SharerSet operator& (SharerSet a, const SharerSet& b) { return a &= b; }
+    friend SharerSet operator- (SharerSet a, const SharerSet& b) { return a -= b; }
+
+    bool operator== (const SharerSet& other) const {
+      const size_t words = std::max (wordCount (), other.wordCount ());
+      for (size_t w = 0; w < words; w++) if (wordOrZero (w) != other.wordOrZero (w)) return false;
+      return true;
+    }
+    bool operator!= (const SharerSet& other) const { return !(*this == other); }
+
+  private:
+
+    uint64_t mInline[INLINE_WORDS];  //!< ids 0 to INLINE_BITS-1
+    std::vector<uint64_t> mOverflow; //!< ids from INLINE_BITS, empty unless such an id was inserted
+
+    inline size_t wordCount () const { return INLINE_WORDS + mOverflow.size (); }
+    inline size_t endPos () const { return wordCount () * 64; }
+
+    inline uint64_t word (size_t w) const { return (w < INLINE_WORDS) ? mInline[w] : mOverflow[w - INLINE_WORDS]; }
+    inline uint64_t wordOrZero (size_t w) const { return (w < wordCount ()) ? word (w) : 0; }
+    inline uint64_t& wordRef (size_t w) { return (w < INLINE_WORDS) ? mInline[w] : mOverflow[w - INLINE_WORDS]; }
+
+    void grow (value_type id) {
+      if (id > MAX_ID) {
+        throw std::out_of_range ("SharerSet: id " + std::to_string (id) + " exceeds the largest supported cache id");
+      }
+      const size_t words = id / 64 + 1;
+      if (words > wordCount ()) mOverflow.resize (words - INLINE_WORDS, 0);
+    }
+  };
+}
+
+#endif /* SHARERSET_HPP_ */
@@ -32,12 +32,15 @@ namespace vpsim
 		//Local variables
 		uint32_t mWordLengthInByte;
 
+		//! @brief Number of channel words needed to transfer len bytes
+		uint64_t getWordCount ( size_t len ) const;
+
 	public:
 
 		sc_time ReadLatency;
 		sc_time WriteLatency;
 		memory(sc_module_name Name, uint64_t Size);
-		memory(sc_module_name Name, uint64_t Size, bool ByteEnable, bool DmiEnable);
+		memory(sc_module_name Name, uint64_t Size, bool ByteEnable, bool DmiEnable, bool SparseMem = false);
 		void Init ( );
 
 		SC_HAS_PROCESS(memory);
@@ -58,7 +61,14 @@ namespace vpsim
 			load_elf_file(name,getBaseAddress(),getSize(),debug);
 		}
 
-		void loadBlob(const string filename, const uint64_t off);
+		//! Loads a file in memory. Whole pages are mapped copy-on-write when the memory is sparse
+		//! @param[in] filename file to load
+		//! @param[in] off offset in memory of the first loaded byte
+		//! @param[in] file_off offset in the file of the first loaded byte
+		void loadBlob(const string filename, const uint64_t off, const uint64_t file_off = 0);
+
+		//! Writes the whole memory content to a file
+		void saveImage(const string filename);
 
 		void setChannelWidth(uint32_t bytes) { mWordLengthInByte=bytes; }
 	};
@@ -28,9 +28,9 @@ memory::memory ( sc_module_name Name, uint64_t Size ) :
 	Init ();
 }
 
-memory::memory( sc_module_name Name, uint64_t Size, bool ByteEnable, bool DmiEnable ) :
+memory::memory( sc_module_name Name, uint64_t Size, bool ByteEnable, bool DmiEnable, bool SparseMem ) :
 	sc_module(Name),
-	TargetIf <unsigned char> ( string(Name), Size, ByteEnable, DmiEnable ),
+	TargetIf <unsigned char> ( string(Name), Size, ByteEnable, DmiEnable, SparseMem ),
 	mWordLengthInByte ( 4 )
 {
 	Init ();
@@ -78,34 +78,53 @@ void memory::Dump ( uint64_t StartAddress, uint64_t EndAddress ) {
 	}
 }
 
-void memory::loadBlob(const string filename, const uint64_t init_off) {
+void memory::loadBlob(const string filename, const uint64_t init_off, const uint64_t file_off) {
+	if (init_off > getSize())
+		throw runtime_error(getName() + string(": blob does not fit in memory: ") + filename);
+
+	//Whole pages are mapped when possible, the rest is read
+	uint64_t mapped = MapLocalMemFile(filename, file_off, init_off);
+
 	FILE* inFile = fopen(filename.c_str(), "rb");
 	if (!inFile)
 		throw runtime_error(string("Unable to open blob file: ") + filename);
-	const size_t bufSize = 2048;
-	size_t nr=0;
-	size_t off=init_off;
-	while ((nr=fread(getLocalMem()+off, sizeof(char), bufSize, inFile)) == bufSize) {off+=nr;
-	//if(off-nr>=0x01FDFF0) cout<<hex<<"Loaded :"<<nr<< " bytes "<<*(uint32_t*)(getLocalMem()+off-nr)<<" @"<<off-nr<<dec<<endl;
+	if (fseek(inFile, file_off + mapped, SEEK_SET) != 0) {
+		fclose(inFile);
+		throw runtime_error(string("Unable to seek in blob file: ") + filename);
+	}
+	uint64_t off = init_off + mapped;
+	size_t nr = 0;
+	while (off < getSize() && (nr = fread(getLocalMem() + off, sizeof(char), getSize() - off, inFile)) > 0) {
+		off += nr;
 	}
-	//cout<<hex<<" initially = "<<*(uint32_t*)&getLocalMem()[0x01FDFF0]<<dec<<endl;
 	fclose(inFile);
 }
 
+void memory::saveImage(const string filename) {
+	FILE* outFile = fopen(filename.c_str(), "wb");
+	if (!outFile)
+		throw runtime_error(string("Unable to open image file: ") + filename);
+	size_t nw = fwrite(getLocalMem(), sizeof(char), getSize(), outFile);
+	fclose(outFile);
+	if (nw != getSize())
+		throw runtime_error(string("Unable to write image file: ") + filename);
+}
+
 
 //---------------------------------------------------
 //Main functions
-tlm::tlm_response_status memory::read ( payload_t & payload, sc_time & delay ) {
-	//Compute delay time (can be more accurate)
+uint64_t memory::getWordCount ( size_t len ) const {
+	//At least one word is accessed, even for an empty payload
+	if ( mWordLengthInByte == 0 || len <= mWordLengthInByte ) {
+		return 1;
+	}
+	return ( len + mWordLengthInByte - 1 ) / mWordLengthInByte;
+}
 
+tlm::tlm_response_status memory::read ( payload_t & payload, sc_time & delay ) {
+	//One ReadLatency per word of the channel
 	if ( getEnableLatency() ) {
-		size_t accessed=0;
-		do
-		{
-			accessed += mWordLengthInByte;
-			//delay += (getInitialCyclesPerAccess() + getCyclesPerRead()) * getCycleDuration();
-			delay += ReadLatency;
-		} while (accessed < payload.len);
+		delay += ReadLatency * (double) getWordCount ( payload.len );
 	}
 
 	payload.dmi = true;
@@ -114,34 +133,17 @@ tlm::tlm_response_status memory::read ( payload_t & payload, sc_time & delay ) {
 		return tlm::TLM_OK_RESPONSE;
 	}
 
-
-	//Test data allocated buffer
-	//if (payload.ptr==NULL) {
-	//	cerr<<getName()<<": error, data pointer not initialized in payload."<<endl; throw(0);
-	//}
-
-	//Read word
-	unsigned char * tmp = new unsigned char [ payload.len ];
-	for ( size_t i=0 ; i<payload.len ; i++ ) tmp [i] = getLocalMem()[ payload.addr-getBaseAddress()+i ];
-    BYTE * tmp_ptr = (BYTE*) tmp;
-	memcpy ( payload.ptr, tmp_ptr, payload.len );
-	delete [] tmp;
-
+	//Read data
+	memcpy ( payload.ptr, getLocalMem() + ( payload.addr - getBaseAddress() ), payload.len );
 
 	//End
 	return ( tlm::TLM_OK_RESPONSE );
 }
 
 tlm::tlm_response_status memory::write ( payload_t & payload, sc_time & delay ) {
-	//Compute delay time (can be more accurate)
+	//One WriteLatency per word of the channel
 	if ( getEnableLatency() ) {
-		size_t accessed=0;
-		do
-		{
-			accessed += mWordLengthInByte;
-			//delay += (getInitialCyclesPerAccess() + getCyclesPerRead()) * getCycleDuration();
-			delay += WriteLatency;
-		} while (accessed < payload.len);
+		delay += WriteLatency * (double) getWordCount ( payload.len );
 	}
 
 	payload.dmi = true;
@@ -150,17 +152,8 @@ tlm::tlm_response_status memory::write ( payload_t & payload, sc_time & delay )
 		return tlm::TLM_OK_RESPONSE;
 	}
 
-	//Test data allocated buffer
-	//if (payload.ptr==NULL) {
-	//	cerr<<getName()<<": error, data pointer not initialized in payload."<<endl; throw(0);
-	//}
-
-	//Write word
-	BYTE * tmp = new BYTE [ payload.len ];
-	memcpy (tmp, payload.ptr, payload.len);
-	unsigned char * tmp_ptr = (unsigned char*) tmp;
-	for ( size_t i=0 ; i<payload.len ; i++ ) getLocalMem()[ payload.addr - getBaseAddress() + i ] = (unsigned char) tmp_ptr [i];
-	delete [] tmp;
+	//Write data
+	memcpy ( getLocalMem() + ( payload.addr - getBaseAddress() ), payload.ptr, payload.len );
 
 	//End
 	return ( tlm::TLM_OK_RESPONSE );
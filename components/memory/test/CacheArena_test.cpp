@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+
+#include <gtest/gtest.h>
+#include "global.hpp"
+#include "CacheBase.hpp"
+#include "CacheArena.hpp"
+
+using namespace vpsim;
+using namespace std;
+
+int sc_main(int argc, char* argv[])
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+typedef CacheLine<uint64_t> Line;
+typedef CacheSet<Line, uint64_t> Set;
+typedef CacheBase<uint64_t, uint64_t> TestCache;
+
+static const uint64_t LINE_SIZE = 64;
+
+TEST(CacheArena, zeroedAndAligned){
+  CacheArena<unsigned char> data(3 * 4096 + 5);
+  EXPECT_EQ(3u * 4096 + 5, data.size());
+  EXPECT_EQ(0u, (uintptr_t) data.data() % 4096);
+  for (size_t i = 0; i < data.size(); i += 97) ASSERT_EQ(0, data[i]);
+
+  //Reallocating drops the previous content
+  data[0] = 1;
+  data.allocate(16);
+  EXPECT_EQ(16u, data.bytes());
+  EXPECT_EQ(0, data[0]);
+  data.release();
+  EXPECT_EQ(NULL, data.data());
+  EXPECT_EQ(0u, data.bytes());
+}
+
+TEST(CacheArena, constructsLines){
+  CacheArena<Line> lines(100);
+  for (size_t i = 0; i < lines.size(); i++) {
+    ASSERT_EQ(Invalid, lines[i].getState());
+    ASSERT_EQ(NULL, lines[i].getDataPtr());
+  }
+}
+
+TEST(CacheArena, setsOverArenas){
+  const unsigned assoc = 4;
+  CacheArena<Line> lines(2 * assoc);
+  CacheArena<unsigned> ages(2 * assoc);
+  CacheArena<unsigned char> data(2 * assoc * LINE_SIZE);
+  Set first(&lines[0], &ages[0], LINE_SIZE, assoc, LRU);
+  Set second(&lines[assoc], &ages[assoc], LINE_SIZE, assoc, LRU);
+  first.setData(&data[0]);
+  second.setData(&data[assoc * LINE_SIZE]);
+
+  //Each line has its own LINE_SIZE bytes, the sets lying one after the other
+  EXPECT_EQ(&lines[assoc], &second.getLine(0));
+  for (unsigned way = 0; way < assoc; way++) {
+    EXPECT_EQ(&data[way * LINE_SIZE], first.getLine(way).getDataPtr());
+    EXPECT_EQ(&data[(assoc + way) * LINE_SIZE], second.getLine(way).getDataPtr());
+    EXPECT_EQ(LINE_SIZE, first.getLine(way).getSize());
+  }
+
+  Line* line = NULL;
+  EXPECT_FALSE(second.accessSet(7, &line));
+  line->setNewLine(7 * LINE_SIZE, 7);
+  line->setState(Shared);
+  EXPECT_TRUE(second.accessSet(7, &line));
+  EXPECT_EQ(-1, first.locateLineInSet(7));
+}
+
+TEST(CacheArena, largeGeometries){
+  //256 MB, 16 ways: the arenas are sized by the geometry, the data ones only with data support
+  const uint64_t size = 256 << 20;
+  const uint64_t nbLines = size / LINE_SIZE;
+  TestCache withData("withData", size, LINE_SIZE, 16, 0, LRU, WBack, WAllocate, true);
+  TestCache timingOnly("timingOnly", size, LINE_SIZE, 16, 0, SRRIP, WBack, WAllocate, false);
+  EXPECT_EQ(size, withData.getDataBytes());
+  EXPECT_EQ(0u, timingOnly.getDataBytes());
+  EXPECT_EQ(nbLines * (sizeof(Line) + sizeof(unsigned)), withData.getMetadataBytes());
+  EXPECT_EQ(withData.getMetadataBytes(), timingOnly.getMetadataBytes());
+
+  //Lines of the first and last sets hold their own data
+  sc_time delay = SC_ZERO_TIME;
+  for (uint64_t addr : { (uint64_t) 0, size - LINE_SIZE, 3 * size }) {
+    uint64_t value = addr ^ 0x5a5a5a5a5a5a5a5aULL;
+    ASSERT_EQ(tlm::TLM_OK_RESPONSE, withData.accessCache<Write>((unsigned char*) &value, sizeof(value), addr, 0, 0, delay));
+    ASSERT_EQ(tlm::TLM_OK_RESPONSE, timingOnly.accessCache<Write>((unsigned char*) &value, sizeof(value), addr, 0, 0, delay));
+  }
+  for (uint64_t addr : { (uint64_t) 0, size - LINE_SIZE, 3 * size }) {
+    uint64_t value = 0;
+    withData.debugAccess((unsigned char*) &value, addr, sizeof(value), false);
+    EXPECT_EQ(addr ^ 0x5a5a5a5a5a5a5a5aULL, value);
+  }
+}
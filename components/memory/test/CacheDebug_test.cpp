@@ -0,0 +1,205 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+
+#include <gtest/gtest.h>
+#include "Cache.hpp"
+#include "interconnect.hpp"
+#include "memory.hpp"
+
+using namespace vpsim;
+using namespace sc_core;
+using namespace std;
+
+/*
+ * General comments
+ * Modules cannot be instantiated once the elaboration is over, so the
+ * platform is built once in sc_main and shared by every test:
+ * cpu -> l1 -> bus -> { mem0, mem1 }
+ * The L1 is a write-back cache holding data, so that memory is stale for
+ * every dirty line. The cpu issues functional accesses with the extension
+ * the L1 expects from a processor, and debug accesses through the same
+ * socket, like a debugger attached to the processor would.
+ */
+
+static const uint64_t LINE_SIZE = 64;
+static const uint64_t CACHE_SIZE = 4096;
+static const uint64_t ASSOCIATIVITY = 2;
+static const uint64_t MEM_SIZE = 0x10000;
+
+typedef Cache<uint64_t, uint64_t> TestCache;
+
+class TestCpu : public sc_module
+{
+public:
+	tlm_utils::simple_initiator_socket<TestCpu> socket;
+
+	TestCpu(sc_module_name name): sc_module(name), socket("socket") {}
+
+	tlm::tlm_response_status access(tlm::tlm_command cmd, uint64_t addr, void* data, unsigned int len) {
+		tlm::tlm_generic_payload trans;
+		SourceCpuExtension src;
+		src.type = 0;
+		src.cpu_id = 0;
+		src.time_stamp = SC_ZERO_TIME;
+		setPayload(trans, cmd, addr, data, len);
+		trans.set_extension<SourceCpuExtension>(&src); //the L1 detaches it
+		sc_time delay = SC_ZERO_TIME;
+		socket->b_transport(trans, delay);
+		trans.clear_extension(&src);
+		return trans.get_response_status();
+	}
+
+	unsigned int debug(tlm::tlm_command cmd, uint64_t addr, void* data, unsigned int len) {
+		tlm::tlm_generic_payload trans;
+		setPayload(trans, cmd, addr, data, len);
+		return socket->transport_dbg(trans);
+	}
+
+private:
+	static void setPayload(tlm::tlm_generic_payload& trans, tlm::tlm_command cmd, uint64_t addr, void* data, unsigned int len) {
+		trans.set_command(cmd);
+		trans.set_address(addr);
+		trans.set_data_ptr((unsigned char*)data);
+		trans.set_data_length(len);
+		trans.set_streaming_width(len);
+		trans.set_byte_enable_ptr(nullptr);
+		trans.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
+	}
+};
+
+static TestCpu* cpu;
+static TestCache* l1;
+static memory* mem0;
+static memory* mem1;
+
+int sc_main(int argc, char* argv[])
+{
+	testing::InitGoogleTest(&argc, argv);
+
+	cpu = new TestCpu("cpu");
+	l1 = new TestCache("l1", sc_time(1, SC_NS), CACHE_SIZE, LINE_SIZE, ASSOCIATIVITY, 1,
+			LRU, WBack, WAllocate, true, 0, 1);
+	interconnect* bus = new interconnect("bus", 1, 2);
+	mem0 = new memory("mem0", MEM_SIZE);
+	mem1 = new memory("mem1", MEM_SIZE);
+
+	mem0->setBaseAddress(0);
+	mem1->setBaseAddress(MEM_SIZE);
+	bus->set_socket_out_addr(0, 0, MEM_SIZE);
+	bus->set_socket_out_addr(1, MEM_SIZE, MEM_SIZE);
+
+	cpu->socket.bind(l1->socket_in[0]);
+	l1->socket_out[0].bind(bus->socket_in[0]);
+	bus->socket_out[0].bind(mem0->mTargetSocket);
+	bus->socket_out[1].bind(mem1->mTargetSocket);
+
+	sc_start(SC_ZERO_TIME);
+
+	return RUN_ALL_TESTS();
+}
+
+//Reads the memories behind the cache, without the cache
+static uint64_t memoryWord(uint64_t addr) {
+	uint64_t value = 0;
+	tlm::tlm_generic_payload trans;
+	trans.set_read();
+	trans.set_address(addr);
+	trans.set_data_ptr((unsigned char*)&value);
+	trans.set_data_length(8);
+	EXPECT_EQ(8u, (addr < MEM_SIZE ? mem0 : mem1)->transport_dbg(trans));
+	return value;
+}
+
+static uint64_t functionalWord(uint64_t addr) {
+	uint64_t value = 0;
+	EXPECT_EQ(tlm::TLM_OK_RESPONSE, cpu->access(tlm::TLM_READ_COMMAND, addr, &value, 8));
+	return value;
+}
+
+static void writeWords(uint64_t addr, uint64_t size, uint64_t seed) {
+	for (uint64_t a = addr; a < addr + size; a += 8) {
+		uint64_t value = seed ^ a;
+		EXPECT_EQ(tlm::TLM_OK_RESPONSE, cpu->access(tlm::TLM_WRITE_COMMAND, a, &value, 8));
+	}
+}
+
+TEST(CacheDebug, dirtyLinesAreVisible){
+	const uint64_t addr = 0x100, size = 0x200;
+	writeWords(addr, size, 0x1111);
+
+	vector<uint64_t> words(size / 8);
+	EXPECT_EQ(size, cpu->debug(tlm::TLM_READ_COMMAND, addr, words.data(), size));
+	for (uint64_t i = 0; i < words.size(); i++) {
+		const uint64_t a = addr + i * 8;
+		EXPECT_EQ(functionalWord(a), words[i]) << hex << a;
+		//The lines are dirty: memory has not seen the writes yet
+		EXPECT_NE(words[i], memoryWord(a)) << hex << a;
+	}
+
+	//Unaligned and smaller than a line
+	uint32_t value = 0;
+	EXPECT_EQ(4u, cpu->debug(tlm::TLM_READ_COMMAND, addr + 0x3C, &value, 4));
+	EXPECT_EQ((uint32_t)(functionalWord(addr + 0x38) >> 32), value);
+}
+
+TEST(CacheDebug, debugWriteReachesCacheAndMemory){
+	const uint64_t addr = 0x400;
+	writeWords(addr, LINE_SIZE, 0x2222);
+
+	//Debug write in the middle of a dirty line
+	const uint64_t patch = 0xDEADBEEFCAFEF00Dull;
+	EXPECT_EQ(8u, cpu->debug(tlm::TLM_WRITE_COMMAND, addr + 8, (void*)&patch, 8));
+	EXPECT_EQ(patch, functionalWord(addr + 8));
+	EXPECT_EQ(0x2222 ^ addr, functionalWord(addr));
+
+	//Once the line is written back, memory holds both the functional and the debug writes
+	const uint64_t setStride = CACHE_SIZE / ASSOCIATIVITY;
+	for (uint64_t way = 1; way <= ASSOCIATIVITY; way++) {
+		writeWords(addr + way * setStride, 8, 0x3333);
+	}
+	EXPECT_EQ(patch, memoryWord(addr + 8));
+	EXPECT_EQ(0x2222 ^ addr, memoryWord(addr));
+	EXPECT_EQ(patch, functionalWord(addr + 8));
+}
+
+TEST(CacheDebug, largeTransferAcrossMemories){
+	//Larger than the cache, half in each memory
+	const uint64_t size = 2 * CACHE_SIZE, addr = MEM_SIZE - CACHE_SIZE;
+	writeWords(addr + 0x100, 0x80, 0x4444);
+	writeWords(MEM_SIZE + 0x200, 0x80, 0x5555);
+
+	vector<uint64_t> words(size / 8);
+	EXPECT_EQ(size, cpu->debug(tlm::TLM_READ_COMMAND, addr, words.data(), size));
+	for (uint64_t i = 0; i < words.size(); i++) {
+		EXPECT_EQ(functionalWord(addr + i * 8), words[i]) << hex << addr + i * 8;
+	}
+
+	for (uint64_t i = 0; i < words.size(); i++) words[i] = 0x6666 ^ i;
+	EXPECT_EQ(size, cpu->debug(tlm::TLM_WRITE_COMMAND, addr, words.data(), size));
+	for (uint64_t i = 0; i < words.size(); i++) {
+		EXPECT_EQ(0x6666 ^ i, functionalWord(addr + i * 8)) << hex << addr + i * 8;
+	}
+}
+
+TEST(CacheDebug, unmappedEnd){
+	//Only the mapped part of the transfer is done
+	uint64_t words[2] = { 0, 0 };
+	writeWords(2 * MEM_SIZE - 8, 8, 0x7777);
+	EXPECT_EQ(8u, cpu->debug(tlm::TLM_READ_COMMAND, 2 * MEM_SIZE - 8, words, 16));
+	EXPECT_EQ(0x7777 ^ (2 * MEM_SIZE - 8), words[0]);
+	EXPECT_EQ(0u, cpu->debug(tlm::TLM_READ_COMMAND, 2 * MEM_SIZE, words, 8));
+}
@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+
+#include <gtest/gtest.h>
+#include "global.hpp"
+#include "CacheLine.hpp"
+#include "CacheSet.hpp"
+
+using namespace vpsim;
+using namespace std;
+
+int sc_main(int argc, char* argv[])
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+typedef CacheLine<uint64_t> Line;
+typedef CacheSet<Line, uint64_t> Set;
+
+static const unsigned LINE_SIZE = 64;
+
+//Accesses tag as CacheBase does, filling the victim on a miss
+//@return the way holding tag, negated minus one on a miss
+static int access(Set& set, unsigned tag) {
+  Line* line = NULL;
+  const bool hit = set.accessSet(tag, &line);
+  const int way = line - &set.getLine(0);
+  if (hit) return way;
+  line->setNewLine(tag * LINE_SIZE, tag);
+  line->setState(Shared);
+  return -way - 1;
+}
+
+//Counts the hits of a trace repeated rounds times, the first round excluded
+static unsigned hits(Set& set, const vector<unsigned>& trace, unsigned rounds) {
+  unsigned count = 0;
+  for (unsigned r = 0; r < rounds; r++)
+    for (unsigned tag: trace)
+      if (access(set, tag) >= 0 && r) count++;
+  return count;
+}
+
+TEST(CacheReplacement, names){
+  EXPECT_EQ(LRU, getReplacementPolicy("LRU"));
+  EXPECT_EQ(FIFO, getReplacementPolicy("FIFO"));
+  EXPECT_EQ(MRU, getReplacementPolicy("MRU"));
+  EXPECT_EQ(PLRU, getReplacementPolicy("PLRU"));
+  EXPECT_EQ(RANDOM, getReplacementPolicy("RANDOM"));
+  EXPECT_EQ(SRRIP, getReplacementPolicy("SRRIP"));
+  EXPECT_EQ(BRRIP, getReplacementPolicy("BRRIP"));
+  EXPECT_THROW(getReplacementPolicy("LFU"), runtime_error);
+}
+
+TEST(CacheReplacement, lru){
+  Set set(LINE_SIZE, 4, LRU);
+  for (unsigned tag = 1; tag <= 4; tag++) EXPECT_EQ(-int(tag), access(set, tag));
+  EXPECT_EQ(0, access(set, 1));
+  //2 is now the least recently used
+  EXPECT_EQ(-2, access(set, 5));
+  EXPECT_EQ(-3, access(set, 6));
+
+  //Hitting the least recently used way, the last one, does not elect it
+  Set two(LINE_SIZE, 2, LRU);
+  access(two, 1);
+  access(two, 2);
+  EXPECT_EQ(0, access(two, 1));
+  EXPECT_EQ(1, access(two, 2));
+  EXPECT_EQ(-1, access(two, 3));
+}
+
+TEST(CacheReplacement, fifo){
+  Set set(LINE_SIZE, 4, FIFO);
+  for (unsigned tag = 1; tag <= 4; tag++) EXPECT_EQ(-int(tag), access(set, tag));
+  //Hits do not change the order of the fills
+  EXPECT_EQ(0, access(set, 1));
+  EXPECT_EQ(-1, access(set, 5));
+  EXPECT_EQ(-2, access(set, 1));
+  EXPECT_EQ(-3, access(set, 6));
+}
+
+TEST(CacheReplacement, mru){
+  Set set(LINE_SIZE, 4, MRU);
+  //Free ways are filled first, hits included
+  EXPECT_EQ(-1, access(set, 1));
+  EXPECT_EQ(0, access(set, 1));
+  EXPECT_EQ(-2, access(set, 2));
+  EXPECT_EQ(-3, access(set, 3));
+  EXPECT_EQ(-4, access(set, 4));
+  EXPECT_EQ(1, access(set, 2));
+  EXPECT_EQ(-2, access(set, 5));
+  EXPECT_EQ(-2, access(set, 6));
+}
+
+TEST(CacheReplacement, plru){
+  Set set(LINE_SIZE, 4, PLRU);
+  //Every fill points the tree away from its way
+  EXPECT_EQ(-1, access(set, 1));
+  EXPECT_EQ(-3, access(set, 2));
+  EXPECT_EQ(-2, access(set, 3));
+  EXPECT_EQ(-4, access(set, 4));
+  EXPECT_EQ(0, access(set, 1));
+  //Way 0 hit, root points up, way 3 filled last, the victim is way 2
+  EXPECT_EQ(-3, access(set, 5));
+
+  //A loop over the ways never misses once they are filled
+  Set eight(LINE_SIZE, 8, PLRU);
+  vector<unsigned> loop;
+  for (unsigned tag = 1; tag <= 8; tag++) loop.push_back(tag);
+  EXPECT_EQ(8u * 3, hits(eight, loop, 4));
+
+  EXPECT_THROW(Set(LINE_SIZE, 6, PLRU), runtime_error);
+  EXPECT_THROW(Set(LINE_SIZE, 128, PLRU), runtime_error);
+}
+
+TEST(CacheReplacement, random){
+  Set a(LINE_SIZE, 8, RANDOM), b(LINE_SIZE, 8, RANDOM), c(LINE_SIZE, 8, RANDOM);
+  a.setSeed(42);
+  b.setSeed(42);
+  c.setSeed(43);
+  vector<unsigned> used(8, 0);
+  bool differ = false;
+  for (unsigned tag = 1; tag <= 1000; tag++) {
+    const int way = access(a, tag);
+    ASSERT_LT(way, 0);
+    //Same seed, same victims
+    ASSERT_EQ(way, access(b, tag));
+    differ |= way != access(c, tag);
+    used[-way - 1]++;
+  }
+  EXPECT_TRUE(differ);
+  for (unsigned w = 0; w < 8; w++) EXPECT_GT(used[w], 60u) << "way " << w;
+}
+
+TEST(CacheReplacement, srripScan){
+  //Two hot lines, reused once, then accessed between scans of three lines each, in 4 ways
+  vector<unsigned> trace = {1, 2, 1, 2};
+  unsigned next = 100;
+  for (unsigned i = 0; i < 50; i++) {
+    trace.push_back(1);
+    trace.push_back(2);
+    for (unsigned s = 0; s < 3; s++) trace.push_back(next++);
+  }
+  unsigned hot[2] = {0, 0};
+  for (CacheReplacementPolicy policy: {LRU, SRRIP}) {
+    Set set(LINE_SIZE, 4, policy);
+    for (unsigned i = 0; i < trace.size(); i++)
+      if (access(set, trace[i]) >= 0 && i >= 6 && trace[i] < 100) hot[policy == SRRIP]++;
+  }
+  //From the second round, LRU loses the hot lines to every scan, SRRIP keeps them
+  EXPECT_EQ(0u, hot[0]);
+  EXPECT_EQ(2u * 49, hot[1]);
+}
+
+TEST(CacheReplacement, brripThrashing){
+  //A loop over one more line than there are ways
+  vector<unsigned> loop;
+  for (unsigned tag = 1; tag <= 9; tag++) loop.push_back(tag);
+  Set lru(LINE_SIZE, 8, LRU), srrip(LINE_SIZE, 8, SRRIP), brrip(LINE_SIZE, 8, BRRIP);
+  brrip.setSeed(7);
+  EXPECT_EQ(0u, hits(lru, loop, 100));
+  const unsigned brripHits = hits(brrip, loop, 100);
+  //A good part of the loop stays in the set
+  EXPECT_GT(brripHits, 9u * 99 / 3);
+  EXPECT_GT(brripHits, hits(srrip, loop, 100));
+}
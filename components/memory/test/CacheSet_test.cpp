@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+
+#include <gtest/gtest.h>
+#include "global.hpp"
+#include "CacheLine.hpp"
+#include "CacheSet.hpp"
+#include <random>
+
+using namespace vpsim;
+using namespace std;
+
+int sc_main(int argc, char* argv[])
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+typedef CacheLine<uint64_t> Line;
+typedef CacheSet<Line, uint64_t> Set;
+
+static const unsigned LINE_SIZE = 64;
+
+static int way(Set& set, Line* line) {
+  return line - &set.getLine(0);
+}
+
+//Drives both sets with the same accesses, as CacheBase does, and checks they behave the same
+static void checkEquivalence(unsigned assoc, CacheReplacementPolicy policy, unsigned tagBits) {
+  SCOPED_TRACE(to_string(assoc) + " ways, " + to_string(tagBits) + " tag bits");
+  Set lines(LINE_SIZE, assoc, policy);
+  Set tags(LINE_SIZE, assoc, policy);
+  tags.setLayout(TagArray, tagBits);
+  ASSERT_EQ(LineArray, lines.getLayout());
+  ASSERT_EQ(TagArray, tags.getLayout());
+
+  mt19937 rng(assoc);
+  //Twice as many tags as ways, tag 0 included
+  uniform_int_distribution<unsigned> tagOf(0, 2 * assoc - 1);
+  for (unsigned i = 0; i < 20000; i++) {
+    const unsigned tag = tagOf(rng);
+    Line* fromLines = NULL;
+    Line* fromTags = NULL;
+    const bool hit = lines.accessSet(tag, &fromLines);
+    ASSERT_EQ(hit, tags.accessSet(tag, &fromTags)) << "access " << i;
+    ASSERT_EQ(way(lines, fromLines), way(tags, fromTags)) << "access " << i;
+
+    if (!hit) {
+      fromLines->setNewLine(tag * LINE_SIZE, tag);
+      fromTags->setNewLine(tag * LINE_SIZE, tag);
+    }
+    //Fills, upgrades and invalidations
+    const CoherenceState state = rng() % 8 ? (rng() % 2 ? Shared : Modified) : Invalid;
+    fromLines->setState(state);
+    fromTags->setState(state);
+
+    const unsigned probe = tagOf(rng);
+    ASSERT_EQ(lines.locateLineInSet(probe), tags.locateLineInSet(probe)) << "probe " << i;
+  }
+}
+
+TEST(CacheSet, equivalence){
+  for (unsigned assoc: {1u, 2u, 4u, 6u, 8u, 12u, 16u, 32u, 64u}) {
+    checkEquivalence(assoc, LRU, 31);
+    checkEquivalence(assoc, FIFO, 31);
+    checkEquivalence(assoc, SRRIP, 63);
+  }
+}
+
+TEST(CacheSet, switchLayout){
+  Set set(LINE_SIZE, 8, LRU);
+  Line* line = NULL;
+  for (unsigned tag = 1; tag <= 8; tag++) {
+    EXPECT_FALSE(set.accessSet(tag, &line));
+    line->setNewLine(tag * LINE_SIZE, tag);
+    line->setState(Shared);
+  }
+  set.getLine(3).setState(Invalid);
+
+  //Lines already in the set are found once it switches, and updates are seen by both layouts
+  set.setLayout(TagArray);
+  EXPECT_EQ(0, set.locateLineInSet(1));
+  EXPECT_EQ(-1, set.locateLineInSet(4));
+  EXPECT_EQ(7, set.locateLineInSet(8));
+  set.getLine(7).setNewLine(9 * LINE_SIZE, 9);
+  set.getLine(7).setState(Modified);
+  EXPECT_EQ(-1, set.locateLineInSet(8));
+  EXPECT_EQ(7, set.locateLineInSet(9));
+
+  set.setLayout(LineArray);
+  EXPECT_EQ(7, set.locateLineInSet(9));
+  set.getLine(7).setState(Invalid);
+  EXPECT_EQ(-1, set.locateLineInSet(9));
+  EXPECT_EQ(&set.getLine(0), set.peekLine(1));
+}
+
+TEST(CacheSet, tooManyWays){
+  Set set(LINE_SIZE, 128, LRU);
+  EXPECT_THROW(set.setLayout(TagArray), runtime_error);
+  EXPECT_EQ(LineArray, set.getLayout());
+}
+
+TEST(CacheSet, wideTags){
+  //Tags differing only above bit 32, and the widest tag a 64 bit word can pack with its valid bit
+  const uint64_t wide[] = { 5, (1ULL << 32) + 5, (1ULL << 40) + 5, (1ULL << 62) + 5, (1ULL << 63) - 1 };
+  for (bool tagArray : { false, true }) {
+    Set set(LINE_SIZE, 8, LRU);
+    if (tagArray) set.setLayout(TagArray, 63);
+    Line* line = NULL;
+    for (uint64_t tag : wide) {
+      EXPECT_FALSE(set.accessSet(tag, &line)) << hex << tag;
+      line->setNewLine(0, tag);
+      line->setState(Shared);
+    }
+    for (unsigned i = 0; i < 5; i++) {
+      EXPECT_EQ((int) i, set.locateLineInSet(wide[i])) << hex << wide[i];
+      EXPECT_EQ(wide[i], set.getLine(i).getTag());
+    }
+    EXPECT_EQ(-1, set.locateLineInSet(1ULL << 32));
+  }
+  Set set(LINE_SIZE, 8, LRU);
+  EXPECT_THROW(set.setLayout(TagArray, 64), runtime_error);
+}
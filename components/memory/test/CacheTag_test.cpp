@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+
+#include <gtest/gtest.h>
+#include "global.hpp"
+#include "CacheBase.hpp"
+
+using namespace vpsim;
+using namespace std;
+
+int sc_main(int argc, char* argv[])
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+typedef CacheBase<uint64_t, uint64_t> TestCache;
+
+//4 KB, 4 ways, 64 byte lines: 16 sets, the tags start at bit 10
+static const uint64_t CACHE_SIZE = 4096;
+static const uint64_t LINE_SIZE = 64;
+static const uint64_t TIB = 1ULL << 40;
+
+//Reads addr, @return true on a hit
+static bool read(TestCache& cache, uint64_t addr) {
+  uint64_t data = 0;
+  sc_time delay = SC_ZERO_TIME;
+  const uint64_t hits = cache.HitCount;
+  cache.accessCache<Read>((unsigned char*) &data, sizeof(data), addr, 0, 0, delay);
+  return cache.HitCount != hits;
+}
+
+//Lines of the same set whose tags only differ above bit 32, which 32 bit tags aliased
+static void checkNoAliasing(TestCache& cache, uint64_t base) {
+  const uint64_t addrs[] = { base, base + 4 * TIB, base + (1ULL << 48), base + (1ULL << 48) + 4 * TIB };
+  for (uint64_t addr : addrs) EXPECT_FALSE(read(cache, addr)) << hex << addr;
+  for (uint64_t addr : addrs) EXPECT_TRUE(read(cache, addr)) << hex << addr;
+  EXPECT_FALSE(read(cache, base + 8 * TIB));
+}
+
+TEST(CacheTag, above4TiB){
+  for (CacheSetLayout layout : { LineArray, TagArray }) {
+    TestCache cache("cache", CACHE_SIZE, LINE_SIZE, 4, 0);
+    cache.setSetLayout(layout);
+    EXPECT_EQ(54u, cache.getTagBits());
+    checkNoAliasing(cache, 0x1040);
+  }
+}
+
+TEST(CacheTag, above2Pow48){
+  TestCache cache("cache", CACHE_SIZE, LINE_SIZE, 4, 0);
+  cache.setSetLayout(TagArray);
+  checkNoAliasing(cache, (1ULL << 52) + 0x1040);
+  //Highest line of the address space
+  EXPECT_FALSE(read(cache, ~0ULL - LINE_SIZE + 1));
+  EXPECT_TRUE(read(cache, ~0ULL - LINE_SIZE + 1));
+}
+
+TEST(CacheTag, physicalAddressWidth){
+  TestCache cache("cache", CACHE_SIZE, LINE_SIZE, 4, 0);
+  cache.setSetLayout(TagArray);
+  //40 bit addresses: 30 bit tags, packed with their valid bit in 32 bit words
+  cache.setPhysicalAddressBits(40);
+  EXPECT_EQ(30u, cache.getTagBits());
+  EXPECT_FALSE(read(cache, 0x1040));
+  EXPECT_FALSE(read(cache, 0x1040 + 512ULL * (1 << 30)));
+  EXPECT_TRUE(read(cache, 0x1040));
+  EXPECT_FALSE(read(cache, (1ULL << 40) - LINE_SIZE));
+  //Addresses the cache cannot tell apart are rejected, and counted
+  uint64_t data = 0;
+  sc_time delay = SC_ZERO_TIME;
+  const uint64_t misses = cache.MissCount;
+  EXPECT_EQ(0u, cache.NAddrErrors);
+  EXPECT_EQ(tlm::TLM_ADDRESS_ERROR_RESPONSE, cache.accessCache<Read>((unsigned char*) &data, sizeof(data), 1ULL << 40, 0, 0, delay));
+  EXPECT_EQ(tlm::TLM_ADDRESS_ERROR_RESPONSE, cache.accessCache<Write>((unsigned char*) &data, sizeof(data), (1ULL << 40) + 0x1040, 0, 0, delay));
+  EXPECT_EQ(2u, cache.NAddrErrors);
+  EXPECT_EQ(misses, cache.MissCount);
+  EXPECT_TRUE(read(cache, 0x1040));
+
+  //Wider addresses switch back to 64 bit words, the lines being kept
+  cache.setPhysicalAddressBits(52);
+  EXPECT_EQ(42u, cache.getTagBits());
+  EXPECT_TRUE(read(cache, 0x1040));
+  EXPECT_FALSE(read(cache, 0x1040 + 4 * TIB));
+
+  EXPECT_THROW(cache.setPhysicalAddressBits(65), runtime_error);
+  EXPECT_THROW(cache.setPhysicalAddressBits(10), runtime_error);
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+
+#include <gtest/gtest.h>
+#include "global.hpp"
+#include "DirectoryTable.hpp"
+#include "SharerSet.hpp"
+#include <map>
+#include <random>
+
+using namespace vpsim;
+using namespace std;
+
+int sc_main(int argc, char* argv[])
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+struct Entry { int State; uint32_t Owner; SharerSet Sharers; };
+
+TEST(DirectoryTable, insertFindErase){
+  DirectoryTable<uint64_t, Entry> dir(Entry { 2, 0xffffffff, {} });
+  EXPECT_TRUE(dir.empty());
+  EXPECT_EQ(NULL, dir.find(0x40));
+
+  //New entries start from the blank value
+  Entry& e = dir[0x40];
+  EXPECT_EQ(2, e.State);
+  EXPECT_EQ(0xffffffffu, e.Owner);
+  e = { 1, 0xffffffff, {3, 5} };
+  EXPECT_EQ(1u, dir.size());
+  EXPECT_EQ(&e, dir.find(0x40));
+  EXPECT_EQ(&e, &dir[0x40]);
+  EXPECT_EQ(1u, dir.size());
+
+  EXPECT_TRUE(dir.erase(0x40));
+  EXPECT_FALSE(dir.erase(0x40));
+  EXPECT_EQ(NULL, dir.find(0x40));
+  EXPECT_TRUE(dir.empty());
+  //A recycled entry starts from the blank value again
+  EXPECT_TRUE(dir[0x80].Sharers.empty());
+}
+
+TEST(DirectoryTable, stableEntries){
+  DirectoryTable<uint64_t, Entry> dir;
+  Entry& first = dir[0];
+  first.Sharers.insert(7);
+  //Growing the index many times does not move the entries
+  for (uint64_t line = 1; line < 100000; line++) dir[line * 64].Owner = line;
+  EXPECT_EQ(&first, dir.find(0));
+  EXPECT_TRUE(first.Sharers.contains(7));
+  EXPECT_GE(dir.capacity(), 2 * dir.size());
+}
+
+TEST(DirectoryTable, randomAgainstMap){
+  DirectoryTable<uint64_t, uint64_t> dir;
+  map<uint64_t, uint64_t> ref;
+  mt19937_64 rng(1);
+  //Few keys, so that erasing shifts back long probe sequences
+  for (unsigned i = 0; i < 200000; i++) {
+    const uint64_t key = (rng() % 3000) * 64;
+    switch (rng() % 3) {
+    case 0: dir[key] = i; ref[key] = i; break;
+    case 1: ASSERT_EQ(ref.erase(key) == 1, dir.erase(key)); break;
+    default: {
+      uint64_t* value = dir.find(key);
+      ASSERT_EQ(ref.count(key) == 1, value != NULL) << "key " << key;
+      if (value) {
+        ASSERT_EQ(ref[key], *value);
+      }
+    }
+    }
+    ASSERT_EQ(ref.size(), dir.size());
+  }
+  for (auto& kv : ref) ASSERT_EQ(kv.second, *dir.find(kv.first));
+}
+
+TEST(DirectoryTable, reserveClear){
+  DirectoryTable<uint64_t, int> dir;
+  dir.reserve(1000);
+  const size_t capacity = dir.capacity();
+  EXPECT_GE(capacity, 2000u);
+  for (uint64_t line = 0; line < 1000; line++) dir[line << 6] = 1;
+  EXPECT_EQ(capacity, dir.capacity());
+
+  dir.clear();
+  EXPECT_TRUE(dir.empty());
+  EXPECT_EQ(NULL, dir.find(0));
+  EXPECT_EQ(0, dir[0]);
+}
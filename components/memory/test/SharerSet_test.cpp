@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0 
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+
+#include <gtest/gtest.h>
+#include "global.hpp"
+#include "SharerSet.hpp"
+#include <random>
+
+using namespace vpsim;
+using namespace std;
+
+int sc_main(int argc, char* argv[])
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+static vector<uint32_t> ids(const SharerSet& s){
+  return vector<uint32_t>(s.begin(), s.end());
+}
+
+TEST(SharerSet, empty){
+  SharerSet s;
+  EXPECT_TRUE(s.empty());
+  EXPECT_EQ(0u, s.size());
+  EXPECT_TRUE(s.begin() == s.end());
+  EXPECT_EQ(0u, s.count(0));
+  EXPECT_EQ(0u, s.count(1000));
+}
+
+TEST(SharerSet, insertErase){
+  SharerSet s{3, 1, 63, 64};
+  EXPECT_EQ((vector<uint32_t>{1, 3, 63, 64}), ids(s));
+  EXPECT_EQ(4u, s.size());
+
+  s.insert(3);
+  EXPECT_EQ(4u, s.size());
+  s.erase(63);
+  s.erase(500); //not present, beyond the storage
+  EXPECT_EQ((vector<uint32_t>{1, 3, 64}), ids(s));
+  EXPECT_TRUE(s.contains(64));
+  EXPECT_FALSE(s.contains(63));
+
+  s.clear();
+  EXPECT_TRUE(s.empty());
+}
+
+TEST(SharerSet, overflow){
+  SharerSet s{0, SharerSet::INLINE_BITS - 1, SharerSet::INLINE_BITS, 1000};
+  EXPECT_EQ(4u, s.size());
+  EXPECT_EQ((vector<uint32_t>{0, SharerSet::INLINE_BITS - 1, SharerSet::INLINE_BITS, 1000}), ids(s));
+
+  SharerSet copy = s;
+  EXPECT_EQ(s, copy);
+  copy.erase(1000);
+  EXPECT_NE(s, copy);
+
+  //Trailing empty overflow words do not matter for equality
+  EXPECT_EQ(SharerSet({0, SharerSet::INLINE_BITS - 1, SharerSet::INLINE_BITS}), copy);
+
+  EXPECT_THROW(s.insert(SharerSet::MAX_ID + 1), out_of_range);
+}
+
+TEST(SharerSet, setOperations){
+  SharerSet a{1, 2, 3, 200}, b{2, 3, 4, 300};
+  EXPECT_EQ((SharerSet{1, 2, 3, 4, 200, 300}), a | b);
+  EXPECT_EQ((SharerSet{2, 3}), a & b);
+  EXPECT_EQ((SharerSet{1, 200}), a - b);
+  EXPECT_EQ((SharerSet{4, 300}), b - a);
+}
+
+TEST(SharerSet, matchesStdSet){
+  mt19937 rng(1);
+  for (int round = 0; round < 200; round++) {
+    set<uint32_t> ref;
+    SharerSet s;
+    for (int i = 0; i < 64; i++) {
+      uint32_t id = rng() % 512;
+      if (rng() % 3) { ref.insert(id); s.insert(id); }
+      else { ref.erase(id); s.erase(id); }
+    }
+    EXPECT_EQ(vector<uint32_t>(ref.begin(), ref.end()), ids(s));
+    EXPECT_EQ(ref.size(), s.size());
+  }
+}
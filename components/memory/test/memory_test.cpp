@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0 
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+
+#include <gtest/gtest.h>
+#include "memory.hpp"
+#include <fstream>
+#include <unistd.h>
+
+using namespace vpsim;
+using namespace sc_core;
+using namespace std;
+
+/*
+ * General comments
+ * The memory is not bound to anything: read() and write() are called
+ * directly, and their delay is compared with the per-word accumulation
+ * the memory used to perform.
+ */
+
+static const uint64_t MEM_BASE = 0x40000000;
+static const uint64_t MEM_SIZE = 0x20000;
+
+int sc_main(int argc, char* argv[])
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+//Former computation: one latency per word, at least one word
+static sc_time referenceDelay(const sc_time& latency, uint32_t width, size_t len){
+  sc_time delay = SC_ZERO_TIME;
+  size_t accessed = 0;
+  do {
+    accessed += width;
+    delay += latency;
+  } while (accessed < len);
+  return delay;
+}
+
+static payload_t makePayload(tlm::tlm_command cmd, uint64_t addr, unsigned char* ptr, unsigned int len){
+  payload_t p;
+  p.cmd = cmd;
+  p.addr = addr;
+  p.ptr = ptr;
+  p.len = len;
+  p.byte_enable_ptr = nullptr;
+  p.byte_enable_len = 0;
+  p.is_active = true;
+  p.dmi = false;
+  p.original_payload = nullptr;
+  return p;
+}
+
+TEST(memory, timing){
+  memory mem("testMemoryTiming", MEM_SIZE);
+  mem.setBaseAddress(MEM_BASE);
+  mem.setEnableLatency(true);
+  mem.ReadLatency = sc_time(3, SC_NS);
+  mem.WriteLatency = sc_time(7, SC_NS);
+
+  vector<unsigned char> buf(MEM_SIZE);
+  const uint32_t widths[] = { 1, 2, 4, 8, 16, 64 };
+  for (uint32_t width : widths) {
+    mem.setChannelWidth(width);
+    for (size_t len = 0; len <= 65536; len = (len < 256) ? len + 1 : len * 2) {
+      sc_time rd = SC_ZERO_TIME;
+      payload_t prd = makePayload(tlm::TLM_READ_COMMAND, MEM_BASE, buf.data(), len);
+      mem.read(prd, rd);
+      EXPECT_EQ(referenceDelay(mem.ReadLatency, width, len), rd) << "width " << width << " len " << len;
+
+      sc_time wr = SC_ZERO_TIME;
+      payload_t pwr = makePayload(tlm::TLM_WRITE_COMMAND, MEM_BASE, buf.data(), len);
+      mem.write(pwr, wr);
+      EXPECT_EQ(referenceDelay(mem.WriteLatency, width, len), wr) << "width " << width << " len " << len;
+    }
+  }
+}
+
+TEST(memory, noLatency){
+  memory mem("testMemoryNoLatency", MEM_SIZE);
+  mem.setBaseAddress(MEM_BASE);
+  mem.setEnableLatency(false);
+  mem.ReadLatency = sc_time(3, SC_NS);
+
+  unsigned char data[64];
+  sc_time delay = SC_ZERO_TIME;
+  payload_t p = makePayload(tlm::TLM_READ_COMMAND, MEM_BASE, data, sizeof(data));
+  mem.read(p, delay);
+  EXPECT_EQ(SC_ZERO_TIME, delay);
+}
+
+TEST(memory, data){
+  memory mem("testMemoryData", MEM_SIZE);
+  mem.setBaseAddress(MEM_BASE);
+
+  vector<unsigned char> in(4096), out(4096, 0);
+  for (size_t i = 0; i < in.size(); i++)
+    in[i] = (unsigned char)(i * 7 + 1);
+
+  sc_time delay = SC_ZERO_TIME;
+  payload_t pwr = makePayload(tlm::TLM_WRITE_COMMAND, MEM_BASE + 0x1003, in.data(), in.size());
+  EXPECT_EQ(tlm::TLM_OK_RESPONSE, mem.write(pwr, delay));
+  EXPECT_TRUE(pwr.dmi);
+  EXPECT_EQ(0, memcmp(mem.getLocalMem() + 0x1003, in.data(), in.size()));
+
+  payload_t prd = makePayload(tlm::TLM_READ_COMMAND, MEM_BASE + 0x1003, out.data(), out.size());
+  EXPECT_EQ(tlm::TLM_OK_RESPONSE, mem.read(prd, delay));
+  EXPECT_EQ(in, out);
+
+  //Timing-only accesses do not touch the data
+  payload_t pnull = makePayload(tlm::TLM_WRITE_COMMAND, MEM_BASE + 0x1003, nullptr, 16);
+  EXPECT_EQ(tlm::TLM_OK_RESPONSE, mem.write(pnull, delay));
+  EXPECT_EQ(in[0], mem.getLocalMem()[0x1003]);
+}
+
+static vector<unsigned char> readFile(const string& name){
+  ifstream in(name, ios::binary);
+  return vector<unsigned char>((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+}
+
+TEST(memory, image){
+  const uint64_t pageSize = sysconf(_SC_PAGESIZE);
+  const string imageName = "memory_test_image.bin";
+  const string savedName = "memory_test_saved.bin";
+
+  //Three whole pages and a partial one
+  vector<unsigned char> image(3 * pageSize + 100);
+  for (size_t i = 0; i < image.size(); i++)
+    image[i] = (unsigned char)(i * 13 + 5);
+  ofstream(imageName, ios::binary).write((const char*) image.data(), image.size());
+
+  memory mem("testMemoryImage", MEM_SIZE, false, true, true);
+  mem.setBaseAddress(MEM_BASE);
+
+  //Written before the load, right after the partial page: must survive it
+  const uint64_t memOff = pageSize;
+  mem.getLocalMem()[memOff + image.size() - pageSize + 1] = 0x77;
+
+  //Skip the first page of the file
+  mem.loadBlob(imageName, memOff, pageSize);
+  EXPECT_EQ(0, memcmp(mem.getLocalMem() + memOff, image.data() + pageSize, image.size() - pageSize));
+  EXPECT_EQ(0, mem.getLocalMem()[0]);
+  EXPECT_EQ(0x77, mem.getLocalMem()[memOff + image.size() - pageSize + 1]);
+
+  //Writes are private to the memory
+  mem.getLocalMem()[memOff] ^= 0xff;
+  EXPECT_EQ(image, readFile(imageName));
+
+  mem.saveImage(savedName);
+  vector<unsigned char> saved = readFile(savedName);
+  ASSERT_EQ(MEM_SIZE, saved.size());
+  EXPECT_EQ(0, memcmp(saved.data(), mem.getLocalMem(), MEM_SIZE));
+
+  unlink(imageName.c_str());
+  unlink(savedName.c_str());
+}
@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#include "AddressMap.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+namespace vpsim {
+
+const int32_t AddressMap::NO_TARGET;
+
+//Maps are created and destroyed during the elaboration only, by a single thread
+static vector<AddressMap*>& Instances() {
+	static vector<AddressMap*> instances;
+	return instances;
+}
+
+AddressMap::AddressMap(const string& name):
+	mName(name),
+	mCompiled(false)
+{
+	Instances().push_back(this);
+}
+
+AddressMap::~AddressMap() {
+	auto& instances = Instances();
+	instances.erase(std::remove(instances.begin(), instances.end(), this), instances.end());
+}
+
+void AddressMap::addRange(uint64_t base, uint64_t size, int32_t target, const string& name) {
+	if (!size) return;
+	mPending.push_back(Region { base, base + size - 1, target, 0, 0, 0, name });
+	mCompiled = false;
+}
+
+void AddressMap::addInterleavedRange(uint64_t base, uint64_t size, uint64_t granule,
+		const vector<int32_t>& targets, const string& name) {
+	if (!size) return;
+	if (!granule || targets.empty()) {
+		throw runtime_error(mName + ": an interleaved range needs a granule and at least one target");
+	}
+	mPending.push_back(Region { base, base + size - 1, targets[0], granule,
+		(uint32_t)mInterleaved.size(), (uint32_t)targets.size(), name });
+	mInterleaved.insert(mInterleaved.end(), targets.begin(), targets.end());
+	mCompiled = false;
+}
+
+void AddressMap::clear() {
+	mPending.clear();
+	mRegions.clear();
+	mBases.clear();
+	mInterleaved.clear();
+	mCompiled = false;
+}
+
+string AddressMap::describe(const Region& r) const {
+	stringstream ss;
+	ss << "0x" << hex << r.base_addr << "-0x" << r.end_addr << dec;
+	if (r.granule) ss << " (interleaved over " << r.count << " targets)";
+	else ss << " of target " << r.target;
+	if (!r.name.empty()) ss << " (" << r.name << ")";
+	return ss.str();
+}
+
+void AddressMap::compile() {
+	mRegions = mPending;
+	std::stable_sort(mRegions.begin(), mRegions.end(),
+			[](const Region& a, const Region& b) { return a.base_addr < b.base_addr; });
+
+	size_t kept = 0;
+	for (size_t i = 0; i < mRegions.size(); i++) {
+		const Region& r = mRegions[i];
+		if (r.end_addr < r.base_addr) {
+			stringstream ss;
+			ss << mName << ": the range at 0x" << hex << r.base_addr << " wraps around the address space";
+			throw runtime_error(ss.str());
+		}
+		if (kept) {
+			const Region& prev = mRegions[kept - 1];
+			//The same target mapped twice is harmless
+			if (prev.base_addr == r.base_addr && prev.end_addr == r.end_addr
+					&& !prev.granule && !r.granule && prev.target == r.target) continue;
+			if (r.base_addr <= prev.end_addr) {
+				throw runtime_error(mName + ": the range " + describe(r) + " overlaps the range " + describe(prev));
+			}
+		}
+		mRegions[kept++] = r;
+	}
+	mRegions.resize(kept);
+
+	mBases.resize(kept);
+	for (size_t i = 0; i < kept; i++) mBases[i] = mRegions[i].base_addr;
+	mCompiled = true;
+}
+
+int32_t AddressMap::getWindow(uint64_t addr, uint64_t& base, uint64_t& end) const {
+	size_t next = std::upper_bound(mBases.begin(), mBases.end(), addr) - mBases.begin();
+
+	//In a region, or in its granule if it is interleaved
+	if (next && addr <= mRegions[next - 1].end_addr) {
+		const Region& r = mRegions[next - 1];
+		base = r.base_addr;
+		end = r.end_addr;
+		if (r.granule) {
+			base = r.base_addr + (addr - r.base_addr) / r.granule * r.granule;
+			if (end - base >= r.granule) end = base + r.granule - 1;
+		}
+		return next - 1;
+	}
+
+	//Otherwise in the hole between the regions around addr
+	base = next ? mRegions[next - 1].end_addr + 1 : 0;
+	end = next < mRegions.size() ? mRegions[next].base_addr - 1 : UINT64_MAX;
+	return -1;
+}
+
+void AddressMap::dump(ostream& os) const {
+	os << mName << endl;
+	for (const Region& r: mRegions) {
+		os << "  0x" << hex << setw(16) << setfill('0') << r.base_addr
+		   << " - 0x" << setw(16) << r.end_addr << setfill(' ') << dec;
+		if (r.granule) {
+			os << "  interleaved by 0x" << hex << r.granule << dec << " over";
+			for (uint32_t i = 0; i < r.count; i++) os << " " << mInterleaved[r.first + i];
+		} else {
+			os << "  target " << r.target;
+		}
+		if (!r.name.empty()) os << "  " << r.name;
+		os << endl;
+	}
+}
+
+void AddressMap::CompileAll() {
+	for (AddressMap* map: Instances()) {
+		if (!map->isCompiled()) map->compile();
+	}
+}
+
+void AddressMap::DumpAll(ostream& os) {
+	for (AddressMap* map: Instances()) {
+		if (!map->isCompiled()) map->compile();
+		if (map->getRegionCount()) map->dump(os);
+	}
+}
+
+}
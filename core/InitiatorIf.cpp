@@ -45,6 +45,10 @@ InitiatorIf::InitiatorIf ( string Name, unsigned int Quantum, bool Active, uint3
 	mTlmActive ( Active ),
 	mNbPort (NbPort)
 {
+	mCachedDmiRegions.resize ( getNbPort() );
+	mLastDmiRegion.resize ( getNbPort(), NULL );
+	mDmiAccessCount = 0;
+
 	//Create table of port
 	mInitiatorSocket = new tlm_utils::simple_initiator_socket<InitiatorIf> * [getNbPort()];
 
@@ -58,6 +62,13 @@ InitiatorIf::InitiatorIf ( string Name, unsigned int Quantum, bool Active, uint3
 
 		//register the socket
 		getInitiatorSocket()[i]->register_invalidate_direct_mem_ptr ( this, &InitiatorIf::invalidate_direct_mem_ptr );
+
+		//The payload owns its extension and frees it on destruction
+		mPayloads.push_back ( new tlm::tlm_generic_payload );
+		mCpuIdExtensions.push_back ( new GicCpuExtension );
+		mCpuIdExtensions.back()->cpu_id = 0;
+		mPayloads.back()->set_extension<GicCpuExtension> ( mCpuIdExtensions.back() );
+		mPayloadBusy.push_back ( false );
 	}
 }
 
@@ -66,6 +77,7 @@ InitiatorIf::~InitiatorIf ( )
 {
 	for ( size_t i=0; i<getNbPort(); i++ ) delete mInitiatorSocket [i];
 	delete [] mInitiatorSocket;
+	for ( size_t i=0; i<getNbPort(); i++ ) delete mPayloads [i];
 }
 
 //-----------------------------------------------------------------------------
@@ -147,50 +159,78 @@ bool InitiatorIf::getTlmActive() { return (mTlmActive); }
 
 bool InitiatorIf::getDmiEnable() { return (mDmiEnable); }
 
+uint64_t InitiatorIf::getDmiAccessCount() { return (mDmiAccessCount); }
+
+//-----------------------------------------------------------------------------
+//DMI regions
+tlm::tlm_dmi * InitiatorIf::findDmiRegion ( uint32_t port, uint64_t addr, uint32_t length ) {
+	uint64_t end = addr + length - 1;
+
+	tlm::tlm_dmi * last = mLastDmiRegion [port];
+	if ( last && addr >= last->get_start_address() && end <= last->get_end_address() ) {
+		return last;
+	}
+
+	std::map < sc_dt::uint64, tlm::tlm_dmi > & regions = mCachedDmiRegions [port];
+	std::map < sc_dt::uint64, tlm::tlm_dmi >::iterator it = regions.upper_bound ( addr );
+	if ( it == regions.begin() ) return NULL;
+	--it;
+	if ( end > it->second.get_end_address() ) return NULL;
+
+	mLastDmiRegion [port] = &it->second;
+	return &it->second;
+}
+
+void InitiatorIf::requestDmiRegion ( uint32_t port, uint64_t addr, uint32_t length, ACCESS_TYPE rw ) {
+	tlm::tlm_dmi dmi_data;
+	tlm::tlm_generic_payload & trans = *mPayloads [port];
+
+	trans.set_address ( addr );
+	trans.set_data_length ( length );
+	if ( rw == READ ) trans.set_read ( ); else trans.set_write ( );
+
+	if ( !(*getInitiatorSocket() [port])->get_direct_mem_ptr ( trans, dmi_data ) ) return;
+	if ( dmi_data.is_none_allowed() ) return;
+	if ( addr < dmi_data.get_start_address() || addr + length - 1 > dmi_data.get_end_address() ) return;
+
+	//Granted regions are kept disjoint, a new grant supersedes the ones it overlaps
+	std::map < sc_dt::uint64, tlm::tlm_dmi > & regions = mCachedDmiRegions [port];
+	std::map < sc_dt::uint64, tlm::tlm_dmi >::iterator it = regions.upper_bound ( dmi_data.get_start_address() );
+	if ( it != regions.begin() && std::prev ( it )->second.get_end_address() >= dmi_data.get_start_address() ) --it;
+	while ( it != regions.end() && it->first <= dmi_data.get_end_address() ) it = regions.erase ( it );
+
+	regions.emplace ( dmi_data.get_start_address(), dmi_data );
+	mLastDmiRegion [port] = NULL;
+
+	LOG_DEBUG(dbg1) <<getName()<<": DMI granted on port "<<port<<" from 0x"<<hex<<dmi_data.get_start_address()
+			<<" to 0x"<<dmi_data.get_end_address()<<dec<<endl;
+}
+
 //-----------------------------------------------------------------------------
 //target_mem_access
 tlm::tlm_response_status InitiatorIf::target_mem_access ( uint32_t port, uint64_t addr,
 		uint32_t length, unsigned char * data, ACCESS_TYPE rw, sc_time &delay, uint32_t id ) {
-	//static prevents for constructing/destructing the payload every time (very costly)
-
-	//Reset is only a partial reset
-	//One must take care of explicitely initializing every single used field of the payload
-	//Otherwise, previous transactions values could interfere
-	trans.reset();
-
-	//dmi_data can be safely reused as all fields are explicitely set bellow;
-//	static tlm::tlm_dmi dmi_data;
-
-	tlm::tlm_response_status status(tlm::TLM_INCOMPLETE_RESPONSE);
-
-//	if ( !getForceLt() && getTlmActive() )
-//	{
-//		//Test if this access is in a region already registered as DMI
-//		bool found = false;
-//		std::vector < tlm::tlm_dmi >::iterator it;
-//		for ( it=mCachedDmiRegions.begin() ; it!=mCachedDmiRegions.end() ; it++ ) {
-//			if (( addr >= it->get_start_address() ) && ( addr < it->get_end_address() ))
-//			{
-//				dmi_data.set_dmi_ptr ( it->get_dmi_ptr() );
-//				dmi_data.set_start_address ( it->get_start_address() );
-//				dmi_data.set_end_address ( it->get_end_address() );
-//				dmi_data.set_granted_access ( it->get_granted_access() );
-//				dmi_data.set_read_latency( it->get_read_latency() );
-//				dmi_data.set_write_latency ( it->get_write_latency() );
-//				found = true;
-//			}
-//		}
-//		if(!found)
-//		{
-//			//Test if DMI is enabled for future communications at this address
-//			trans.set_address ( addr );
-//			trans.set_data_length ( length );
-//			setDmiEnable( (*getInitiatorSocket() [port])->get_direct_mem_ptr ( trans, dmi_data ));
-//			tlm_error_checking ( trans.get_response_status() );
-//			mCachedDmiRegions.push_back ( dmi_data );
-//		}
-//	}
+	//DMI fast path: the access is served from a region already granted by the target
+	bool use_dmi = !getForceLt() && getTlmActive() && data != NULL;
+	tlm::tlm_dmi * dmi = use_dmi ? findDmiRegion ( port, addr, length ) : NULL;
+
+	if ( dmi ) {
+		unsigned char * dmi_ptr = dmi->get_dmi_ptr() + ( addr - dmi->get_start_address() );
+		if ( rw == READ && dmi->is_read_allowed() ) {
+			memcpy ( data, dmi_ptr, length );
+			delay += dmi->get_read_latency();
+			mDmiAccessCount++;
+			return tlm::TLM_OK_RESPONSE;
+		}
+		if ( rw == WRITE && dmi->is_write_allowed() ) {
+			memcpy ( dmi_ptr, data, length );
+			delay += dmi->get_write_latency();
+			mDmiAccessCount++;
+			return tlm::TLM_OK_RESPONSE;
+		}
+	}
 
+	tlm::tlm_response_status status;
 
 	//------------------------------------------------------------------------------
 	// DEBUG
@@ -200,12 +240,6 @@ tlm::tlm_response_status InitiatorIf::target_mem_access ( uint32_t port, uint64_
 	if ( rw == READ) {LOG_DEBUG(dbg2) <<getName()<<": command = READ" <<endl;}
 	else {LOG_DEBUG(dbg2) <<getName()<<": command = WRITE";}
 
-	//LT or DMI
-//	if ( ( dmi_data.is_read_allowed() && !getForceLt() ) ||
-//			 ( dmi_data.is_write_allowed() && !getForceLt() ) ){
-//		LOG_DEBUG(dbg2)  << " (DMI)"<<endl; else LOG_DEBUG(dbg2) <<" (LT)"<<endl;
-//	}
-
 	//Others
 	LOG_DEBUG(dbg2) <<getName()<<": address = 0x"<<hex<<(uint64_t)addr<<dec<<endl;
 	LOG_DEBUG(dbg2) <<getName()<<": burst = "<<dec<<(uint32_t)length<<dec<<endl;
@@ -214,99 +248,107 @@ tlm::tlm_response_status InitiatorIf::target_mem_access ( uint32_t port, uint64_
 	//Active or not?
 	LOG_DEBUG(dbg2) <<getName()<<": is_active = " <<(getTlmActive() ? "true":"false") << endl;
 
-
 	//------------------------------------------------------------------------------
-	//READ access
-	if ( rw == READ )
-	{
-		//Test if DMI access
-//		if ( dmi_data.is_read_allowed() && !getForceLt() )
-//		{
-//			if (getTlmActive()) {
-//				//Do DMI transaction
-//				unsigned char* dmi_ptr = dmi_data.get_dmi_ptr();
-//				memcpy ( data, dmi_ptr + addr, length );
-//				delay += dmi_data.get_read_latency();
-//				status = tlm::TLM_OK_RESPONSE;
-//			}
-//			else {
-//				//Nothing to do (the DMI communication has already been done)
-//			}
-//		}
-
-		//Loosely-timed communication
-//		else
-//		{
-
-			//cout << endl << "InitiatorIf.cpp: target_mem_access: else is_read_allowed1: dmi_data.is_read_allowed = " << dmi_data.is_read_allowed() << " name = " << getName() << endl;
-
-			//Prepare payload
-			trans.set_address ( addr );
-			trans.set_read ( );
-			trans.set_data_length ( length );
-			trans.set_data_ptr ( (unsigned char*)(data) );
-			trans.set_byte_enable_ptr ( NULL );
-			trans.set_byte_enable_length ( 0 );
-			if (getTlmActive() || getForceLt()) trans.set_gp_option ( tlm::TLM_FULL_PAYLOAD ); else trans.set_gp_option ( tlm::TLM_MIN_PAYLOAD );
-			trans.set_response_status ( tlm::TLM_INCOMPLETE_RESPONSE );
-
-			GicCpuExtension cpu_id_ext;
-			cpu_id_ext.cpu_id=id;
-			trans.set_extension<GicCpuExtension>(&cpu_id_ext);
-			//cout << endl << "InitiatorIf.cpp: target_mem_access: else is_read_allowed2: dmi_data.is_read_allowed = " << dmi_data.is_read_allowed() << " name = " << getName() << endl;
-
-			//Execute blocking transaction
-			(*getInitiatorSocket() [port])->b_transport ( trans, delay );
-			trans.clear_extension(&cpu_id_ext);
-			status = trans.get_response_status ( );
-//		}
+	//Loosely-timed access
+	if ( mPayloadBusy [port] ) {
+		//Nested access on the same port (e.g. issued by a target while serving ours):
+		//the port payload is in flight and cannot be reused
+		tlm::tlm_generic_payload payload;
+		GicCpuExtension cpu_id_ext;
+		cpu_id_ext.cpu_id = id;
+		payload.set_extension<GicCpuExtension> ( &cpu_id_ext );
+		status = transport ( port, payload, cpu_id_ext, addr, length, data, rw, delay, id );
+		payload.clear_extension ( &cpu_id_ext );
+		return status;
 	}
-	//WRITE access
-	else
-	{
-		//Test if DMI access
-//		if ( dmi_data.is_write_allowed() && !getForceLt() )
-//		{
-//			if (getTlmActive()) {
-//				//Do DMI transaction
-//				unsigned char* dmi_ptr = dmi_data.get_dmi_ptr();
-//				memcpy ( dmi_ptr + addr, data, length );
-//				delay += dmi_data.get_write_latency();
-//				status = tlm::TLM_OK_RESPONSE;
-//			}
-//			else {
-//				//Nothing to do (the DMI communication has already been done)
-//			}
-//		}
-		//Loosely-timed communication
-//		else
-//		{
-			//cout << endl << "InitiatorIf.cpp: target_mem_access: else is_write_allowed: dmi_data.is_write_allowed = " << dmi_data.is_write_allowed() << " name = " << getName() << endl;
-
-			//Prepare payload
-			trans.set_address ( addr );
-			trans.set_write ( );
-			trans.set_data_length( length );
-			trans.set_data_ptr ( (unsigned char*)(data) );
-			trans.set_byte_enable_ptr ( NULL );
-			trans.set_byte_enable_length ( 0 );
-			if (getTlmActive() || getForceLt()) trans.set_gp_option ( tlm::TLM_FULL_PAYLOAD ); else trans.set_gp_option ( tlm::TLM_MIN_PAYLOAD );
-			trans.set_response_status ( tlm::TLM_INCOMPLETE_RESPONSE );
-			GicCpuExtension cpu_id_ext;
-			cpu_id_ext.cpu_id=id;
-			trans.set_extension<GicCpuExtension>(&cpu_id_ext);
-
-			//Execute blocking transaction
-			(*getInitiatorSocket() [port])->b_transport(trans, delay);
-			trans.clear_extension(&cpu_id_ext);
-			status = trans.get_response_status ();
-//		}
+
+	mPayloadBusy [port] = true;
+	status = transport ( port, *mPayloads [port], *mCpuIdExtensions [port], addr, length, data, rw, delay, id );
+	mPayloadBusy [port] = false;
+
+	//Lazily ask for a DMI region when the target hints that one is available
+	if ( use_dmi && !dmi && status == tlm::TLM_OK_RESPONSE && mPayloads [port]->is_dmi_allowed() ) {
+		requestDmiRegion ( port, addr, length, rw );
 	}
 
 	//End
 	return status;
 }
 
+tlm::tlm_response_status InitiatorIf::transport ( uint32_t port, tlm::tlm_generic_payload & payload, GicCpuExtension & cpu_id_ext,
+		uint64_t addr, uint32_t length, unsigned char * data, ACCESS_TYPE rw, sc_time &delay, uint32_t id ) {
+	//The payload is not reset: every field the targets may use is explicitly set here
+	//so that previous transactions values cannot interfere
+	if ( rw == READ ) payload.set_read ( ); else payload.set_write ( );
+	payload.set_address ( addr );
+	payload.set_data_length ( length );
+	payload.set_streaming_width ( length );
+	payload.set_data_ptr ( data );
+	payload.set_byte_enable_ptr ( NULL );
+	payload.set_byte_enable_length ( 0 );
+	if (getTlmActive() || getForceLt()) payload.set_gp_option ( tlm::TLM_FULL_PAYLOAD ); else payload.set_gp_option ( tlm::TLM_MIN_PAYLOAD );
+	payload.set_dmi_allowed ( false );
+	payload.set_response_status ( tlm::TLM_INCOMPLETE_RESPONSE );
+
+	//The extension stays attached to the payload, it is only written when the CPU changes
+	if ( cpu_id_ext.cpu_id != id ) cpu_id_ext.cpu_id = id;
+
+	//Execute blocking transaction
+	(*getInitiatorSocket() [port])->b_transport ( payload, delay );
+	return payload.get_response_status ( );
+}
+
+tlm::tlm_response_status InitiatorIf::target_mem_access_vectored ( uint32_t port,
+		const std::vector < VectoredSegment > & segments, ACCESS_TYPE rw, sc_time &delay, uint32_t id ) {
+	bool use_dmi = !getForceLt() && getTlmActive();
+	VectoredExtension vec;
+	vec.Segments.reserve ( segments.size() );
+
+	//DMI fast path, segment by segment
+	for ( const VectoredSegment & seg : segments ) {
+		tlm::tlm_dmi * dmi = use_dmi && seg.ptr != NULL ? findDmiRegion ( port, seg.addr, seg.len ) : NULL;
+		if ( dmi && rw == READ && dmi->is_read_allowed() ) {
+			memcpy ( seg.ptr, dmi->get_dmi_ptr() + ( seg.addr - dmi->get_start_address() ), seg.len );
+			delay += dmi->get_read_latency();
+			mDmiAccessCount++;
+		} else if ( dmi && rw == WRITE && dmi->is_write_allowed() ) {
+			memcpy ( dmi->get_dmi_ptr() + ( seg.addr - dmi->get_start_address() ), seg.ptr, seg.len );
+			delay += dmi->get_write_latency();
+			mDmiAccessCount++;
+		} else {
+			vec.Segments.push_back ( seg );
+		}
+	}
+	if ( vec.Segments.empty() ) return tlm::TLM_OK_RESPONSE;
+
+	LOG_DEBUG(dbg2) <<getName()<<": vectored "<<( rw == READ ? "READ" : "WRITE" )<<" of "<<vec.Segments.size()<<" segments"<<endl;
+
+	//Remaining segments travel in one transaction, the extensions live on the stack
+	tlm::tlm_generic_payload payload;
+	GicCpuExtension cpu_id_ext;
+	cpu_id_ext.cpu_id = id;
+	if ( rw == READ ) payload.set_read ( ); else payload.set_write ( );
+	payload.set_byte_enable_ptr ( NULL );
+	payload.set_byte_enable_length ( 0 );
+	if (getTlmActive() || getForceLt()) payload.set_gp_option ( tlm::TLM_FULL_PAYLOAD ); else payload.set_gp_option ( tlm::TLM_MIN_PAYLOAD );
+	payload.set_dmi_allowed ( false );
+	payload.set_extension<GicCpuExtension> ( &cpu_id_ext );
+	payload.set_extension<VectoredExtension> ( &vec );
+
+	tlm::tlm_response_status status = vectored_b_transport (
+			[this, port] ( tlm::tlm_generic_payload & trans, sc_time & d ) { (*getInitiatorSocket() [port])->b_transport ( trans, d ); },
+			payload, vec, delay );
+
+	//Lazily ask for a DMI region when the target hints that one is available
+	if ( use_dmi && !mPayloadBusy [port] && status == tlm::TLM_OK_RESPONSE && payload.is_dmi_allowed() ) {
+		requestDmiRegion ( port, vec.Segments [0].addr, vec.Segments [0].len, rw );
+	}
+
+	payload.clear_extension ( &vec );
+	payload.clear_extension ( &cpu_id_ext );
+	return status;
+}
+
 uint32_t InitiatorIf::target_dbg_access ( uint32_t port,
 		uint64_t addr, uint32_t length, unsigned char * data, ACCESS_TYPE rw ) {
 	if ( !getTlmActive() ) {
@@ -316,9 +358,8 @@ uint32_t InitiatorIf::target_dbg_access ( uint32_t port,
 
 	else if (getDmiEnable())
 	{
-		//Local variables
-		static tlm::tlm_generic_payload trans;
-		trans.reset();
+		//Local payload: debug accesses may be issued while another one is in flight
+		tlm::tlm_generic_payload trans;
 
 		//Prepare payload
 		trans.set_address ( addr );
@@ -342,8 +383,15 @@ tlm::tlm_sync_enum InitiatorIf::nb_transport_bw ( tlm::tlm_generic_payload& tran
 }
 
 //Function for backward DMI
+//Only the cached regions intersecting [start, end] are dropped
 void InitiatorIf::invalidate_direct_mem_ptr ( sc_dt::uint64 start, sc_dt::uint64 end ) {
-	setDmiEnable(false);
+	for ( size_t i=0; i<getNbPort(); i++ ) {
+		std::map < sc_dt::uint64, tlm::tlm_dmi > & regions = mCachedDmiRegions [i];
+		std::map < sc_dt::uint64, tlm::tlm_dmi >::iterator it = regions.upper_bound ( start );
+		if ( it != regions.begin() && std::prev ( it )->second.get_end_address() >= start ) --it;
+		while ( it != regions.end() && it->first <= end ) it = regions.erase ( it );
+		mLastDmiRegion [i] = NULL;
+	}
 }
 
 }
@@ -0,0 +1,257 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#include "ParallelDomain.hpp"
+
+namespace vpsim {
+
+ParallelDomain::ParallelDomain(sc_module_name name, const sc_time& quantum, unsigned hostThreads):
+	sc_module(name),
+	mQuantum(quantum),
+	mHostThreads(hostThreads),
+	mOrdered(true),
+	mStarted(false),
+	mStopping(false),
+	mSharedHeld(false),
+	mEpoch(0),
+	mQuantumStart(SC_ZERO_TIME),
+	mArrived(0),
+	mFinished(0),
+	mFreeSlots(0),
+	mWaiting(0),
+	mQuantumCount(0),
+	mSharedAccessCount(0)
+{
+	if (quantum == SC_ZERO_TIME) {
+		throw runtime_error(string(this->name()) + ": the quantum of a parallel domain cannot be zero");
+	}
+	SC_THREAD(schedule);
+}
+
+ParallelDomain::~ParallelDomain(){
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStopping = true;
+	}
+	mClusterCv.notify_all();
+	joinClusters();
+}
+
+unsigned ParallelDomain::addCluster(const ClusterBody& body){
+	if (mStarted) {
+		throw runtime_error(string(name()) + ": clusters must be added before the simulation starts");
+	}
+	mClusters.emplace_back();
+	mClusters.back().Body = body;
+	return mClusters.size() - 1;
+}
+
+void ParallelDomain::joinClusters(){
+	for (Cluster& cluster : mClusters) {
+		if (cluster.Thread.joinable()) cluster.Thread.join();
+	}
+}
+
+//!The kernel thread blocks in this process while the clusters run a quantum, then lets
+//!the rest of the platform catch up with the end of the quantum
+void ParallelDomain::schedule(){
+	const unsigned count = mClusters.size();
+	if (count == 0) return;
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStarted = true;
+		mFreeSlots = mHostThreads ? mHostThreads : count;
+	}
+	for (unsigned id = 0; id < count; id++) {
+		mClusters[id].Thread = std::thread(&ParallelDomain::clusterMain, this, id);
+	}
+
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mQuantumStart = sc_time_stamp();
+			mArrived = 0;
+			for (Cluster& cluster : mClusters) {
+				if (cluster.State == CLUSTER_FINISHED) continue;
+				cluster.State = CLUSTER_RUNNING;
+				cluster.Time = mQuantumStart.value();
+			}
+			mEpoch++;
+			mClusterCv.notify_all();
+
+			mKernelCv.wait(lock, [this, count]{ return mArrived + mFinished == count; });
+			if (mError) {
+				mStopping = true;
+				mClusterCv.notify_all();
+				lock.unlock();
+				joinClusters();
+				std::rethrow_exception(mError);
+			}
+			if (mFinished == count) break;
+			mQuantumCount++;
+		}
+		wait(mQuantum);
+	}
+	joinClusters();
+}
+
+void ParallelDomain::clusterMain(unsigned id){
+	try {
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mClusterCv.wait(lock, [this]{ return mEpoch > 0 || mStopping; });
+			if (mStopping) return;
+			acquireSlot(lock);
+		}
+		mClusters[id].Body();
+	} catch (Stopped&) {
+		return;
+	} catch (...) {
+		std::lock_guard<std::mutex> lock(mMutex);
+		if (!mError) mError = std::current_exception();
+	}
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	releaseSlot();
+	mClusters[id].State = CLUSTER_FINISHED;
+	mFinished++;
+	mClusterCv.notify_all();
+	mKernelCv.notify_one();
+}
+
+void ParallelDomain::acquireSlot(std::unique_lock<std::mutex>& lock){
+	if (!waitSlot(lock)) throw Stopped();
+}
+
+bool ParallelDomain::waitSlot(std::unique_lock<std::mutex>& lock){
+	mClusterCv.wait(lock, [this]{ return mFreeSlots > 0 || mStopping; });
+	if (mStopping) return false;
+	mFreeSlots--;
+	return true;
+}
+
+void ParallelDomain::releaseSlot(){
+	mFreeSlots++;
+	mClusterCv.notify_all();
+}
+
+void ParallelDomain::barrier(unsigned cluster){
+	std::unique_lock<std::mutex> lock(mMutex);
+	const uint64_t epoch = mEpoch;
+
+	releaseSlot();
+	mClusters[cluster].State = CLUSTER_AT_BARRIER;
+	mArrived++;
+	mKernelCv.notify_one();
+
+	mClusterCv.wait(lock, [this, epoch]{ return mEpoch != epoch || mStopping; });
+	if (mStopping) throw Stopped();
+	acquireSlot(lock);
+}
+
+void ParallelDomain::advance(unsigned cluster, const sc_time& t){
+	if (!mOrdered) return;
+
+	mClusters[cluster].Time = t.value();
+	if (mWaiting > 0) {
+		//A waiting cluster may have been waiting for this one to go past its time
+		std::lock_guard<std::mutex> lock(mMutex);
+		mClusterCv.notify_all();
+	}
+}
+
+//!Every cluster publishes a lower bound of the time of its next access (its current time,
+//!as time only goes forward), so an access is granted once no cluster may still access
+//!the shared components before it: the accesses of a quantum are then totally ordered
+//!by (time, cluster), independently of the host scheduling
+bool ParallelDomain::mayAccess(unsigned id){
+	const uint64_t time = mClusters[id].Time;
+	for (unsigned other = 0; other < mClusters.size(); other++) {
+		if (other == id) continue;
+
+		const Cluster& cluster = mClusters[other];
+		switch (cluster.State) {
+		case CLUSTER_AT_BARRIER:
+		case CLUSTER_FINISHED:
+			break;
+		case CLUSTER_HOLDING:
+			return false;
+		default: {
+			const uint64_t otherTime = cluster.Time;
+			if (otherTime < time || (otherTime == time && other < id)) return false;
+		}
+		}
+	}
+	return true;
+}
+
+void ParallelDomain::lockShared(unsigned cluster, const sc_time& t){
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	if (!mOrdered) {
+		mClusterCv.wait(lock, [this]{ return !mSharedHeld || mStopping; });
+		if (mStopping) throw Stopped();
+		mSharedHeld = true;
+		mSharedAccessCount++;
+		return;
+	}
+
+	//The host thread is given to another cluster while waiting for the turn of this one
+	releaseSlot();
+	mClusters[cluster].State = CLUSTER_WAITING;
+	mClusters[cluster].Time = t.value();
+	mWaiting++;
+	mClusterCv.wait(lock, [this, cluster]{ return mayAccess(cluster) || mStopping; });
+	mWaiting--;
+	if (mStopping) throw Stopped();
+
+	mClusters[cluster].State = CLUSTER_HOLDING;
+	mSharedAccessCount++;
+}
+
+void ParallelDomain::unlockShared(unsigned cluster){
+	if (!unlockSharedNoThrow(cluster)) throw Stopped();
+}
+
+bool ParallelDomain::unlockSharedNoThrow(unsigned cluster) noexcept {
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	if (!mOrdered) {
+		mSharedHeld = false;
+		mClusterCv.notify_all();
+		return true;
+	}
+
+	mClusters[cluster].State = CLUSTER_RUNNING;
+	mClusterCv.notify_all();
+	return waitSlot(lock);
+}
+
+void ParallelDomain::setOrdered(bool ordered){
+	if (mStarted) {
+		throw runtime_error(string(name()) + ": the access ordering cannot change once the simulation started");
+	}
+	mOrdered = ordered;
+}
+
+bool ParallelDomain::getOrdered(){ return mOrdered; }
+sc_time ParallelDomain::getQuantum(){ return mQuantum; }
+unsigned ParallelDomain::getClusterCount(){ return mClusters.size(); }
+uint64_t ParallelDomain::getQuantumCount(){ return mQuantumCount; }
+uint64_t ParallelDomain::getSharedAccessCount(){ return mSharedAccessCount; }
+
+}//end namespace vpsim
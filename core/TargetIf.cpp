@@ -15,8 +15,13 @@
 */
 
 #include "TargetIf.hpp"
+#include "VectoredTransport.hpp"
 #include "log.hpp"
 #include "string.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 namespace vpsim {
 
@@ -33,11 +38,13 @@ TargetIf<TYPE>::TargetIf ( string Name, uint64_t Size ) :
 	mReadCallback(NULL),
 	mWriteCallback(NULL),
 	mLocalMem ( NULL ),
+	mSparseMem ( false ),
+	mLocalMemBytes ( 0 ),
 	mReadCount ( 0 ),
 	mWriteCount ( 0 ),
 	mTargetSocket ( "mTargetSocket" )
 {
-	mLocalMem = new TYPE [getSize()];
+	AllocateLocalMem ();
 
 	//Register functions for TLM 2.0 communications
 	mTargetSocket.register_get_direct_mem_ptr ( this, &TargetIf::get_direct_mem_ptr );
@@ -46,7 +53,7 @@ TargetIf<TYPE>::TargetIf ( string Name, uint64_t Size ) :
 }
 
 template < typename TYPE >
-TargetIf<TYPE>::TargetIf ( string Name, uint64_t Size, bool ByteEnable, bool DmiEnable ) :
+TargetIf<TYPE>::TargetIf ( string Name, uint64_t Size, bool ByteEnable, bool DmiEnable, bool SparseMem ) :
 	LatencyIf (),
 	AddrSpace (Size),
 	Logger(Name),
@@ -56,11 +63,13 @@ TargetIf<TYPE>::TargetIf ( string Name, uint64_t Size, bool ByteEnable, bool Dmi
 	mReadCallback(NULL),
 	mWriteCallback(NULL),
 	mLocalMem ( NULL ),
+	mSparseMem ( SparseMem ),
+	mLocalMemBytes ( 0 ),
 	mReadCount ( 0 ),
 	mWriteCount ( 0 ),
 	mTargetSocket ( "mTargetSocket" )
 {
-	mLocalMem = new TYPE [getSize()];
+	AllocateLocalMem ();
 
 	//Register functions for TLM 2.0 communications
 	mTargetSocket.register_get_direct_mem_ptr ( this, &TargetIf::get_direct_mem_ptr );
@@ -88,6 +97,44 @@ string TargetIf<TYPE>::getName ( ) { return ( mName ); }
 template < typename TYPE >
 TYPE * TargetIf<TYPE>::getLocalMem ( ) { return mLocalMem; }
 
+template < typename TYPE >
+bool TargetIf<TYPE>::getSparseMem ( ) { return mSparseMem; }
+
+template < typename TYPE >
+uint64_t TargetIf<TYPE>::getResidentBytes ( ) {
+	const uint64_t pageSize = sysconf(_SC_PAGESIZE);
+	const uint64_t start = (uint64_t) mLocalMem & ~(pageSize - 1);
+	const uint64_t end = (uint64_t) mLocalMem + mLocalMemBytes;
+
+	//The page map tells the pages owned by the memory apart from the page cache pages of a mapped
+	//image, which mincore would count as resident although they are only shared with the file
+	const uint64_t PRESENT = 1ULL << 63;
+	const uint64_t FILE_OR_SHARED = 1ULL << 61;
+	int fd = open("/proc/self/pagemap", O_RDONLY);
+	if (fd < 0) {
+		return 0;
+	}
+
+	//One 64 bit entry per page, read by chunks to bound the buffer size
+	const uint64_t chunkPages = 1 << 16;
+	vector<uint64_t> entries(chunkPages);
+	uint64_t resident = 0;
+	for (uint64_t chunk = start; chunk < end; chunk += chunkPages * pageSize) {
+		uint64_t n = min((end - chunk + pageSize - 1) / pageSize, chunkPages);
+		ssize_t bytes = n * sizeof(uint64_t);
+		if (pread(fd, entries.data(), bytes, chunk / pageSize * sizeof(uint64_t)) != bytes) {
+			resident = 0;
+			break;
+		}
+		for (uint64_t i = 0; i < n; i++) {
+			resident += (entries[i] & (PRESENT | FILE_OR_SHARED)) == PRESENT;
+		}
+	}
+	close(fd);
+
+	return min(resident * pageSize, mLocalMemBytes);
+}
+
 template < typename TYPE >
 tlm_utils::simple_target_socket<TargetIf<TYPE>> * TargetIf<TYPE>::getTargetSocket() {
 	return (&mTargetSocket);
@@ -112,6 +159,65 @@ void TargetIf<TYPE>::RegisterMemorySpace ( TYPE * mem ) {
     }
 }
 
+template < typename TYPE >
+void TargetIf<TYPE>::AllocateLocalMem ( ) {
+	mLocalMemBytes = getSize() * sizeof(TYPE);
+
+	if (!mSparseMem) {
+		mLocalMem = new TYPE [getSize()];
+		return;
+	}
+
+	//Only address space is reserved: the kernel backs (and zeroes) each page on first touch
+	void* mem = mmap(NULL, mLocalMemBytes, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (mem == MAP_FAILED) {
+		LOG_ERROR <<getName()<< ": unable to reserve " << mLocalMemBytes << " bytes of sparse memory." << endl;
+		throw runtime_error(getName() + ": unable to reserve sparse memory.");
+	}
+	mLocalMem = (TYPE*) mem;
+}
+
+template < typename TYPE >
+uint64_t TargetIf<TYPE>::MapLocalMemFile ( const string& FileName, uint64_t FileOffset, uint64_t MemOffset ) {
+	const uint64_t pageSize = sysconf(_SC_PAGESIZE);
+	const uint64_t memAddr = (uint64_t) mLocalMem + MemOffset;
+
+	//Only whole pages of a mapped local memory can be replaced by the file
+	if (!mSparseMem || MemOffset >= mLocalMemBytes || ((memAddr | FileOffset) & (pageSize - 1))) {
+		return 0;
+	}
+
+	int fd = open(FileName.c_str(), O_RDONLY);
+	if (fd < 0) {
+		throw runtime_error(getName() + ": unable to open image file " + FileName);
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || (uint64_t) st.st_size <= FileOffset) {
+		close(fd);
+		return 0;
+	}
+
+	//A partial last page is left to the caller, so that the bytes following it are untouched
+	uint64_t len = min((uint64_t) st.st_size - FileOffset, mLocalMemBytes - MemOffset);
+	len &= ~(pageSize - 1);
+	if (len == 0) {
+		close(fd);
+		return 0;
+	}
+
+	//Private mapping: pages are read on first access and copied on first write, the file is never modified
+	void* mem = mmap((void*) memAddr, len, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_FIXED | MAP_NORESERVE, fd, FileOffset);
+	close(fd);
+	if (mem == MAP_FAILED) {
+		LOG_ERROR <<getName()<< ": unable to map " << FileName << " in local memory." << endl;
+		throw runtime_error(getName() + ": unable to map image file " + FileName);
+	}
+
+	return len;
+}
+
 template < typename TYPE >
 void TargetIf<TYPE>::RegisterReadAccess ( Callback_t * callback ) {
     if (mReadCallback) {
@@ -143,7 +249,11 @@ TargetIf<TYPE>::~TargetIf () {
 	if (mReadCallback) delete mReadCallback;
 	if (mWriteCallback) delete mWriteCallback;
 
-	delete[] mLocalMem;
+	if (mSparseMem) {
+		munmap(mLocalMem, mLocalMemBytes);
+	} else {
+		delete[] mLocalMem;
+	}
 }
 
 //----------------------------------------------------------------------------------
@@ -156,6 +266,37 @@ TargetIf<TYPE>::~TargetIf () {
 //
 template < typename TYPE >
 void TargetIf<TYPE>::b_transport( tlm::tlm_generic_payload& trans, sc_time& delay ) {
+	//Vectored transaction: every segment is serviced in order, up to the first failing one.
+	//The payload is pointed to each segment in turn, with the extension detached, so that
+	//callbacks relying on the original payload only ever see a single access.
+	//A router that does not split vectored transactions sends them whole to the target of
+	//the first segment: the segments from the first one mapped elsewhere are left to the
+	//initiator, the ones serviced here being reported as a success
+	VectoredExtension* vec = trans.get_extension<VectoredExtension> ();
+	if ( vec ) {
+		tlm::tlm_response_status rsp = tlm::TLM_OK_RESPONSE;
+		bool dmi = true;
+		vec->Serviced = 0;
+		trans.clear_extension ( vec );
+		for ( const VectoredSegment& seg : vec->Segments ) {
+			if ( vec->Serviced && ( seg.addr < getBaseAddress () || seg.addr + seg.len > getBaseAddress () + getSize () ) ) break;
+			set_segment ( trans, seg );
+			rsp = Transport ( trans, delay );
+			if ( rsp != tlm::TLM_OK_RESPONSE ) break;
+			dmi = dmi && trans.is_dmi_allowed ();
+			vec->Serviced++;
+		}
+		trans.set_extension ( vec );
+		trans.set_dmi_allowed ( dmi && rsp == tlm::TLM_OK_RESPONSE );
+		trans.set_response_status ( rsp );
+		return;
+	}
+
+	trans.set_response_status ( Transport ( trans, delay ) );
+}
+
+template < typename TYPE >
+tlm::tlm_response_status TargetIf<TYPE>::Transport ( tlm::tlm_generic_payload& trans, sc_time& delay ) {
 	//-----------------------------------------------------------------------
 	//Get information
 	payload_t payload;
@@ -172,27 +313,22 @@ void TargetIf<TYPE>::b_transport( tlm::tlm_generic_payload& trans, sc_time& dela
 	//-----------------------------------------------------------------------
 	//Test address
 	if ( (payload.addr < getBaseAddress() ) || ((payload.addr + payload.len) > (getBaseAddress() + getSize())) ) {
-
-		trans.set_response_status( tlm::TLM_ADDRESS_ERROR_RESPONSE );
-		return;
+		return tlm::TLM_ADDRESS_ERROR_RESPONSE;
 	}
 
 	//Test burst size
 	if ( (payload.len > getSize() ) || (payload.len == 0) ) {
-		trans.set_response_status( tlm::TLM_BURST_ERROR_RESPONSE );
-		return;
+		return tlm::TLM_BURST_ERROR_RESPONSE;
 	}
 
 	//Test byte mode
 	if ( !getByteEnable() && ((payload.byte_enable_ptr!=0) || (payload.byte_enable_len!=0) )) {
-		trans.set_response_status( tlm::TLM_BYTE_ENABLE_ERROR_RESPONSE );
-		return;
+		return tlm::TLM_BYTE_ENABLE_ERROR_RESPONSE;
 	}
 
 	//Test command
 	if (( payload.cmd != tlm::TLM_WRITE_COMMAND ) && ( payload.cmd != tlm::TLM_READ_COMMAND) ) {
-		trans.set_response_status( tlm::TLM_COMMAND_ERROR_RESPONSE );
-		return;
+		return tlm::TLM_COMMAND_ERROR_RESPONSE;
 	}
 
 	//-----------------------------------------------------------------------
@@ -200,12 +336,8 @@ void TargetIf<TYPE>::b_transport( tlm::tlm_generic_payload& trans, sc_time& dela
 	tlm::tlm_response_status rsp = CoreFunction ( payload, delay );
 	trans.set_dmi_allowed(payload.dmi);
 
-	//-----------------------------------------------------------------------
-	// Successful completion
-	trans.set_response_status( rsp );
-
 	//End
-	return;
+	return rsp;
 }
 
 //----------------------------------------------------------------------------------
@@ -355,19 +487,21 @@ unsigned int TargetIf<TYPE>::transport_dbg(tlm::tlm_generic_payload& trans) {
 
 	//Get information
 	tlm::tlm_command cmd = trans.get_command();
-	sc_dt::uint64 addr = trans.get_address() / 4;
+	uint64_t addr = trans.get_address();
 	unsigned char* ptr = trans.get_data_ptr();
 	unsigned int len = trans.get_data_length();
 
-	//Test address
-	if ( ( addr >= getSize() ) || ( (addr+len) >= getSize() ) ) {
+	//Test address, only the part of the transfer inside the target is done
+	if ( ( addr < getBaseAddress() ) || ( addr > getEndAddress() ) ) {
 		trans.set_response_status( tlm::TLM_ADDRESS_ERROR_RESPONSE );
 		return 0;
 	}
+	len = min ( (uint64_t) len, getEndAddress() - addr + 1 );
+	unsigned char* mem = (unsigned char*) mLocalMem + ( addr - getBaseAddress() );
 
 	//TODO : shall rely on read_access_function
-	if ( cmd == tlm::TLM_READ_COMMAND ) memcpy( ptr, &mLocalMem [ addr ], len );
-	else if ( cmd == tlm::TLM_WRITE_COMMAND ) memcpy( &mLocalMem [ addr ], ptr, len );
+	if ( cmd == tlm::TLM_READ_COMMAND ) memcpy( ptr, mem, len );
+	else if ( cmd == tlm::TLM_WRITE_COMMAND ) memcpy( mem, ptr, len );
 
 	// Successful completion
 	trans.set_response_status( tlm::TLM_OK_RESPONSE );
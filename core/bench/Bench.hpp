@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/*
+ * Helpers shared by the micro-benchmarks: an initiator built on InitiatorIf
+ * and a timing loop printing one row per benchmark in the same layout as
+ * Google Benchmark.
+ */
+
+#ifndef BENCH_HPP_
+#define BENCH_HPP_
+
+#include "InitiatorIf.hpp"
+#include <chrono>
+#include <iomanip>
+#include <type_traits>
+
+namespace vpsim
+{
+	//Initiator with a single port, whose accesses are issued by the benchmark
+	class BenchInitiator : public sc_core::sc_module, public InitiatorIf
+	{
+	public:
+		BenchInitiator(sc_core::sc_module_name name):
+			sc_core::sc_module(name),
+			InitiatorIf(std::string(name), 0, true, 1)
+		{}
+	};
+
+	static const int BENCH_NAME_WIDTH = 40;
+
+	//Keeps the compiler from dropping a value computed by a benchmark, as benchmark::DoNotOptimize
+	template <typename T>
+	inline void benchKeep(const T& value) {
+		asm volatile("" : : "r,m"(value) : "memory");
+	}
+
+	template <typename Body>
+	inline void benchRun(Body& body, uint64_t i, std::true_type) {
+		body(i);
+	}
+
+	template <typename Body>
+	inline void benchRun(Body& body, uint64_t i, std::false_type) {
+		benchKeep(body(i));
+	}
+
+	inline void benchHeader() {
+		std::cout << std::left << std::setw(BENCH_NAME_WIDTH) << "Benchmark" << std::right
+		          << std::setw(15) << "Time" << std::setw(14) << "Iterations" << std::endl;
+		std::cout << std::string(BENCH_NAME_WIDTH + 29, '-') << std::endl;
+	}
+
+	//Runs body(i) for i from 0 to iterations, prints its row and returns the nanoseconds per iteration.
+	//The value returned by body, if any, is kept alive.
+	template <typename Body>
+	double bench(const std::string& name, uint64_t iterations, Body body) {
+		typedef std::is_void<decltype(body(0))> returnsVoid;
+		auto start = std::chrono::steady_clock::now();
+		for (uint64_t i = 0; i < iterations; i++) {
+			benchRun(body, i, returnsVoid());
+		}
+		auto stop = std::chrono::steady_clock::now();
+		double ns = std::chrono::duration<double, std::nano>(stop - start).count() / iterations;
+
+		std::cout << std::left << std::setw(BENCH_NAME_WIDTH) << name << std::right
+		          << std::setw(12) << std::fixed << std::setprecision(1) << ns << " ns"
+		          << std::setw(14) << iterations << std::endl;
+		return ns;
+	}
+}
+
+#endif /* BENCH_HPP_ */
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0 
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/*
+ * Lookup cost of DmiKeeper::getDmi versus the number of DMI regions on a port.
+ * Two access patterns are measured: a sequential one, served by the last-hit
+ * entry most of the time, and a random one that always goes to the index.
+ */
+
+#include "DmiKeeper.hpp"
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <random>
+
+using namespace vpsim;
+using namespace std;
+
+static const uint64_t REGION_SIZE = 0x10000;
+static const uint64_t LOOKUPS = 1 << 24;
+
+static double run(DmiKeeper& dmi, const vector<uint64_t>& addrs) {
+	uintptr_t sink = 0;
+	auto start = chrono::steady_clock::now();
+	for (uint64_t i = 0; i < LOOKUPS; i++) {
+		sink += (uintptr_t)dmi.getDmi(0, addrs[i & (addrs.size() - 1)]);
+	}
+	auto stop = chrono::steady_clock::now();
+	if (sink == 1) cout << "";
+	return chrono::duration<double, nano>(stop - start).count() / LOOKUPS;
+}
+
+int sc_main(int argc, char* argv[])
+{
+	static unsigned char backing[64];
+	mt19937_64 rng(42);
+
+	cout << setw(10) << "regions" << setw(18) << "sequential ns" << setw(18) << "random ns" << endl;
+	for (uint64_t nregions = 1; nregions <= 1024; nregions *= 2) {
+		DmiKeeper dmi(1);
+		// Leave a hole between regions so that they do not merge.
+		for (uint64_t r = 0; r < nregions; r++) {
+			dmi.setDmiRange(0, r * 2 * REGION_SIZE, REGION_SIZE, backing);
+		}
+
+		vector<uint64_t> sequential(1 << 16), random(1 << 16);
+		for (size_t i = 0; i < sequential.size(); i++) {
+			// Walk every region in turn with cache-line sized strides.
+			uint64_t region = i * nregions / sequential.size();
+			sequential[i] = region * 2 * REGION_SIZE + (i * 64) % REGION_SIZE;
+			random[i] = (rng() % nregions) * 2 * REGION_SIZE + rng() % REGION_SIZE;
+		}
+
+		cout << setw(10) << nregions
+		     << setw(18) << fixed << setprecision(2) << run(dmi, sequential)
+		     << setw(18) << fixed << setprecision(2) << run(dmi, random) << endl;
+	}
+	return 0;
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0 
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/*
+ * Nanoseconds per access of the InitiatorIf access functions, reported in
+ * the same layout as Google Benchmark. The target does the minimum amount
+ * of work so that the cost measured is the one of the initiator side.
+ */
+
+#include "Bench.hpp"
+#include "InitiatorIf.hpp"
+#include "TargetIf.hpp"
+#include "TlmCallbackPrivate.hpp"
+
+using namespace vpsim;
+using namespace sc_core;
+using namespace std;
+
+static const uint64_t MEM_SIZE = 0x10000;
+
+class NullTarget : public sc_module, public tlm::tlm_fw_transport_if<>
+{
+public:
+	tlm_utils::simple_target_socket<NullTarget> socket;
+	unsigned char mem[MEM_SIZE];
+	bool dmiHint;
+
+	NullTarget(sc_module_name name): sc_module(name), socket("socket"), dmiHint(false) {
+		socket.register_b_transport(this, &NullTarget::b_transport);
+		socket.register_get_direct_mem_ptr(this, &NullTarget::get_direct_mem_ptr);
+		socket.register_transport_dbg(this, &NullTarget::transport_dbg);
+	}
+
+	void b_transport(tlm::tlm_generic_payload& trans, sc_time& delay) override {
+		trans.set_dmi_allowed(dmiHint);
+		trans.set_response_status(tlm::TLM_OK_RESPONSE);
+	}
+
+	bool get_direct_mem_ptr(tlm::tlm_generic_payload& trans, tlm::tlm_dmi& dmi) override {
+		dmi.set_dmi_ptr(mem);
+		dmi.set_start_address(0);
+		dmi.set_end_address(MEM_SIZE - 1);
+		dmi.allow_read_write();
+		return true;
+	}
+
+	unsigned int transport_dbg(tlm::tlm_generic_payload& trans) override {
+		trans.set_response_status(tlm::TLM_OK_RESPONSE);
+		return trans.get_data_length();
+	}
+
+	tlm::tlm_sync_enum nb_transport_fw(tlm::tlm_generic_payload&, tlm::tlm_phase&, sc_time&) override {
+		return tlm::TLM_COMPLETED;
+	}
+};
+
+int sc_main(int argc, char* argv[])
+{
+	const uint64_t iterations = 1 << 24;
+
+	BenchInitiator cpu("cpu");
+	NullTarget target("target");
+	cpu.getInitiatorSocket()[0]->bind(target.socket);
+	sc_start(SC_ZERO_TIME);
+
+	uint64_t value = 0;
+	sc_time delay = SC_ZERO_TIME;
+
+	benchHeader();
+
+	cpu.setForceLt(true);
+	bench("BM_TargetMemAccess_Read", iterations, [&](uint64_t i) {
+		cpu.target_mem_access(0, (i * 8) & (MEM_SIZE - 1), 8, (unsigned char*)&value, READ, delay);
+	});
+	bench("BM_TargetMemAccess_Write", iterations, [&](uint64_t i) {
+		cpu.target_mem_access(0, (i * 8) & (MEM_SIZE - 1), 8, (unsigned char*)&value, WRITE, delay);
+	});
+	bench("BM_TargetMemAccess_CpuIdChange", iterations, [&](uint64_t i) {
+		cpu.target_mem_access(0, (i * 8) & (MEM_SIZE - 1), 8, (unsigned char*)&value, READ, delay, i & 1);
+	});
+
+	cpu.setForceLt(false);
+	target.dmiHint = true;
+	bench("BM_TargetMemAccess_Dmi", iterations, [&](uint64_t i) {
+		cpu.target_mem_access(0, (i * 8) & (MEM_SIZE - 1), 8, (unsigned char*)&value, READ, delay);
+	});
+
+	cpu.setDmiEnable(true);
+	bench("BM_TargetDbgAccess", iterations, [&](uint64_t i) {
+		cpu.target_dbg_access(0, (i * 8) & (MEM_SIZE - 1), 8, (unsigned char*)&value, READ);
+	});
+
+	return 0;
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0 
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/*
+ * Accesses per second of InitiatorIf::target_mem_access on a memory-backed
+ * platform, with the DMI fast path and with force_lt (b_transport only).
+ */
+
+#include "InitiatorIf.hpp"
+#include "TargetIf.hpp"
+#include "TlmCallbackPrivate.hpp"
+#include <chrono>
+#include <iomanip>
+
+using namespace vpsim;
+using namespace sc_core;
+using namespace std;
+
+static const uint64_t MEM_BASE = 0x80000000;
+static const uint64_t MEM_SIZE = 0x100000;
+static const uint64_t ACCESSES = 1 << 24;
+
+class BenchMemory : public sc_module, public TargetIf<unsigned char>
+{
+	typedef BenchMemory this_type;
+
+public:
+	BenchMemory(sc_module_name name):
+		sc_module(name),
+		TargetIf<unsigned char>(string(name), MEM_SIZE, false, true)
+	{
+		setBaseAddress(MEM_BASE);
+		setSize(MEM_SIZE);
+		setCyclesPerRead(1);
+		setCyclesPerWrite(1);
+		RegisterReadAccess(REGISTER(this_type, read));
+		RegisterWriteAccess(REGISTER(this_type, write));
+	}
+
+	tlm::tlm_response_status read(payload_t& payload, sc_time& delay) {
+		memcpy(payload.ptr, getLocalMem() + payload.addr - getBaseAddress(), payload.len);
+		delay += getReadWordLatency();
+		payload.dmi = true;
+		return tlm::TLM_OK_RESPONSE;
+	}
+
+	tlm::tlm_response_status write(payload_t& payload, sc_time& delay) {
+		memcpy(getLocalMem() + payload.addr - getBaseAddress(), payload.ptr, payload.len);
+		delay += getWriteWordLatency();
+		payload.dmi = true;
+		return tlm::TLM_OK_RESPONSE;
+	}
+};
+
+class BenchInitiator : public sc_module, public InitiatorIf
+{
+public:
+	BenchInitiator(sc_module_name name):
+		sc_module(name),
+		InitiatorIf(string(name), 0, true, 1)
+	{}
+};
+
+static double run(BenchInitiator& cpu) {
+	uint64_t value = 0;
+	sc_time delay = SC_ZERO_TIME;
+
+	auto start = chrono::steady_clock::now();
+	for (uint64_t i = 0; i < ACCESSES; i++) {
+		uint64_t addr = MEM_BASE + ((i * 8) & (MEM_SIZE - 1));
+		cpu.target_mem_access(0, addr, 8, (unsigned char*)&value, (i & 3) ? READ : WRITE, delay);
+	}
+	auto stop = chrono::steady_clock::now();
+
+	return ACCESSES / chrono::duration<double>(stop - start).count();
+}
+
+int sc_main(int argc, char* argv[])
+{
+	BenchInitiator cpu("cpu");
+	BenchMemory mem("mem");
+	cpu.getInitiatorSocket()[0]->bind(mem.mTargetSocket);
+	sc_start(SC_ZERO_TIME);
+
+	cpu.setForceLt(true);
+	double lt = run(cpu);
+
+	cpu.setForceLt(false);
+	double dmi = run(cpu);
+
+	cout << setw(12) << "mode" << setw(20) << "Maccesses/s" << endl;
+	cout << setw(12) << "b_transport" << setw(20) << fixed << setprecision(2) << lt / 1e6 << endl;
+	cout << setw(12) << "dmi" << setw(20) << fixed << setprecision(2) << dmi / 1e6 << endl;
+	cout << "speedup: " << setprecision(2) << dmi / lt << "x" << endl;
+
+	return 0;
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0 
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/*
+ * Accesses per second of TargetIf::b_transport with the different logging
+ * settings. Build once with the default VPSIM_LOG_MAX_DEBUG_LEVEL and once
+ * with -DVPSIM_LOG_MAX_DEBUG_LEVEL=1 to measure the cost of the debug
+ * messages of the access path against their compiled out counterpart.
+ */
+
+#include "TargetIf.hpp"
+#include "log.hpp"
+#include <chrono>
+#include <iomanip>
+
+using namespace vpsim;
+using namespace sc_core;
+using namespace std;
+
+static const uint64_t MEM_BASE = 0x80000000;
+static const uint64_t MEM_SIZE = 0x100000;
+static const uint64_t ACCESSES = 1 << 24;
+
+class BenchMemory : public sc_module, public TargetIf<unsigned char>
+{
+	typedef BenchMemory this_type;
+
+public:
+	BenchMemory(sc_module_name name):
+		sc_module(name),
+		TargetIf<unsigned char>(string(name), MEM_SIZE, false, true)
+	{
+		setBaseAddress(MEM_BASE);
+		setSize(MEM_SIZE);
+		setCyclesPerRead(1);
+		setCyclesPerWrite(1);
+		RegisterReadAccess(REGISTER(this_type, read));
+		RegisterWriteAccess(REGISTER(this_type, write));
+	}
+
+	tlm::tlm_response_status read(payload_t& payload, sc_time& delay) {
+		memcpy(payload.ptr, getLocalMem() + payload.addr - getBaseAddress(), payload.len);
+		delay += getReadWordLatency();
+		return tlm::TLM_OK_RESPONSE;
+	}
+
+	tlm::tlm_response_status write(payload_t& payload, sc_time& delay) {
+		memcpy(getLocalMem() + payload.addr - getBaseAddress(), payload.ptr, payload.len);
+		delay += getWriteWordLatency();
+		return tlm::TLM_OK_RESPONSE;
+	}
+};
+
+static double run(BenchMemory& mem) {
+	uint64_t value = 0;
+	sc_time delay = SC_ZERO_TIME;
+	tlm::tlm_generic_payload trans;
+	trans.set_data_ptr((unsigned char*)&value);
+	trans.set_data_length(8);
+	trans.set_streaming_width(8);
+	trans.set_byte_enable_ptr(nullptr);
+
+	auto start = chrono::steady_clock::now();
+	for (uint64_t i = 0; i < ACCESSES; i++) {
+		trans.set_address(MEM_BASE + ((i * 8) & (MEM_SIZE - 1)));
+		trans.set_command((i & 3) ? tlm::TLM_READ_COMMAND : tlm::TLM_WRITE_COMMAND);
+		trans.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
+		mem.b_transport(trans, delay);
+	}
+	auto stop = chrono::steady_clock::now();
+
+	return ACCESSES / chrono::duration<double>(stop - start).count();
+}
+
+int sc_main(int argc, char* argv[])
+{
+	BenchMemory mem("mem");
+	sc_start(SC_ZERO_TIME);
+
+	//Logging off: the default of a simulation
+	LoggerCore::get().enableLogging(false);
+	double off = run(mem);
+
+	//Logging on, but the access path messages are above the debug level
+	LoggerCore::get().enableLogging(true);
+	LoggerCore::get().setDebugLvl(dbg0);
+	double on = run(mem);
+
+	//Logging on, every debug message disabled
+	LoggerCore::get().enableDebugLogging(false);
+	double debugOff = run(mem);
+
+	cout << "VPSIM_LOG_MAX_DEBUG_LVL=" << VPSIM_LOG_MAX_DEBUG_LVL << endl;
+	cout << setw(16) << "mode" << setw(20) << "Maccesses/s" << endl;
+	cout << setw(16) << "logging off" << setw(20) << fixed << setprecision(2) << off / 1e6 << endl;
+	cout << setw(16) << "logging on" << setw(20) << fixed << setprecision(2) << on / 1e6 << endl;
+	cout << setw(16) << "debug off" << setw(20) << fixed << setprecision(2) << debugOff / 1e6 << endl;
+
+	return 0;
+}
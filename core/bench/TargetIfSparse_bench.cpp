@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/*
+ * Construction time and resident memory of large declared memories, from
+ * 1 GiB to 64 GiB, eagerly allocated or sparse. Resident memory is read once
+ * the memory is built and again after one byte has been written in TOUCHED
+ * evenly spaced pages, a guest touching a scattered working set. An eager
+ * memory the host cannot commit is reported as failed. The largest size in
+ * GiB can be given as first argument. Each measure runs in its own process,
+ * which exits without destroying its memory.
+ */
+
+#include "TargetIf.hpp"
+#include <chrono>
+#include <iomanip>
+#include <unistd.h>
+#include <sys/wait.h>
+
+using namespace vpsim;
+using namespace sc_core;
+using namespace std;
+
+class BenchMemory : public sc_module, public TargetIf<unsigned char>
+{
+public:
+	BenchMemory(sc_module_name name, uint64_t size, bool sparse):
+		sc_module(name),
+		TargetIf<unsigned char>(string(name), size, false, true, sparse)
+	{
+	}
+};
+
+static const uint64_t TOUCHED = 1024;
+
+struct Result { bool Built; double Startup, BuiltMiB, TouchedMiB; };
+
+static Result measure(uint64_t size, bool sparse) {
+	Result r = { false, 0, 0, 0 };
+	auto start = chrono::steady_clock::now();
+	BenchMemory* mem;
+	try {
+		mem = new BenchMemory("mem", size, sparse);
+	} catch (bad_alloc&) {
+		return r;
+	}
+	r.Startup = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+	r.Built = true;
+	r.BuiltMiB = mem->getResidentBytes() / (double) (1 << 20);
+	for (uint64_t i = 0; i < TOUCHED; i++)
+		mem->getLocalMem()[size / TOUCHED * i] = (unsigned char) i;
+	r.TouchedMiB = mem->getResidentBytes() / (double) (1 << 20);
+	return r;
+}
+
+//Runs measure in a child process, so that each measure starts from the same heap
+static Result isolated(uint64_t size, bool sparse) {
+	Result r = { false, 0, 0, 0 };
+	int fds[2];
+	if (pipe(fds) != 0) throw runtime_error("pipe failed");
+	cout << flush;
+	pid_t pid = fork();
+	if (pid == 0) {
+		r = measure(size, sparse);
+		if (write(fds[1], &r, sizeof(r)) != sizeof(r)) _exit(1);
+		_exit(0);
+	}
+	//A child killed by the host running out of memory reports nothing: the memory is not built
+	close(fds[1]);
+	if (read(fds[0], &r, sizeof(r)) != sizeof(r)) r.Built = false;
+	waitpid(pid, NULL, 0);
+	close(fds[0]);
+	return r;
+}
+
+static void print(const string& mode, const Result& r) {
+	cout << setw(10) << mode;
+	if (!r.Built) {
+		cout << setw(14) << "failed" << endl;
+		return;
+	}
+	cout << setw(14) << r.Startup << setw(14) << r.BuiltMiB << setw(14) << r.TouchedMiB << endl;
+}
+
+int sc_main(int argc, char* argv[])
+{
+	const uint64_t maxGiB = argc > 1 ? stoull(argv[1]) : 64;
+
+	cout << setw(8) << "size" << setw(10) << "mode" << setw(14) << "startup (ms)" << setw(14) << "built (MiB)" << setw(14) << "touched (MiB)" << endl;
+	cout << fixed << setprecision(1);
+	for (uint64_t gib = 1; gib <= maxGiB; gib *= 4) {
+		Result eager = isolated(gib << 30, false);
+		Result sparse = isolated(gib << 30, true);
+		cout << setw(5) << gib << "GiB";
+		print("eager", eager);
+		cout << setw(8) << "";
+		print("sparse", sparse);
+	}
+	return 0;
+}
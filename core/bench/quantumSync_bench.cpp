@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/*
+ * Wall-clock time to simulate SIM_TIME of an N-CPU platform with each
+ * quantum sync mode. The CPUs behave like the ISS wrappers: they execute
+ * one instruction per nanosecond, issue a load every ACCESS_PERIOD
+ * instructions through an InitiatorIf, and sync their quantum keeper after
+ * each load. Modules cannot be created once the simulation started, so all
+ * CPUs are built upfront and a driver thread starts the first N of them for
+ * each run.
+ */
+
+#include "InitiatorIf.hpp"
+#include "TargetIf.hpp"
+#include "TlmCallbackPrivate.hpp"
+#include "quantum.hpp"
+#include <chrono>
+#include <iomanip>
+
+using namespace vpsim;
+using namespace sc_core;
+using namespace std;
+
+static const unsigned MAX_CPUS = 32;
+static const unsigned QUANTUM_NS = 1000;
+static const unsigned ACCESS_PERIOD = 7;
+static const sc_time SIM_TIME(10, SC_MS);
+static const uint64_t MEM_SIZE = 0x1000;
+
+class BenchMemory : public sc_module, public TargetIf<unsigned char>
+{
+	typedef BenchMemory this_type;
+
+public:
+	BenchMemory(sc_module_name name):
+		sc_module(name),
+		TargetIf<unsigned char>(string(name), MEM_SIZE, false, false)
+	{
+		setBaseAddress(0);
+		RegisterReadAccess(REGISTER(this_type, read));
+		RegisterWriteAccess(REGISTER(this_type, read));
+	}
+
+	tlm::tlm_response_status read(payload_t& payload, sc_time& delay) {
+		delay += sc_time(10, SC_NS);
+		return tlm::TLM_OK_RESPONSE;
+	}
+};
+
+class BenchCpu : public sc_module, public InitiatorIf
+{
+public:
+	ParallelQuantumKeeper mQuantumKeeper;
+	sc_event* mStart;
+	bool mActive;
+	sc_time mRunEnd;
+
+	SC_HAS_PROCESS(BenchCpu);
+
+	BenchCpu(sc_module_name name, sc_event* start):
+		sc_module(name),
+		InitiatorIf(string(name), QUANTUM_NS, true, 1),
+		mQuantumKeeper(QUANTUM_NS),
+		mStart(start),
+		mActive(false)
+	{
+		setForceLt(true);
+		SC_THREAD(run);
+	}
+
+	void run() {
+		uint64_t value = 0, pc = 0;
+		while (true) {
+			wait(*mStart);
+			if (!mActive) continue;
+
+			mQuantumKeeper.reset();
+			while (mQuantumKeeper.get_current_time() < mRunEnd) {
+				sc_time delay(ACCESS_PERIOD, SC_NS);
+				target_mem_access(0, (pc++ * 8) & (MEM_SIZE - 1), 8, (unsigned char*)&value, READ, delay);
+				mQuantumKeeper += delay;
+				mQuantumKeeper.sync();
+			}
+		}
+	}
+};
+
+class Driver : public sc_module
+{
+public:
+	vector<BenchCpu*> mCpus;
+	sc_event mStart;
+
+	SC_HAS_PROCESS(Driver);
+
+	Driver(sc_module_name name): sc_module(name) {
+		for (unsigned i = 0; i < MAX_CPUS; i++) {
+			BenchCpu* cpu = new BenchCpu(("cpu" + to_string(i)).c_str(), &mStart);
+			BenchMemory* mem = new BenchMemory(("mem" + to_string(i)).c_str());
+			cpu->getInitiatorSocket()[0]->bind(mem->mTargetSocket);
+			mCpus.push_back(cpu);
+		}
+		SC_THREAD(run);
+	}
+
+	void run() {
+		const pair<QuantumSyncMode, string> modes[] = {
+			{ QUANTUM_SYNC_UNALIGNED, "Unaligned" },
+			{ QUANTUM_SYNC_ALIGNED, "Aligned" } };
+
+		for (auto& mode : modes) {
+			for (unsigned n = 1; n <= MAX_CPUS; n *= 2) {
+				sc_time runEnd = sc_time_stamp() + SIM_TIME;
+				uint64_t syncs = 0;
+				for (unsigned i = 0; i < MAX_CPUS; i++) {
+					mCpus[i]->mActive = i < n;
+					mCpus[i]->mRunEnd = runEnd;
+					mCpus[i]->mQuantumKeeper.setSyncMode(mode.first);
+					syncs -= mCpus[i]->mQuantumKeeper.getTotalSyncCount();
+				}
+
+				auto start = chrono::steady_clock::now();
+				mStart.notify(SC_ZERO_TIME);
+				//Leave room for the last sync of every CPU
+				wait(SIM_TIME + sc_time(2 * QUANTUM_NS, SC_NS));
+				auto stop = chrono::steady_clock::now();
+
+				for (unsigned i = 0; i < MAX_CPUS; i++) syncs += mCpus[i]->mQuantumKeeper.getTotalSyncCount();
+				double ms = chrono::duration<double, milli>(stop - start).count();
+				cout << left << setw(36) << ("BM_QuantumSync_" + mode.second + "/" + to_string(n)) << right
+				     << setw(12) << fixed << setprecision(1) << ms << " ms"
+				     << setw(14) << syncs << endl;
+			}
+		}
+		sc_stop();
+	}
+};
+
+int sc_main(int argc, char* argv[])
+{
+	Driver driver("driver");
+
+	cout << left << setw(36) << "Benchmark" << right << setw(15) << "Wall time" << setw(14) << "Syncs" << endl;
+	cout << string(65, '-') << endl;
+
+	sc_start();
+	return 0;
+}
@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef _ADDRESSMAP_HPP_
+#define _ADDRESSMAP_HPP_
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace vpsim {
+
+/*
+ * Compiled address decoder shared by the routing components.
+ * A router adds the ranges of its targets, plain or interleaved over several
+ * targets with a fixed granule, then compiles the map: ranges are sorted
+ * by base address into a flat array and checked for overlaps, so that a
+ * decode is one binary search on the base addresses.
+ * Every map registers itself, so that the platform can compile all of
+ * them once it is built and dump the resolved memory map.
+ */
+class AddressMap {
+public:
+	static const int32_t NO_TARGET = -1;
+
+	struct Region {
+		uint64_t base_addr;
+		uint64_t end_addr;
+		int32_t target;    //!< target of the whole range, unless interleaved
+		uint64_t granule;  //!< 0 if not interleaved
+		uint32_t first;    //!< first interleaved target in mInterleaved
+		uint32_t count;    //!< number of interleaved targets
+		std::string name;
+	};
+
+	//!
+	//! @param [in] name of the map, usually that of its router, used in errors and dumps
+	//!
+	AddressMap(const std::string& name);
+	~AddressMap();
+
+	AddressMap(const AddressMap&) = delete;
+	AddressMap& operator=(const AddressMap&) = delete;
+
+	//!
+	//! maps [base, base+size-1] to target, an empty range is ignored
+	//!
+	void addRange(uint64_t base, uint64_t size, int32_t target, const std::string& name = "");
+
+	//!
+	//! maps [base, base+size-1] to targets, granule by granule and in turn
+	//!
+	void addInterleavedRange(uint64_t base, uint64_t size, uint64_t granule,
+			const std::vector<int32_t>& targets, const std::string& name = "");
+
+	//! removes every range
+	void clear();
+
+	//!
+	//! sorts the ranges, throws if one wraps around the address space or if two of them overlap.
+	//! The same range added twice for the same target is kept once.
+	//!
+	void compile();
+
+	bool isCompiled() const { return mCompiled; }
+
+	//!
+	//! @return the index of the region containing addr, -1 if none
+	//!
+	int32_t find(uint64_t addr) const {
+		//Regions do not overlap: the only candidate is the last one starting at or below addr
+		size_t lo = 0, hi = mBases.size();
+		while (lo < hi) {
+			size_t mid = (lo + hi) / 2;
+			if (mBases[mid] <= addr) lo = mid + 1;
+			else hi = mid;
+		}
+		if (lo == 0 || addr > mRegions[lo - 1].end_addr) return -1;
+		return lo - 1;
+	}
+
+	//!
+	//! @return the target of addr in the region at index
+	//!
+	int32_t getTarget(int32_t index, uint64_t addr) const {
+		const Region& r = mRegions[index];
+		if (!r.granule) return r.target;
+		return mInterleaved[r.first + ((addr - r.base_addr) / r.granule) % r.count];
+	}
+
+	//!
+	//! @return the target of [addr, addr+length-1], NO_TARGET if it is not inside one region
+	//!
+	int32_t decode(uint64_t addr, uint64_t length = 1) const {
+		int32_t index = find(addr);
+		if (index < 0 || addr + (length - 1) > mRegions[index].end_addr) return NO_TARGET;
+		return getTarget(index, addr);
+	}
+
+	//!
+	//! finds the largest window around addr that decodes to a single target, or to none
+	//! @param [out] base first address of the window
+	//! @param [out] end last address of the window
+	//! @return the index of the region of the window, -1 for a hole between regions
+	//!
+	int32_t getWindow(uint64_t addr, uint64_t& base, uint64_t& end) const;
+
+	const Region& getRegion(int32_t index) const { return mRegions[index]; }
+	size_t getRegionCount() const { return mRegions.size(); }
+	const std::string& getName() const { return mName; }
+
+	//! prints the compiled ranges, one per line
+	void dump(std::ostream& os) const;
+
+	//!
+	//! compiles every map not compiled yet, the first error is thrown
+	//!
+	static void CompileAll();
+
+	//! dumps every map, compiling it first if needed
+	static void DumpAll(std::ostream& os);
+
+private:
+	std::string mName;
+	std::vector<Region> mPending;      //!< ranges as added
+	std::vector<Region> mRegions;      //!< compiled ranges, sorted by base address
+	std::vector<uint64_t> mBases;      //!< base addresses of mRegions, contiguous for the search
+	std::vector<int32_t> mInterleaved; //!< targets of the interleaved ranges
+	bool mCompiled;
+
+	std::string describe(const Region& r) const;
+};
+
+}
+
+#endif /* _ADDRESSMAP_HPP_ */
@@ -20,35 +20,169 @@
 #include <inttypes.h>
 #include <stdint.h>
 #include <vector>
-#include <deque>
+#include <map>
+#include <iterator>
 
 using namespace std;
 
 namespace vpsim {
 
+/*
+ * Keeps, for each port, the DMI regions granted to a component.
+ * Regions of a port are stored as a sorted set of non-overlapping intervals
+ * indexed by base address, so that a lookup is a single tree search.
+ * The last region hit on each port is cached in front of the index since
+ * consecutive accesses tend to fall in the same region.
+ */
 struct DmiKeeper {
 
+	struct DmiRegion {
+		uint64_t base;
+		uint64_t size;
+		unsigned char* ptr;
+	};
+
 	DmiKeeper(uint32_t nports) {
 		mRanges.resize(nports);
+		mLastHit.resize(nports, DmiRegion { 0, 0, nullptr });
 	}
 
 	unsigned char* getDmi(uint32_t port, uint64_t addr) {
-		for (auto & entry: mRanges[port]) {
-			if (addr >= get<0>(entry) && addr < get<0>(entry)+get<1>(entry)) {
-				return get<2>(entry) + addr-get<0>(entry);
-			}
+		// Unsigned wrap-around makes this false for addr < base, and size 0 never matches.
+		DmiRegion& last = mLastHit[port];
+		if (addr - last.base < last.size) {
+			return last.ptr + (addr - last.base);
+		}
+
+		auto& index = mRanges[port];
+		auto it = index.upper_bound(addr);
+		if (it == index.begin()) {
+			return nullptr;
 		}
-		return nullptr;
+		--it;
+		if (addr - it->first >= it->second.size) {
+			return nullptr;
+		}
+
+		last = DmiRegion { it->first, it->second.size, it->second.ptr };
+		return it->second.ptr + (addr - it->first);
 	}
 
+	// A new range replaces whatever it overlaps, then is merged with its
+	// neighbours when they are contiguous both in address and host memory.
 	void setDmiRange(uint32_t port, uint64_t base, uint64_t size, unsigned char* ptr) {
-		mRanges[port].push_back(make_tuple(base, size, ptr));
+		if (size == 0) {
+			return;
+		}
+		uint64_t last = base + (size - 1);
+		if (last < base) {
+			// Clip ranges running past the end of the address space.
+			last = UINT64_MAX;
+			size = last - base + 1;
+		}
+
+		invalidateDmiRange(port, base, last);
+
+		auto& index = mRanges[port];
+		auto it = index.emplace(base, Entry { size, ptr }).first;
+
+		if (it != index.begin()) {
+			auto prev = std::prev(it);
+			if (prev->first + prev->second.size == base && prev->second.ptr + prev->second.size == ptr) {
+				prev->second.size += size;
+				index.erase(it);
+				it = prev;
+			}
+		}
+
+		auto next = std::next(it);
+		if (next != index.end()
+				&& it->first + it->second.size == next->first
+				&& it->second.ptr + it->second.size == next->second.ptr) {
+			it->second.size += next->second.size;
+			index.erase(next);
+		}
+	}
+
+	// Removes [start, end] (end inclusive, as in invalidate_direct_mem_ptr)
+	// from the regions of a port, splitting regions that straddle the bounds.
+	void invalidateDmiRange(uint32_t port, uint64_t start, uint64_t end) {
+		if (end < start) {
+			return;
+		}
+
+		auto& index = mRanges[port];
+		auto it = index.upper_bound(start);
+		if (it != index.begin()) {
+			auto prev = std::prev(it);
+			if (start - prev->first < prev->second.size) {
+				it = prev;
+			}
+		}
+
+		while (it != index.end() && it->first <= end) {
+			uint64_t base = it->first;
+			uint64_t last = base + (it->second.size - 1);
+			unsigned char* ptr = it->second.ptr;
+
+			it = index.erase(it);
+
+			if (base < start) {
+				index.emplace(base, Entry { start - base, ptr });
+			}
+			if (last > end) {
+				it = index.emplace(end + 1, Entry { last - end, ptr + (end + 1 - base) }).first;
+				break;
+			}
+		}
+
+		mLastHit[port] = DmiRegion { 0, 0, nullptr };
+	}
+
+	// True when a region of a port overlaps [start, end] (end inclusive).
+	bool overlapsDmiRange(uint32_t port, uint64_t start, uint64_t end) const {
+		if (end < start) {
+			return false;
+		}
+
+		auto& index = mRanges[port];
+		auto it = index.upper_bound(end);
+		if (it == index.begin()) {
+			return false;
+		}
+		--it;
+		return it->first >= start || start - it->first < it->second.size;
+	}
+
+	void invalidateDmiRange(uint64_t start, uint64_t end) {
+		for (uint32_t port = 0; port < mRanges.size(); port++) {
+			invalidateDmiRange(port, start, end);
+		}
+	}
+
+	void clearDmi(uint32_t port) {
+		mRanges[port].clear();
+		mLastHit[port] = DmiRegion { 0, 0, nullptr };
+	}
+
+	// Regions of a port in ascending address order.
+	std::vector<DmiRegion> getDmiRegions(uint32_t port) const {
+		std::vector<DmiRegion> regions;
+		regions.reserve(mRanges[port].size());
+		for (auto & entry: mRanges[port]) {
+			regions.push_back(DmiRegion { entry.first, entry.second.size, entry.second.ptr });
+		}
+		return regions;
 	}
 
 private:
-	std::vector<
-	    std::deque<
-		    std::tuple<uint64_t, uint64_t, unsigned char*> > > mRanges;
+	struct Entry {
+		uint64_t size;
+		unsigned char* ptr;
+	};
+
+	std::vector<std::map<uint64_t, Entry>> mRanges;
+	std::vector<DmiRegion> mLastHit;
 };
 
 }
@@ -19,14 +19,25 @@
 
 #include "global.hpp"
 #include "logger.hpp"
+#include "VectoredTransport.hpp"
+#include <map>
 
 namespace vpsim
 {
+	struct GicCpuExtension;
+
 	class InitiatorIf : public tlm::tlm_bw_transport_if<>, public Logger
 	{
 	private:
 		//Other local variables
-		std::vector < tlm::tlm_dmi > mCachedDmiRegions;
+		std::vector < std::map < sc_dt::uint64, tlm::tlm_dmi > > mCachedDmiRegions; //!< DMI regions granted to each port, indexed by start address
+		std::vector < tlm::tlm_dmi * > mLastDmiRegion; //!< last DMI region hit on each port (NULL if none)
+		uint64_t mDmiAccessCount; //!< number of accesses served through DMI
+
+		//Payloads reused by target_mem_access on each port, along with their persistent extension
+		std::vector < tlm::tlm_generic_payload * > mPayloads;
+		std::vector < GicCpuExtension * > mCpuIdExtensions;
+		std::vector < bool > mPayloadBusy; //!< set while the payload of a port is in flight
 		bool mDmiEnable;
 		string mName;
 		DIAG_LEVEL mDiagnosticLevel;
@@ -34,6 +45,22 @@ namespace vpsim
 		bool mTlmActive;
 		uint32_t mNbPort;
 
+		//!
+		//! @return the cached DMI region of port covering [addr, addr+length-1], NULL if none
+		//!
+		tlm::tlm_dmi * findDmiRegion ( uint32_t port, uint64_t addr, uint32_t length );
+
+		//!
+		//! asks the target of port for a DMI region covering addr and caches it if granted
+		//!
+		void requestDmiRegion ( uint32_t port, uint64_t addr, uint32_t length, ACCESS_TYPE rw );
+
+		//!
+		//! fills every field of payload used by the targets and sends it through b_transport
+		//!
+		tlm::tlm_response_status transport ( uint32_t port, tlm::tlm_generic_payload & payload, GicCpuExtension & cpu_id_ext,
+				uint64_t addr, uint32_t length, unsigned char * data, ACCESS_TYPE rw, sc_time &delay, uint32_t id );
+
 	public:
 		//---------------------------------------------------
 		//Constructor
@@ -50,6 +77,12 @@ namespace vpsim
 
 		tlm::tlm_response_status target_mem_access ( uint32_t port, uint64_t addr, uint32_t length, unsigned char * data, ACCESS_TYPE rw, sc_time &delay, uint32_t id=0 );
 
+		//! accesses several address ranges of port in a single vectored transaction (see VectoredTransport.hpp):
+		//! segments covered by a cached DMI region are served directly, the others are sent together
+		//! reentrant: every call uses its own payload
+		tlm::tlm_response_status target_mem_access_vectored ( uint32_t port, const std::vector < VectoredSegment > & segments, ACCESS_TYPE rw, sc_time &delay, uint32_t id=0 );
+
+		//! reentrant: every call uses its own payload
 		uint32_t target_dbg_access ( uint32_t port, uint64_t addr, uint32_t length, unsigned char * data, ACCESS_TYPE rw );
 
 		//---------------------------------------------------
@@ -65,8 +98,7 @@ namespace vpsim
 		uint32_t getNbPort();
 		bool getTlmActive();
 		bool getDmiEnable();
-
-		tlm::tlm_generic_payload trans;
+		uint64_t getDmiAccessCount();
 
 		//!
 		//! @return InitiatorIf module mName
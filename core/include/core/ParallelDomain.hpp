@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef PARALLELDOMAIN_HPP_
+#define PARALLELDOMAIN_HPP_
+
+#include "global.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace vpsim
+{
+	//! ParallelDomain runs a set of clusters (a CPU, or a CPU and its private non-coherent caches) on host threads
+	//! of their own.
+	//! Clusters run one quantum at a time, concurrently. The SystemC kernel only resumes between quanta, once every
+	//! cluster reached the quantum barrier, so the rest of the platform (devices, interrupt controllers...) still
+	//! runs serially, with sc_time_stamp() set to the start of the quantum while the clusters run.
+	//! A cluster synchronizes through its ParallelQuantumKeeper only: it never calls sc_core::wait.
+	//! Accesses leaving a cluster for shared components are wrapped in lockShared/unlockShared (see ParallelBridge):
+	//!  - in ordered mode (default), they are granted in increasing (time, cluster) order whatever the host scheduling,
+	//!    so a simulation gives the same results with any number of host threads;
+	//!  - otherwise, they are only mutually exclusive and granted in host arrival order.
+	//! A cluster holds no state the shared components may reach on their own: a coherent cache, snooped by the
+	//! interconnect on behalf of another cluster, would be accessed from two host threads (see ParallelBridge).
+	//! Clusters may log: the lines of the loggers are written one at a time (see LogLineLock).
+	//! ParallelDomain and ParallelBridge are execution infrastructure only, no platform model runs on them yet.
+	//! The CPU models cannot be clusters: IssWrapper and ModelProvider wait on SystemC events (interrupts,
+	//! WFI, IO polling) from their CPU thread. Domains are thus built in C++ only, the platform XML and
+	//! PlatformBuilder do not describe them, and only clusters written against the keeper (see the tests and
+	//! parallelDomain_bench) run in parallel.
+	class ParallelDomain : public sc_module
+	{
+	public:
+		typedef std::function<void()> ClusterBody;
+
+		//! thrown in the cluster threads still running when the domain is destroyed, to unwind them
+		struct Stopped {};
+
+	private:
+		enum ClusterState {
+			CLUSTER_RUNNING,    //!< executing its quantum, or waiting for a host thread to do so
+			CLUSTER_WAITING,    //!< waiting for its turn to access the shared components
+			CLUSTER_HOLDING,    //!< accessing the shared components
+			CLUSTER_AT_BARRIER, //!< done with the current quantum
+			CLUSTER_FINISHED    //!< body returned
+		};
+
+		struct Cluster {
+			ClusterBody Body;
+			std::thread Thread;
+			ClusterState State = CLUSTER_RUNNING;
+			std::atomic<uint64_t> Time{0}; //!< lower bound of the time of its next shared access, in sc_time units
+		};
+
+		sc_time mQuantum;
+		unsigned mHostThreads; //!< maximum number of clusters executing at once, 0 for one host thread per cluster
+		bool mOrdered;
+
+		std::deque<Cluster> mClusters;
+
+		std::mutex mMutex;
+		std::condition_variable mClusterCv; //!< quantum release, shared access turns, host thread slots
+		std::condition_variable mKernelCv;  //!< cluster arrivals at the barrier
+		bool mStarted;
+		bool mStopping;
+		bool mSharedHeld; //!< unordered mode only
+		uint64_t mEpoch;  //!< number of quanta released
+		sc_time mQuantumStart;
+		unsigned mArrived;
+		unsigned mFinished;
+		unsigned mFreeSlots;
+		std::atomic<unsigned> mWaiting; //!< clusters waiting for a shared access, read without the mutex by advance
+		std::exception_ptr mError;      //!< first exception escaping a cluster body, rethrown in the kernel thread
+
+		//stats
+		uint64_t mQuantumCount;
+		uint64_t mSharedAccessCount;
+
+		//! SystemC process releasing the quanta
+		void schedule();
+
+		void clusterMain(unsigned id);
+		void joinClusters();
+
+		//! @return true if every access that may precede the one of cluster id in (time, cluster) order is done
+		bool mayAccess(unsigned id);
+
+		void acquireSlot(std::unique_lock<std::mutex>& lock);
+		//! @return false, without a slot, if the domain is stopping
+		bool waitSlot(std::unique_lock<std::mutex>& lock);
+		void releaseSlot();
+
+	public:
+		//! @param quantum : duration of the quanta, cannot be zero
+		//! @param hostThreads : maximum number of clusters executing at once, 0 for no limit
+		ParallelDomain(sc_module_name name, const sc_time& quantum, unsigned hostThreads = 0);
+		~ParallelDomain();
+		SC_HAS_PROCESS(ParallelDomain);
+
+		//! registers a cluster, before the simulation starts. body runs on its own host thread
+		//! @return the index of the cluster, to be given to its keeper and bridges
+		unsigned addCluster(const ClusterBody& body);
+
+		void setOrdered(bool ordered);
+		bool getOrdered();
+
+		sc_time getQuantum();
+		unsigned getClusterCount();
+
+		//-----------------------------------------
+		//Cluster side, called from the cluster threads
+
+		//! ends the current quantum of a cluster, blocks until the next one is released
+		void barrier(unsigned cluster);
+
+		//! publishes the current time of a cluster: it will not access shared components before t
+		void advance(unsigned cluster, const sc_time& t);
+
+		//! blocks until cluster may access the shared components at time t, see mayAccess
+		void lockShared(unsigned cluster, const sc_time& t);
+		//! ends the shared access of cluster, then blocks until it gets a host thread again
+		void unlockShared(unsigned cluster);
+		//! unlockShared for a cluster unwinding from an exception, which does not throw Stopped
+		//! @return false if the domain is stopping, the cluster then holding no host thread
+		bool unlockSharedNoThrow(unsigned cluster) noexcept;
+
+		//stats
+		uint64_t getQuantumCount();
+		uint64_t getSharedAccessCount();
+	};
+}
+
+#endif /* PARALLELDOMAIN_HPP_ */
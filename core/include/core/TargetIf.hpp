@@ -42,6 +42,8 @@ namespace vpsim
 		Callback_t * mWriteCallback; //!< callback function pointer to a TLM write function implemented by inheriting slave
 
 		TYPE * mLocalMem;//!< Internal shared memory space
+		bool mSparseMem; //!< true if mLocalMem is a reserved mapping whose pages are only backed once touched
+		uint64_t mLocalMemBytes; //!< size in bytes of mLocalMem as allocated
 
 		//------------
 		//Statistics
@@ -74,8 +76,10 @@ namespace vpsim
 		//! @param [in] size : the size of the memory address range that this TargetIf will encompass
 		//! @param [in] byte_enable : activates byte masked communication if set to true
 		//! @param [in] dmi_enable : activates the support of DMI accesses if set to true
+		//! @param [in] sparse_mem : reserves the local memory with an anonymous MAP_NORESERVE mapping instead of allocating it,
+		//! host pages are then only committed (and zeroed) on first access
 		//!
-		TargetIf ( string Name, uint64_t Size, bool ByteEnable, bool DmiEnable );
+		TargetIf ( string Name, uint64_t Size, bool ByteEnable, bool DmiEnable, bool SparseMem = false );
 
 		//!
 		//! destructor
@@ -139,6 +143,28 @@ namespace vpsim
 		//!
 		TYPE * getLocalMem ();
 
+		//!
+		//! @return true if the local memory is sparse (lazily backed)
+		//!
+		bool getSparseMem ();
+
+		//!
+		//! @return the number of bytes of the local memory currently resident in host memory.
+		//! Pages of a mapped image are only counted once written, the others being page cache pages
+		//!
+		uint64_t getResidentBytes ();
+
+		//!
+		//! Maps a file, privately and copy-on-write, over a part of a sparse local memory.
+		//! Nothing is mapped if the local memory is not sparse, or if the offsets are not page aligned.
+		//! Only whole pages are mapped: the caller copies the bytes left after the returned length.
+		//! @param [in] FileName : the image file
+		//! @param [in] FileOffset : offset in the file of the first mapped byte
+		//! @param [in] MemOffset : offset in the local memory of the first mapped byte
+		//! @return the number of bytes mapped
+		//!
+		uint64_t MapLocalMemFile ( const string& FileName, uint64_t FileOffset, uint64_t MemOffset );
+
 		//!
 		//! @return TargetIf module mTargetSocket
 		//!
@@ -181,6 +207,21 @@ namespace vpsim
 		//void register_write_access ( sc_module * mod, tlm::tlm_response_status (*ptr) ( payload_t&, sc_core::sc_time& ) );
 		void RegisterWriteAccess ( Callback_t * callback );
 
+	private:
+
+		//!
+		//! Allocates mLocalMem, eagerly or as a sparse mapping depending on mSparseMem
+		//!
+		void AllocateLocalMem ( );
+
+		//!
+		//! Checks and services the single access described by trans, without setting its response status
+		//! @return the response status of the access
+		//!
+		tlm::tlm_response_status Transport ( tlm::tlm_generic_payload& trans, sc_time& delay );
+
+	public:
+
 
 		//---------------------------------------------------
 		//core tlm function
@@ -219,6 +260,7 @@ namespace vpsim
 
 		//!
 		//! Provides reference implementation for TLM 2.0 standard blocking transport interface
+		//! Vectored transactions (see VectoredTransport.hpp) are serviced natively, segment by segment
 		//! @param [in,out] trans : a TLM packet using the tlm_generic_payload structure provided by TLM standard implementation
 		//! @param [in,out] delay : the accumulated delay vs the current simulation time accumulated throughout TLM blocking calls
 		//!
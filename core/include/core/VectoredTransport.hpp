@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef _VECTOREDTRANSPORT_HPP_
+#define _VECTOREDTRANSPORT_HPP_
+
+#include "global.hpp"
+#include <vector>
+
+namespace vpsim {
+
+/*
+ * Scatter/gather transactions.
+ * A vectored transaction is a generic payload carrying a VectoredExtension:
+ * all its segments share the command of the payload, and the address, length
+ * and data pointer of the payload are those of the first segment, so that a
+ * target ignoring the extension still services a valid (first) access.
+ * Targets servicing the extension natively process every segment in order,
+ * stop at the first failing one and report in Serviced how many succeeded.
+ * They also stop, with an OK response, at the first segment outside of their
+ * own range, since routers that do not split vectored transactions send them
+ * whole to the target of the first segment.
+ * A target ignoring the extension leaves Serviced to 0, its response standing
+ * for the first segment only. In both cases the initiator issues the
+ * remaining segments one b_transport at a time (see vectored_b_transport).
+ * Simulated time is accumulated per segment, as if the segments had been
+ * sent one by one.
+ */
+struct VectoredSegment {
+	uint64_t addr;
+	uint32_t len;
+	unsigned char* ptr;
+};
+
+struct VectoredExtension : public tlm::tlm_extension<VectoredExtension> {
+	std::vector<VectoredSegment> Segments;
+	size_t Serviced = 0; //!< number of leading segments serviced by the target
+
+	virtual tlm::tlm_extension_base* clone() const {
+		return new VectoredExtension(*this);
+	}
+	virtual void copy_from(tlm::tlm_extension_base const &ext) {
+		*this = static_cast<VectoredExtension const &>(ext);
+	}
+};
+
+//!
+//! Points the address, length and data pointer of trans to a segment
+//!
+inline void set_segment(tlm::tlm_generic_payload& trans, const VectoredSegment& seg) {
+	trans.set_address(seg.addr);
+	trans.set_data_length(seg.len);
+	trans.set_streaming_width(seg.len);
+	trans.set_data_ptr(seg.ptr);
+	trans.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
+}
+
+//!
+//! Sends a vectored transaction through transport (any callable taking the payload and the delay,
+//! typically a socket b_transport), then sends one by one the segments the target left unserviced.
+//! ext must be attached to trans and hold at least one segment. The extension is detached while the
+//! fallback accesses are in flight, so that routers on the way do not take them for vectored ones.
+//! @return the response status of the last transaction sent
+//!
+template < typename TRANSPORT >
+tlm::tlm_response_status vectored_b_transport(TRANSPORT&& transport, tlm::tlm_generic_payload& trans,
+		VectoredExtension& ext, sc_time& delay) {
+	const size_t count = ext.Segments.size();
+
+	ext.Serviced = 0;
+	set_segment(trans, ext.Segments[0]);
+	transport(trans, delay);
+	if (trans.get_response_status() != tlm::TLM_OK_RESPONSE || ext.Serviced == count) {
+		return trans.get_response_status();
+	}
+
+	//Resume after the segments serviced natively, or after the first one for a legacy
+	//target, which only serviced the access described by the payload itself
+	if (ext.Serviced == 0) ext.Serviced = 1;
+	trans.clear_extension(&ext);
+	while (ext.Serviced < count) {
+		set_segment(trans, ext.Segments[ext.Serviced]);
+		transport(trans, delay);
+		if (trans.get_response_status() != tlm::TLM_OK_RESPONSE) break;
+		ext.Serviced++;
+	}
+	trans.set_extension(&ext);
+	return trans.get_response_status();
+}
+
+}
+
+#endif /* _VECTOREDTRANSPORT_HPP_ */
@@ -18,9 +18,18 @@
 #define QUANTUM_HPP_
 
 #include "global.hpp"
+#include <atomic>
 
 namespace vpsim
 {
+	class ParallelDomain;
+
+	//! Synchronization modes of ParallelQuantumKeeper
+	enum QuantumSyncMode {
+		QUANTUM_SYNC_UNALIGNED, //!< wait for the whole local time as soon as the quantum is exceeded
+		QUANTUM_SYNC_ALIGNED    //!< wait until the last quantum boundary reached, keeping the rest as local time
+	};
+
 	//! ParallelQuantumKeeper leverages tlm_utils::tlm_quantumkeeper to provide synchronous time events between
 	//! LT initiators. It makes sure that synchronization occur on specific time stamps and do not induce initiators
     //! to run at different time events (though committing waits every quantum in average)
@@ -30,6 +39,51 @@ namespace vpsim
 		//stats
 		uint32_t forceSyncCount;
 		uint32_t syncCount;
+		sc_time mSyncWaitTime; //!< simulated time waited at sync points
+		double mSyncWaitHostTime; //!< host time, in seconds, spent suspended at sync points
+
+		QuantumSyncMode mSyncMode;
+		bool mSyncModeSet; //!< mSyncMode was set by setSyncMode, otherwise DefaultSyncMode applies
+
+		//! mode of the keepers whose mode is not set, see setDefaultSyncMode
+		static QuantumSyncMode DefaultSyncMode;
+
+		//! suspends the calling thread for t and updates the wait statistics
+		void waitAndAccount(const sc_time& t);
+
+		//adaptive quantum: the local quantum is mMinQuantum * 2^mLevel, so that the boundaries
+		//of larger quanta are also boundaries of the smaller ones
+		bool mAdaptive;
+		sc_time mMinQuantum;
+		unsigned mLevel;
+		unsigned mMaxLevel;
+		uint64_t mShrinkThreshold; //!< interactions per sync above which the quantum falls back to its minimum
+		uint64_t mLastInteractionCount; //!< InteractionCount at the last sync
+
+		//adaptive quantum stats
+		vector<sc_time> mQuantumLevelTime; //!< simulated time spent with each quantum level
+		sc_time mLevelSince; //!< time stamp at which the current level was chosen
+		uint64_t mQuantumChangeCount;
+
+		//! number of interactions between initiators notified since the beginning of the simulation
+		static std::atomic<uint64_t> InteractionCount;
+
+		//parallel execution, see setParallelDomain
+		ParallelDomain* mDomain;
+		unsigned mCluster;
+
+		//! sync() of a keeper running in a parallel domain
+		void syncParallel();
+
+		//! grows or shrinks the adaptive quantum depending on the interactions seen since the last sync
+		void adaptQuantum();
+
+		//! adds the time spent with the current level to its stats
+		void accountQuantumLevel();
+
+	protected:
+		//! time left until the next quantum boundary, using the adaptive quantum when enabled
+		virtual sc_time compute_local_quantum();
 
 	public:
 		//!Constructor
@@ -40,7 +94,8 @@ namespace vpsim
 		virtual ~ParallelQuantumKeeper();
 
 
-		//! Synchronization with systemc time using regular quantum steps (multiples of quantum)
+		//! Synchronization with systemc time once the local time exceeds the quantum,
+		//! aligned on quantum boundaries or not depending on the sync mode
 		//! to be used by default
 		virtual void sync();
 
@@ -48,6 +103,7 @@ namespace vpsim
 
 		//! forced synchronization at time stamps unaligned with quantum
 		//! to be used when absolutely necessary for synchronization purposes (adds some synchronization poitns)
+		//! In a parallel domain, where threads cannot wait within a quantum, it is a regular sync
 		void forceSync();
 
 		//! convenience proxy to clarify the set function defined by tlm_quantumkeeper
@@ -56,9 +112,49 @@ namespace vpsim
 
 		ParallelQuantumKeeper& operator+=( sc_time const t);
 
+		void setSyncMode(QuantumSyncMode mode);
+		QuantumSyncMode getSyncMode();
+
+		//! sets the mode of the keepers whose mode is not set, i.e. the mode of a whole platform,
+		//! whether they are constructed before or after the call
+		static void setDefaultSyncMode(QuantumSyncMode mode);
+		static QuantumSyncMode getDefaultSyncMode();
+
+		//! @return the mode named name ("unaligned" or "aligned"), throws if unknown
+		static QuantumSyncMode parseSyncMode(const string& name);
+
 		uint32_t getSyncCount();
 		uint32_t getForceSyncCount();
 		uint32_t getTotalSyncCount();
+		sc_time getSyncWaitTime();
+		double getSyncWaitHostTime();
+
+		//! Enables the adaptive quantum: it doubles at each sync without interaction since the previous one,
+		//! and falls back to min at each sync after which more than shrinkThreshold interactions were notified.
+		//! max is rounded down to min times a power of two. Throws if min is zero or max is lower than min.
+		void setAdaptiveQuantum(const sc_time& min, const sc_time& max, uint64_t shrinkThreshold = 0);
+		bool getAdaptiveQuantum();
+		sc_time getMinQuantum();
+
+		//! @return the current quantum of this keeper, the global one unless the adaptive quantum is enabled
+		sc_time getQuantum();
+
+		//! Notifies an interaction between initiators (coherence traffic, interrupt, device I/O):
+		//! the adaptive quantum of every keeper shrinks at its next sync
+		static void notifyInteraction();
+		static uint64_t getInteractionCount();
+
+		//! @return the simulated time spent with each adaptive quantum, index i for min * 2^i
+		const vector<sc_time>& getQuantumLevelTime();
+		//! @return the adaptive quantum averaged over the simulated time
+		sc_time getAverageQuantum();
+		uint64_t getQuantumChangeCount();
+
+		//! Runs the keeper in a cluster of a parallel domain: sync() waits at the barriers of the domain instead of
+		//! waiting in SystemC, and the sync mode and adaptive quantum are ignored in favour of the domain quantum
+		void setParallelDomain(ParallelDomain* domain, unsigned cluster);
+		ParallelDomain* getParallelDomain();
+		unsigned getParallelCluster();
 	};
 }
 
@@ -21,6 +21,17 @@
 #include "logger.hpp"
 #include "loggerCore.hpp"
 
+//! @brief Highest debug level compiled in, set with the VPSIM_LOG_MAX_DEBUG_LEVEL CMake option.
+//! Debug messages of a higher level are removed at compile time.
+#ifndef VPSIM_LOG_MAX_DEBUG_LVL
+#define VPSIM_LOG_MAX_DEBUG_LVL 6
+#endif
+
+//! @brief Tells if a debug message of level lvl can be logged at all.
+//! Constant false for levels compiled out, then a single test of the global debug
+//! switch (see LoggerCore::enableDebugLogging) when debug logging is disabled at runtime.
+#define LOG_DEBUG_ACTIVE(lvl) ((lvl) <= VPSIM_LOG_MAX_DEBUG_LVL && vpsim::Logger::sDebugLogging)
+
 //! @brief provides a stream to the logging file for a line of INFO
 #define LOG_INFO        if(Logger::canLogInfo())       Logger::logInfo()       << "[Info] "
 
@@ -35,7 +46,7 @@
 
 //! @brief provides a stream to the logging file for a line of DEBUG
 //! @param[in] lvl Level of debug of the message
-#define LOG_DEBUG(lvl)  if(Logger::canLogDebug((lvl))) Logger::logDebug((lvl)) << "[Debug" << (lvl) << "] "
+#define LOG_DEBUG(lvl)  if(LOG_DEBUG_ACTIVE(lvl) && Logger::canLogDebug((lvl))) Logger::logDebug((lvl)) << "[Debug" << (lvl) << "] "
 
 namespace vpsim{
   extern Logger globalLogger;
@@ -55,6 +66,6 @@ namespace vpsim{
 
 //! @brief provides a stream to the logging file for a line of DEBUG in the global log file
 //! @param[in] lvl Level of debug of the message
-#define LOG_GLOBAL_DEBUG(lvl)  if(globalLogger.canLogDebug((lvl))) globalLogger.logDebug((lvl)) << "[Debug" << (lvl) << "] "
+#define LOG_GLOBAL_DEBUG(lvl)  if(LOG_DEBUG_ACTIVE(lvl) && globalLogger.canLogDebug((lvl))) globalLogger.logDebug((lvl)) << "[Debug" << (lvl) << "] "
 
 #endif /* end of include guard: _LOG_HPP_ */
@@ -21,10 +21,26 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <mutex>
 #include "logResources.hpp"
 
 namespace vpsim{
 
+//! @brief Serializes the lines logged from several host threads (see ParallelDomain).
+//! Taken as a default argument by the stream accessors of Logger, it lives until the
+//! end of the statement writing the line, so that lines are never interleaved.
+class LogLineLock{
+public:
+  LogLineLock(){ sMutex.lock(); }
+  ~LogLineLock(){ sMutex.unlock(); }
+  LogLineLock(const LogLineLock&) = delete;
+  LogLineLock& operator=(const LogLineLock&) = delete;
+
+private:
+  //! @brief Recursive, as a value written to a line may log on its own
+  static std::recursive_mutex sMutex;
+};
+
 //! @brief Class to inherit from to use the logging macros in log.hpp.
 class Logger{
   //! @brief Allows the LoggerCore to change the debug level of the Logger object
@@ -48,6 +64,13 @@ private:
   bool mEnabled;
 
 public:
+  //! @brief Global switch of the debug messages: false when no debug message
+  //! can be logged, whatever the Logger and its debug level.
+  //! Checked first by every debug macro of log.hpp so that, in hot paths,
+  //! disabled debug logging costs a single predictable branch.
+  //! @see LoggerCore::enableDebugLogging(bool)
+  static bool sDebugLogging;
+
   //! @brief Only public Constructor
   //! @param[in] name Name to give to the logger
   Logger(const std::string name, std::ostream& stream=std::cout);
@@ -96,29 +119,51 @@ public:
 
   //! @brief Access the output stream to log info messages
   //! @return The stream to log info
-  std::ostream& logInfo();
+  std::ostream& logInfo(const LogLineLock& lock = LogLineLock());
 
   //! @brief Access the output stream to log warning messages
   //! @return The stream to log warnings
-  std::ostream& logWarning();
+  std::ostream& logWarning(const LogLineLock& lock = LogLineLock());
 
   //! @brief Access the output stream to log error messages
   //! @return The stream to log errors
-  std::ostream& logError();
+  std::ostream& logError(const LogLineLock& lock = LogLineLock());
 
   //! @brief Access the output stream to log stats messages
   //! @return The stream to log stats
-  std::ofstream& logStats();
+  std::ofstream& logStats(const LogLineLock& lock = LogLineLock());
 
   //! @brief Access the output stream to log debug messages
   //! @param[in] lvl level of the debug messages to be loggeg
   //! @return The stream to log debugs
-  std::ostream& logDebug(DebugLvl lvl);
+  std::ostream& logDebug(DebugLvl lvl, const LogLineLock& lock = LogLineLock());
 
 private:
   Logger();
 };
 
+//Defined inline as they are evaluated by every logging macro
+
+inline bool Logger::canLogInfo() const{
+  return mEnabled;
+}
+
+inline bool Logger::canLogWarning() const{
+  return mEnabled;
+}
+
+inline bool Logger::canLogError() const{
+  return mEnabled;
+}
+
+inline bool Logger::canLogStats() const{
+  return mEnabled;
+}
+
+inline bool Logger::canLogDebug(DebugLvl lvl) const {
+  return mEnabled && (lvl <= mDebugLvl);
+}
+
 }
 
 #endif /* end of include guard: _LOGGER_HPP_ */
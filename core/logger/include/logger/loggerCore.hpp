@@ -46,6 +46,9 @@ private:
   //! @brief Global lvl of debug
   DebugLvl mGlobalDebugLvl;
 
+  //! @brief Tells wether or not the debug messages of the hot paths are allowed
+  bool mDebugLoggingEnabled;
+
 public:
 
   //! @brief Accessor to the unique instance of the class LoggerCore
@@ -90,6 +93,15 @@ public:
   //! @return True if the logging is globaly enabled, false otherwise
   bool loggingEnabled() const;
 
+  //! @brief Globaly enable or disable every debug message of every Logger, leaving the other kinds
+  //! of messages untouched. When disabled, a debug logging macro costs a single test of Logger::sDebugLogging.
+  //! @param[in] enable Set to false to disable the debug messages
+  void enableDebugLogging(const bool enable);
+
+  //! @brief Tells if the debug messages are allowed
+  //! @return True if the debug messages are allowed, false otherwise
+  bool debugLoggingEnabled() const;
+
   //! @brief Print the current schedule of the LoggerScheduler module
   void printSchedule() const;
 
@@ -108,6 +120,9 @@ public:
 
 
 private:
+  //! @brief Recompute Logger::sDebugLogging after a change of settings
+  void updateDebugLogging();
+
   //! @brief Default constructor made private to prevent from additional instanciations
   LoggerCore();
 
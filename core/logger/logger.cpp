@@ -19,8 +19,13 @@
 
 namespace vpsim{
 
+//Defined first, as the global logger may log as soon as it is built
+std::recursive_mutex LogLineLock::sMutex;
+
 Logger globalLogger("globalLog");
 
+bool Logger::sDebugLogging = false;
+
 Logger::Logger(std::string name, std::ostream& stream):
   mName(name), mLogName(name.append(".log")), mDebugLvl(dbg0), mOfstream(stream), mEnabled(false)
 {
@@ -46,32 +51,7 @@ std::string Logger::logName() const{
 }
 
 
-bool Logger::canLogInfo() const{
-  return mEnabled;
-}
-
-
-bool Logger::canLogWarning() const{
-  return mEnabled;
-}
-
-
-bool Logger::canLogError() const{
-  return mEnabled;
-}
-
-
-bool Logger::canLogStats() const{
-  return mEnabled;
-}
-
-
-bool Logger::canLogDebug(DebugLvl lvl) const {
-  return mEnabled && (lvl <= mDebugLvl);
-}
-
-
-std::ostream& Logger::logInfo(){
+std::ostream& Logger::logInfo(const LogLineLock&){
   if(canLogInfo()){
     mOfstream.clear();
   } else {
@@ -81,7 +61,7 @@ std::ostream& Logger::logInfo(){
 }
 
 
-std::ostream& Logger::logWarning(){
+std::ostream& Logger::logWarning(const LogLineLock&){
   if(canLogWarning()){
     mOfstream.clear();
   } else {
@@ -91,7 +71,7 @@ std::ostream& Logger::logWarning(){
 }
 
 
-std::ostream& Logger::logError(){
+std::ostream& Logger::logError(const LogLineLock&){
   if(canLogError()){
     mOfstream.clear();
   } else {
@@ -101,7 +81,7 @@ std::ostream& Logger::logError(){
 }
 
 
-std::ofstream& Logger::logStats(){
+std::ofstream& Logger::logStats(const LogLineLock&){
   if(canLogStats()){
     if (!mStatStream.is_open()){
       mStatStream.open(mLogName.c_str(), std::ofstream::out);
@@ -114,7 +94,7 @@ std::ofstream& Logger::logStats(){
 }
 
 
-std::ostream& Logger::logDebug(DebugLvl lvl){
+std::ostream& Logger::logDebug(DebugLvl lvl, const LogLineLock&){
   if(canLogDebug(lvl)){
     mOfstream.clear();
   } else {
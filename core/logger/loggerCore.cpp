@@ -35,8 +35,11 @@ LoggerCore::LoggerCore():
   mLoggerScheduler("loggerScheduler"),
   mLoggingEnabled(false),
   mLoggingImpossible(false),
-  mGlobalDebugLvl(dbg0)
-{}
+  mGlobalDebugLvl(dbg0),
+  mDebugLoggingEnabled(true)
+{
+  updateDebugLogging();
+}
 
 void LoggerCore::registerLogger(Logger& logger)
 {
@@ -97,6 +100,8 @@ void LoggerCore::enableLogging(const bool enable)
   for(auto& p : mLoggers){
     p.second.mEnabled = loggingEnabled();
   }
+
+  updateDebugLogging();
 }
 
 bool LoggerCore::loggingEnabled() const
@@ -104,6 +109,22 @@ bool LoggerCore::loggingEnabled() const
   return mLoggingEnabled && !mLoggingImpossible;
 }
 
+void LoggerCore::enableDebugLogging(const bool enable)
+{
+  mDebugLoggingEnabled = enable;
+  updateDebugLogging();
+}
+
+bool LoggerCore::debugLoggingEnabled() const
+{
+  return mDebugLoggingEnabled;
+}
+
+void LoggerCore::updateDebugLogging()
+{
+  Logger::sDebugLogging = loggingEnabled() && mDebugLoggingEnabled;
+}
+
 void LoggerCore::addAppointment(std::string logger,
                                 sc_core::sc_time date,
                                 DebugLvl debugLvl)
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+
+#include <gtest/gtest.h>
+#include "log.hpp"
+#include <sstream>
+
+using namespace vpsim;
+
+int sc_main(int argc, char* argv[])
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+//Logs one debug and one info message through the macros of log.hpp
+class TestLogger : public Logger{
+public:
+  TestLogger(const std::string& name, std::ostream& stream): Logger(name, stream) {}
+
+  void logMessages(){
+    LOG_DEBUG(dbg0) << "debug" << std::endl;
+    LOG_INFO << "info" << std::endl;
+  }
+};
+
+TEST(DebugLogging, enableDebugLogging){
+  LoggerCore::get().enableLogging(true);
+  EXPECT_TRUE(LoggerCore::get().debugLoggingEnabled());
+  EXPECT_TRUE(Logger::sDebugLogging);
+
+  LoggerCore::get().enableDebugLogging(false);
+  EXPECT_FALSE(LoggerCore::get().debugLoggingEnabled());
+  EXPECT_FALSE(Logger::sDebugLogging);
+
+  //Disabling the whole logging also disables the debug messages
+  LoggerCore::get().enableDebugLogging(true);
+  LoggerCore::get().enableLogging(false);
+  EXPECT_FALSE(Logger::sDebugLogging);
+
+  LoggerCore::get().enableLogging(true);
+  EXPECT_TRUE(Logger::sDebugLogging);
+}
+
+TEST(DebugLogging, globalSwitch){
+  std::ostringstream out1, out2;
+  TestLogger logger1("testDebugLoggingGlobalSwitch1", out1);
+  TestLogger logger2("testDebugLoggingGlobalSwitch2", out2);
+  LoggerCore::get().enableLogging(true);
+  LoggerCore::get().setDebugLvl(logger1, dbg0);
+  LoggerCore::get().setDebugLvl(logger2, dbg6);
+
+  logger1.logMessages();
+  logger2.logMessages();
+  EXPECT_EQ("[Debug0] debug\n[Info] info\n", out1.str());
+  EXPECT_EQ("[Debug0] debug\n[Info] info\n", out2.str());
+
+  //The debug messages of every logger are gone, whatever its level, the other messages stay
+  out1.str("");
+  out2.str("");
+  LoggerCore::get().enableDebugLogging(false);
+  logger1.logMessages();
+  logger2.logMessages();
+  EXPECT_EQ("[Info] info\n", out1.str());
+  EXPECT_EQ("[Info] info\n", out2.str());
+
+  LoggerCore::get().enableDebugLogging(true);
+  LoggerCore::get().enableLogging(false);
+}
@@ -15,6 +15,7 @@
 */
 
 #include "platform_builder/PlatformBuilder.hpp"
+#include "AddressMap.hpp"
 
 namespace vpsim {
 
@@ -83,6 +84,8 @@ VpsimIp<InPortType, OutPortType>& PlatformBuilder::endBuild(
 void PlatformBuilder::finalize() {
 	VpsimIp<InPortType, OutPortType>::NotifyDmiAddresses(mLocalIps);
 	VpsimIp<InPortType, OutPortType>::Finalize(mLocalIps);
+	//Every router knows its ranges by now: report overlaps before the elaboration ends
+	AddressMap::CompileAll();
 }
 
 void PlatformBuilder::setAttribute(std::string attr, std::string value) {
@@ -106,6 +109,10 @@ void PlatformBuilder::forwardOutPort(std::string childName,
 	mCurrentIp->forwardChildOutPort(childName, childOutPortName, portAlias);
 }
 
+void PlatformBuilder::dumpMemoryMap(ostream &stream) {
+	AddressMap::DumpAll(stream);
+}
+
 void PlatformBuilder::dumpComponents(ostream &stream) {
 	for (auto cls=VpsimIp<InPortType,OutPortType>::RegisteredClasses.begin(); cls!=VpsimIp<InPortType,OutPortType>::RegisteredClasses.end(); cls++) {
 		stream<<"begin_component "<<cls->first<<endl;
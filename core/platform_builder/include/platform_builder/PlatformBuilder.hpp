@@ -55,6 +55,9 @@ struct PlatformBuilder {
 
 	static void dumpComponents(std::ostream& stream) ;
 
+	//! prints the address map of every router of the built platforms
+	static void dumpMemoryMap(std::ostream& stream) ;
+
 private:
 	VpsimIp<InPortType, OutPortType>* mCurrentIp;
 	std::vector<VpsimIp<InPortType, OutPortType>*> mBuildStack;
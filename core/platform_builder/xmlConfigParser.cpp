@@ -16,6 +16,7 @@
 
 #include <string>
 #include <log.hpp>
+#include <quantum.hpp>
 #include "platform_builder/xmlConfigParser.hpp"
 
 
@@ -163,9 +164,14 @@ namespace vpsim{
                 //simNode->skip_children();
                 cerr << "Global quantum is not currently supported" << endl;
                 LOG_GLOBAL_INFO << "Global quantum is not currently supported" << endl;
+            } else if (simNodeName == "quantumSync"){
+                ParallelQuantumKeeper::setDefaultSyncMode(ParallelQuantumKeeper::parseSyncMode(std::string(simNode->value())));
             } else if (simNodeName == "log"){
                 bool enable = std::string(simNode->value()) == "enable";
                 LoggerCore::get().enableLogging(enable);
+            } else if (simNodeName == "debugLog"){
+                bool enable = std::string(simNode->value()) == "enable";
+                LoggerCore::get().enableDebugLogging(enable);
             } else if (simNodeName == "defaultBlockingTLM"){
                 auto defaultBTLM = std::string(simNode->value()) == "enable" ?
                     BlockingTLMEnabledParameter::BT_ENABLED : BlockingTLMEnabledParameter::BT_DISABLED;
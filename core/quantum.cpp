@@ -15,63 +15,218 @@
 */
 
 #include "quantum.hpp"
+#include "ParallelDomain.hpp"
+#include <chrono>
 
 namespace vpsim {
 
+QuantumSyncMode ParallelQuantumKeeper::DefaultSyncMode = QUANTUM_SYNC_UNALIGNED;
+std::atomic<uint64_t> ParallelQuantumKeeper::InteractionCount(0);
 
 ParallelQuantumKeeper::ParallelQuantumKeeper( unsigned int quantum):
-	forceSyncCount(0),
-	syncCount(0)
+	ParallelQuantumKeeper()
 {
 	cout<<"Setting global quantum to "<<sc_time(quantum, SC_NS)<<endl;
 	set_global_quantum( sc_time(quantum, SC_NS) );
 }
 
-ParallelQuantumKeeper::ParallelQuantumKeeper(){
+ParallelQuantumKeeper::ParallelQuantumKeeper():
+	forceSyncCount(0),
+	syncCount(0),
+	mSyncWaitTime(SC_ZERO_TIME),
+	mSyncWaitHostTime(0),
+	mSyncMode(QUANTUM_SYNC_UNALIGNED),
+	mSyncModeSet(false),
+	mAdaptive(false),
+	mMinQuantum(SC_ZERO_TIME),
+	mLevel(0),
+	mMaxLevel(0),
+	mShrinkThreshold(0),
+	mLastInteractionCount(0),
+	mLevelSince(SC_ZERO_TIME),
+	mQuantumChangeCount(0),
+	mDomain(nullptr),
+	mCluster(0)
+{
 }
 
 ParallelQuantumKeeper::~ParallelQuantumKeeper(){
 }
 
-//#define ENABLE_PARALLEL_QUANTUM
+void ParallelQuantumKeeper::waitAndAccount(const sc_time& t){
+	auto start = std::chrono::steady_clock::now();
+	sc_core::wait(t);
+	mSyncWaitHostTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	mSyncWaitTime += t;
+}
 
-//!Synchronisation with systemc time using regular quantum steps (multiples of quantum)
-//!to be used by default
+//!Synchronisation with systemc time
+//!In aligned mode, the thread is only resumed on multiples of the quantum, so that
+//!all the initiators of a platform wake up on the same time stamps
 void ParallelQuantumKeeper::sync(){
-#ifdef ENABLE_PARALLEL_QUANTUM
-	while(need_sync()){ // local time is higher than the remaining quantum
-		sc_time q =  m_next_sync_point-sc_core::sc_time_stamp();
-		//sc_time q = compute_local_quantum();(identical to previous line but less efficient)
+	if (mDomain) {
+		syncParallel();
+		return;
+	}
+
+	if (getSyncMode() != QUANTUM_SYNC_ALIGNED) {
+		if (need_sync()) forceSync();
+		return;
+	}
 
-		//cout << endl << "quantum.cpp: ParallelQuantumKeeper: sync: wait: q =" << q << endl;
+	const sc_time now = sc_core::sc_time_stamp();
 
-		sc_core::wait(q); //we wait for the remaining quantum to align on specific time points (multiples of quantum)
+	//The sync point is stale when the thread waited outside of the keeper (e.g. for an interrupt)
+	if (m_next_sync_point <= now) m_next_sync_point = now + compute_local_quantum();
 
-		//we reset ParallelQuantumKeeper, i.e we compute the new quantum, and we update the local time
-	    m_local_time -= q;
-	    m_next_sync_point = sc_core::sc_time_stamp() + compute_local_quantum();
+	if (!need_sync()) return;
 
-	    //update stats
-	    syncCount++;
+	const sc_time quantum = getQuantum();
+	if (quantum == SC_ZERO_TIME) {
+		//No boundary to align on
+		forceSync();
+		return;
 	}
-#else
-	if (need_sync()) forceSync();
-#endif
 
+	//Wait once until the last boundary reached by the local time, the remainder stays local
+	const sc_time target = now + m_local_time;
+	const sc_time boundary = quantum * (double) (target.value() / quantum.value());
+	const sc_time q = boundary - now;
+
+	waitAndAccount(q);
+
+	m_local_time = target - boundary;
+	adaptQuantum();
+	m_next_sync_point = sc_core::sc_time_stamp() + compute_local_quantum();
+
+	//update stats
+	syncCount++;
 }
 
 //! forced synchronisation at time stamps unaligned with quantum
 //! to be used when absolutely necessary for synchronization purposes (adds some synchronization points)
 void ParallelQuantumKeeper::forceSync(){
+	if (mDomain) {
+		syncParallel();
+		return;
+	}
+
+	waitAndAccount(m_local_time);
+	adaptQuantum();
+	reset();
 
-	//cout << endl << "quantum.cpp: ParallelQuantumKeeper: ForceSync: wait: m_local_time =" << m_local_time << endl;
+	//update stats
+	forceSyncCount++;
+}
+
+sc_time ParallelQuantumKeeper::compute_local_quantum(){
+	if (!mAdaptive) return tlm_quantumkeeper::compute_local_quantum();
+
+	const sc_time quantum = getQuantum();
+	const sc_time now = sc_core::sc_time_stamp();
+	return quantum * (double) (now.value() / quantum.value() + 1) - now;
+}
+
+//!Interactions are counted platform-wide: the initiators involved in an interaction are not known,
+//!and any of them may have to observe it, so every keeper shrinks its quantum
+void ParallelQuantumKeeper::adaptQuantum(){
+	if (!mAdaptive) return;
+
+	const uint64_t count = InteractionCount;
+	const uint64_t interactions = count - mLastInteractionCount;
+	mLastInteractionCount = count;
 
-	sc_core::wait(m_local_time);
+	unsigned level = mLevel;
+	if (interactions > mShrinkThreshold) level = 0;
+	else if (interactions == 0 && level < mMaxLevel) level++;
 
+	if (level != mLevel) {
+		accountQuantumLevel();
+		mLevel = level;
+		mQuantumChangeCount++;
+	}
+}
 
-  reset();
+void ParallelQuantumKeeper::accountQuantumLevel(){
+	const sc_time now = sc_core::sc_time_stamp();
+	mQuantumLevelTime[mLevel] += now - mLevelSince;
+	mLevelSince = now;
 }
 
+void ParallelQuantumKeeper::setAdaptiveQuantum(const sc_time& min, const sc_time& max, uint64_t shrinkThreshold){
+	if (min == SC_ZERO_TIME || max < min) {
+		throw runtime_error("Invalid adaptive quantum bounds: [" + min.to_string() + ", " + max.to_string() + "]");
+	}
+
+	mAdaptive = true;
+	mMinQuantum = min;
+	mShrinkThreshold = shrinkThreshold;
+	mMaxLevel = 0;
+	while (mMaxLevel < 62 && min * (double) (2ull << mMaxLevel) <= max) mMaxLevel++;
+	mLevel = 0;
+	mLastInteractionCount = InteractionCount;
+	mQuantumLevelTime.assign(mMaxLevel + 1, SC_ZERO_TIME);
+	mLevelSince = sc_core::sc_time_stamp();
+	mQuantumChangeCount = 0;
+
+	m_next_sync_point = sc_core::sc_time_stamp() + compute_local_quantum();
+}
+
+bool ParallelQuantumKeeper::getAdaptiveQuantum(){ return mAdaptive; }
+sc_time ParallelQuantumKeeper::getMinQuantum(){ return mMinQuantum; }
+
+sc_time ParallelQuantumKeeper::getQuantum(){
+	if (!mAdaptive) return tlm::tlm_global_quantum::instance().get();
+	return mMinQuantum * (double) (1ull << mLevel);
+}
+
+void ParallelQuantumKeeper::notifyInteraction(){ InteractionCount++; }
+uint64_t ParallelQuantumKeeper::getInteractionCount(){ return InteractionCount; }
+
+const vector<sc_time>& ParallelQuantumKeeper::getQuantumLevelTime(){
+	if (mAdaptive) accountQuantumLevel();
+	return mQuantumLevelTime;
+}
+
+sc_time ParallelQuantumKeeper::getAverageQuantum(){
+	if (!mAdaptive) return getQuantum();
+
+	double weighted = 0, total = 0;
+	const vector<sc_time>& times = getQuantumLevelTime();
+	for (unsigned level = 0; level < times.size(); level++) {
+		weighted += times[level].to_seconds() * (mMinQuantum * (double) (1ull << level)).to_seconds();
+		total += times[level].to_seconds();
+	}
+	if (total == 0) return getQuantum();
+	return sc_time(weighted / total, SC_SEC);
+}
+
+uint64_t ParallelQuantumKeeper::getQuantumChangeCount(){ return mQuantumChangeCount; }
+
+//!The kernel time stays at the start of the quantum while the clusters run it, and
+//!goes exactly one quantum forward at each barrier
+void ParallelQuantumKeeper::syncParallel(){
+	const sc_time quantum = mDomain->getQuantum();
+	mDomain->advance(mCluster, get_current_time());
+
+	while (m_local_time >= quantum) {
+		auto start = std::chrono::steady_clock::now();
+		mDomain->barrier(mCluster);
+		mSyncWaitHostTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		mSyncWaitTime += quantum;
+		m_local_time -= quantum;
+		syncCount++;
+	}
+}
+
+void ParallelQuantumKeeper::setParallelDomain(ParallelDomain* domain, unsigned cluster){
+	mDomain = domain;
+	mCluster = cluster;
+}
+
+ParallelDomain* ParallelQuantumKeeper::getParallelDomain(){ return mDomain; }
+unsigned ParallelQuantumKeeper::getParallelCluster(){ return mCluster; }
+
 //! convenience proxy to clarify the set function defined by tlm_quantumkeeper
 //! and be more consistent with existing tlm_quantumkeeper::get_local_time
 void ParallelQuantumKeeper::set_local_time(const sc_core::sc_time& t)
@@ -84,8 +239,22 @@ ParallelQuantumKeeper& ParallelQuantumKeeper::operator+=( sc_time const t){
 	return *this;
 }
 
+void ParallelQuantumKeeper::setSyncMode(QuantumSyncMode mode){ mSyncMode = mode; mSyncModeSet = true; }
+QuantumSyncMode ParallelQuantumKeeper::getSyncMode(){ return mSyncModeSet ? mSyncMode : DefaultSyncMode; }
+
+void ParallelQuantumKeeper::setDefaultSyncMode(QuantumSyncMode mode){ DefaultSyncMode = mode; }
+QuantumSyncMode ParallelQuantumKeeper::getDefaultSyncMode(){ return DefaultSyncMode; }
+
+QuantumSyncMode ParallelQuantumKeeper::parseSyncMode(const string& name){
+	if (name == "unaligned") return QUANTUM_SYNC_UNALIGNED;
+	if (name == "aligned") return QUANTUM_SYNC_ALIGNED;
+	throw runtime_error("Unknown quantum sync mode: " + name + " (expected unaligned or aligned)");
+}
+
 uint32_t ParallelQuantumKeeper::getSyncCount(){ return syncCount;};
 uint32_t ParallelQuantumKeeper::getForceSyncCount(){ return forceSyncCount;};
 uint32_t ParallelQuantumKeeper::getTotalSyncCount(){ return syncCount+forceSyncCount;};
+sc_time ParallelQuantumKeeper::getSyncWaitTime(){ return mSyncWaitTime;};
+double ParallelQuantumKeeper::getSyncWaitHostTime(){ return mSyncWaitHostTime;};
 
 }//end namespace vpsim
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+
+#include <gtest/gtest.h>
+#include "AddressMap.hpp"
+#include <sstream>
+
+using namespace vpsim;
+using namespace std;
+
+int sc_main(int argc, char* argv[])
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+TEST(AddressMap, decode){
+  AddressMap map("map");
+  //Added in reverse order, with a hole between the ranges
+  map.addRange(0x3000, 0x1000, 1, "mem1");
+  map.addRange(0x1000, 0x1000, 0, "mem0");
+  map.addRange(0x8000, 0, 2);  //empty, ignored
+  map.compile();
+
+  EXPECT_EQ(2u, map.getRegionCount());
+  EXPECT_EQ(0, map.decode(0x1000));
+  EXPECT_EQ(0, map.decode(0x1ffc, 4));
+  EXPECT_EQ(1, map.decode(0x3800));
+  EXPECT_EQ(AddressMap::NO_TARGET, map.decode(0xfff));
+  EXPECT_EQ(AddressMap::NO_TARGET, map.decode(0x2000));
+  EXPECT_EQ(AddressMap::NO_TARGET, map.decode(0x4000));
+  EXPECT_EQ(AddressMap::NO_TARGET, map.decode(0x8000));
+
+  //Straddling the end of a range
+  EXPECT_EQ(AddressMap::NO_TARGET, map.decode(0x1ffc, 8));
+}
+
+TEST(AddressMap, interleaved){
+  AddressMap map("map");
+  map.addInterleavedRange(0x10000, 0x10000, 0x100, { 4, 5, 6 }, "ram");
+  map.addRange(0x0, 0x1000, 0, "rom");
+  map.compile();
+
+  EXPECT_EQ(0, map.decode(0x10));
+  EXPECT_EQ(4, map.decode(0x10000));
+  EXPECT_EQ(5, map.decode(0x101ff));
+  EXPECT_EQ(6, map.decode(0x10200));
+  EXPECT_EQ(4, map.decode(0x10300));
+  EXPECT_EQ(AddressMap::NO_TARGET, map.decode(0x20000));
+
+  //The window of an interleaved range is a granule
+  uint64_t base, end;
+  EXPECT_EQ(1, map.getWindow(0x10234, base, end));
+  EXPECT_EQ(0x10200u, base);
+  EXPECT_EQ(0x102ffu, end);
+
+  EXPECT_THROW(map.addInterleavedRange(0x30000, 0x1000, 0, { 1 }), runtime_error);
+  EXPECT_THROW(map.addInterleavedRange(0x30000, 0x1000, 0x100, { }), runtime_error);
+}
+
+TEST(AddressMap, window){
+  AddressMap map("map");
+  map.addRange(0x1000, 0x1000, 0);
+  map.addRange(0x3000, 0x1000, 1);
+  map.compile();
+
+  uint64_t base, end;
+  EXPECT_EQ(0, map.getWindow(0x1800, base, end));
+  EXPECT_EQ(0x1000u, base);
+  EXPECT_EQ(0x1fffu, end);
+
+  //Holes between, before and after the ranges
+  EXPECT_EQ(-1, map.getWindow(0x2800, base, end));
+  EXPECT_EQ(0x2000u, base);
+  EXPECT_EQ(0x2fffu, end);
+  EXPECT_EQ(-1, map.getWindow(0x10, base, end));
+  EXPECT_EQ(0x0u, base);
+  EXPECT_EQ(0xfffu, end);
+  EXPECT_EQ(-1, map.getWindow(0x4000, base, end));
+  EXPECT_EQ(0x4000u, base);
+  EXPECT_EQ(UINT64_MAX, end);
+}
+
+TEST(AddressMap, errors){
+  AddressMap overlap("overlap");
+  overlap.addRange(0x1000, 0x1000, 0);
+  overlap.addRange(0x1800, 0x1000, 1);
+  EXPECT_THROW(overlap.compile(), runtime_error);
+
+  AddressMap wrap("wrap");
+  wrap.addRange(UINT64_MAX - 0xff, 0x1000, 0);
+  EXPECT_THROW(wrap.compile(), runtime_error);
+
+  //The same target mapped twice is allowed, not two targets on the same range
+  AddressMap twice("twice");
+  twice.addRange(0x1000, 0x1000, 0);
+  twice.addRange(0x1000, 0x1000, 0);
+  twice.compile();
+  EXPECT_EQ(1u, twice.getRegionCount());
+  twice.addRange(0x1000, 0x1000, 1);
+  EXPECT_FALSE(twice.isCompiled());
+  EXPECT_THROW(twice.compile(), runtime_error);
+}
+
+TEST(AddressMap, dumpAll){
+  AddressMap map("dumped");
+  map.addRange(0x1000, 0x1000, 3, "uart");
+  AddressMap empty("empty");
+
+  stringstream ss;
+  AddressMap::DumpAll(ss);
+  EXPECT_TRUE(map.isCompiled());
+  EXPECT_NE(string::npos, ss.str().find("dumped"));
+  EXPECT_NE(string::npos, ss.str().find("0x0000000000001000 - 0x0000000000001fff  target 3  uart"));
+  EXPECT_EQ(string::npos, ss.str().find("empty"));
+}
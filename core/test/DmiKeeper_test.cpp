@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0 
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+
+#include <gtest/gtest.h>
+#include "DmiKeeper.hpp"
+
+using namespace vpsim;
+using namespace std;
+
+int sc_main(int argc, char* argv[])
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+static unsigned char mem0[0x1000];
+static unsigned char mem1[0x1000];
+
+TEST(DmiKeeper, lookup){
+  DmiKeeper dmi(2);
+  dmi.setDmiRange(0, 0x1000, 0x100, mem0);
+  dmi.setDmiRange(0, 0x3000, 0x100, mem1);
+
+  EXPECT_EQ(mem0, dmi.getDmi(0, 0x1000));
+  EXPECT_EQ(mem0 + 0xff, dmi.getDmi(0, 0x10ff));
+  EXPECT_EQ(mem1 + 0x10, dmi.getDmi(0, 0x3010));
+  EXPECT_EQ(nullptr, dmi.getDmi(0, 0x1100));
+  EXPECT_EQ(nullptr, dmi.getDmi(0, 0xfff));
+  EXPECT_EQ(nullptr, dmi.getDmi(0, 0x2000));
+
+  //Ports are independent
+  EXPECT_EQ(nullptr, dmi.getDmi(1, 0x1000));
+}
+
+TEST(DmiKeeper, lastHitDoesNotOutliveInvalidation){
+  DmiKeeper dmi(1);
+  dmi.setDmiRange(0, 0x1000, 0x100, mem0);
+  EXPECT_EQ(mem0 + 4, dmi.getDmi(0, 0x1004));
+
+  dmi.invalidateDmiRange(0, 0x1000, 0x10ff);
+  EXPECT_EQ(nullptr, dmi.getDmi(0, 0x1004));
+}
+
+TEST(DmiKeeper, mergeContiguous){
+  DmiKeeper dmi(1);
+  dmi.setDmiRange(0, 0x1000, 0x100, mem0);
+  dmi.setDmiRange(0, 0x1200, 0x100, mem0 + 0x200);
+  dmi.setDmiRange(0, 0x1100, 0x100, mem0 + 0x100);
+
+  auto regions = dmi.getDmiRegions(0);
+  ASSERT_EQ(1u, regions.size());
+  EXPECT_EQ(0x1000u, regions[0].base);
+  EXPECT_EQ(0x300u, regions[0].size);
+  EXPECT_EQ(mem0, regions[0].ptr);
+}
+
+TEST(DmiKeeper, noMergeWhenHostMemoryIsDiscontiguous){
+  DmiKeeper dmi(1);
+  dmi.setDmiRange(0, 0x1000, 0x100, mem0);
+  dmi.setDmiRange(0, 0x1100, 0x100, mem1);
+
+  EXPECT_EQ(2u, dmi.getDmiRegions(0).size());
+  EXPECT_EQ(mem0 + 0xff, dmi.getDmi(0, 0x10ff));
+  EXPECT_EQ(mem1, dmi.getDmi(0, 0x1100));
+}
+
+TEST(DmiKeeper, overlapReplacesAndSplits){
+  DmiKeeper dmi(1);
+  dmi.setDmiRange(0, 0x1000, 0x300, mem0);
+  dmi.setDmiRange(0, 0x1100, 0x100, mem1);
+
+  auto regions = dmi.getDmiRegions(0);
+  ASSERT_EQ(3u, regions.size());
+  EXPECT_EQ(0x1000u, regions[0].base);
+  EXPECT_EQ(0x100u, regions[0].size);
+  EXPECT_EQ(0x1100u, regions[1].base);
+  EXPECT_EQ(mem1, regions[1].ptr);
+  EXPECT_EQ(0x1200u, regions[2].base);
+  EXPECT_EQ(0x100u, regions[2].size);
+  EXPECT_EQ(mem0 + 0x200, regions[2].ptr);
+
+  EXPECT_EQ(mem0 + 0x50, dmi.getDmi(0, 0x1050));
+  EXPECT_EQ(mem1 + 0x50, dmi.getDmi(0, 0x1150));
+  EXPECT_EQ(mem0 + 0x250, dmi.getDmi(0, 0x1250));
+}
+
+TEST(DmiKeeper, overlapSeveralRegions){
+  DmiKeeper dmi(1);
+  dmi.setDmiRange(0, 0x1000, 0x100, mem0);
+  dmi.setDmiRange(0, 0x1200, 0x100, mem0 + 0x200);
+  dmi.setDmiRange(0, 0x1400, 0x100, mem0 + 0x400);
+  dmi.setDmiRange(0, 0x1080, 0x400, mem1);
+
+  auto regions = dmi.getDmiRegions(0);
+  ASSERT_EQ(3u, regions.size());
+  EXPECT_EQ(0x80u, regions[0].size);
+  EXPECT_EQ(0x1080u, regions[1].base);
+  EXPECT_EQ(0x400u, regions[1].size);
+  EXPECT_EQ(0x1480u, regions[2].base);
+  EXPECT_EQ(0x80u, regions[2].size);
+  EXPECT_EQ(mem0 + 0x480, regions[2].ptr);
+}
+
+TEST(DmiKeeper, invalidateSplits){
+  DmiKeeper dmi(1);
+  dmi.setDmiRange(0, 0x1000, 0x1000, mem0);
+  dmi.invalidateDmiRange(0, 0x1400, 0x17ff);
+
+  EXPECT_EQ(mem0 + 0x3ff, dmi.getDmi(0, 0x13ff));
+  EXPECT_EQ(nullptr, dmi.getDmi(0, 0x1400));
+  EXPECT_EQ(nullptr, dmi.getDmi(0, 0x17ff));
+  EXPECT_EQ(mem0 + 0x800, dmi.getDmi(0, 0x1800));
+  EXPECT_EQ(2u, dmi.getDmiRegions(0).size());
+}
+
+TEST(DmiKeeper, invalidateAllPorts){
+  DmiKeeper dmi(2);
+  dmi.setDmiRange(0, 0x1000, 0x100, mem0);
+  dmi.setDmiRange(1, 0x1000, 0x100, mem1);
+  dmi.invalidateDmiRange(0, UINT64_MAX);
+
+  EXPECT_TRUE(dmi.getDmiRegions(0).empty());
+  EXPECT_TRUE(dmi.getDmiRegions(1).empty());
+}
+
+TEST(DmiKeeper, overlaps){
+  DmiKeeper dmi(2);
+  dmi.setDmiRange(0, 0x1000, 0x1000, mem0);
+  dmi.setDmiRange(0, 0x4000, 0x100, mem1);
+
+  EXPECT_TRUE(dmi.overlapsDmiRange(0, 0x1fff, 0x2fff));
+  EXPECT_TRUE(dmi.overlapsDmiRange(0, 0x0, 0x1000));
+  EXPECT_TRUE(dmi.overlapsDmiRange(0, 0x0, UINT64_MAX));
+  EXPECT_TRUE(dmi.overlapsDmiRange(0, 0x1100, 0x1100));
+  EXPECT_FALSE(dmi.overlapsDmiRange(0, 0x2000, 0x3fff));
+  EXPECT_FALSE(dmi.overlapsDmiRange(0, 0x0, 0xfff));
+  EXPECT_FALSE(dmi.overlapsDmiRange(0, 0x4100, UINT64_MAX));
+  EXPECT_FALSE(dmi.overlapsDmiRange(1, 0x0, UINT64_MAX));
+  EXPECT_FALSE(dmi.overlapsDmiRange(0, 0x1800, 0x17ff));
+}
+
+TEST(DmiKeeper, topOfAddressSpace){
+  DmiKeeper dmi(1);
+  dmi.setDmiRange(0, UINT64_MAX - 0xff, 0x100, mem0);
+
+  EXPECT_EQ(mem0 + 0xff, dmi.getDmi(0, UINT64_MAX));
+  dmi.invalidateDmiRange(0, UINT64_MAX - 0xf, UINT64_MAX);
+  EXPECT_EQ(nullptr, dmi.getDmi(0, UINT64_MAX));
+  EXPECT_EQ(mem0 + 0xef, dmi.getDmi(0, UINT64_MAX - 0x10));
+}
@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0 
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+
+#include <gtest/gtest.h>
+#include "InitiatorIf.hpp"
+#include "TargetIf.hpp"
+#include "TlmCallbackPrivate.hpp"
+
+using namespace vpsim;
+using namespace sc_core;
+using namespace std;
+
+/*
+ * General comments
+ * Modules cannot be instantiated once the elaboration is over, so the
+ * platform is built once in sc_main and shared by every test.
+ * Each test starts by invalidating all DMI regions of the initiator.
+ */
+
+class TestMemory : public sc_module, public TargetIf<unsigned char>
+{
+	typedef TestMemory this_type;
+
+public:
+	uint64_t mTransportCount;
+
+	TestMemory(sc_module_name name, uint64_t base, uint64_t size):
+		sc_module(name),
+		TargetIf<unsigned char>(string(name), size, false, true),
+		mTransportCount(0)
+	{
+		setBaseAddress(base);
+		setSize(size);
+		setCyclesPerRead(3);
+		setCyclesPerWrite(5);
+		RegisterReadAccess(REGISTER(this_type, read));
+		RegisterWriteAccess(REGISTER(this_type, write));
+	}
+
+	tlm::tlm_response_status read(payload_t& payload, sc_time& delay) {
+		mTransportCount++;
+		memcpy(payload.ptr, getLocalMem() + payload.addr - getBaseAddress(), payload.len);
+		delay += sc_time(10, SC_NS);
+		payload.dmi = true;
+		return tlm::TLM_OK_RESPONSE;
+	}
+
+	tlm::tlm_response_status write(payload_t& payload, sc_time& delay) {
+		mTransportCount++;
+		memcpy(getLocalMem() + payload.addr - getBaseAddress(), payload.ptr, payload.len);
+		delay += sc_time(10, SC_NS);
+		payload.dmi = true;
+		return tlm::TLM_OK_RESPONSE;
+	}
+};
+
+//Hints that DMI is allowed on the first half of its range only, and leaves the hint untouched elsewhere
+class HalfDmiTarget : public sc_module
+{
+public:
+	tlm_utils::simple_target_socket<HalfDmiTarget> socket;
+	unsigned char mem[0x1000];
+	uint64_t mDmiRequestCount;
+
+	HalfDmiTarget(sc_module_name name): sc_module(name), socket("socket"), mDmiRequestCount(0) {
+		socket.register_b_transport(this, &HalfDmiTarget::b_transport);
+		socket.register_get_direct_mem_ptr(this, &HalfDmiTarget::get_direct_mem_ptr);
+	}
+
+	void b_transport(tlm::tlm_generic_payload& trans, sc_time& delay) {
+		if (trans.get_address() < 0x800) trans.set_dmi_allowed(true);
+		trans.set_response_status(tlm::TLM_OK_RESPONSE);
+	}
+
+	bool get_direct_mem_ptr(tlm::tlm_generic_payload& trans, tlm::tlm_dmi& dmi) {
+		mDmiRequestCount++;
+		if (trans.get_address() >= 0x800) return false;
+		dmi.set_dmi_ptr(mem);
+		dmi.set_start_address(0);
+		dmi.set_end_address(0x7ff);
+		dmi.allow_read_write();
+		return true;
+	}
+};
+
+class TestInitiator : public sc_module, public InitiatorIf
+{
+public:
+	TestInitiator(sc_module_name name):
+		sc_module(name),
+		InitiatorIf(string(name), 0, true, 3)
+	{}
+};
+
+static TestInitiator* initiator;
+static TestMemory* mem0;
+static TestMemory* mem1;
+static HalfDmiTarget* halfDmi;
+
+int sc_main(int argc, char* argv[])
+{
+	testing::InitGoogleTest(&argc, argv);
+
+	initiator = new TestInitiator("initiator");
+	mem0 = new TestMemory("mem0", 0x1000, 0x1000);
+	mem1 = new TestMemory("mem1", 0x8000, 0x1000);
+	halfDmi = new HalfDmiTarget("halfDmi");
+	initiator->getInitiatorSocket()[0]->bind(mem0->mTargetSocket);
+	initiator->getInitiatorSocket()[1]->bind(mem1->mTargetSocket);
+	initiator->getInitiatorSocket()[2]->bind(halfDmi->socket);
+	sc_start(SC_ZERO_TIME);
+
+	return RUN_ALL_TESTS();
+}
+
+class InitiatorIfDmi : public testing::Test {
+protected:
+	void SetUp() override {
+		initiator->setForceLt(false);
+		initiator->invalidate_direct_mem_ptr(0, UINT64_MAX);
+	}
+};
+
+TEST_F(InitiatorIfDmi, secondAccessUsesDmi){
+	uint32_t value = 0xdeadbeef, readBack = 0;
+	sc_time delay = SC_ZERO_TIME;
+
+	uint64_t transports = mem0->mTransportCount;
+	uint64_t dmiAccesses = initiator->getDmiAccessCount();
+
+	EXPECT_EQ(tlm::TLM_OK_RESPONSE, initiator->target_mem_access(0, 0x1010, 4, (unsigned char*)&value, WRITE, delay));
+	EXPECT_EQ(transports + 1, mem0->mTransportCount);
+	EXPECT_EQ(sc_time(10, SC_NS), delay);
+
+	delay = SC_ZERO_TIME;
+	EXPECT_EQ(tlm::TLM_OK_RESPONSE, initiator->target_mem_access(0, 0x1010, 4, (unsigned char*)&readBack, READ, delay));
+	EXPECT_EQ(transports + 1, mem0->mTransportCount);
+	EXPECT_EQ(dmiAccesses + 1, initiator->getDmiAccessCount());
+	EXPECT_EQ(value, readBack);
+	//Granted latency is annotated instead of the b_transport one
+	EXPECT_EQ(sc_time(3, SC_NS), delay);
+
+	delay = SC_ZERO_TIME;
+	value = 0x12345678;
+	EXPECT_EQ(tlm::TLM_OK_RESPONSE, initiator->target_mem_access(0, 0x1ffc, 4, (unsigned char*)&value, WRITE, delay));
+	EXPECT_EQ(transports + 1, mem0->mTransportCount);
+	EXPECT_EQ(sc_time(5, SC_NS), delay);
+	EXPECT_EQ(0, memcmp(&value, mem0->getLocalMem() + 0xffc, 4));
+}
+
+TEST_F(InitiatorIfDmi, forceLtDisablesDmi){
+	uint32_t value = 0;
+	sc_time delay = SC_ZERO_TIME;
+	initiator->setForceLt(true);
+
+	uint64_t transports = mem0->mTransportCount;
+	initiator->target_mem_access(0, 0x1000, 4, (unsigned char*)&value, READ, delay);
+	initiator->target_mem_access(0, 0x1000, 4, (unsigned char*)&value, READ, delay);
+	EXPECT_EQ(transports + 2, mem0->mTransportCount);
+}
+
+TEST_F(InitiatorIfDmi, invalidationOnlyDropsAffectedRegions){
+	uint32_t value = 0;
+	sc_time delay = SC_ZERO_TIME;
+
+	//Get a region on each port
+	initiator->target_mem_access(0, 0x1000, 4, (unsigned char*)&value, READ, delay);
+	initiator->target_mem_access(1, 0x8000, 4, (unsigned char*)&value, READ, delay);
+
+	uint64_t transports0 = mem0->mTransportCount;
+	uint64_t transports1 = mem1->mTransportCount;
+
+	mem0->mTargetSocket->invalidate_direct_mem_ptr(0x1100, 0x11ff);
+
+	initiator->target_mem_access(0, 0x1000, 4, (unsigned char*)&value, READ, delay);
+	initiator->target_mem_access(1, 0x8000, 4, (unsigned char*)&value, READ, delay);
+	EXPECT_EQ(transports0 + 1, mem0->mTransportCount);
+	EXPECT_EQ(transports1, mem1->mTransportCount);
+
+	//The region of mem0 was granted again by the last access
+	initiator->target_mem_access(0, 0x1000, 4, (unsigned char*)&value, READ, delay);
+	EXPECT_EQ(transports0 + 1, mem0->mTransportCount);
+}
+
+TEST_F(InitiatorIfDmi, accessCrossingRegionEndUsesTransport){
+	uint64_t value = 0;
+	sc_time delay = SC_ZERO_TIME;
+
+	initiator->target_mem_access(0, 0x1000, 4, (unsigned char*)&value, READ, delay);
+	uint64_t transports = mem0->mTransportCount;
+
+	//Out of the granted region: must not be served from the DMI pointer
+	EXPECT_EQ(tlm::TLM_ADDRESS_ERROR_RESPONSE,
+			initiator->target_mem_access(0, 0x1ffc, 8, (unsigned char*)&value, READ, delay));
+	EXPECT_EQ(transports, mem0->mTransportCount);
+}
+
+TEST_F(InitiatorIfDmi, dmiHintIsNotCarriedOver){
+	uint32_t value = 0;
+	sc_time delay = SC_ZERO_TIME;
+	uint64_t requests = halfDmi->mDmiRequestCount;
+
+	//The hinted access gets its region
+	initiator->target_mem_access(2, 0x000, 4, (unsigned char*)&value, READ, delay);
+	EXPECT_EQ(requests + 1, halfDmi->mDmiRequestCount);
+
+	//The port payload is reused: the hint of the previous access must not trigger a request
+	initiator->target_mem_access(2, 0x800, 4, (unsigned char*)&value, READ, delay);
+	initiator->target_mem_access(2, 0x900, 4, (unsigned char*)&value, WRITE, delay);
+	EXPECT_EQ(requests + 1, halfDmi->mDmiRequestCount);
+}
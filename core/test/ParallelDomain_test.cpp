@@ -0,0 +1,212 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+
+#include <gtest/gtest.h>
+#include "ParallelDomain.hpp"
+#include "quantum.hpp"
+#include "log.hpp"
+#include <deque>
+#include <sstream>
+
+using namespace vpsim;
+using namespace sc_core;
+using namespace std;
+
+/*
+ * General comments
+ * Each workload runs CLUSTERS clusters in a domain of its own. A cluster
+ * annotates pseudo-random steps of local time, drawn from a generator seeded
+ * with SEED and its index, and now and then updates a state shared with the
+ * other clusters of its workload, logging what it did. The same workload runs
+ * on a single host thread and on one host thread per cluster: in ordered mode
+ * both runs must log the same shared accesses.
+ * Another workload logs from every cluster at once, through a Logger.
+ */
+
+static const unsigned CLUSTERS = 8;
+static const unsigned ITERATIONS = 2000;
+static const unsigned QUANTUM_NS = 500;
+static const uint64_t SEED = 42;
+
+struct SharedAccess {
+	sc_time time;
+	unsigned cluster;
+	uint64_t value;
+
+	bool operator==(const SharedAccess& other) const {
+		return time == other.time && cluster == other.cluster && value == other.value;
+	}
+};
+
+class Workload
+{
+public:
+	ParallelDomain domain;
+	deque<ParallelQuantumKeeper> keepers;
+	vector<sc_time> finalTimes;
+	vector<uint64_t> privateStates;
+
+	//shared between the clusters
+	uint64_t sharedState;
+	vector<SharedAccess> log;
+
+	Workload(const char* name, unsigned hostThreads, bool ordered):
+		domain(name, sc_time(QUANTUM_NS, SC_NS), hostThreads),
+		finalTimes(CLUSTERS),
+		privateStates(CLUSTERS),
+		sharedState(0)
+	{
+		domain.setOrdered(ordered);
+		for (unsigned c = 0; c < CLUSTERS; c++) {
+			keepers.emplace_back();
+			unsigned id = domain.addCluster([this, c]{ run(c); });
+			keepers.back().setParallelDomain(&domain, id);
+		}
+	}
+
+	void run(unsigned c) {
+		ParallelQuantumKeeper& keeper = keepers[c];
+		uint64_t rng = SEED * 0x9E3779B97F4A7C15ull + c + 1;
+		uint64_t state = c;
+
+		for (unsigned i = 0; i < ITERATIONS; i++) {
+			rng = rng * 6364136223846793005ull + 1442695040888963407ull;
+			keeper += sc_time(1 + (rng >> 33) % 20, SC_NS);
+			keeper.sync();
+
+			if ((rng >> 20) % 4 == 0) {
+				domain.lockShared(c, keeper.get_current_time());
+				sharedState = sharedState * 31 + c + i;
+				state ^= sharedState;
+				log.push_back({ keeper.get_current_time(), c, sharedState });
+				domain.unlockShared(c);
+			}
+		}
+		finalTimes[c] = keeper.get_current_time();
+		privateStates[c] = state;
+	}
+};
+
+//Each cluster writes a line per iteration, lines must come out whole
+static ostringstream clusterLog;
+
+class LoggingWorkload : public Logger
+{
+public:
+	ParallelDomain domain;
+	deque<ParallelQuantumKeeper> keepers;
+
+	LoggingWorkload(const char* name):
+		Logger(name, clusterLog),
+		domain(name, sc_time(QUANTUM_NS, SC_NS), 0)
+	{
+		for (unsigned c = 0; c < CLUSTERS; c++) {
+			keepers.emplace_back();
+			unsigned id = domain.addCluster([this, c]{ run(c); });
+			keepers.back().setParallelDomain(&domain, id);
+		}
+	}
+
+	void run(unsigned c) {
+		for (unsigned i = 0; i < ITERATIONS; i++) {
+			keepers[c] += sc_time(1, SC_NS);
+			keepers[c].sync();
+			LOG_INFO << "cluster " << c << " iteration " << i << " done" << endl;
+		}
+	}
+};
+
+static Workload* serial;
+static Workload* parallel;
+static Workload* unordered;
+static LoggingWorkload* logging;
+
+int sc_main(int argc, char* argv[])
+{
+	testing::InitGoogleTest(&argc, argv);
+
+	serial = new Workload("serial", 1, true);
+	parallel = new Workload("parallel", 0, true);
+	unordered = new Workload("unordered", 0, false);
+	logging = new LoggingWorkload("logging");
+	LoggerCore::get().enableLogging(true);
+	sc_start();
+	LoggerCore::get().enableLogging(false);
+
+	return RUN_ALL_TESTS();
+}
+
+TEST(ParallelDomain, deterministic){
+	ASSERT_FALSE(serial->log.empty());
+	EXPECT_EQ(serial->log.size(), parallel->log.size());
+	EXPECT_TRUE(serial->log == parallel->log);
+	EXPECT_EQ(serial->privateStates, parallel->privateStates);
+	EXPECT_EQ(serial->finalTimes, parallel->finalTimes);
+}
+
+TEST(ParallelDomain, orderedAccesses){
+	const vector<SharedAccess>& log = parallel->log;
+	for (size_t i = 1; i < log.size(); i++) {
+		bool ordered = log[i - 1].time < log[i].time ||
+				(log[i - 1].time == log[i].time && log[i - 1].cluster <= log[i].cluster);
+		EXPECT_TRUE(ordered) << i;
+	}
+	EXPECT_EQ(log.size(), parallel->domain.getSharedAccessCount());
+}
+
+TEST(ParallelDomain, unorderedExclusive){
+	//Host order may differ, but no access is lost
+	EXPECT_EQ(parallel->log.size(), unordered->log.size());
+	EXPECT_EQ(parallel->finalTimes, unordered->finalTimes);
+}
+
+TEST(ParallelDomain, quantumBarriers){
+	const sc_time quantum(QUANTUM_NS, SC_NS);
+	uint64_t quanta = 0;
+	for (unsigned c = 0; c < CLUSTERS; c++) {
+		ParallelQuantumKeeper& keeper = parallel->keepers[c];
+		uint64_t crossed = parallel->finalTimes[c].value() / quantum.value();
+		quanta = max(quanta, crossed);
+		EXPECT_EQ(crossed, keeper.getSyncCount()) << c;
+		EXPECT_LT(keeper.get_local_time(), quantum) << c;
+	}
+	EXPECT_EQ(quanta, parallel->domain.getQuantumCount());
+}
+
+TEST(ParallelDomain, configuration){
+	EXPECT_THROW(parallel->domain.addCluster([]{}), runtime_error);
+	EXPECT_THROW(parallel->domain.setOrdered(false), runtime_error);
+	EXPECT_EQ(CLUSTERS, parallel->domain.getClusterCount());
+	EXPECT_TRUE(parallel->domain.getOrdered());
+	EXPECT_FALSE(unordered->domain.getOrdered());
+}
+
+TEST(ParallelDomain, logging){
+	istringstream lines(clusterLog.str());
+	vector<unsigned> iterations(CLUSTERS);
+	string line;
+	while (getline(lines, line)) {
+		unsigned c = CLUSTERS, i = 0;
+		char done[5] = "";
+		ASSERT_EQ(3, sscanf(line.c_str(), "[Info] cluster %u iteration %u %4s", &c, &i, done)) << line;
+		ASSERT_LT(c, CLUSTERS) << line;
+		EXPECT_STREQ("done", done) << line;
+		//The lines of a cluster keep their order
+		EXPECT_EQ(iterations[c]++, i) << line;
+	}
+	EXPECT_EQ(vector<unsigned>(CLUSTERS, ITERATIONS), iterations);
+}
@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0 
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+
+#include <gtest/gtest.h>
+#include "TargetIf.hpp"
+#include <fstream>
+#include <unistd.h>
+
+using namespace vpsim;
+using namespace sc_core;
+using namespace std;
+
+/*
+ * General comments
+ * The targets are not bound to anything: only their local memory is used.
+ * The declared sizes are much larger than what the tests touch, so that a
+ * sparse memory stays far below its declared size once accessed.
+ * TargetIf owns a target socket, hence each target is a module, built in
+ * sc_main before the tests run.
+ */
+
+static const uint64_t LARGE_SIZE = 8ULL << 30;
+static const uint64_t SMALL_SIZE = 64ULL << 20;
+
+class TestTarget : public sc_module, public TargetIf<unsigned char>
+{
+public:
+  TestTarget(sc_module_name name, uint64_t size, bool sparse):
+    sc_module(name),
+    TargetIf<unsigned char>(string(name), size, false, true, sparse)
+  {
+  }
+};
+
+static TestTarget* startupMem;
+static TestTarget* residentMem;
+static TestTarget* eagerMem;
+static TestTarget* imageMem;
+
+int sc_main(int argc, char* argv[])
+{
+  testing::InitGoogleTest(&argc, argv);
+
+  startupMem = new TestTarget("testTargetIfSparseStartup", LARGE_SIZE, true);
+  residentMem = new TestTarget("testTargetIfSparseResident", LARGE_SIZE, true);
+  eagerMem = new TestTarget("testTargetIfSparseEager", SMALL_SIZE, false);
+  imageMem = new TestTarget("testTargetIfSparseImage", SMALL_SIZE, true);
+
+  return RUN_ALL_TESTS();
+}
+
+TEST(TargetIfSparse, startup){
+  TestTarget& mem = *startupMem;
+
+  EXPECT_TRUE(mem.getSparseMem());
+  EXPECT_NE(nullptr, mem.getLocalMem());
+  EXPECT_EQ(0u, mem.getResidentBytes());
+}
+
+TEST(TargetIfSparse, residentBytes){
+  TestTarget& mem = *residentMem;
+  const uint64_t pageSize = sysconf(_SC_PAGESIZE);
+
+  //Untouched pages read as zero
+  EXPECT_EQ(0, mem.getLocalMem()[LARGE_SIZE / 2]);
+
+  //Touch one byte in a few distant pages
+  mem.getLocalMem()[0] = 0x12;
+  mem.getLocalMem()[LARGE_SIZE / 3] = 0x34;
+  mem.getLocalMem()[LARGE_SIZE - 1] = 0x56;
+
+  EXPECT_EQ(0x12, mem.getLocalMem()[0]);
+  EXPECT_EQ(0x34, mem.getLocalMem()[LARGE_SIZE / 3]);
+  EXPECT_EQ(0x56, mem.getLocalMem()[LARGE_SIZE - 1]);
+
+  //A handful of pages, whatever the host page size or transparent huge pages
+  EXPECT_GE(mem.getResidentBytes(), 3 * pageSize);
+  EXPECT_LT(mem.getResidentBytes(), 64ULL << 20);
+}
+
+TEST(TargetIfSparse, eager){
+  TestTarget& mem = *eagerMem;
+  memset(mem.getLocalMem(), 0, SMALL_SIZE);
+
+  EXPECT_FALSE(mem.getSparseMem());
+  EXPECT_EQ(SMALL_SIZE, mem.getResidentBytes());
+}
+
+TEST(TargetIfSparse, mappedImage){
+  TestTarget& mem = *imageMem;
+  const uint64_t pageSize = sysconf(_SC_PAGESIZE);
+  const string imageName = "TargetIfSparse_test_image.bin";
+
+  vector<unsigned char> image(SMALL_SIZE / 4);
+  for (size_t i = 0; i < image.size(); i++)
+    image[i] = (unsigned char)(i * 13 + 5);
+  ofstream(imageName, ios::binary).write((const char*) image.data(), image.size());
+  ASSERT_EQ(image.size(), mem.MapLocalMemFile(imageName, 0, 0));
+
+  //Reading the whole image only maps page cache pages, owned by the file
+  unsigned sum = 0;
+  for (size_t i = 0; i < image.size(); i += pageSize)
+    sum += mem.getLocalMem()[i];
+  EXPECT_NE(0u, sum);
+  EXPECT_EQ(0u, mem.getResidentBytes());
+
+  //A write copies its page
+  mem.getLocalMem()[pageSize + 1] ^= 0xff;
+  EXPECT_EQ(pageSize, mem.getResidentBytes());
+
+  unlink(imageName.c_str());
+}
@@ -0,0 +1,290 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+
+#include <gtest/gtest.h>
+#include "quantum.hpp"
+
+using namespace vpsim;
+using namespace sc_core;
+using namespace std;
+
+/*
+ * General comments
+ * Workers emulate LT initiators: they annotate a fixed step of local time
+ * and call sync() after each step. They all run to completion in sc_main,
+ * the tests then check what they recorded.
+ */
+
+static const unsigned QUANTUM_NS = 100;
+
+class Worker : public sc_module
+{
+public:
+	ParallelQuantumKeeper keeper;
+	sc_time step;
+	unsigned iterations;
+	sc_time externalWait; //!< waited outside of the keeper halfway through, if not zero
+
+	vector<sc_time> resumes; //!< time stamps at which the thread resumed from a sync
+	sc_time endStamp;
+	sc_time finalTime;
+
+	SC_HAS_PROCESS(Worker);
+
+	Worker(sc_module_name name, QuantumSyncMode mode, sc_time step, unsigned iterations, sc_time externalWait = SC_ZERO_TIME):
+		sc_module(name),
+		keeper(QUANTUM_NS),
+		step(step),
+		iterations(iterations),
+		externalWait(externalWait)
+	{
+		keeper.setSyncMode(mode);
+		SC_THREAD(run);
+	}
+
+	void run() {
+		keeper.reset();
+		for (unsigned i = 0; i < iterations; i++) {
+			keeper += step;
+			uint32_t syncs = keeper.getTotalSyncCount();
+			keeper.sync();
+			if (keeper.getTotalSyncCount() != syncs) resumes.push_back(sc_time_stamp());
+
+			if (externalWait != SC_ZERO_TIME && i == iterations / 2) {
+				//e.g. waiting for an interrupt: the next sync point goes stale
+				keeper.forceSync();
+				wait(externalWait);
+			}
+		}
+		endStamp = sc_time_stamp();
+		finalTime = keeper.get_current_time();
+	}
+};
+
+/*
+ * Ping-pong between two initiators through shared variables, in bursts of
+ * MESSAGES round trips separated by quiet phases. The same exchange runs
+ * with a small fixed quantum as a reference, and with an adaptive quantum
+ * that grows during the quiet phases. Only the adaptive initiators notify
+ * their interactions, not to disturb the reference.
+ */
+
+static const unsigned MAX_QUANTUM_NS = QUANTUM_NS << 6;
+static const sc_time PING_STEP(10, SC_NS);
+static const unsigned QUIET_STEPS = 2000;
+static const unsigned BURSTS = 4;
+static const unsigned MESSAGES = 20;
+
+struct Mailbox {
+	unsigned ping = 0;
+	unsigned pong = 0;
+	bool done = false;
+};
+
+class PingPong : public sc_module
+{
+public:
+	ParallelQuantumKeeper keeper;
+	Mailbox& box;
+	bool pinger;
+	bool adaptive;
+
+	vector<sc_time> roundTrips; //!< in local time, for the pinger
+	sc_time finalTime;
+
+	SC_HAS_PROCESS(PingPong);
+
+	PingPong(sc_module_name name, Mailbox& box, bool pinger, bool adaptive):
+		sc_module(name),
+		keeper(QUANTUM_NS),
+		box(box),
+		pinger(pinger),
+		adaptive(adaptive)
+	{
+		keeper.setSyncMode(QUANTUM_SYNC_ALIGNED);
+		if (adaptive) keeper.setAdaptiveQuantum(sc_time(QUANTUM_NS, SC_NS), sc_time(MAX_QUANTUM_NS, SC_NS));
+		SC_THREAD(run);
+	}
+
+	void step() {
+		keeper += PING_STEP;
+		keeper.sync();
+	}
+
+	void interact() {
+		if (adaptive) ParallelQuantumKeeper::notifyInteraction();
+	}
+
+	void run() {
+		keeper.reset();
+		if (pinger) {
+			for (unsigned b = 0; b < BURSTS; b++) {
+				for (unsigned i = 0; i < QUIET_STEPS; i++) step();
+				for (unsigned m = 0; m < MESSAGES; m++) {
+					sc_time sent = keeper.get_current_time();
+					box.ping++;
+					interact();
+					while (box.pong != box.ping) step();
+					roundTrips.push_back(keeper.get_current_time() - sent);
+				}
+			}
+			box.done = true;
+		} else {
+			while (!box.done) {
+				step();
+				if (box.pong != box.ping) {
+					box.pong = box.ping;
+					interact();
+				}
+			}
+		}
+		finalTime = keeper.get_current_time();
+	}
+};
+
+static Worker* aligned;
+static Worker* unaligned;
+static Worker* alignedLargeStep;
+static Worker* alignedStale;
+static Mailbox referenceBox, adaptiveBox;
+static PingPong* referencePinger;
+static PingPong* referencePonger;
+static PingPong* adaptivePinger;
+static PingPong* adaptivePonger;
+
+int sc_main(int argc, char* argv[])
+{
+	testing::InitGoogleTest(&argc, argv);
+
+	aligned = new Worker("aligned", QUANTUM_SYNC_ALIGNED, sc_time(30, SC_NS), 100);
+	unaligned = new Worker("unaligned", QUANTUM_SYNC_UNALIGNED, sc_time(30, SC_NS), 100);
+	alignedLargeStep = new Worker("alignedLargeStep", QUANTUM_SYNC_ALIGNED, sc_time(250, SC_NS), 10);
+	alignedStale = new Worker("alignedStale", QUANTUM_SYNC_ALIGNED, sc_time(30, SC_NS), 100, sc_time(1234, SC_NS));
+	referencePinger = new PingPong("referencePinger", referenceBox, true, false);
+	referencePonger = new PingPong("referencePonger", referenceBox, false, false);
+	adaptivePinger = new PingPong("adaptivePinger", adaptiveBox, true, true);
+	adaptivePonger = new PingPong("adaptivePonger", adaptiveBox, false, true);
+	sc_start();
+
+	return RUN_ALL_TESTS();
+}
+
+static bool onBoundary(const sc_time& t) {
+	return t.value() % sc_time(QUANTUM_NS, SC_NS).value() == 0;
+}
+
+TEST(ParallelQuantumKeeper, alignedResumesOnBoundaries){
+	EXPECT_FALSE(aligned->resumes.empty());
+	for (const sc_time& t : aligned->resumes) EXPECT_TRUE(onBoundary(t)) << t;
+	EXPECT_EQ(aligned->resumes.size(), aligned->keeper.getSyncCount());
+	EXPECT_EQ(0u, aligned->keeper.getForceSyncCount());
+	EXPECT_EQ(sc_time(3000, SC_NS), aligned->finalTime);
+}
+
+TEST(ParallelQuantumKeeper, unalignedForcesSyncs){
+	bool offBoundary = false;
+	for (const sc_time& t : unaligned->resumes) offBoundary = offBoundary || !onBoundary(t);
+	EXPECT_TRUE(offBoundary);
+	EXPECT_EQ(unaligned->resumes.size(), unaligned->keeper.getForceSyncCount());
+	EXPECT_EQ(0u, unaligned->keeper.getSyncCount());
+	EXPECT_EQ(sc_time(3000, SC_NS), unaligned->finalTime);
+}
+
+TEST(ParallelQuantumKeeper, alignedWaitsOncePerSync){
+	//Every step exceeds the quantum: one wait per sync, the remainder stays local
+	EXPECT_EQ(10u, alignedLargeStep->keeper.getSyncCount());
+	for (const sc_time& t : alignedLargeStep->resumes) EXPECT_TRUE(onBoundary(t)) << t;
+	EXPECT_EQ(sc_time(2500, SC_NS), alignedLargeStep->finalTime);
+	EXPECT_EQ(sc_time(2500, SC_NS), alignedLargeStep->endStamp + alignedLargeStep->keeper.get_local_time());
+}
+
+TEST(ParallelQuantumKeeper, alignedAfterExternalWait){
+	EXPECT_EQ(sc_time(3000 + 1234, SC_NS), alignedStale->finalTime);
+	for (size_t i = 1; i < alignedStale->resumes.size(); i++)
+		EXPECT_LE(alignedStale->resumes[i - 1], alignedStale->resumes[i]);
+	EXPECT_EQ(1u, alignedStale->keeper.getForceSyncCount());
+}
+
+TEST(ParallelQuantumKeeper, waitTime){
+	//The threads only wait in their keeper
+	EXPECT_EQ(aligned->endStamp, aligned->keeper.getSyncWaitTime());
+	EXPECT_EQ(unaligned->endStamp, unaligned->keeper.getSyncWaitTime());
+	EXPECT_GE(aligned->keeper.getSyncWaitHostTime(), 0.0);
+}
+
+TEST(ParallelQuantumKeeper, syncModes){
+	EXPECT_EQ(QUANTUM_SYNC_ALIGNED, ParallelQuantumKeeper::parseSyncMode("aligned"));
+	EXPECT_EQ(QUANTUM_SYNC_UNALIGNED, ParallelQuantumKeeper::parseSyncMode("unaligned"));
+	EXPECT_THROW(ParallelQuantumKeeper::parseSyncMode("sometimes"), runtime_error);
+
+	QuantumSyncMode previous = ParallelQuantumKeeper::getDefaultSyncMode();
+	ParallelQuantumKeeper::setDefaultSyncMode(QUANTUM_SYNC_ALIGNED);
+	ParallelQuantumKeeper keeper;
+	EXPECT_EQ(QUANTUM_SYNC_ALIGNED, keeper.getSyncMode());
+	ParallelQuantumKeeper::setDefaultSyncMode(previous);
+}
+
+TEST(ParallelQuantumKeeper, adaptiveBounds){
+	ParallelQuantumKeeper keeper;
+	EXPECT_FALSE(keeper.getAdaptiveQuantum());
+	EXPECT_THROW(keeper.setAdaptiveQuantum(SC_ZERO_TIME, sc_time(1, SC_US)), runtime_error);
+	EXPECT_THROW(keeper.setAdaptiveQuantum(sc_time(1, SC_US), sc_time(100, SC_NS)), runtime_error);
+
+	//The maximum is rounded down to the minimum times a power of two
+	keeper.setAdaptiveQuantum(sc_time(100, SC_NS), sc_time(1000, SC_NS));
+	EXPECT_TRUE(keeper.getAdaptiveQuantum());
+	EXPECT_EQ(sc_time(100, SC_NS), keeper.getQuantum());
+	EXPECT_EQ(4u, keeper.getQuantumLevelTime().size());
+}
+
+TEST(ParallelQuantumKeeper, adaptiveGrowsWhenQuiet){
+	const vector<sc_time>& times = adaptivePinger->keeper.getQuantumLevelTime();
+	ASSERT_EQ(7u, times.size());
+	EXPECT_GT(times.back(), SC_ZERO_TIME);
+	EXPECT_GT(times.front(), SC_ZERO_TIME);
+	EXPECT_GE(adaptivePinger->keeper.getQuantumChangeCount(), 2 * BURSTS);
+	EXPECT_GT(adaptivePinger->keeper.getAverageQuantum(), sc_time(QUANTUM_NS, SC_NS));
+	EXPECT_EQ(sc_time(QUANTUM_NS, SC_NS), referencePinger->keeper.getAverageQuantum());
+
+	//Far fewer syncs than with the small fixed quantum
+	EXPECT_LT(2 * adaptivePinger->keeper.getTotalSyncCount(), referencePinger->keeper.getTotalSyncCount());
+	EXPECT_LT(2 * adaptivePonger->keeper.getTotalSyncCount(), referencePonger->keeper.getTotalSyncCount());
+}
+
+TEST(ParallelQuantumKeeper, adaptiveTimingError){
+	const sc_time minQuantum(QUANTUM_NS, SC_NS), maxQuantum(MAX_QUANTUM_NS, SC_NS);
+	ASSERT_EQ(BURSTS * MESSAGES, referencePinger->roundTrips.size());
+	ASSERT_EQ(BURSTS * MESSAGES, adaptivePinger->roundTrips.size());
+
+	//Only the first round trip of a burst sees a large quantum, the next ones are as
+	//accurate as with the small fixed quantum
+	sc_time error = SC_ZERO_TIME;
+	for (unsigned i = 0; i < BURSTS * MESSAGES; i++) {
+		const sc_time& reference = referencePinger->roundTrips[i];
+		const sc_time& adaptive = adaptivePinger->roundTrips[i];
+		EXPECT_LE(reference, 8 * minQuantum) << i;
+		if (i % MESSAGES == 0) EXPECT_LE(adaptive, 4 * maxQuantum) << i;
+		else EXPECT_LE(adaptive, 8 * minQuantum) << i;
+		error += adaptive > reference ? adaptive - reference : reference - adaptive;
+	}
+
+	const sc_time bound = BURSTS * 4 * maxQuantum + BURSTS * (MESSAGES - 1) * 8 * minQuantum;
+	EXPECT_LE(error, bound);
+	const sc_time& reference = referencePinger->finalTime;
+	const sc_time& adaptive = adaptivePinger->finalTime;
+	EXPECT_LE(adaptive > reference ? adaptive - reference : reference - adaptive, bound);
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2024 Commissariat à l'énergie atomique et aux énergies alternatives (CEA)
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ *    http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include "quantum.hpp"
+#include "log.hpp"
+#include "platform_builder/xmlConfigParser.hpp"
+
+using namespace vpsim;
+using namespace sc_core;
+using namespace std;
+
+int sc_main(int argc, char* argv[])
+{
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
+
+//Writes a python generated platform without IPs, @return its file name
+static string writeXml(const string& simulation)
+{
+	string name = "xmlConfigParser_test.xml";
+	ofstream xml(name);
+	xml << "<vpsim source=\"python\">"
+		<< "<platform><ips></ips><links></links></platform>"
+		<< "<simulation>" << simulation << "</simulation>"
+		<< "</vpsim>";
+	return name;
+}
+
+TEST(XmlConfigParser, quantumSync){
+	QuantumSyncMode previous = ParallelQuantumKeeper::getDefaultSyncMode();
+	ParallelQuantumKeeper::setDefaultSyncMode(QUANTUM_SYNC_UNALIGNED);
+
+	//The keepers of the IPs are built by the platform node, before the simulation node is read
+	ParallelQuantumKeeper keeper;
+	ParallelQuantumKeeper unaligned;
+	unaligned.setSyncMode(QUANTUM_SYNC_UNALIGNED);
+
+	string name = writeXml("<quantumSync>aligned</quantumSync>");
+	XmlConfigParser(name).read();
+	remove(name.c_str());
+
+	EXPECT_EQ(QUANTUM_SYNC_ALIGNED, keeper.getSyncMode());
+	EXPECT_EQ(QUANTUM_SYNC_ALIGNED, ParallelQuantumKeeper().getSyncMode());
+	//A mode set on the keeper itself wins over the platform one
+	EXPECT_EQ(QUANTUM_SYNC_UNALIGNED, unaligned.getSyncMode());
+
+	ParallelQuantumKeeper::setDefaultSyncMode(previous);
+}
+
+TEST(XmlConfigParser, debugLog){
+	string name = writeXml("<log>enable</log><debugLog>disable</debugLog>");
+	XmlConfigParser(name).read();
+	EXPECT_TRUE(LoggerCore::get().loggingEnabled());
+	EXPECT_FALSE(LoggerCore::get().debugLoggingEnabled());
+	EXPECT_FALSE(Logger::sDebugLogging);
+
+	name = writeXml("<log>disable</log><debugLog>enable</debugLog>");
+	XmlConfigParser(name).read();
+	remove(name.c_str());
+	EXPECT_TRUE(LoggerCore::get().debugLoggingEnabled());
+	EXPECT_FALSE(Logger::sDebugLogging);
+}
@@ -14,6 +14,8 @@
  * limitations under the License.
 */
 
+#include <algorithm>
+#include <iterator>
 #include "ForwardSimpleSocket.hpp"
 
 using namespace std;
@@ -27,41 +29,43 @@ void ForwardSimpleSocket::b_transport(tlm_generic_payload &trans, sc_time &delay
     auto start = trans.get_address();
     auto length = trans.get_data_length();
     auto end = start + length - 1;
-    auto blockingTLM = mVpsimModule->getBlockingTLMEnabled(mPortNum, start);
+    auto blockingTLM = isBlockingTLMEnabled(start);
+    tlm_dmi* dmi = nullptr;
 
     if(!blockingTLM) {
         //Look for dmi data
-        for (auto &dmi: mDmiData) {
-            if (start >= dmi.get_start_address() &&
-                end <= dmi.get_end_address() &&
-                ((rw == TLM_READ_COMMAND && dmi.is_read_allowed()) ||
-                 (rw == TLM_WRITE_COMMAND && dmi.is_write_allowed()))
-               ) {
-
-                //FIXME: It shouldn't be legal to let data_ptr be nullptr
-                if (trans.get_data_ptr()) {
-                    auto offset = start - dmi.get_start_address();
-                    if (rw == tlm::TLM_READ_COMMAND) {
-                        memcpy(trans.get_data_ptr(), dmi.get_dmi_ptr() + offset, length);
-                        //FIXME: to big : delay += dmi.get_read_latency();
-                    } else if (rw == tlm::TLM_WRITE_COMMAND) {
-                        memcpy(dmi.get_dmi_ptr() + offset, trans.get_data_ptr(), length);
-                        //FIXME: to big : delay += dmi.get_write_latency();
-                    }
+        dmi = findDmi(start, end);
+        if (dmi &&
+            ((rw == TLM_READ_COMMAND && dmi->is_read_allowed()) ||
+             (rw == TLM_WRITE_COMMAND && dmi->is_write_allowed()))
+           ) {
+
+            //FIXME: It shouldn't be legal to let data_ptr be nullptr
+            if (trans.get_data_ptr()) {
+                auto offset = start - dmi->get_start_address();
+                if (rw == tlm::TLM_READ_COMMAND) {
+                    memcpy(trans.get_data_ptr(), dmi->get_dmi_ptr() + offset, length);
+                    //FIXME: to big : delay += dmi->get_read_latency();
+                } else if (rw == tlm::TLM_WRITE_COMMAND) {
+                    memcpy(dmi->get_dmi_ptr() + offset, trans.get_data_ptr(), length);
+                    //FIXME: to big : delay += dmi->get_write_latency();
                 }
-                trans.set_response_status(TLM_OK_RESPONSE);
-                return;
             }
+            //Let the initiator know it may ask for the region itself
+            trans.set_dmi_allowed(true);
+            trans.set_response_status(TLM_OK_RESPONSE);
+            return;
         }
     }
 
     //blocking TLM access otherwise
     mSocketOut->b_transport(trans, delay);
 
-    if(trans.is_dmi_allowed() && !blockingTLM) {
+    //Only ask for a grant when none is known here, a known one not allowing the access will not change
+    if(trans.is_dmi_allowed() && !blockingTLM && !dmi) {
         mTrans.deep_copy_from(trans);
         if (get_direct_mem_ptr(mTrans, mDmiTrans)) {
-            mDmiData.push_back(mDmiTrans);
+            addDmi(mDmiTrans);
         }
     }
 
@@ -100,15 +104,77 @@ tlm_sync_enum ForwardSimpleSocket::nb_transport_bw(tlm_generic_payload &trans, t
 
 void ForwardSimpleSocket::invalidate_direct_mem_ptr(sc_dt::uint64 start, sc_dt::uint64 end)
 {
-    mDmiData.erase(remove_if(mDmiData.begin(), mDmiData.end(),
-                             [start, end](const tlm_dmi& dmi) {
-                                 return (dmi.get_start_address() <= end) && (dmi.get_end_address() >= start);
-                             }),
-                   mDmiData.end());
+    //Only the grants intersecting [start, end] are dropped
+    auto it = mDmiData.upper_bound(start);
+    if(it != mDmiData.begin() && prev(it)->second.get_end_address() >= start){
+        --it;
+    }
+    while(it != mDmiData.end() && it->first <= end){
+        it = mDmiData.erase(it);
+    }
 
     mSocketIn->invalidate_direct_mem_ptr(start, end);
 }
 
+void ForwardSimpleSocket::refreshParameters()
+{
+    mBlockingTLMRanges.clear();
+    for(const auto& r: mVpsimModule->getBlockingTLMEnabledRanges(mPortNum)){
+        mBlockingTLMRanges.push_back({r.first.getBaseAddress(), r.first.getEndAddress(), r.second});
+    }
+    mBlockingTLMDefault = BlockingTLMEnabledParameter();
+    mBlockingTLMLastHit = 0;
+}
+
+bool ForwardSimpleSocket::isBlockingTLMEnabled(uint64_t addr) const
+{
+    if(mBlockingTLMRanges.empty()){
+        return mBlockingTLMDefault;
+    }
+
+    const auto& last = mBlockingTLMRanges[mBlockingTLMLastHit];
+    if(addr >= last.base && addr <= last.end){
+        return last.enabled;
+    }
+
+    auto it = upper_bound(mBlockingTLMRanges.begin(), mBlockingTLMRanges.end(), addr,
+                          [](uint64_t a, const BlockingTLMRange& r){ return a < r.base; });
+    if(it == mBlockingTLMRanges.begin() || prev(it)->end < addr){
+        return mBlockingTLMDefault;
+    }
+
+    --it;
+    mBlockingTLMLastHit = it - mBlockingTLMRanges.begin();
+    return it->enabled;
+}
+
+tlm_dmi* ForwardSimpleSocket::findDmi(uint64_t start, uint64_t end)
+{
+    auto it = mDmiData.upper_bound(start);
+    if(it == mDmiData.begin()){
+        return nullptr;
+    }
+    --it;
+    return end <= it->second.get_end_address() ? &it->second : nullptr;
+}
+
+void ForwardSimpleSocket::addDmi(const tlm_dmi& dmi)
+{
+    const auto start = dmi.get_start_address();
+    const auto end = dmi.get_end_address();
+
+    //Grants are kept disjoint: a new one supersedes the ones it overlaps
+    auto it = mDmiData.upper_bound(start);
+    if(it != mDmiData.begin() && prev(it)->second.get_end_address() >= start){
+        --it;
+    }
+    while(it != mDmiData.end() && it->first <= end){
+        it = mDmiData.erase(it);
+    }
+
+    mDmiData.emplace(start, dmi);
+}
+
 ForwardSimpleSocket::ForwardSimpleSocket(sc_module_name name, const shared_ptr<VpsimModule> &vpsimModule, size_t portNum)
         :
         sc_module(name),
@@ -125,12 +191,16 @@ ForwardSimpleSocket::ForwardSimpleSocket(sc_module_name name, const shared_ptr<V
     mSocketOut.register_invalidate_direct_mem_ptr(this, &ForwardSimpleSocket::invalidate_direct_mem_ptr);
     mSocketOut.register_nb_transport_bw(this, &ForwardSimpleSocket::nb_transport_bw);
 
+    refreshParameters();
+
     mVpsimModule->registerUpdateHook([this]{
+        refreshParameters();
+
         std::vector<AddrSpace> toInvalidate;
         for(auto& dd: mDmiData){
-            const auto start = dd.get_start_address();
-            const auto end = dd.get_end_address();
-            if((dd.is_write_allowed() || dd.is_read_allowed()) &&
+            const auto start = dd.second.get_start_address();
+            const auto end = dd.second.get_end_address();
+            if((dd.second.is_write_allowed() || dd.second.is_read_allowed()) &&
                mVpsimModule->getBlockingTLMEnabled(mPortNum, AddrSpace(start, end))){
                toInvalidate.emplace_back(start, end);
             }
@@ -20,6 +20,8 @@
 #define SC_INCLUDE_DYNAMIC_PROCESSES
 
 #include <memory>
+#include <map>
+#include <vector>
 #include "systemc"
 #include "vpsimModule/vpsimParam.hpp"
 
@@ -39,7 +41,18 @@ namespace vpsim {
         socketIn_t mSocketIn;
         socketOut_t mSocketOut;
 
-        std::vector<tlm::tlm_dmi> mDmiData;
+        //! @brief DMI grants indexed by start address, never overlapping
+        std::map<uint64_t, tlm::tlm_dmi> mDmiData;
+
+        //! @brief "blocking TLM enabled" resolved for the output port, refreshed on parameter update
+        struct BlockingTLMRange {
+            uint64_t base;
+            uint64_t end;
+            bool enabled;
+        };
+        std::vector<BlockingTLMRange> mBlockingTLMRanges;
+        bool mBlockingTLMDefault;
+        mutable size_t mBlockingTLMLastHit;
 
         tlm::tlm_generic_payload mTrans;
         tlm::tlm_dmi mDmiTrans;
@@ -47,6 +60,18 @@ namespace vpsim {
         std::shared_ptr<VpsimModule> mVpsimModule;
         const size_t mPortNum;
 
+        //! @brief Rebuild the cached parameters from the ones of the VpsimModule
+        void refreshParameters();
+
+        //! @brief Cached equivalent of VpsimModule::getBlockingTLMEnabled(mPortNum, addr)
+        bool isBlockingTLMEnabled(uint64_t addr) const;
+
+        //! @brief Find the DMI grant covering [start, end], if any
+        tlm::tlm_dmi* findDmi(uint64_t start, uint64_t end);
+
+        //! @brief Store a DMI grant, replacing the ones it overlaps
+        void addDmi(const tlm::tlm_dmi& dmi);
+
     public:
         ForwardSimpleSocket(sc_module_name name, const shared_ptr<VpsimModule> &vpsimModule, size_t portNum);
         SC_HAS_PROCESS ( ForwardSimpleSocket );
@@ -105,6 +105,10 @@ public:
 
 	BlockingTLMEnabledParameter getBlockingTLMEnabledParameter(AddrSpace addr) const;
 
+	//! @brief Get the "blocking TLM enabled" parameter on every address space where it is set
+	//! @return Non overlapping address spaces in ascending order with the value of the parameter
+	std::vector<std::pair<AddrSpace, bool>> getBlockingTLMEnabledRanges() const;
+
 
 	//! @brief Get the approximate delay parameter parameter value
 	//! @param[in] addr Address where the parameter value is requiered
@@ -149,6 +149,12 @@ public:
     //! @return The parameter value
     BlockingTLMEnabledParameter getBlockingTLMEnabled(size_t port, AddrSpace addr) const;
 
+    //! @brief get the address spaces where the parameter "blocking TLM enabled" is set
+    //! Meant to be cached by the caller and refreshed from an update hook
+    //! @param[in] port output port
+    //! @return Non overlapping address spaces in ascending order with the parameter value
+    std::vector<std::pair<AddrSpace, bool>> getBlockingTLMEnabledRanges(size_t port) const;
+
 	//! @brief get the value of the parameter approximate delay.
 	//! It is ponderated by the approximate traversal rate of the module
 	//! @param[in] addr address where the parameter value is required
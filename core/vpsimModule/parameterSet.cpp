@@ -120,6 +120,16 @@ BlockingTLMEnabledParameter ParameterSet::getBlockingTLMEnabledParameter(AddrSpa
 	return getParameterValForAddrSpace(mBlockingTLMEnabledParameter, addr);
 }
 
+vector<pair<AddrSpace, bool>> ParameterSet::getBlockingTLMEnabledRanges() const
+{
+	vector<pair<AddrSpace, bool>> ranges;
+	ranges.reserve(mBlockingTLMEnabledParameter.size());
+	for(auto& p: mBlockingTLMEnabledParameter){
+		ranges.emplace_back(p.first, static_cast<const BlockingTLMEnabledParameter&>(*p.second));
+	}
+	return ranges;
+}
+
 
 ApproximateDelayParameter ParameterSet::getApproximateDelayParameter(uint64_t addr) const
 {
@@ -187,6 +187,11 @@ BlockingTLMEnabledParameter VpsimModule::getBlockingTLMEnabled(size_t port, Addr
 	return mEffectiveParameters[port].getBlockingTLMEnabledParameter(addr);
 }
 
+vector<pair<AddrSpace, bool>> VpsimModule::getBlockingTLMEnabledRanges(size_t port) const
+{
+	return mEffectiveParameters[port].getBlockingTLMEnabledRanges();
+}
+
 ApproximateDelayParameter VpsimModule::getApproximateDelay(uint64_t addr) const
 {
 	return getApproximateDelay(0, addr);
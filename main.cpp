@@ -166,16 +166,16 @@ int sc_main ( int argc, char * argv[] )
 
 
 	if (argc<2) {
-		cerr<<"Call with --dump-components or --run <platform_name>.xml"<<endl;
+		cerr<<"Call with --dump-components, --dump-memory-map <platform_name>.xml or --run <platform_name>.xml"<<endl;
 		return 1;
 	} else {
 		if (string("--dump-components") == argv[1]) {
 			PlatformBuilder::dumpComponents(cout);
 			return 0;
-		} else if (string("--run") == argv[1]) {
+		} else if (string("--run") == argv[1] || string("--dump-memory-map") == argv[1]) {
 			if (argc < 3) {
 				cerr<<"Please provide platform description file (XML)"<<endl;
-				cerr<<"Call with --dump-components or --run <platform_name>.xml"<<endl;
+				cerr<<"Call with --dump-components, --dump-memory-map <platform_name>.xml or --run <platform_name>.xml"<<endl;
 				return 1;
 			}
 
@@ -186,6 +186,11 @@ int sc_main ( int argc, char * argv[] )
 			throw(0);
 		}
 
+		if (string("--dump-memory-map") == argv[1]) {
+			PlatformBuilder::dumpMemoryMap(cout);
+			return 0;
+		}
+
 		//Real-time computation
 		struct timeval tp;
 		double sec, usec, start, end;